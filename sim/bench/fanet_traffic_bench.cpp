@@ -0,0 +1,227 @@
+// Host benchmark for the FANET traffic engine (src/vario/comms/fanet_traffic.cpp).
+//
+// Flies us north through a synthetic competition gaggle: most aircraft circling in thermals at
+// different heights, the rest gliding on random headings, each reporting its position every few
+// seconds as FANET tracking does, plus one aircraft flying straight at us.  Every GPS fix sweeps
+// the whole table as FanetNeighbors does on the device.  Reports the cost of each report and each
+// sweep for tables of several sizes, and checks the CPA arithmetic on a few fixed geometries and
+// that the head-on aircraft raises escalating alarms before it arrives.
+//
+//   make -C sim bench
+//   sim/build/fanet_traffic_bench [--fix-rate HZ] [--seconds N]
+
+#include <math.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "comms/fanet_traffic.h"
+
+namespace {
+  // Enough for the biggest launch we expect to see; FANET_MAX_NEIGHBORS on the device
+  constexpr size_t CAPACITY = 200;
+  constexpr double ORIGIN_LAT = 46.0;
+  constexpr double ORIGIN_LON = 8.0;
+  constexpr double METRES_PER_DEGREE = 6378137 * M_PI / 180;
+  constexpr float OWN_SPEED = 10;  // m/s, due north
+  constexpr float OWN_ALTITUDE = 1500;
+  constexpr uint32_t INTRUDER = 0xFFFFFF;
+
+  using Clock = std::chrono::steady_clock;
+  using Table = fanet_traffic::Table<CAPACITY>;
+
+  double nanosSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+
+  struct Aircraft {
+    uint32_t address;
+    // Circling: centre of the circle, radius and angular speed.  Gliding: start and velocity.
+    bool circling;
+    float east, north, altitude;
+    float radius, omega;
+    float velocityEast, velocityNorth, climb;
+    uint32_t intervalMs, nextReportMs;
+  };
+
+  struct State {
+    float east, north, altitude, speed, track, climb;
+  };
+
+  State stateAt(const Aircraft& a, float t) {
+    State s;
+    if (a.circling) {
+      const float angle = a.omega * t;
+      s.east = a.east + a.radius * cosf(angle);
+      s.north = a.north + a.radius * sinf(angle);
+      // Tangent to the circle
+      const float ve = -a.radius * a.omega * sinf(angle);
+      const float vn = a.radius * a.omega * cosf(angle);
+      s.speed = sqrtf(ve * ve + vn * vn);
+      s.track = atan2f(ve, vn) * 180 / M_PI;
+    } else {
+      s.east = a.east + a.velocityEast * t;
+      s.north = a.north + a.velocityNorth * t;
+      s.speed = sqrtf(a.velocityEast * a.velocityEast + a.velocityNorth * a.velocityNorth);
+      s.track = atan2f(a.velocityEast, a.velocityNorth) * 180 / M_PI;
+    }
+    if (s.track < 0) s.track += 360;
+    s.climb = a.climb;
+    s.altitude = a.altitude + a.climb * t;
+    return s;
+  }
+
+  double latOf(float north) { return ORIGIN_LAT + north / METRES_PER_DEGREE; }
+  double lonOf(float east) {
+    return ORIGIN_LON + east / (METRES_PER_DEGREE * cos(ORIGIN_LAT * M_PI / 180));
+  }
+
+  std::vector<Aircraft> gaggle(size_t count, float seconds) {
+    std::mt19937 random(count);
+    auto uniform = [&](float lo, float hi) {
+      return std::uniform_real_distribution<float>(lo, hi)(random);
+    };
+
+    std::vector<Aircraft> aircraft;
+    // Straight at us, same height, so that it arrives about 3/4 of the way through
+    const float meet = seconds * 0.75f;
+    aircraft.push_back({INTRUDER, false, 0, 2 * OWN_SPEED * meet, OWN_ALTITUDE, 0, 0, 0,
+                        -OWN_SPEED, 0, 1000, 0});
+    for (size_t i = 1; i < count; i++) {
+      Aircraft a = {};
+      a.address = 0x100000 + i;
+      a.circling = i % 4 != 0;
+      a.east = uniform(-1500, 1500);
+      a.north = uniform(-500, 2 * OWN_SPEED * seconds);
+      a.altitude = OWN_ALTITUDE + uniform(-300, 300);
+      if (a.circling) {
+        a.radius = uniform(40, 80);
+        a.omega = (i % 2 ? 1 : -1) * 2 * M_PI / uniform(18, 25);
+        a.climb = uniform(0.5f, 3);
+      } else {
+        const float track = uniform(0, 2 * M_PI);
+        a.velocityEast = 10 * sinf(track);
+        a.velocityNorth = 10 * cosf(track);
+        a.climb = uniform(-1.5f, -0.5f);
+      }
+      a.intervalMs = 1000 + (uint32_t)uniform(0, 4000);
+      a.nextReportMs = (uint32_t)uniform(0, a.intervalMs);
+      aircraft.push_back(a);
+    }
+    return aircraft;
+  }
+
+  bool benchCount(size_t count, float fixRate, float seconds) {
+    std::vector<Aircraft> aircraft = gaggle(count, seconds);
+    Table table;
+    double updateNs = 0, assessNs = 0, worstAssessNs = 0;
+    uint32_t updates = 0, assessments = 0;
+    uint32_t alarmFixes[4] = {0, 0, 0, 0};
+    fanet_traffic::Alarm intruderAlarm = fanet_traffic::Alarm::None;
+    bool intruderEscalated = true;
+
+    const uint32_t fixIntervalMs = (uint32_t)(1000 / fixRate);
+    for (uint32_t nowMs = 0; nowMs <= seconds * 1000; nowMs += fixIntervalMs) {
+      const float t = nowMs / 1000.0f;
+      for (Aircraft& a : aircraft) {
+        if (nowMs < a.nextReportMs) continue;
+        a.nextReportMs += a.intervalMs;
+        const State s = stateAt(a, t);
+        const auto start = Clock::now();
+        table.update(a.address, latOf(s.north), lonOf(s.east), s.altitude, s.speed, s.track,
+                     s.climb, nowMs);
+        updateNs += nanosSince(start);
+        updates++;
+      }
+
+      fanet_traffic::Own own;
+      own.lat = latOf(OWN_SPEED * t);
+      own.lon = lonOf(0);
+      own.altitude = OWN_ALTITUDE;
+      own.speed = OWN_SPEED;
+      own.track = 0;
+      own.climb = 0;
+      own.flying = true;
+      const auto start = Clock::now();
+      table.assess(own, nowMs);
+      const double ns = nanosSince(start);
+      assessNs += ns;
+      if (ns > worstAssessNs) worstAssessNs = ns;
+      assessments++;
+      alarmFixes[(int)table.threat().alarm]++;
+
+      // Until it passes, the head-on aircraft's alarm should only rise
+      const fanet_traffic::Report intruder = table.report(INTRUDER);
+      if (t < seconds * 0.75f - 1) {
+        if (intruder.alarm < intruderAlarm) intruderEscalated = false;
+        intruderAlarm = intruder.alarm;
+      }
+    }
+
+    printf("  %3zu aircraft  %6.0f ns/report  %8.0f ns/sweep (worst %8.0f)  "
+           "fixes with alarm low %u important %u urgent %u\n",
+           count, updates ? updateNs / updates : 0, assessNs / assessments, worstAssessNs,
+           alarmFixes[1], alarmFixes[2], alarmFixes[3]);
+
+    if (intruderAlarm != fanet_traffic::Alarm::Urgent || !intruderEscalated) {
+      fprintf(stderr, "  head-on aircraft: alarm %d before passing, escalated %s\n",
+              (int)intruderAlarm, intruderEscalated ? "yes" : "no");
+      return false;
+    }
+    return true;
+  }
+
+  bool check(const char* name, const fanet_traffic::Relative& relative, float expected) {
+    const float actual = fanet_traffic::predict(relative).timeToConflict;
+    const bool ok = isinf(expected) ? isinf(actual) : fabsf(actual - expected) < 0.01f;
+    if (!ok) fprintf(stderr, "  %s: time to conflict %.2f, expected %.2f\n", name, actual, expected);
+    return ok;
+  }
+
+  bool checkGeometry() {
+    bool ok = true;
+    // 200 m ahead, closing at 20 m/s: enters the 50 m radius after 7.5 s
+    ok = check("head-on", {0, 200, 0, 0, -20, 0}, 7.5f) && ok;
+    // Same, but 100 m above and not climbing
+    ok = check("head-on above", {0, 200, 100, 0, -20, 0}, INFINITY) && ok;
+    // Same, but descending onto us at 10 m/s: within 25 m of our height after 7.5 s
+    ok = check("descending", {0, 200, 100, 0, -20, -10}, 7.5f) && ok;
+    // Passing 100 m to the side
+    ok = check("abeam", {100, 200, 0, 0, -20, 0}, INFINITY) && ok;
+    // Flying alongside at the same speed
+    ok = check("formation", {30, 0, 0, 0, 0, 0}, INFINITY) && ok;
+    // Close but moving apart
+    ok = check("diverging", {30, 0, 0, 5, 0, 0}, INFINITY) && ok;
+    // Close and closing
+    ok = check("converging", {30, 0, 0, -5, 0, 0}, 0) && ok;
+    // Beyond the horizon
+    ok = check("distant", {0, 2000, 0, 0, -20, 0}, INFINITY) && ok;
+    return ok;
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  float fixRate = 1;
+  float seconds = 120;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--fix-rate") == 0 && i + 1 < argc) {
+      fixRate = strtof(argv[++i], nullptr);
+    } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = strtof(argv[++i], nullptr);
+    } else {
+      fprintf(stderr, "usage: %s [--fix-rate HZ] [--seconds N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (fixRate <= 0) fixRate = 1;
+  if (seconds < 30) seconds = 30;
+
+  printf("FANET traffic: %.0f s at %.0f fixes per second\n", seconds, fixRate);
+  bool ok = checkGeometry();
+  for (size_t count : {16, 32, 64, 128, 200}) ok = benchCount(count, fixRate, seconds) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+// Host benchmark for the NMEA parser (src/vario/instruments/nmea.cpp).
+//
+// Feeds the same sentences through the path LeafGPS used before it, TinyGPSPlus::encode() one
+// character at a time with the firmware's custom fields plus a second pass over GSV sentences
+// for the satellite list, and through the in-place parser, and reports the cost per sentence of
+// each.  It also checks that both decode the same fix after every sentence.
+//
+//   make -C sim bench
+//   sim/build/nmea_bench [--repeat N] file.igc|file.log...
+//
+// Bus logs (.log) are replayed from their G lines as recorded.  IGC files are turned into the
+// sentences the LC86G sends for each fix (GGA, RMC, GSA and two GSVs), as leafsim's scenario
+// player does.  With no files it uses the IGC recordings in sim/recordings.
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <TinyGPSPlus.h>
+
+#include "instruments/gps_fix.h"
+#include "instruments/nmea.h"
+
+// Both parsers stamp each value with millis(); the bench has no clock to give them
+uint32_t millis(void) { return 0; }
+
+namespace {
+  constexpr int MAX_SATELLITES = 80;  // instruments/gps.h
+  constexpr uint32_t DEFAULT_REPEAT = 20;
+
+  using Clock = std::chrono::steady_clock;
+
+  double nanosSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+
+  struct Sat {
+    bool active;
+    uint8_t elevation;
+    uint16_t azimuth;
+    uint8_t snr;
+  };
+
+  // ---------------------------------------------------------------- input
+
+  std::string checksummed(const std::string& body) {
+    uint8_t checksum = 0;
+    for (char c : body) checksum ^= (uint8_t)c;
+    char buf[8];
+    snprintf(buf, sizeof(buf), "*%02X", checksum);
+    return "$" + body + buf;
+  }
+
+  void formatDegrees(double value, bool isLatitude, char* out, size_t size, char& hemisphere) {
+    hemisphere = isLatitude ? (value < 0 ? 'S' : 'N') : (value < 0 ? 'W' : 'E');
+    // In whole ten-thousandths of a minute, clamped to a valid coordinate so the text fits
+    const double absolute = std::min(fabs(value), isLatitude ? 90.0 : 180.0);
+    const uint32_t minutes = (uint32_t)lround(absolute * 600000) % (181 * 600000);
+    const unsigned degrees = minutes / 600000;
+    const unsigned wholeMinutes = minutes / 10000 % 60;
+    const unsigned fraction = minutes % 10000;
+    snprintf(out, size, isLatitude ? "%02u%02u.%04u" : "%03u%02u.%04u", degrees, wholeMinutes,
+             fraction);
+  }
+
+  bool readIgc(const std::string& path, std::vector<std::string>& sentences) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    double lastLat = NAN, lastLon = NAN;
+    while (std::getline(in, line)) {
+      // B HHMMSS DDMMmmm N DDDMMmmm E A PPPPP GGGGG
+      if (line.size() < 35 || line[0] != 'B') continue;
+      const auto digits = [&line](size_t offset, size_t count) {
+        return atoi(line.substr(offset, count).c_str());
+      };
+      const double lat = (digits(7, 2) + digits(9, 5) / 60000.0) * (line[14] == 'S' ? -1 : 1);
+      const double lon = (digits(15, 3) + digits(18, 5) / 60000.0) * (line[23] == 'W' ? -1 : 1);
+      double knots = 0, course = 0;
+      if (!isnan(lastLat)) {
+        const double north = (lat - lastLat) * 111320.0;
+        const double east = (lon - lastLon) * 111320.0 * cos(lat * M_PI / 180);
+        knots = sqrt(north * north + east * east) * 1.94384;
+        course = fmod(atan2(east, north) * 180 / M_PI + 360, 360);
+      }
+      lastLat = lat;
+      lastLon = lon;
+
+      char time[16], latText[16], lonText[16], body[160];
+      char latHemisphere, lonHemisphere;
+      snprintf(time, sizeof(time), "%02d%02d%02d.00", digits(1, 2), digits(3, 2), digits(5, 2));
+      formatDegrees(lat, true, latText, sizeof(latText), latHemisphere);
+      formatDegrees(lon, false, lonText, sizeof(lonText), lonHemisphere);
+      snprintf(body, sizeof(body), "GNGGA,%s,%s,%c,%s,%c,1,08,0.9,%d.0,M,47.0,M,,", time,
+               latText, latHemisphere, lonText, lonHemisphere, digits(30, 5));
+      sentences.push_back(checksummed(body));
+      snprintf(body, sizeof(body), "GNRMC,%s,A,%s,%c,%s,%c,%.2f,%.2f,010125,,,A", time, latText,
+               latHemisphere, lonText, lonHemisphere, knots, course);
+      sentences.push_back(checksummed(body));
+      sentences.push_back(checksummed("GNGSA,A,3,01,02,03,04,05,06,07,08,,,,,1.8,0.9,1.5"));
+      sentences.push_back(
+          checksummed("GPGSV,2,1,08,01,72,035,44,02,58,120,42,03,45,210,40,04,38,290,38"));
+      sentences.push_back(
+          checksummed("GPGSV,2,2,08,05,31,015,36,06,25,175,34,07,18,255,31,08,12,330,28"));
+    }
+    return true;
+  }
+
+  // G<ms>,<sentence>
+  bool readBusLog(const std::string& path, std::vector<std::string>& sentences) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+      while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+      if (line.empty() || line[0] != 'G') continue;
+      const size_t comma = line.find(',');
+      if (comma != std::string::npos) sentences.push_back(line.substr(comma + 1));
+    }
+    return true;
+  }
+
+  bool readSentences(const std::string& path, std::vector<std::string>& sentences) {
+    const size_t dot = path.find_last_of('.');
+    const std::string ext = dot == std::string::npos ? "" : path.substr(dot + 1);
+    if (ext == "igc" || ext == "IGC") return readIgc(path, sentences);
+    return readBusLog(path, sentences);
+  }
+
+  // ---------------------------------------------------------------- TinyGPSPlus, as LeafGPS had it
+
+  class TinyPath {
+   public:
+    TinyPath() {
+      totalGsv_.begin(gps, "GPGSV", 1);
+      gsvNumber_.begin(gps, "GPGSV", 2);
+      satsInView_.begin(gps, "GPGSV", 3);
+      latAccuracy_.begin(gps, "GPGST", 6);
+      lonAccuracy_.begin(gps, "GPGST", 7);
+      fix_.begin(gps, "GNGGA", 6);
+      fixMode_.begin(gps, "GNGSA", 2);
+      for (int i = 0; i < 4; ++i) {
+        satNumber_[i].begin(gps, "GPGSV", 4 + 4 * i);
+        elevation_[i].begin(gps, "GPGSV", 5 + 4 * i);
+        azimuth_[i].begin(gps, "GPGSV", 6 + 4 * i);
+        snr_[i].begin(gps, "GPGSV", 7 + 4 * i);
+      }
+    }
+
+    bool receive(const std::string& nmea) {
+      bool newSentence = false;
+      for (char c : nmea) {
+        newSentence = gps.encode(c);
+        if (newSentence) break;
+      }
+      if (!newSentence) newSentence = gps.encode('\r');
+      if (newSentence) updateSatList(nmea);
+      return newSentence;
+    }
+
+    TinyGPSPlus gps;
+    Sat sats[MAX_SATELLITES] = {};
+
+   private:
+    static bool isGsvSentence(const std::string& nmea) {
+      return nmea.length() >= 7 && nmea[0] == '$' && nmea[3] == 'G' && nmea[4] == 'S' &&
+             nmea[5] == 'V' && nmea[6] == ',';
+    }
+
+    static bool parseNmeaIntField(const std::string& nmea, uint8_t targetField, int& value) {
+      uint8_t field = 0;
+      size_t start = nmea[0] == '$' ? 1 : 0;
+      for (size_t i = start; i <= nmea.length(); ++i) {
+        char c = i < nmea.length() ? nmea[i] : '\0';
+        if (c == ',' || c == '*' || c == '\0') {
+          if (field == targetField) {
+            if (i == start) return false;
+            int parsed = 0;
+            for (size_t j = start; j < i; ++j) {
+              if (nmea[j] < '0' || nmea[j] > '9') return false;
+              parsed = parsed * 10 + (nmea[j] - '0');
+            }
+            value = parsed;
+            return true;
+          }
+          ++field;
+          start = i + 1;
+          if (c == '*' || c == '\0') return false;
+        }
+      }
+      return false;
+    }
+
+    void updateSatList(const std::string& nmea) {
+      if (!isGsvSentence(nmea)) {
+        groupActive_ = false;
+        return;
+      }
+      int total = 0, current = 0;
+      if (!parseNmeaIntField(nmea, 1, total) || !parseNmeaIntField(nmea, 2, current)) return;
+      if (current == 1 && !groupActive_) {
+        for (Sat& sat : sats) sat.active = false;
+      }
+      groupActive_ = true;
+      for (int i = 0; i < 4; ++i) {
+        int no = 0, elevation = 0, azimuth = 0, snr = 0;
+        const uint8_t field = 4 + 4 * i;
+        if (parseNmeaIntField(nmea, field, no) && no >= 1 && no <= MAX_SATELLITES &&
+            parseNmeaIntField(nmea, field + 1, elevation) &&
+            parseNmeaIntField(nmea, field + 2, azimuth)) {
+          parseNmeaIntField(nmea, field + 3, snr);
+          sats[no - 1] = {true, (uint8_t)std::min(elevation, 90), (uint16_t)std::min(azimuth, 359),
+                          (uint8_t)std::min(snr, 99)};
+        }
+      }
+    }
+
+    TinyGPSCustom totalGsv_, gsvNumber_, satsInView_;
+    TinyGPSCustom satNumber_[4], elevation_[4], azimuth_[4], snr_[4];
+    TinyGPSCustom latAccuracy_, lonAccuracy_, fix_, fixMode_;
+    bool groupActive_ = false;
+  };
+
+  // ---------------------------------------------------------------- nmea::Sentence
+
+  class SpanPath {
+   public:
+    bool receive(const std::string& nmea) {
+      const nmea::Sentence sentence(nmea.data(), nmea.size());
+      if (!sentence.valid()) return false;
+      nmea::decode(sentence, fix);
+      nmea::SatellitePage page;
+      if (!nmea::decode(sentence, page)) {
+        if (sentence.type() != nmea::Type::GSV) groupActive_ = false;
+        return true;
+      }
+      if (page.number == 1 && !groupActive_) {
+        for (Sat& sat : sats) sat.active = false;
+      }
+      groupActive_ = true;
+      for (uint8_t i = 0; i < page.count; i++) {
+        const nmea::Satellite& s = page.satellites[i];
+        if (s.id <= MAX_SATELLITES) sats[s.id - 1] = {true, s.elevation, s.azimuth, s.snr};
+      }
+      return true;
+    }
+
+    GpsFix fix;
+    Sat sats[MAX_SATELLITES] = {};
+
+   private:
+    bool groupActive_ = false;
+  };
+
+  // ---------------------------------------------------------------- comparison
+
+  // Returns the number of values that differ
+  uint32_t compare(TinyPath& tiny, SpanPath& span) {
+    TinyGPSPlus& a = tiny.gps;
+    GpsFix& b = span.fix;
+    uint32_t differences = 0;
+    const auto check = [&differences](bool aValid, bool bValid, bool same) {
+      if (aValid != bValid || (aValid && !same)) differences++;
+    };
+    check(a.location.isValid(), b.location.isValid(),
+          fabs(a.location.lat() - b.location.lat()) < 1e-9 &&
+              fabs(a.location.lng() - b.location.lng()) < 1e-9);
+    check(a.altitude.isValid(), b.altitude.isValid(), a.altitude.value() == b.altitude.value());
+    check(a.speed.isValid(), b.speed.isValid(), a.speed.value() == b.speed.value());
+    check(a.course.isValid(), b.course.isValid(), a.course.value() == b.course.value());
+    check(a.time.isValid(), b.time.isValid(), a.time.value() == b.time.value());
+    check(a.date.isValid(), b.date.isValid(), a.date.value() == b.date.value());
+    check(a.satellites.isValid(), b.satellites.isValid(),
+          a.satellites.value() == b.satellites.value());
+    check(a.hdop.isValid(), b.hdop.isValid(), a.hdop.value() == b.hdop.value());
+    for (int i = 0; i < MAX_SATELLITES; i++) {
+      const Sat& x = tiny.sats[i];
+      const Sat& y = span.sats[i];
+      if (x.active != y.active || (x.active && (x.elevation != y.elevation ||
+                                                x.azimuth != y.azimuth || x.snr != y.snr))) {
+        differences++;
+      }
+    }
+    return differences;
+  }
+
+  template <typename Path>
+  double nanosPerSentence(const std::vector<std::string>& sentences, uint32_t repeat) {
+    Path path;
+    uint32_t accepted = 0;
+    const auto start = Clock::now();
+    for (uint32_t r = 0; r < repeat; r++) {
+      for (const std::string& sentence : sentences) accepted += path.receive(sentence);
+    }
+    const double ns = nanosSince(start);
+    if (accepted == 0) fprintf(stderr, "  no sentence was accepted\n");
+    return ns / ((double)sentences.size() * repeat);
+  }
+
+  bool benchFile(const std::string& path, uint32_t repeat) {
+    std::vector<std::string> sentences;
+    if (!readSentences(path, sentences) || sentences.empty()) {
+      fprintf(stderr, "%s: no sentences\n", path.c_str());
+      return false;
+    }
+    size_t characters = 0;
+    for (const std::string& sentence : sentences) characters += sentence.size();
+    printf("%s\n  %zu sentences, %.1f characters each\n", path.c_str(), sentences.size(),
+           (double)characters / sentences.size());
+
+    TinyPath tiny;
+    SpanPath span;
+    uint32_t rejected = 0;
+    uint32_t differences = 0;
+    for (const std::string& sentence : sentences) {
+      if (tiny.receive(sentence) != span.receive(sentence)) rejected++;
+      differences += compare(tiny, span);
+    }
+    printf("  %u sentences accepted by only one parser, %u decoded values differ\n", rejected,
+           differences);
+
+    const double tinyNs = nanosPerSentence<TinyPath>(sentences, repeat);
+    const double spanNs = nanosPerSentence<SpanPath>(sentences, repeat);
+    printf("  TinyGPSPlus::encode + GSV pass  %8.1f ns/sentence\n", tinyNs);
+    printf("  nmea::Sentence + decode         %8.1f ns/sentence (%.1fx)\n", spanNs,
+           tinyNs / spanNs);
+    return rejected == 0 && differences == 0;
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t repeat = DEFAULT_REPEAT;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (repeat == 0) repeat = 1;
+  if (paths.empty()) paths = {"sim/recordings/example.igc", "sim/recordings/example2.igc"};
+
+  bool ok = true;
+  for (const std::string& path : paths) ok = benchFile(path, repeat) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+// Host benchmark for BLE notification batching (src/vario/comms/nus_batch.cpp).
+//
+// Plays the sentences the BLE task sends in flight through both the path it used before, one
+// notification per sentence, and a nus_batch::Batch flushed on every 100 ms timer tick, and
+// reports notifications per second and the host cost of each tick at the default 23 byte MTU
+// and at the MTUs flight apps negotiate.  The traffic is LK8EX1 at --vario-hz, GGA and RMC at
+// --gps-hz, and a PFLAA line for each tracking frame heard from --aircraft others every 5 s.
+//
+//   make -C sim bench
+//   sim/build/nus_batch_bench [--vario-hz N] [--gps-hz N] [--aircraft N] [--seconds N]
+//
+// It fails if the notifications do not reassemble into exactly the sentences queued, if any is
+// longer than the payload, or if a sentence that fits in one notification is split across two.
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "comms/nus_batch.h"
+
+namespace {
+  constexpr uint32_t TICK_MS = 100;  // The BLE task's periodic timer
+  constexpr uint32_t FANET_INTERVAL_MS = 5000;
+  constexpr uint16_t MTUS[] = {nus_batch::DEFAULT_MTU, 185, 247};
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    int varioHz = 10;
+    int gpsHz = 2;
+    int aircraft = 20;
+    int seconds = 600;
+  };
+
+  // The sentences that become due in each tick, as the firmware formats them
+  std::vector<std::vector<std::string>> flight(const Options& options) {
+    std::mt19937 random(1);
+    std::vector<std::vector<std::string>> ticks(options.seconds * 1000 / TICK_MS);
+    std::vector<uint32_t> nextFrameMs(options.aircraft);
+    for (uint32_t& ms : nextFrameMs) ms = random() % FANET_INTERVAL_MS;
+
+    char sentence[120];
+    for (size_t tick = 0; tick < ticks.size(); tick++) {
+      const uint32_t atMs = tick * TICK_MS;
+      const float t = atMs / 1000.0f;
+      auto& due = ticks[tick];
+
+      for (int a = 0; a < options.aircraft; a++) {
+        while (nextFrameMs[a] < atMs + TICK_MS) {
+          snprintf(sentence, sizeof(sentence), "$PFLAA,0,%d,%d,%d,2,FC%04X,%d,,%.2f,%.2f,7,0,0,%d",
+                   (int)(random() % 4000) - 2000, (int)(random() % 4000) - 2000,
+                   (int)(random() % 600) - 300, a + 1, (int)(random() % 360),
+                   9 + (random() % 300) / 100.0, (int)(random() % 600) / 100.0 - 3,
+                   -60 - (int)(random() % 50));
+          due.push_back(sentence);
+          nextFrameMs[a] += FANET_INTERVAL_MS + 75 + random() % 425;
+        }
+      }
+      if (tick % (10 / options.gpsHz) == 0) {
+        snprintf(sentence, sizeof(sentence),
+                 "$GNGGA,12%02d%05.2f,4730.%05d,N,01112.%05d,E,1,14,0.8,%.1f,M,47.1,M,,*00",
+                 (int)(t / 60) % 60, fmodf(t, 60), (int)(tick * 7) % 100000,
+                 (int)(tick * 3) % 100000, 1300 + t * 0.5f);
+        due.push_back(sentence);
+        snprintf(sentence, sizeof(sentence),
+                 "$GNRMC,12%02d%05.2f,A,4730.%05d,N,01112.%05d,E,21.4,183.2,190726,,,A,V*00",
+                 (int)(t / 60) % 60, fmodf(t, 60), (int)(tick * 7) % 100000,
+                 (int)(tick * 3) % 100000);
+        due.push_back(sentence);
+      }
+      if (tick % (10 / options.varioHz) == 0) {
+        snprintf(sentence, sizeof(sentence), "$LK8EX1,%d,%u,%d,%s,%d,",
+                 86000 + (int)(random() % 200), 4265u + (unsigned)(tick % 300),
+                 (int)(random() % 600) - 300, "21.5", 1087);
+        due.push_back(sentence);
+      }
+    }
+    return ticks;
+  }
+
+  // What a sentence becomes on the wire: body, checksum and CRLF
+  std::string onWire(const std::string& sentence) {
+    const std::string body = sentence.substr(0, sentence.find('*'));
+    uint8_t checksum = 0;
+    for (size_t i = 1; i < body.size(); i++) checksum ^= (uint8_t)body[i];
+    char suffix[8];
+    snprintf(suffix, sizeof(suffix), "*%02X\r\n", checksum);
+    return body + suffix;
+  }
+
+  struct Result {
+    uint64_t notifications = 0;
+    uint64_t truncated = 0;  // Sentences cut short by one-per-notification
+    double nsPerTick = 0;
+    double worstNs = 0;
+    bool ok = true;
+  };
+
+  // One notification per sentence, as before.  NimBLE truncates a value to the payload.
+  Result unbatched(const std::vector<std::vector<std::string>>& ticks, uint16_t mtu) {
+    Result result;
+    const size_t payload = nus_batch::payloadSize(mtu);
+    for (const auto& due : ticks) {
+      for (const std::string& sentence : due) {
+        const size_t length = onWire(sentence).size();
+        result.notifications++;
+        if (length > payload) result.truncated++;
+      }
+    }
+    return result;
+  }
+
+  Result batched(const std::vector<std::vector<std::string>>& ticks, uint16_t mtu) {
+    Result result;
+    const size_t payload = nus_batch::payloadSize(mtu);
+    static nus_batch::Batch batch;
+    std::string expected, received;
+    for (const auto& due : ticks) {
+      for (const std::string& sentence : due) expected += onWire(sentence);
+    }
+    received.reserve(expected.size());
+    double totalNs = 0;
+
+    auto notify = [&](const uint8_t* data, size_t length) {
+      result.notifications++;
+      if (length > payload) result.ok = false;
+      // Only a sentence longer than the payload may be cut, so a notification that does not end
+      // a line must be a full payload from the middle of one
+      if (data[length - 1] != '\n' &&
+          (length != payload || memchr(data, '\n', length) != nullptr)) {
+        result.ok = false;
+      }
+      received.append((const char*)data, length);
+    };
+
+    for (const auto& due : ticks) {
+      const Clock::time_point start = Clock::now();
+      for (const std::string& sentence : due) {
+        if (!batch.add(sentence.c_str())) {
+          batch.flush(mtu, notify);
+          if (!batch.add(sentence.c_str())) result.ok = false;
+        }
+      }
+      batch.flush(mtu, notify);
+      const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+      totalNs += ns;
+      result.worstNs = std::max(result.worstNs, ns);
+    }
+    result.nsPerTick = totalNs / ticks.size();
+
+    // The notifications must reassemble into the sentences queued, in order
+    if (received != expected) result.ok = false;
+    return result;
+  }
+
+  bool parse(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+      auto next = [&]() { return i + 1 < argc ? atoi(argv[++i]) : 0; };
+      if (!strcmp(argv[i], "--vario-hz")) {
+        options.varioHz = next();
+      } else if (!strcmp(argv[i], "--gps-hz")) {
+        options.gpsHz = next();
+      } else if (!strcmp(argv[i], "--aircraft")) {
+        options.aircraft = next();
+      } else if (!strcmp(argv[i], "--seconds")) {
+        options.seconds = next();
+      } else {
+        return false;
+      }
+    }
+    auto rate = [](int hz) { return hz == 1 || hz == 2 || hz == 5 || hz == 10; };
+    return rate(options.varioHz) && rate(options.gpsHz) && options.aircraft >= 0 &&
+           options.seconds > 0;
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parse(argc, argv, options)) {
+    fprintf(stderr,
+            "usage: nus_batch_bench [--vario-hz 1|2|5|10] [--gps-hz 1|2|5|10] [--aircraft N] "
+            "[--seconds N]\n");
+    return 2;
+  }
+
+  const auto ticks = flight(options);
+  size_t sentences = 0;
+  for (const auto& due : ticks) sentences += due.size();
+  printf("nus_batch: LK8EX1 %d Hz, GGA+RMC %d Hz, %d aircraft: %.1f sentences/s\n",
+         options.varioHz, options.gpsHz, options.aircraft, sentences / (double)options.seconds);
+
+  bool ok = true;
+  for (uint16_t mtu : MTUS) {
+    const Result before = unbatched(ticks, mtu);
+    const Result after = batched(ticks, mtu);
+    ok = ok && after.ok;
+    printf("  MTU %3u  per sentence %6.1f notify/s (%5llu truncated)   batched %6.1f notify/s  "
+           "%6.0f ns/tick (worst %6.0f)%s\n",
+           mtu, before.notifications / (double)options.seconds,
+           (unsigned long long)before.truncated, after.notifications / (double)options.seconds,
+           after.nsPerTick, after.worstNs, after.ok ? "" : "  MISMATCH");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+// Host benchmark for the XC scoring engine (src/vario/logbook/xc_score.cpp).
+//
+// Replays real IGC tracklogs through the scorer exactly as the firmware drives it: one addFix()
+// and one budgeted update() per fix while "flying", then the post-flight solve and refinement
+// passes.  Reports wall time per phase and the worst single in-flight update, plus distance
+// evaluations, which are the unit the in-flight budget is expressed in and which carry over to
+// the ESP32-S3 (a few hundred ns each there, single-precision FPU).  Fails if any in-flight
+// update does more evaluations than its budget.
+//
+//   make -C sim bench
+//   sim/build/xc_score_bench [--budget N] [--final-candidates N] file.igc...
+//
+// With no files it scores the IGC recordings in sim/recordings and tools and analysis/.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logbook/igc_fix.h"
+#include "logbook/xc_score.h"
+
+namespace {
+  // XC_EVALUATIONS_PER_TICK in logging/log.cpp: one update per 1 Hz log tick
+  constexpr uint32_t DEFAULT_BUDGET = 2000;
+
+  using Clock = std::chrono::steady_clock;
+
+  double microsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  }
+
+  bool readFixes(const std::string& path, std::vector<IgcFix>& fixes) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+      while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+      IgcFix fix;
+      if (igc_fix::parseBRecord(line.c_str(), line.size(), fix)) fixes.push_back(fix);
+    }
+    return true;
+  }
+
+  void printScore(const char* label, const XcScore& score) {
+    printf("  %-10s free %7.2f km  triangle %-13s %7.2f km (closing %5.2f km)  "
+           "best %-13s %7.2f pts\n",
+           label, score.freeDistanceM / 1000, XcScore::typeName(score.triangleType),
+           score.trianglePerimeterM / 1000, score.closingDistanceM / 1000,
+           XcScore::typeName(score.bestType), score.bestScore);
+  }
+
+  bool benchFile(const std::string& path, uint32_t budget, uint16_t finalCandidates) {
+    std::vector<IgcFix> fixes;
+    if (!readFixes(path, fixes) || fixes.size() < 2) {
+      fprintf(stderr, "%s: no fixes\n", path.c_str());
+      return false;
+    }
+    printf("%s\n  %zu fixes\n", path.c_str(), fixes.size());
+
+    // In flight
+    XcScorer inFlight;
+    if (!inFlight.begin(XcScorer::IN_FLIGHT_CANDIDATES)) return false;
+    double worstUpdateUs = 0;
+    uint32_t worstUpdateEvaluations = 0;
+    uint32_t overBudget = 0;
+    uint32_t solves = 0;
+    const auto flightStart = Clock::now();
+    for (const IgcFix& fix : fixes) {
+      const auto tickStart = Clock::now();
+      inFlight.addFix(fix.latE5, fix.lonE5);
+      const uint32_t before = inFlight.evaluations();
+      if (inFlight.update(budget)) solves++;
+      const double us = microsSince(tickStart);
+      if (us > worstUpdateUs) worstUpdateUs = us;
+      const uint32_t evaluations = inFlight.evaluations() - before;
+      if (evaluations > worstUpdateEvaluations) worstUpdateEvaluations = evaluations;
+      if (evaluations > budget) overBudget++;
+    }
+    const double flightUs = microsSince(flightStart);
+    printf("  in flight: %u candidates, %u solves, %.1f ms total, %.1f us/fix average\n",
+           XcScorer::IN_FLIGHT_CANDIDATES, solves, flightUs / 1000, flightUs / fixes.size());
+    printf("             worst tick %.1f us, %u evaluations (budget %u)\n", worstUpdateUs,
+           worstUpdateEvaluations, budget);
+    printScore("in flight", inFlight.result());
+    if (overBudget > 0) {
+      fprintf(stderr, "%s: %u updates went over the budget of %u evaluations\n", path.c_str(),
+              overBudget, budget);
+      return false;
+    }
+
+    // Post-flight, as the XC score task runs it
+    XcScorer postFlight;
+    if (!postFlight.begin(finalCandidates, fixes.size())) return false;
+    auto phaseStart = Clock::now();
+    for (const IgcFix& fix : fixes) postFlight.addFix(fix.latE5, fix.lonE5);
+    const double collectUs = microsSince(phaseStart);
+    const uint32_t collectEvaluations = postFlight.evaluations();
+
+    phaseStart = Clock::now();
+    postFlight.solve();
+    const double solveUs = microsSince(phaseStart);
+    const uint32_t solveEvaluations = postFlight.evaluations() - collectEvaluations;
+    printScore("solved", postFlight.result());
+
+    phaseStart = Clock::now();
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      postFlight.beginRefinement();
+      for (const IgcFix& fix : fixes) postFlight.refineFix(fix.latE5, fix.lonE5);
+      postFlight.finishRefinement();
+    }
+    const double refineUs = microsSince(phaseStart);
+    const uint32_t refineEvaluations =
+        postFlight.evaluations() - collectEvaluations - solveEvaluations;
+    printf("  final: %u candidates; collect %.1f ms (%u evals), solve %.1f ms (%u evals), "
+           "refine %.1f ms (%u evals)\n",
+           finalCandidates, collectUs / 1000, collectEvaluations, solveUs / 1000,
+           solveEvaluations, refineUs / 1000, refineEvaluations);
+    printScore("final", postFlight.result());
+    return true;
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t budget = DEFAULT_BUDGET;
+  uint16_t finalCandidates = XcScorer::FINAL_CANDIDATES;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+      budget = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--final-candidates") == 0 && i + 1 < argc) {
+      finalCandidates = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.empty()) {
+    paths = {"sim/recordings/example.igc", "sim/recordings/example2.igc",
+             "tools and analysis/thermal_detection/"
+             "2026-06-10-XNA-012A0E13E4CAE10B9F78BA46365F9A14-02 (1).igc",
+             "tools and analysis/thermal_detection/"
+             "2026-06-12-XNA-012A0E13E4CAE10B9F78BA46365F9A14-01 (2).igc"};
+  }
+
+  bool ok = true;
+  for (const std::string& path : paths) ok = benchFile(path, budget, finalCandidates) && ok;
+  return ok ? 0 : 1;
+}
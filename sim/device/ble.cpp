@@ -0,0 +1,161 @@
+// The emulated Bluetooth transport, replacing comms/ble.cpp.
+//
+// The real one runs NimBLE: a GATT server with the Nordic UART service, a task woken through a
+// queue, and a 100 ms FreeRTOS timer.  Here the sentence stream is the shipping one
+// (comms/ble_stream.cpp formats, batches and counts exactly as on the device) and only the radio
+// is replaced, by sim::bleLink(), which carries the notifications to a TCP client or a virtual
+// central at the pace of a BLE connection.  The task is a 1 ms slot on the virtual clock that
+// drains the wakeup queue, so it runs on the device thread in device time, and the periodic timer
+// is the FreeRTOS one, which the sim also runs on the clock.  On the device the task's priority
+// has it drain the queue as soon as anything is sent to it; a millisecond later is close enough
+// for stream timing, but a burst of more than four messages inside one millisecond overflows the
+// queue here where it would not there.
+//
+// Without any --ble option the link is off and BLE stays "not emulated", as before.
+
+#include "comms/ble.h"
+
+#include <Arduino.h>
+
+#include <deque>
+
+#include "diagnostics/heap_monitor.h"
+#include "sim/ble_link.h"
+#include "sim/clock.h"
+
+// Only ever compared against nullptr by the firmware: a server exists while BLE is set up
+class NimBLEServer {};
+
+namespace {
+  constexpr uint32_t TASK_PERIOD_US = 1000;
+
+  // The reason NimBLE reports when the central hangs up (BLE_HS_ERR_HCI_BASE + Remote User
+  // Terminated Connection)
+  constexpr int REMOTE_USER_TERMINATED = 0x213;
+
+  NimBLEServer server;
+  int taskTimer = -1;
+
+  // When each sentence in the batch was formatted, oldest first, so the link can report how old
+  // a notification's data is when the central receives it
+  std::deque<uint32_t> formattedMs;
+
+  void noteFormatted(size_t sentences) {
+    while (formattedMs.size() < sentences) formattedMs.push_back(millis());
+  }
+}  // namespace
+
+BLE& BLE::get() {
+  static BLE instance;
+  return instance;
+}
+
+void BLE::setup() {
+  if (pServer != nullptr) return;
+  if (!sim::bleLink().enabled()) {
+    Serial.println("BLE: not emulated");
+    return;
+  }
+
+  heap_monitor::checkpoint("ble-setup-before");
+  pServer = &server;
+  createWakeupQueue();
+
+  xTimer = xTimerCreate("BLEPeriodicSend", pdMS_TO_TICKS(100), pdTRUE, NULL, BLE::timerCallback);
+  xTimerStart(xTimer, 0);
+
+  taskTimer = sim::clock().addTimer(1000000);
+  sim::clock().setTimerCallback(taskTimer, BLE::bleTask, this);
+  sim::clock().setTimerPeriodUs(taskTimer, TASK_PERIOD_US, true);
+  heap_monitor::checkpoint("ble-setup-after");
+}
+
+void BLE::start() {
+  if (pServer == nullptr) setup();
+  if (pServer == nullptr || started) return;
+  sim::bleLink().advertise(true);
+  started = true;
+}
+
+void BLE::stop() {
+  if (pServer == nullptr || !started) return;
+  sim::bleLink().advertise(false);
+  started = false;
+}
+
+void BLE::end() {
+  if (pServer == nullptr) {
+    started = false;
+    return;
+  }
+
+  heap_monitor::checkpoint("ble-end-before");
+  sim::bleLink().advertise(false);
+  sim::bleLink().disconnect();
+  started = false;
+
+  if (taskTimer >= 0) sim::clock().removeTimer(taskTimer);
+  taskTimer = -1;
+  xTimerStop(xTimer, 0);
+  xTimerDelete(xTimer, 0);
+  xTimer = nullptr;
+  vQueueDelete(xQueue);
+  xQueue = nullptr;
+
+  pServer = nullptr;
+  connections.store(0, std::memory_order_relaxed);
+  nusMtu.store(nus_batch::DEFAULT_MTU, std::memory_order_relaxed);
+  nusBatch.clear();
+  formattedMs.clear();
+  heap_monitor::checkpoint("ble-end-after");
+}
+
+// One pass of the task: connection events first, as NimBLE's host task would deliver them, then
+// every wakeup waiting in the queue
+void BLE::bleTask(void* args) {
+  BLE* ble = (BLE*)args;
+  sim::BleLink& link = sim::bleLink();
+
+  for (auto event = link.poll(millis()); event != sim::BleLink::Event::None;
+       event = link.poll(millis())) {
+    switch (event) {
+      case sim::BleLink::Event::Connected:
+        ble->noteConnected(nus_batch::DEFAULT_MTU);
+        break;
+      case sim::BleLink::Event::MtuChanged:
+        ble->noteMtuChanged(link.mtu());
+        break;
+      case sim::BleLink::Event::Disconnected:
+        ble->noteDisconnected(REMOTE_USER_TERMINATED);
+        if (ble->isStarted()) {
+          link.advertise(true);
+          ble->noteAdvertisingRestarted(true);
+        }
+        break;
+      case sim::BleLink::Event::None:
+        break;
+    }
+  }
+
+  while (ble->processWakeup(0)) noteFormatted(ble->nusBatch.sentences());
+}
+
+void BLE::flushNus() {
+  if (nusBatch.empty()) return;
+  noteFormatted(nusBatch.sentences());
+  if (connections.load(std::memory_order_relaxed) == 0) {
+    // Disconnected since these were formatted
+    nusBatch.clear();
+    formattedMs.clear();
+    return;
+  }
+  nusBatch.flush(nusMtu.load(std::memory_order_relaxed), [this](const uint8_t* data, size_t size) {
+    // The first sentence in the notification is the oldest; it is done with once its line ends
+    const uint32_t oldestMs = formattedMs.front();
+    for (size_t i = 0; i < size; i++) {
+      if (data[i] == '\n' && formattedMs.size() > 1) formattedMs.pop_front();
+    }
+    recordNusNotifyResult(sim::bleLink().notify(data, size, oldestMs));
+  });
+  formattedMs.clear();
+}
@@ -1,15 +1,15 @@
 // Radios and network services the emulator does not model.
 //
-// Bluetooth, FANET/LoRa, WiFi provisioning, the configuration webserver, OTA and the factory
-// discovery responder all need hardware or a network stack that has no meaning on the host.  Each
-// keeps its interface so the firmware's call sites and menu screens compile and behave sensibly
-// (features report themselves as unavailable), without pretending to work.
+// WiFi provisioning, the configuration webserver, OTA and the factory discovery responder all need
+// hardware or a network stack that has no meaning on the host.  Each keeps its interface so the
+// firmware's call sites and menu screens compile and behave sensibly (features report themselves
+// as unavailable), without pretending to work.  FANET and Bluetooth are modelled: see
+// fanet_radio.cpp and ble.cpp.
 
 #include <Arduino.h>
 
 #include "hardware/configuration.h"
 
-#include "comms/ble.h"
 #include "comms/factory_discovery.h"
 #include "comms/leaf_log_client.h"
 #include "comms/ota.h"
@@ -18,56 +18,6 @@
 #include "comms/wifi_coordinator.h"
 #include "diagnostics/diagnostic_network/diagnostic_network.h"
 
-#ifdef FANET_CAPABLE
-#include "comms/fanet_radio.h"
-#endif
-
-// ---------------------------------------------------------------- Bluetooth
-
-BLE& BLE::get() {
-  static BLE instance;
-  return instance;
-}
-
-void BLE::setup() { Serial.println("BLE: not emulated"); }
-void BLE::start() { started = true; }
-void BLE::stop() { started = false; }
-void BLE::end() { started = false; }
-void BLE::on_receive(const GpsMessage& msg) {}
-void BLE::on_receive(const FanetPacket& msg) {}
-void BLE::sendVarioUpdate() {}
-void BLE::sendGpsUpdate(TinyGPSPlus& gps) {}
-void BLE::sendFanetUpdate(FanetPacket& packetMsg) {}
-void BLE::addChecksumToNMEA(etl::istring& nmea) {}
-void BLE::bleTask(void*) {}
-void BLE::timerCallback(TimerHandle_t timer) {}
-
-// ---------------------------------------------------------------- FANET / LoRa
-
-#ifdef FANET_CAPABLE
-FanetRadio fanetRadio;
-
-String FanetAddressToString(FANET::Address address) { return String("000:000"); }
-
-void FanetRadio::setup() {}
-void FanetRadio::subscribe(etl::imessage_bus* bus) {}
-void FanetRadio::begin(const FanetRadioRegion& region) { state = FanetRadioState::UNINSTALLED; }
-void FanetRadio::end() { state = FanetRadioState::UNINITIALIZED; }
-void FanetRadio::logDetectionResult() { Serial.println("FANET: radio not emulated"); }
-FanetRadioState FanetRadio::getState() { return state; }
-void FanetRadio::setGroundTrackingMode(const FANET::GroundTrackingPayload::TrackingType& mode) {}
-void FanetRadio::setCurrentLocation(const float& lat, const float& lon, const uint32_t& alt,
-                                    const int& heading, const float& climbRate,
-                                    const float& speedKmh) {}
-const FANET::Protocol::Stats FanetRadio::getStats() const { return FANET::Protocol::Stats(); }
-String FanetRadio::getAddress() { return String("000:000"); }
-const FanetNeighbors::NeighborMap& FanetRadio::getNeighborTable() const { return neighbors.get(); }
-void FanetRadio::on_receive(const GpsReading& msg) {}
-bool FanetRadio::fanet_sendFrame(uint8_t codingRate, etl::span<const uint8_t> data) {
-  return false;
-}
-#endif
-
 // ---------------------------------------------------------------- WiFi provisioning
 
 namespace leaf_wifi {
@@ -86,6 +36,8 @@ namespace leaf_wifi {
 
 // ---------------------------------------------------------------- webserver
 
+void webserver_start_task() {}
+void webserver_main_loop() {}
 void webserver_setup() {}
 void webserver_loop() {}
 void webserver_enable_user_app(bool useLeafWifi) {}
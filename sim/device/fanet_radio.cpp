@@ -0,0 +1,249 @@
+// The emulated FANET radio, replacing comms/fanet_radio.cpp.
+//
+// The real one drives an SX1262 over SPI, with an RX task woken by the radio's interrupt and a TX
+// task that feeds it queued frames.  Here the radio listens to sim::fanetAir() instead, where a
+// scenario's swarm transmits.  Everything from the received bytes up is the shipping path:
+// processRxPacket() hands each frame to the FANET library's protocol handler and neighbour table,
+// then to FanetNeighbors and its traffic table, then onto the bus for BLE, exactly as on the
+// device.  It runs on the device thread as the scenario puts frames on air, so the host time it
+// takes is what the FANET report measures.  Our own tracking frames are built and queued as on
+// the device and go out into air nothing else is listening to.
+
+#include "comms/fanet_radio.h"
+
+#ifdef FANET_CAPABLE
+
+#include <string.h>
+
+#include "diagnostics/fatal_error.h"
+#include "esp_mac.h"
+#include "fanet/packetParser.hpp"
+#include "fanet/tracking.hpp"
+#include "instruments/baro.h"
+#include "logging/log.h"
+#include "sim/fanet_air.h"
+#include "utils/lock_guard.h"
+
+FanetRadio fanetRadio;
+
+namespace {
+  // What the SX1262 reports for the frame in its buffer
+  size_t rxLength = 0;
+  float rxRssi = 0;
+  float rxSnr = 0;
+}  // namespace
+
+void FanetRadio::setupFanetHandler() {
+  auto addressString = getAddress();
+
+  // Convert the 6 character arduino hex string into 3 bytes
+  uint8_t addressBytes[3];
+  for (int i = 0; i < 3; i++) {
+    addressBytes[i] = strtol(addressString.substring(i * 2, i * 2 + 2).c_str(), nullptr, 16);
+  }
+
+  FANET::Address srcAddress(addressBytes[0], (addressBytes[1] << 8) | addressBytes[2]);
+  protocol->ownAddress(srcAddress);
+}
+
+void FanetRadio::subscribe(etl::imessage_bus* bus) {
+  if (!bus->subscribe(*this)) {
+    fatalError("FanetRadio couldn't subscribe to message bus");
+  };
+
+  // Subscribe the neighbors to any FanetPacket updates
+  if (!bus->subscribe(neighbors)) {
+    fatalError("FanetRadio couldn't subscribe neighbors to message bus");
+  }
+}
+
+void FanetRadio::setup() {
+  // Always installed: the module is as present as the scenario's swarm
+  state = FanetRadioState::UNINITIALIZED;
+  protocol = new FANET::Protocol(this);
+  x_fanet_manager_mutex = xSemaphoreCreateMutex();
+  setupFanetHandler();
+}
+
+void FanetRadio::begin(const FanetRadioRegion& region) {
+  logDetectionResult();
+  if (region == FanetRadioRegion::OFF) {
+    end();
+    return;
+  }
+  if (protocol == nullptr || x_fanet_manager_mutex == nullptr) {
+    state = FanetRadioState::FAILED_OTHER;
+    return;
+  }
+
+  random.initialise(millis());
+  state = FanetRadioState::RUNNING;
+
+  // The receive interrupt and the RX task it wakes, in one: copy the frame into the radio's
+  // buffer and process it
+  sim::fanetAir().listen([this](const sim::FanetFrame& frame) {
+    if (frame.bytes.empty() || frame.bytes.size() > buffer.size()) return;
+    memcpy(buffer.data(), frame.bytes.data(), frame.bytes.size());
+    rxLength = frame.bytes.size();
+    rxRssi = frame.rssi;
+    rxSnr = frame.snr;
+    processRxPacket();
+  });
+  Serial.println("[FanetRadio] Initialized");
+}
+
+void FanetRadio::end() {
+  sim::fanetAir().listen(nullptr);
+  if (state == FanetRadioState::RUNNING) state = FanetRadioState::UNINITIALIZED;
+  trackingMode = etl::nullopt;  // Reset the tracking mode
+}
+
+void FanetRadio::logDetectionResult() {
+  if (detectionResultLogged_) return;
+  detectionResultLogged_ = true;
+  Serial.println("FANET: emulated (listening to the scenario's swarm)");
+}
+
+FanetRadioState FanetRadio::getState() { return state; }
+
+void FanetRadio::processRxPacket() {
+  if (state != FanetRadioState::RUNNING) return;
+
+  const size_t length = rxLength;
+  const float rssi = rxRssi;
+  const float snr = rxSnr;
+  etl::span<uint8_t> packetSpan{buffer.data(), length};
+
+  if (LockGuard lock{x_fanet_manager_mutex}) {
+    protocol->handleRx(rssi, packetSpan);
+    neighbors.updateFromTable(protocol->neighborTable());
+  }
+
+  // Check if this packet should be processed by this vario and put it in the bus
+  auto packet = FANET::PacketParser<FANET_MAX_FRAME_SIZE>::parse(packetSpan);
+  if (!packet.payload().has_value()) return;
+
+  // If the packet is unicast destined for not us, ignore it.
+  if (packet.destination().has_value() && packet.destination().value() != protocol->ownAddress()) {
+    return;
+  }
+
+  // If the received packet is from ourself, discard it.
+  if (packet.source() == protocol->ownAddress()) return;
+
+  bus_->receive(FanetPacket(packet, rssi, snr));
+}
+
+bool FanetRadio::fanet_sendFrame(uint8_t codingRate, etl::span<const uint8_t> data) {
+  if (state != FanetRadioState::RUNNING) return false;
+  sim::fanetAir().noteTransmitted();
+  return true;
+}
+
+void FanetRadio::setCurrentLocation(const float& lat, const float& lon, const uint32_t& alt,
+                                    const int& heading, const float& climbRate,
+                                    const float& speedKmh) {
+  if (state != FanetRadioState::RUNNING) return;
+
+  auto ms = millis();
+  if (ms < m_nextAllowedTrackingTimeMs) return;
+
+  if (LockGuard lock{x_fanet_manager_mutex}) {
+    FANET::Packet<FANET_MAX_FRAME_SIZE> trackingPacket;
+    trackingPacket.forward(settings.dev_fanetFwd);
+
+    if (trackingMode.has_value()) {
+      FANET::GroundTrackingPayload groundTrackingPayload;
+      groundTrackingPayload.latitude(lat)
+          .longitude(lon)
+          .groundType(trackingMode.value())
+          .tracking(true);
+      trackingPacket.payload(groundTrackingPayload);
+    } else {
+      FANET::TrackingPayload trackingPayload;
+      trackingPayload.aircraftType(FANET::TrackingPayload::AircraftType::PARAGLIDER)
+          .tracking(true)
+          .latitude(lat)
+          .longitude(lon)
+          .altitude(alt)
+          .groundTrack(heading)
+          .climbRate(climbRate)
+          .speed(speedKmh);
+      trackingPacket.payload(trackingPayload);
+    }
+
+    protocol->sendPacket(trackingPacket);
+  }
+
+  auto offset = random.range(75, 500);
+  m_nextAllowedTrackingTimeMs =
+      ms + offset + floor((protocol->neighborTable().size() / 10.0f + 1) + 5000);
+}
+
+const FANET::Protocol::Stats FanetRadio::getStats() const {
+  if (state != FanetRadioState::RUNNING) return {};
+
+  LockGuard lock(x_fanet_manager_mutex);
+  if (!lock) return {};
+  return protocol->stats();
+}
+
+const FanetNeighbors::NeighborMap& FanetRadio::getNeighborTable() const {
+  if (state != FanetRadioState::RUNNING || x_fanet_manager_mutex == nullptr) {
+    return neighbors.get();
+  }
+  LockGuard lock(x_fanet_manager_mutex);
+  return neighbors.get();
+}
+
+void FanetRadio::on_receive(const GpsReading& msg) {
+  if (state != FanetRadioState::RUNNING) return;
+
+  // The TX task: the device wakes it at least every couple of seconds to send what is queued
+  if (LockGuard lock{x_fanet_manager_mutex}) protocol->handleTx();
+
+  if (!msg.gps.location.isValid()) return;
+  if (trackingMode.has_value() == false && flightTimer_isRunning() == false) return;
+
+  GpsFix gps = msg.gps;  // Needed as lat() calls are not const
+  float climbRate = 0;
+  if (baro.climbRateFilteredValid()) {
+    climbRate = baro.climbRateFiltered() / 100.0f;
+  }
+  setCurrentLocation(gps.location.lat(), gps.location.lng(), gps.altitude.meters(),
+                     gps.course.deg(), climbRate, gps.speed.kmph());
+}
+
+String FanetRadio::getAddress() {
+  if (settings.fanet_address.isEmpty()) {
+    // 0xFB and the last two bytes of the MAC, as on the device
+    uint8_t mac[6];
+    esp_efuse_mac_get_default(mac);
+    String ret = "FB";
+    ret += String(mac[4] < 16 ? "0" : "") + String(mac[4], HEX);
+    ret += String(mac[5] < 16 ? "0" : "") + String(mac[5], HEX);
+    ret.toUpperCase();
+    settings.fanet_address = ret;
+    return ret;
+  }
+  return settings.fanet_address;
+}
+
+void FanetRadio::setGroundTrackingMode(const FANET::GroundTrackingPayload::TrackingType& mode) {
+  if (state != FanetRadioState::RUNNING) return;
+  LockGuard lock(x_fanet_manager_mutex);
+  trackingMode =
+      etl::optional<FANET::GroundTrackingPayload::TrackingType::enum_type>(mode.get_enum());
+}
+
+String FanetAddressToString(FANET::Address address) {
+  char buffer[7];
+  snprintf(buffer, sizeof(buffer), "%02X%02X%02X", address.manufacturer(), address.unique() << 8,
+           address.unique() | 0xFF);
+  buffer[6] = '\0';
+  auto ret = String(buffer);
+  ret.toUpperCase();
+  return ret;
+}
+
+#endif
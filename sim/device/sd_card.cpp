@@ -11,11 +11,15 @@
 
 #include <Arduino.h>
 #include <SD_MMC.h>
+#include <unistd.h>
 
 #include "hardware/configuration.h"
 #include "hardware/io_pins.h"
 #include "logging/log.h"
+#include "storage/preallocated_file.h"
+#include "storage/sd_latency.h"
 #include "storage/sd_card.h"
+#include "ui/audio/vario_tones.h"
 
 SDCard sdcard;
 
@@ -34,7 +38,13 @@ bool SDCard::mount() {
     return false;
   }
   mounted_ = SD_MMC.begin();
+  if (mounted_) mountGeneration_.fetch_add(1, std::memory_order_acq_rel);
   Serial.printf("SD card: %s\n", mounted_ ? "mounted" : "mount failed");
+  if (mounted_) {
+    PreallocatedFile::recoverInterrupted();
+    sd_latency::runMountBenchmark();
+    vario_tones::loadFromSd();
+  }
   return mounted_;
 }
 
@@ -71,6 +81,21 @@ SDCard::FormatResult SDCard::remountAfterFormat() { return formatDetailed(); }
 
 bool SDCard::setLabel() { return true; }
 
+// A host file has no clusters to reserve.  Sizing it up front still gives the firmware what the
+// card does: a file as long as its reservation until it is cut back.
+bool SDCard::createContiguousFile(const char* path, uint32_t size) {
+  if (!mounted_ || SD_MMC.exists(path)) return false;
+  File file = SD_MMC.open(path, "w", true);
+  if (!file) return false;
+  file.close();
+  return truncate(SD_MMC.hostPath(path).c_str(), size) == 0;
+}
+
+bool SDCard::truncateFile(const char* path, uint32_t length) {
+  if (!mounted_) return false;
+  return truncate(SD_MMC.hostPath(path).c_str(), length) == 0;
+}
+
 // There is no USB host in the emulator, so the card is never actually handed off: these keep the
 // real contract's return values and ownership bookkeeping, but ownership never leaves the
 // firmware.
@@ -106,6 +131,10 @@ bool SDCard::beginHostIo() { return false; }
 
 void SDCard::endHostIo() {}
 
+bool SDCard::beginFirmwareIo() { return firmwareCanAccessFilesystem(); }
+
+void SDCard::endFirmwareIo() {}
+
 int32_t SDCard::readHostSectors(uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
   (void)lba;
   (void)offset;
@@ -0,0 +1,236 @@
+#include "fanet_swarm.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+
+namespace sim {
+
+  namespace {
+    constexpr double RADIANS_PER_DEGREE = M_PI / 180.0;
+    constexpr double METRES_PER_DEGREE_LAT = 111320.0;
+
+    // The swarm is flown in half-second steps; frames go out at their own millisecond
+    constexpr uint32_t STEP_MS = 500;
+
+    // Paraglider polar, roughly: circling and gliding airspeed, and sink on glide
+    constexpr double CIRCLING_AIRSPEED = 9.5;
+    constexpr double GLIDING_AIRSPEED = 11.0;
+    constexpr double GLIDING_SINK = 1.2;
+    // Climbs stop this far above the start, which is where the thermals top out
+    constexpr double CLOUDBASE_ABOVE_START = 800;
+
+    // Radio: 14 dBm, the EU limit most trackers transmit at, over a log-distance path (free space
+    // at 1 m for 868 MHz, then a little worse than free space, air to air), into a 250 kHz
+    // channel's noise floor.  The SNR a LoRa receiver reports saturates around +10 dB.
+    constexpr double TX_POWER_DBM = 14;
+    constexpr double PATH_LOSS_AT_1M_DB = 31;
+    constexpr double PATH_LOSS_EXPONENT = 2.3;
+    constexpr double RSSI_SPREAD_DB = 3;
+    constexpr double NOISE_FLOOR_DBM = -114;
+    constexpr double MAX_SNR_DB = 10;
+
+    // FANET: "unregistered devices" manufacturer, and the tracking payload's scale factors
+    constexpr uint8_t MANUFACTURER = 0xFC;
+    constexpr uint8_t TYPE_TRACKING = 1;
+    constexpr uint8_t AIRCRAFT_PARAGLIDER = 1;
+    constexpr double LATITUDE_SCALE = 93206;
+    constexpr double LONGITUDE_SCALE = 46603;
+
+    struct Thermal {
+      double east, north;  // m from the start, at scenario time zero
+      double climb;        // m/s, net of the glider's own sink
+    };
+
+    struct Glider {
+      uint16_t id;
+      double east, north, altitude;
+      double velocityEast, velocityNorth, climb;
+      int thermal;  // Circling in, or gliding towards
+      bool circling;
+      double angle, radius, omega;  // Around the thermal's centre
+      double leaveS;
+      uint32_t nextSendMs;
+    };
+
+    void put24(std::vector<uint8_t>& out, int32_t value) {
+      out.push_back(value & 0xFF);
+      out.push_back((value >> 8) & 0xFF);
+      out.push_back((value >> 16) & 0xFF);
+    }
+
+    // A FANET type 1 (tracking) frame, without extended header, as the spec lays it out
+    std::vector<uint8_t> trackingFrame(const Glider& g, double lat, double lon) {
+      std::vector<uint8_t> frame;
+      frame.reserve(15);
+      frame.push_back(TYPE_TRACKING);
+      frame.push_back(MANUFACTURER);
+      frame.push_back(g.id & 0xFF);
+      frame.push_back(g.id >> 8);
+
+      put24(frame, (int32_t)lround(lat * LATITUDE_SCALE));
+      put24(frame, (int32_t)lround(lon * LONGITUDE_SCALE));
+
+      // Online tracking, aircraft type, and altitude in metres, or in 4 m steps above 2047 m
+      long altitude = std::min(std::max(lround(g.altitude), 0L), 8188L);
+      uint16_t status = 0x8000 | AIRCRAFT_PARAGLIDER << 12;
+      status |= altitude > 0x7FF ? 0x0800 | (uint16_t)(altitude / 4) : (uint16_t)altitude;
+      frame.push_back(status & 0xFF);
+      frame.push_back(status >> 8);
+
+      // Speed in 0.5 km/h, or in 2.5 km/h steps past 63.5 km/h
+      const double speedKmh = hypot(g.velocityEast, g.velocityNorth) * 3.6;
+      long speed = lround(speedKmh * 2);
+      frame.push_back(speed > 0x7F ? 0x80 | (uint8_t)std::min(lround(speed / 5.0), 0x7FL)
+                                   : (uint8_t)speed);
+
+      // Climb in 0.1 m/s, or in 0.5 m/s steps past +-6.3 m/s, two's complement in 7 bits
+      long climb = lround(g.climb * 10);
+      if (climb < -64 || climb > 63) {
+        climb = std::min(std::max(lround(g.climb * 2), -64L), 63L);
+        frame.push_back(0x80 | (climb & 0x7F));
+      } else {
+        frame.push_back(climb & 0x7F);
+      }
+
+      double track = atan2(g.velocityEast, g.velocityNorth) / RADIANS_PER_DEGREE;
+      if (track < 0) track += 360;
+      frame.push_back((uint8_t)(lround(track * 256 / 360) & 0xFF));
+      return frame;
+    }
+  }  // namespace
+
+  std::vector<FanetFrame> generateFanetSwarm(const FanetSwarmConfig& config,
+                                             const std::vector<Scenario::TrackPoint>& own) {
+    std::vector<FanetFrame> frames;
+    if (own.empty() || config.aircraft <= 0) return frames;
+
+    std::mt19937 random(config.seed);
+    auto uniform = [&](double lo, double hi) {
+      return std::uniform_real_distribution<double>(lo, hi)(random);
+    };
+    std::normal_distribution<double> fading(0, RSSI_SPREAD_DB);
+
+    // Everything is flown in metres from where we start
+    const double originLat = own.front().latitude;
+    const double originLon = own.front().longitude;
+    const double metresPerDegreeLon = METRES_PER_DEGREE_LAT * cos(originLat * RADIANS_PER_DEGREE);
+    const double cloudbase = own.front().altitudeM + CLOUDBASE_ABOVE_START;
+
+    std::vector<Thermal> thermals(std::max(config.thermals, 1));
+    for (Thermal& t : thermals) {
+      const double bearing = uniform(0, 2 * M_PI);
+      const double distance = config.radiusM * sqrt(uniform(0, 1));
+      t.east = distance * sin(bearing);
+      t.north = distance * cos(bearing);
+      t.climb = uniform(1, 3.5);
+    }
+    auto centreOf = [&](int thermal, double atS, double& east, double& north) {
+      east = thermals[thermal].east + config.windEast * atS;
+      north = thermals[thermal].north + config.windNorth * atS;
+    };
+
+    const uint32_t intervalMs = (uint32_t)(std::max(config.intervalS, 1.0) * 1000);
+    std::vector<Glider> gliders(config.aircraft);
+    for (size_t i = 0; i < gliders.size(); i++) {
+      Glider& g = gliders[i];
+      g = {};
+      g.id = (uint16_t)(i + 1);
+      g.thermal = (int)(random() % thermals.size());
+      g.circling = uniform(0, 1) < 0.7;
+      g.radius = uniform(35, 70);
+      g.omega = (uniform(0, 1) < 0.5 ? 1 : -1) * CIRCLING_AIRSPEED / g.radius;
+      g.angle = uniform(0, 2 * M_PI);
+      g.leaveS = uniform(30, 300);
+      g.altitude = own.front().altitudeM + uniform(-300, 300);
+      double east, north;
+      centreOf(g.thermal, 0, east, north);
+      if (g.circling) {
+        g.east = east + g.radius * sin(g.angle);
+        g.north = north + g.radius * cos(g.angle);
+      } else {
+        const double bearing = uniform(0, 2 * M_PI);
+        g.east = east + uniform(300, 1500) * sin(bearing);
+        g.north = north + uniform(300, 1500) * cos(bearing);
+      }
+      g.nextSendMs = (uint32_t)uniform(0, intervalMs);
+    }
+
+    const uint32_t lengthMs = (uint32_t)(own.back().atS * 1000);
+    const double dt = STEP_MS / 1000.0;
+    size_t ownIndex = 0;
+    for (uint32_t atMs = 0; atMs <= lengthMs; atMs += STEP_MS) {
+      const double atS = atMs / 1000.0;
+      while (ownIndex + 1 < own.size() && own[ownIndex + 1].atS <= atS) ownIndex++;
+      const Scenario::TrackPoint& us = own[ownIndex];
+      const double usEast = (us.longitude - originLon) * metresPerDegreeLon;
+      const double usNorth = (us.latitude - originLat) * METRES_PER_DEGREE_LAT;
+
+      for (Glider& g : gliders) {
+        double centreEast, centreNorth;
+        centreOf(g.thermal, atS, centreEast, centreNorth);
+        if (g.circling) {
+          g.angle += g.omega * dt;
+          const double east = centreEast + g.radius * sin(g.angle);
+          const double north = centreNorth + g.radius * cos(g.angle);
+          g.velocityEast = (east - g.east) / dt;
+          g.velocityNorth = (north - g.north) / dt;
+          g.east = east;
+          g.north = north;
+          g.climb = g.altitude < cloudbase ? thermals[g.thermal].climb : 0;
+
+          // Off to the next thermal when this one tops out or we have had enough of it
+          if (g.altitude >= cloudbase || atS >= g.leaveS) {
+            g.circling = false;
+            if (thermals.size() > 1) {
+              g.thermal = (g.thermal + 1 + random() % (thermals.size() - 1)) % thermals.size();
+            }
+          }
+        } else {
+          const double toEast = centreEast - g.east;
+          const double toNorth = centreNorth - g.north;
+          const double distance = hypot(toEast, toNorth);
+          g.velocityEast = GLIDING_AIRSPEED * toEast / std::max(distance, 1.0) + config.windEast;
+          g.velocityNorth = GLIDING_AIRSPEED * toNorth / std::max(distance, 1.0) + config.windNorth;
+          g.east += g.velocityEast * dt;
+          g.north += g.velocityNorth * dt;
+          g.climb = -GLIDING_SINK;
+
+          if (distance <= g.radius) {
+            g.circling = true;
+            g.angle = atan2(g.east - centreEast, g.north - centreNorth);
+            g.leaveS = atS + uniform(60, 300);
+          }
+        }
+        g.altitude += g.climb * dt;
+
+        while (g.nextSendMs <= atMs + STEP_MS && g.nextSendMs <= lengthMs) {
+          FanetFrame frame;
+          frame.atMs = g.nextSendMs;
+          frame.bytes = trackingFrame(g, originLat + g.north / METRES_PER_DEGREE_LAT,
+                                      originLon + g.east / metresPerDegreeLon);
+
+          const double distance =
+              std::max(sqrt(pow(g.east - usEast, 2) + pow(g.north - usNorth, 2) +
+                            pow(g.altitude - us.altitudeM, 2)),
+                       1.0);
+          frame.rssi = (float)(TX_POWER_DBM - PATH_LOSS_AT_1M_DB -
+                               10 * PATH_LOSS_EXPONENT * log10(distance) + fading(random));
+          frame.snr = (float)std::min(frame.rssi - NOISE_FLOOR_DBM, MAX_SNR_DB);
+          frame.lost =
+              frame.rssi < config.sensitivityDbm || uniform(0, 100) < config.lossPercent;
+          frames.push_back(std::move(frame));
+
+          // The firmware's own interval, splay included
+          g.nextSendMs += intervalMs + (uint32_t)uniform(75, 500);
+        }
+      }
+    }
+
+    std::stable_sort(frames.begin(), frames.end(),
+                     [](const FanetFrame& a, const FanetFrame& b) { return a.atMs < b.atMs; });
+    return frames;
+  }
+
+}  // namespace sim
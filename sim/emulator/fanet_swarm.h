@@ -0,0 +1,43 @@
+// Synthetic FANET traffic: a swarm of gliders sharing a scenario's sky.
+//
+// A synthetic scenario's optional "fanet" block describes the swarm (every field has a default):
+//
+//   "fanet": { "aircraft": 100, "seed": 1, "radiusM": 2000, "thermals": 4, "intervalS": 5,
+//              "lossPercent": 10, "sensitivityDbm": -120 }
+//
+// Each aircraft climbs in circles in one of the thermals until it nears cloudbase or tires of it,
+// then glides to another, all drifting with the scenario's wind.  Every intervalS, plus the
+// firmware's own 75-500 ms of splay, it transmits a FANET tracking frame encoded as the protocol
+// specifies.  Each frame is given the RSSI a log-distance path loss model puts on it at our
+// position at that moment, and is lost below sensitivity or at random with lossPercent.
+//
+// The swarm is generated whole at load time from the seed, so a run is repeatable and seeking
+// moves through the traffic the same way it moves through the rest of the recording.
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "scenario.h"
+#include "sim/fanet_air.h"
+
+namespace sim {
+
+  struct FanetSwarmConfig {
+    int aircraft = 50;
+    uint32_t seed = 1;
+    double radiusM = 2000;  // Thermals are scattered this far around the start
+    int thermals = 4;
+    double intervalS = 5;     // Between tracking frames, as FANET recommends with few neighbours
+    double lossPercent = 10;  // Frames lost at random, on top of those below sensitivity
+    double sensitivityDbm = -120;
+    double windNorth = 0;  // m/s the air mass moves
+    double windEast = 0;
+  };
+
+  // Every frame the swarm sends while we fly `own`, in time order.
+  std::vector<FanetFrame> generateFanetSwarm(const FanetSwarmConfig& config,
+                                             const std::vector<Scenario::TrackPoint>& own);
+
+}  // namespace sim
@@ -18,6 +18,7 @@
 #include "scenario.h"
 #include "sim/board.h"
 #include "sim/clock.h"
+#include "ui/audio/vario_tones.h"
 
 namespace sim {
 
@@ -157,6 +158,17 @@ namespace sim {
           << ",\"scenario\":{\"name\":\"" << jsonEscape(s.scenarioName)
           << "\",\"positionS\":" << s.scenarioPositionS << ",\"lengthS\":" << s.scenarioLengthS
           << ",\"playing\":" << (s.scenarioPlaying ? "true" : "false") << "}";
+      out << ",\"tasks\":[";
+      for (size_t i = 0; i < s.tasks.size(); i++) {
+        const Status::TaskTiming& t = s.tasks[i];
+        out << (i ? "," : "") << "{\"name\":\"" << jsonEscape(t.name) << "\",\"core\":\"" << t.core
+            << "\",\"runs\":" << t.runs
+            << ",\"budgetUs\":" << t.budgetUs << ",\"averageUs\":" << t.averageUs
+            << ",\"maxUs\":" << t.maxUs << ",\"overBudget\":" << t.overBudget
+            << ",\"deadlineMisses\":" << t.deadlineMisses << ",\"maxJitterUs\":" << t.maxJitterUs
+            << "}";
+      }
+      out << "]";
       out << "}";
       return out.str();
     }
@@ -464,6 +476,26 @@ namespace sim {
         return;
       }
 
+      if (path == "/api/tones") {
+        // Try a tone curve without writing it to the card; no points goes back to the built-in
+        // tones.  The panel's audio plays the result.
+        if (request["points"].as<JsonArrayConst>().size() == 0) {
+          device.post([] { vario_tones::useDefault(); });
+          sendJson(client, "{\"ok\":true}");
+          return;
+        }
+        vario_tones::Curve curve;
+        String error;
+        if (!request["schema"].is<const char*>()) request["schema"] = "leaf.tones";
+        if (!vario_tones::parse(request.as<JsonVariantConst>(), curve, error)) {
+          sendJson(client, "{\"ok\":false,\"error\":\"" + jsonEscape(error.c_str()) + "\"}");
+          return;
+        }
+        device.post([curve] { vario_tones::use(curve); });
+        sendJson(client, "{\"ok\":true}");
+        return;
+      }
+
       if (path == "/api/restart") {
         device.post([&device] { device.restart(); });
         sendJson(client, "{\"ok\":true}");
@@ -15,14 +15,25 @@
 #include <string>
 #include <vector>
 
+#include "comms/ble.h"
 #include "dispatch/message_bus.h"
+#include "hardware/configuration.h"
 #include "http_server.h"
 #include "runtime.h"
 #include "scenario.h"
 #include "script.h"
+#include "sim/ble_link.h"
 #include "sim/clock.h"
+#include "sim/fanet_air.h"
+#include "task_schedule.h"
+#include "tone_report.h"
+#include "ui/audio/dynamic_effects.h"
 #include "ui/settings/settings.h"
 
+#ifdef FANET_CAPABLE
+#include "comms/fanet_radio.h"
+#endif
+
 // The firmware's message bus, defined in src/vario/main.cpp.
 extern MessageBus<11> bus;
 
@@ -44,17 +55,83 @@ namespace {
         "  --charge-mode       boot as if plugged in without the power button held\n"
         "  --accept-warning    answer the safety disclaimer (presses DOWN then CENTER for you)\n"
         "  --setting KEY=VALUE set a saved setting before boot, e.g. LAB_THERM_TRACK=1\n"
-        "                      (repeatable; keys are the NVS keys in ui/settings/settings.cpp)\n"
+        "                      (repeatable; keys are LEGACY_KEYS in ui/settings/settings.cpp)\n"
+        "  --gps-rate HZ       synthesise GPS fixes from .igc and .json scenarios at 1, 5 or\n"
+        "                      10Hz, and set the firmware's GPS rate to match\n"
         "  --script FILE       run a timed script of button presses and assertions\n"
         "  --run-seconds N     run for N seconds of device time, then exit (headless runs)\n"
         "  --screenshot FILE   write a PNG of the screen before exiting\n"
         "  --export-log FILE   write the loaded scenario out as a device-format bus log\n"
+        "  --tone-report       after a headless run, report how far the speaker's tone changes\n"
+        "                      strayed from the audio sequencer's 40 ms note grid\n"
+        "  --task-report       after a headless run, report each main loop task's host run time\n"
+        "                      against its budget, and its deadline misses and jitter\n"
+        "  --fanet-report      after a headless run, report the scenario's FANET traffic: frames\n"
+        "                      sent, lost and received, and the host time each received one cost\n"
+        "  --ble-port N        turn Bluetooth on and serve its NMEA stream to a TCP client on\n"
+        "                      port N, as a flight app would receive it over the air\n"
+        "  --ble-mtu N         ATT_MTU the central negotiates after connecting (default 247)\n"
+        "  --ble-interval MS   connection interval (default 30)\n"
+        "  --ble-log FILE      record every notification the central receives, with its time\n"
+        "  --ble-report        after a headless run, report the Bluetooth stream's notifications,\n"
+        "                      throughput and data age in device time; without --ble-port a\n"
+        "                      virtual central connects and reads it\n"
         "  --scale N           screenshot scale factor (default 3)\n"
         "  --help\n");
   }
 
   bool argMatches(const char* arg, const char* name) { return strcmp(arg, name) == 0; }
 
+  // Run times are host time (see ESP.getCycleCount() in sim/hal), so they say which tasks are
+  // expensive relative to each other, not what they cost on the device.
+  void printTaskReport() {
+    printf("leafsim: task report (host us)\n");
+    printf("  %-16s %-8s %8s %8s %8s %8s %8s %8s %8s\n", "task", "core", "runs", "budget", "avg",
+           "max", "over", "missed", "jit_max");
+    for (uint8_t i = 0; i < task_schedule::taskCount(); i++) {
+      const task_schedule::Task& task = task_schedule::task(i);
+      const task_schedule::Stats& stats = task_schedule::stats(i);
+      printf("  %-16s %-8s %8u %8u %8u %8u %8u %8u %8u\n", task.name,
+             task_schedule::coreName(task.core), stats.runs, task.budgetUs,
+             task_schedule::averageUs(stats), stats.maxUs, stats.overBudget, stats.deadlineMisses,
+             stats.maxJitterUs);
+    }
+  }
+
+  void printFanetReport() {
+    const sim::FanetAir::Stats stats = sim::fanetAir().stats();
+    printf("leafsim: FANET report (host us)\n");
+    printf("  aircraft %d, frames sent %u, lost %u, unheard %u, received %u, transmitted %u\n",
+           sim::scenario().state().fanetAircraft, stats.sent, stats.lost, stats.unheard,
+           stats.received, stats.transmitted);
+    printf("  per received frame: avg %.1f, max %.1f\n",
+           stats.received ? stats.receiveNs / 1000.0 / stats.received : 0.0,
+           stats.maxReceiveNs / 1000.0);
+#ifdef FANET_CAPABLE
+    const fanet_traffic::Report threat = fanetRadio.getTrafficThreat();
+    printf("  neighbours %zu, highest alarm %d\n", fanetRadio.getNeighborTable().size(),
+           (int)threat.alarm);
+#endif
+  }
+
+  // Device time throughout: the link paces notifications on the virtual clock
+  void printBleReport() {
+    const sim::BleLink::Stats stats = sim::bleLink().stats();
+    const sim::BleLink::Config& config = sim::bleLink().config();
+    const double seconds = stats.delivered ? (stats.lastMs - stats.firstMs) / 1000.0 : 0;
+    printf("leafsim: BLE report (device ms)\n");
+    printf("  MTU %u, interval %u ms, connections %u\n", config.mtu, config.intervalMs,
+           stats.connections);
+    printf("  notifications %u, refused %u, delivered %u, most buffered %u\n", stats.notifications,
+           stats.refused, stats.delivered, stats.maxBuffered);
+    printf("  %.1f notify/s, %.0f bytes/s\n", seconds > 0 ? stats.delivered / seconds : 0.0,
+           seconds > 0 ? stats.bytes / seconds : 0.0);
+    printf("  sentences %u: LK8EX1 %u, GGA %u, RMC %u, PFLAA %u\n", stats.sentences, stats.lk8ex1,
+           stats.gga, stats.rmc, stats.pflaa);
+    printf("  data age at delivery: avg %.1f, max %u\n",
+           stats.delivered ? stats.ageMsTotal / (double)stats.delivered : 0.0, stats.ageMsMax);
+  }
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -69,6 +146,11 @@ int main(int argc, char** argv) {
   std::string exportPath;
   std::vector<std::string> presetSettings;
   bool autoPlay = false;
+  bool toneReport = false;
+  bool taskReport = false;
+  bool fanetReport = false;
+  bool bleReport = false;
+  sim::BleLink::Config ble;
   double runSeconds = 0;
   int scale = 3;
 
@@ -109,6 +191,13 @@ int main(int argc, char** argv) {
     } else if (argMatches(arg, "--setting") && next) {
       presetSettings.push_back(next);
       i++;
+    } else if (argMatches(arg, "--gps-rate") && next) {
+      if (!sim::scenario().setGpsRate(atoi(next))) {
+        printf("leafsim: --gps-rate wants 1, 5 or 10, got '%s'\n", next);
+        return 2;
+      }
+      presetSettings.push_back(std::string("lGpsRateHz=") + next);
+      i++;
     } else if (argMatches(arg, "--script") && next) {
       scriptPath = next;
       i++;
@@ -121,6 +210,31 @@ int main(int argc, char** argv) {
     } else if (argMatches(arg, "--export-log") && next) {
       exportPath = next;
       i++;
+    } else if (argMatches(arg, "--tone-report")) {
+      toneReport = true;
+    } else if (argMatches(arg, "--task-report")) {
+      taskReport = true;
+    } else if (argMatches(arg, "--fanet-report")) {
+      fanetReport = true;
+    } else if (argMatches(arg, "--ble-port") && next) {
+      ble.enabled = true;
+      ble.port = atoi(next);
+      i++;
+    } else if (argMatches(arg, "--ble-mtu") && next) {
+      ble.enabled = true;
+      ble.mtu = (uint16_t)atoi(next);
+      i++;
+    } else if (argMatches(arg, "--ble-interval") && next) {
+      ble.enabled = true;
+      ble.intervalMs = (uint32_t)atoi(next);
+      i++;
+    } else if (argMatches(arg, "--ble-log") && next) {
+      ble.enabled = true;
+      ble.logPath = next;
+      i++;
+    } else if (argMatches(arg, "--ble-report")) {
+      ble.enabled = true;
+      bleReport = true;
     } else if (argMatches(arg, "--scale") && next) {
       scale = atoi(next);
       i++;
@@ -141,14 +255,23 @@ int main(int argc, char** argv) {
   sim::Runtime& device = sim::runtime();
   device.configure(options);
 
+  // Before boot: the firmware sets Bluetooth up during setup() if it was left on
+  {
+    std::string error;
+    if (!sim::bleLink().configure(ble, error)) {
+      printf("leafsim: %s\n", error.c_str());
+      return 1;
+    }
+    if (ble.port >= 0) printf("leafsim: BLE NMEA stream on tcp port %d\n", ble.port);
+  }
+
   printf("leafsim: booting the Leaf firmware on a virtual board\n");
   device.boot();
 
-  // Presets are applied after boot, not before.  On a store it has never seen, the firmware writes
-  // its whole default set during setup(), and several settings are read back with no fallback
-  // (Settings::retrieve calls getBool("AUTO_START") and friends), so a value written beforehand is
-  // either overwritten or leaves its neighbours reading as false.  Writing afterwards and asking
-  // the firmware to re-read is what a user changing settings in the menus does.
+  // Presets are applied after boot, not before: on a store it has never seen, the firmware writes
+  // its whole default set during setup(), over anything written beforehand.  They go in under the
+  // per-setting keys the firmware stored before it kept one record, and the firmware imports them
+  // into the record as it does when upgrading from that layout.
   if (!presetSettings.empty()) {
     Preferences preferences;
     preferences.begin("varioPrefs", false);
@@ -164,7 +287,14 @@ int main(int argc, char** argv) {
       printf("leafsim: setting %s = %s\n", key.c_str(), value.c_str());
     }
     preferences.end();
-    settings.retrieve();
+    settings.importKeys();
+  }
+
+  // A --ble option turns Bluetooth on as the menu does, for this run only
+  if (sim::bleLink().enabled() && !BLE::get().isStarted()) {
+    settings.system_bluetoothOn = true;
+    BLE::get().setup();
+    BLE::get().start();
   }
 
   // Injected sensor data goes onto the firmware's own message bus, through the same parser the
@@ -206,9 +336,18 @@ int main(int argc, char** argv) {
   }
 
   if (runSeconds > 0) {
+    sim::ToneReport tones(NOTE_DURATION_MS * 1000);
+    if (toneReport) tones.collect();
     const uint64_t until = sim::clock().nowUs() + (uint64_t)(runSeconds * 1000000.0);
-    while (sim::clock().nowUs() < until && !sim::script().quitRequested()) device.step();
+    while (sim::clock().nowUs() < until && !sim::script().quitRequested()) {
+      device.step();
+      if (toneReport) tones.collect();
+    }
     printf("leafsim: ran %.1fs of device time\n", runSeconds);
+    if (toneReport) tones.print();
+    if (taskReport) printTaskReport();
+    if (fanetReport) printFanetReport();
+    if (bleReport) printBleReport();
   } else {
     device.run();
   }
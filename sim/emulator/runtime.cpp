@@ -26,6 +26,7 @@
 #include "sim/board.h"
 #include "sim/clock.h"
 #include "storage/sd_card.h"
+#include "task_schedule.h"
 #include "ui/display/display.h"
 #include "utils/magic_enum.h"
 #include "wind_estimate/wind_estimate.h"
@@ -42,8 +43,9 @@ namespace sim {
 
   namespace {
 
-    // Virtual time granted per pass through loop().  The firmware's main loop polls flags set by
-    // a 10ms timer interrupt, so the quantum has to be well under that to keep the task schedule
+    // Virtual time granted per pass through loop().  The firmware's main loop waits for a 10ms
+    // timer interrupt, and here it returns to be granted more time rather than sleeping (see
+    // ulTaskNotifyTake), so the quantum has to be well under that to keep the task schedule
     // faithful; 200us gives 50 passes per task block.
     constexpr uint64_t LOOP_QUANTUM_US = 200;
 
@@ -216,6 +218,7 @@ namespace sim {
     if (!booted_) boot();
 
     loop();
+    Serial0.deliverReceived();
     drainCommands();
     if (options_.acceptWarning) answerWarningScreen();
     scenario().update(clock().millis());
@@ -417,6 +420,22 @@ namespace sim {
     s.toneHz = board().currentTone();
     s.volume = board().volume();
 
+    for (uint8_t i = 0; i < task_schedule::taskCount(); i++) {
+      const task_schedule::Task& task = task_schedule::task(i);
+      const task_schedule::Stats& stats = task_schedule::stats(i);
+      Status::TaskTiming timing;
+      timing.name = task.name;
+      timing.core = task_schedule::coreName(task.core);
+      timing.runs = stats.runs;
+      timing.budgetUs = task.budgetUs;
+      timing.averageUs = task_schedule::averageUs(stats);
+      timing.maxUs = stats.maxUs;
+      timing.overBudget = stats.overBudget;
+      timing.deadlineMisses = stats.deadlineMisses;
+      timing.maxJitterUs = stats.maxJitterUs;
+      s.tasks.push_back(std::move(timing));
+    }
+
     const Scenario::State scenarioState = scenario().state();
     s.scenarioName = scenarioState.name;
     s.scenarioPositionS = scenarioState.positionS;
@@ -65,6 +65,20 @@ namespace sim {
     uint32_t toneHz = 0;
     uint8_t volume = 0;
 
+    // Main loop task timings (task_schedule.h); run times are host time
+    struct TaskTiming {
+      std::string name;
+      std::string core;  // "realtime" or "service"
+      uint32_t runs = 0;
+      uint32_t budgetUs = 0;
+      uint32_t averageUs = 0;
+      uint32_t maxUs = 0;
+      uint32_t overBudget = 0;
+      uint32_t deadlineMisses = 0;
+      uint32_t maxJitterUs = 0;
+    };
+    std::vector<TaskTiming> tasks;
+
     std::string scenarioName;
     double scenarioPositionS = 0;
     double scenarioLengthS = 0;
@@ -9,8 +9,10 @@
 
 #include <algorithm>
 #include <fstream>
+#include <set>
 #include <sstream>
 
+#include "fanet_swarm.h"
 #include "sim/clock.h"
 
 namespace sim {
@@ -66,6 +68,7 @@ namespace sim {
       int hour = 12;
       int minute = 0;
       int second = 0;
+      int centisecond = 0;
       double latitude = 0;
       double longitude = 0;
       double gnssAltitudeM = 0;
@@ -74,17 +77,27 @@ namespace sim {
       uint8_t satellites = 8;
     };
 
+    void setTimeOfDay(Fix& fix, uint32_t msOfDay) {
+      msOfDay %= 86400000;
+      fix.hour = msOfDay / 3600000;
+      fix.minute = (msOfDay / 60000) % 60;
+      fix.second = (msOfDay / 1000) % 60;
+      fix.centisecond = (msOfDay / 10) % 100;
+    }
+
     // One fix, as the LC86G reports it.
     //
-    // The talker IDs matter: the firmware binds its fix-quality field to GNGGA and its fix mode to
-    // GNGSA (instruments/gps.cpp), because the receiver is multi-constellation and emits GN
-    // sentences.  Synthesising GP sentences instead parses as a position but never sets
-    // fixInfo.fix, and everything gated on hasUsableFix() -- glide ratio, average speed, distance
-    // flown, IGC logging, flight auto-start -- silently stays blank.  Satellites in view come from
-    // GPGSV, which keeps its GP talker on this receiver.
+    // The talker IDs are the receiver's: it is multi-constellation and emits GN sentences, except
+    // for GPGSV.  The firmware reads any talker (instruments/nmea.cpp), but the GGA fix quality
+    // matters: without it, everything gated on hasUsableFix() -- glide ratio, average speed,
+    // distance flown, IGC logging, flight auto-start -- silently stays blank.
+    //
+    // GGA and RMC go out with every fix, GSA and GSV only with the fix on each whole second: the
+    // output the firmware configures at any rate (LC86G::sendConfiguration).
     void appendFixSentences(const Fix& fix, std::vector<std::string>& lines) {
       char time[16];
-      snprintf(time, sizeof(time), "%02d%02d%02d.00", fix.hour, fix.minute, fix.second);
+      snprintf(time, sizeof(time), "%02d%02d%02d.%02d", fix.hour, fix.minute, fix.second,
+               fix.centisecond);
 
       char lat[16];
       char lon[16];
@@ -104,6 +117,7 @@ namespace sim {
       snprintf(rmc, sizeof(rmc), "GNRMC,%s,A,%s,%c,%s,%c,%.2f,%.2f,010125,,,A", time, lat,
                latHemisphere, lon, lonHemisphere, fix.speedKnots, fix.courseDeg);
       lines.push_back(nmeaChecksummed(rmc));
+      if (fix.centisecond != 0) return;
 
       // Fix mode 3 (3D), with the DOP values the firmware's accuracy display reads.
       lines.push_back(nmeaChecksummed("GNGSA,A,3,01,02,03,04,05,06,07,08,,,,,1.8,0.9,1.5"));
@@ -137,6 +151,7 @@ namespace sim {
     }
 
     constexpr int MOTION_HZ = 20;  // the rate the device's DMP is configured to produce
+    constexpr int PRESSURE_HZ = 4;
 
     constexpr double RADIANS_PER_DEGREE = M_PI / 180.0;
     constexpr double METRES_PER_DEGREE_LAT = 111320.0;
@@ -160,16 +175,23 @@ namespace sim {
 
   // ---------------------------------------------------------------- loading
 
+  bool Scenario::setGpsRate(int hz) {
+    if (hz != 1 && hz != 5 && hz != 10) return false;
+    gpsRateHz_ = hz;
+    return true;
+  }
+
   bool Scenario::load(const std::string& path, std::string& error) {
     const std::string ext = extensionOf(path);
     std::vector<Event> loaded;
+    std::vector<FanetFrame> air;
     bool ok = false;
     if (ext == "log" || ext == "txt") {
       ok = loadBusLog(path, loaded, error);
     } else if (ext == "igc") {
       ok = loadIgc(path, loaded, error);
     } else if (ext == "json") {
-      ok = loadSynthetic(path, loaded, error);
+      ok = loadSynthetic(path, loaded, air, error);
     } else {
       error = "unsupported recording type '." + ext + "' (expected .log, .igc or .json)";
       return false;
@@ -180,7 +202,7 @@ namespace sim {
       error = "recording contains no playable messages";
       return false;
     }
-    install(path, loaded);
+    install(path, loaded, air);
     return true;
   }
 
@@ -246,17 +268,26 @@ namespace sim {
     return track_;
   }
 
-  void Scenario::install(const std::string& path, std::vector<Event>& loaded) {
+  void Scenario::install(const std::string& path, std::vector<Event>& loaded,
+                         std::vector<FanetFrame>& air) {
     std::stable_sort(loaded.begin(), loaded.end(),
                      [](const Event& a, const Event& b) { return a.atMs < b.atMs; });
     std::vector<TrackPoint> track = extractTrack(loaded);
+    // One source address per aircraft in the swarm
+    std::set<uint32_t> aircraft;
+    for (const FanetFrame& frame : air) {
+      aircraft.insert(frame.bytes[1] | frame.bytes[2] << 8 | frame.bytes[3] << 16);
+    }
 
     std::lock_guard<std::mutex> lock(mutex_);
     events_.swap(loaded);
     track_.swap(track);
+    air_.swap(air);
+    fanetAircraft_ = (int)aircraft.size();
     name_ = baseNameOf(path);
     lengthMs_ = events_.empty() ? 0 : events_.back().atMs;
     nextIndex_ = 0;
+    nextFrame_ = 0;
     positionMs_ = 0;
     playing_ = false;
     originMs_ = clock().millis();
@@ -293,6 +324,7 @@ namespace sim {
     int firstSecondOfDay = 0;
     double previousLat = 0;
     double previousLon = 0;
+    double previousGnssAltitude = 0;
     int previousSecondOfDay = 0;
     int previousElapsedS = 0;
     // B records carry a time of day, not a date, so an evening flight that runs past midnight
@@ -324,6 +356,7 @@ namespace sim {
         firstSecondOfDay = secondOfDay;
         previousLat = latitude;
         previousLon = longitude;
+        previousGnssAltitude = gnssAltitude;
         previousSecondOfDay = secondOfDay;
       }
 
@@ -348,6 +381,25 @@ namespace sim {
         if (courseDeg < 0) courseDeg += 360.0;
       }
 
+      std::vector<Fix> fixes;
+
+      // Above 1Hz, the fixes between two B records are placed along the straight line joining
+      // them, at the speed and track that line implies
+      const int between = gpsRateHz_ > 1 && dt > 0 ? dt * gpsRateHz_ : 0;
+      for (int step = 1; step < between; step++) {
+        const uint32_t offsetMs = (uint32_t)step * 1000 / gpsRateHz_;
+        const double t = offsetMs / (dt * 1000.0);
+        Fix fix;
+        fix.atMs = previousElapsedS * 1000 + offsetMs;
+        setTimeOfDay(fix, previousSecondOfDay * 1000 + offsetMs);
+        fix.latitude = previousLat + (latitude - previousLat) * t;
+        fix.longitude = previousLon + (longitude - previousLon) * t;
+        fix.gnssAltitudeM = previousGnssAltitude + (gnssAltitude - previousGnssAltitude) * t;
+        fix.speedKnots = speedKnots;
+        fix.courseDeg = courseDeg;
+        fixes.push_back(fix);
+      }
+
       Fix fix;
       fix.atMs = atMs;
       fix.hour = hour;
@@ -358,11 +410,14 @@ namespace sim {
       fix.gnssAltitudeM = gnssAltitude;
       fix.speedKnots = speedKnots;
       fix.courseDeg = courseDeg;
+      fixes.push_back(fix);
 
-      std::vector<std::string> sentences;
-      appendFixSentences(fix, sentences);
-      for (const auto& sentence : sentences) {
-        into.push_back({atMs, "G" + std::to_string(atMs) + "," + sentence});
+      for (const Fix& each : fixes) {
+        std::vector<std::string> sentences;
+        appendFixSentences(each, sentences);
+        for (const auto& sentence : sentences) {
+          into.push_back({each.atMs, "G" + std::to_string(each.atMs) + "," + sentence});
+        }
       }
 
       // Pressure at 4Hz between fixes, interpolated from the tracklog's pressure altitude: the
@@ -384,6 +439,7 @@ namespace sim {
 
       previousLat = latitude;
       previousLon = longitude;
+      previousGnssAltitude = gnssAltitude;
       previousSecondOfDay = secondOfDay;
       previousElapsedS = elapsedS;
     }
@@ -396,7 +452,7 @@ namespace sim {
   }
 
   bool Scenario::loadSynthetic(const std::string& path, std::vector<Event>& into,
-                               std::string& error) {
+                               std::vector<FanetFrame>& air, std::string& error) {
     std::ifstream in(path);
     if (!in) {
       error = "cannot open " + path;
@@ -426,9 +482,14 @@ namespace sim {
     const double windFrom = doc["wind"]["fromDeg"] | 0.0;
 
     uint32_t atMs = 0;
-    int elapsedSeconds = 0;
+    int fixCount = 0;
     const int startHour = doc["start"]["hour"] | 12;
 
+    // The flight is integrated at 4Hz, matching the pressure rate, or at the IMU's rate when GPS
+    // fixes come faster than that
+    const int stepHz = gpsRateHz_ > 1 ? MOTION_HZ : PRESSURE_HZ;
+    const double dt = 1.0 / stepHz;
+
     JsonArray legs = doc["legs"].as<JsonArray>();
     if (legs.isNull() || legs.size() == 0) {
       error = "scenario has no legs";
@@ -452,9 +513,8 @@ namespace sim {
       const double turnRate = leg["turnRateDegPerS"] | 0.0;
       if (leg["headingDeg"].is<double>()) heading = leg["headingDeg"].as<double>();
 
-      const int steps = (int)(durationS * 4);  // 4Hz integration, matching the pressure rate
+      const int steps = (int)(durationS * stepHz);
       for (int step = 0; step < steps; step++) {
-        const double dt = 0.25;
         heading += turnRate * dt;
         while (heading >= 360.0) heading -= 360.0;
         while (heading < 0.0) heading += 360.0;
@@ -468,31 +528,31 @@ namespace sim {
             (groundEast * dt) / (METRES_PER_DEGREE_LAT * cos(latitude * RADIANS_PER_DEGREE));
         altitude += climbRate * dt;
 
-        char pressureLine[48];
-        snprintf(pressureLine, sizeof(pressureLine), "P%u,%d", atMs,
-                 pressureFromAltitude(altitude));
-        into.push_back({atMs, pressureLine});
+        if (step % (stepHz / PRESSURE_HZ) == 0) {
+          char pressureLine[48];
+          snprintf(pressureLine, sizeof(pressureLine), "P%u,%d", atMs,
+                   pressureFromAltitude(altitude));
+          into.push_back({atMs, pressureLine});
+        }
 
         // Motion at the IMU's own rate, carrying the vertical acceleration this step's change in
         // climb rate implies.  Constant-rate legs are 1g; the transitions between them are not.
         const double verticalAccelG = (climbRate - previousClimbRate) / (dt * 9.80665);
         previousClimbRate = climbRate;
-        for (int sub = 0; sub < MOTION_HZ / 4; sub++) {
+        for (int sub = 0; sub < MOTION_HZ / stepHz; sub++) {
           const uint32_t motionMs = atMs + (uint32_t)(sub * (1000 / MOTION_HZ));
           into.push_back({motionMs, motionLine(motionMs, sub == 0 ? verticalAccelG : 0.0)});
         }
 
-        // One GPS fix per second, as the receiver produces.
-        if (step % 4 == 0) {
+        // GPS fixes at the receiver's rate
+        if (step % (stepHz / gpsRateHz_) == 0) {
           const double groundSpeed = sqrt(groundNorth * groundNorth + groundEast * groundEast);
           double track = atan2(groundEast, groundNorth) / RADIANS_PER_DEGREE;
           if (track < 0) track += 360.0;
 
           Fix fix;
           fix.atMs = atMs;
-          fix.hour = (startHour + elapsedSeconds / 3600) % 24;
-          fix.minute = (elapsedSeconds / 60) % 60;
-          fix.second = elapsedSeconds % 60;
+          setTimeOfDay(fix, startHour * 3600000u + (uint32_t)fixCount * 1000 / gpsRateHz_);
           fix.latitude = latitude;
           fix.longitude = longitude;
           fix.gnssAltitudeM = altitude;
@@ -504,7 +564,7 @@ namespace sim {
           for (const auto& sentence : sentences) {
             into.push_back({atMs, "G" + std::to_string(atMs) + "," + sentence});
           }
-          elapsedSeconds++;
+          fixCount++;
         }
 
         // Ambient every 10 seconds, as the AHT20 task produces it.
@@ -514,10 +574,26 @@ namespace sim {
           into.push_back({atMs, ambientLine});
         }
 
-        atMs += 250;
+        atMs += 1000 / stepHz;
       }
     }
 
+    // Other aircraft, flown around the flight we have just built and in the same wind
+    JsonObject fanet = doc["fanet"].as<JsonObject>();
+    if (!fanet.isNull()) {
+      FanetSwarmConfig config;
+      config.aircraft = fanet["aircraft"] | config.aircraft;
+      config.seed = fanet["seed"] | config.seed;
+      config.radiusM = fanet["radiusM"] | config.radiusM;
+      config.thermals = fanet["thermals"] | config.thermals;
+      config.intervalS = fanet["intervalS"] | config.intervalS;
+      config.lossPercent = fanet["lossPercent"] | config.lossPercent;
+      config.sensitivityDbm = fanet["sensitivityDbm"] | config.sensitivityDbm;
+      config.windNorth = windNorth;
+      config.windEast = windEast;
+      air = generateFanetSwarm(config, extractTrack(into));
+    }
+
     return true;
   }
 
@@ -546,11 +622,14 @@ namespace sim {
     originMs_ = clock().millis() - positionMs_;
     nextIndex_ = 0;
     while (nextIndex_ < events_.size() && events_[nextIndex_].atMs < positionMs_) nextIndex_++;
+    nextFrame_ = 0;
+    while (nextFrame_ < air_.size() && air_[nextFrame_].atMs < positionMs_) nextFrame_++;
     injector_.resetReferenceTime();
   }
 
   void Scenario::update(uint32_t nowMs) {
     std::vector<std::string> due;
+    std::vector<FanetFrame> dueFrames;
     {
       std::lock_guard<std::mutex> lock(mutex_);
       if (!playing_ || events_.empty()) return;
@@ -560,6 +639,10 @@ namespace sim {
         due.push_back(events_[nextIndex_].line);
         nextIndex_++;
       }
+      while (nextFrame_ < air_.size() && air_[nextFrame_].atMs <= positionMs_) {
+        dueFrames.push_back(air_[nextFrame_]);
+        nextFrame_++;
+      }
       if (nextIndex_ >= events_.size()) playing_ = false;
     }
 
@@ -568,6 +651,7 @@ namespace sim {
     for (const std::string& line : due) {
       injector_.handleLine(line.c_str(), line.size());
     }
+    for (const FanetFrame& frame : dueFrames) fanetAir().send(frame);
   }
 
   Scenario::State Scenario::state() const {
@@ -577,6 +661,7 @@ namespace sim {
     s.positionS = positionMs_ / 1000.0;
     s.lengthS = lengthMs_ / 1000.0;
     s.playing = playing_;
+    s.fanetAircraft = fanetAircraft_;
     return s;
   }
 
@@ -7,7 +7,11 @@
 //
 //   *.log   device bus logs: real captured GPS, IMU, pressure and ambient data
 //   *.igc   flight tracklogs: GPS fixes and pressure altitude at 1Hz
-//   *.json  synthetic scenarios: hand-authored flights (climb, circle, glide, approach)
+//   *.json  synthetic scenarios: hand-authored flights (climb, circle, glide, approach), and
+//           optionally a swarm of FANET traffic around them (see fanet_swarm.h)
+//
+// IGC and synthetic flights are turned into NMEA at a GPS rate of 1Hz unless setGpsRate() asks
+// for more, which is how the firmware's 5 and 10Hz modes get exercised.
 #pragma once
 
 #include <stdint.h>
@@ -17,6 +21,7 @@
 #include <vector>
 
 #include "dispatch/message_injector.h"
+#include "sim/fanet_air.h"
 
 namespace sim {
 
@@ -37,11 +42,18 @@ namespace sim {
       double positionS = 0;
       double lengthS = 0;
       bool playing = false;
+      int fanetAircraft = 0;
     };
 
     void setBus(etl::imessage_bus* bus) { injector_.setBus(bus); }
     etl::imessage_bus* injectorBus() const { return injector_.bus(); }
 
+    // Position fixes per second synthesised by later loads: 1, 5 or 10, the rates the firmware
+    // can configure the receiver for.  Returns false, changing nothing, for any other rate.  Bus
+    // logs replay whatever the device recorded.
+    bool setGpsRate(int hz);
+    int gpsRate() const { return gpsRateHz_; }
+
     // Loads and normalises a recording.  Returns false and fills `error` if the file cannot be
     // read or contains nothing playable.
     bool load(const std::string& path, std::string& error);
@@ -56,13 +68,15 @@ namespace sim {
     // device -- a faithful scrub would mean rebooting and replaying to the requested time.
     void seek(double seconds);
 
-    // Called from the device loop: publishes everything due at the current device time.
+    // Called from the device loop: publishes everything due at the current device time, and puts
+    // any FANET frames due on the air.
     void update(uint32_t nowMs);
 
     State state() const;
 
     // Writes the normalised timeline as a .log, so a synthetic or IGC-derived scenario can be
-    // replayed against real hardware with sim/play_buslog.py.
+    // replayed against real hardware with sim/play_buslog.py.  FANET traffic has no bus-log line
+    // and is left out.
     bool exportLog(const std::string& path) const;
 
     // Recording files found in a directory, newest first.
@@ -81,8 +95,9 @@ namespace sim {
     // lock: loading happens on the HTTP thread while the device thread is playing the old one.
     bool loadBusLog(const std::string& path, std::vector<Event>& into, std::string& error);
     bool loadIgc(const std::string& path, std::vector<Event>& into, std::string& error);
-    bool loadSynthetic(const std::string& path, std::vector<Event>& into, std::string& error);
-    void install(const std::string& path, std::vector<Event>& loaded);
+    bool loadSynthetic(const std::string& path, std::vector<Event>& into,
+                       std::vector<FanetFrame>& air, std::string& error);
+    void install(const std::string& path, std::vector<Event>& loaded, std::vector<FanetFrame>& air);
 
     // Pulls the GGA sentences out of the normalised timeline into a flight path.
     static std::vector<TrackPoint> extractTrack(const std::vector<Event>& events);
@@ -92,11 +107,16 @@ namespace sim {
     std::vector<TrackPoint> track_;
     std::string name_;
     size_t nextIndex_ = 0;
+    // Frames the scenario's FANET swarm sends, in time order, on the same clock as events_
+    std::vector<FanetFrame> air_;
+    size_t nextFrame_ = 0;
+    int fanetAircraft_ = 0;
     bool playing_ = false;
     uint32_t lengthMs_ = 0;
     uint32_t positionMs_ = 0;
     // Device time corresponding to scenario time zero; shifted on seek and when paused.
     uint32_t originMs_ = 0;
+    int gpsRateHz_ = 1;
     MessageInjector injector_;
   };
 
@@ -0,0 +1,50 @@
+#include "tone_report.h"
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "sim/board.h"
+
+namespace sim {
+
+  constexpr uint32_t ToneReport::BUCKET_LIMITS_US[];
+
+  void ToneReport::collect() {
+    std::vector<ToneEvent> events;
+    if (!started_) {
+      // Tones are live events; anything before the report started is not part of it
+      cursor_ = board().toneEventCount();
+      started_ = true;
+      lastUs_ = 0;
+      return;
+    }
+    cursor_ = board().toneEventsSince(cursor_, events);
+
+    for (const ToneEvent& event : events) {
+      changes_++;
+      if (lastUs_ != 0) {
+        const uint64_t gapUs = event.atUs - lastUs_;
+        const uint32_t phaseUs = (uint32_t)(gapUs % stepUs_);
+        const uint32_t offUs = phaseUs < stepUs_ - phaseUs ? phaseUs : stepUs_ - phaseUs;
+        gaps_++;
+        totalOffUs_ += offUs;
+        if (offUs > maxOffUs_) maxOffUs_ = offUs;
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && offUs >= BUCKET_LIMITS_US[bucket]) bucket++;
+        buckets_[bucket]++;
+      }
+      lastUs_ = event.atUs;
+    }
+  }
+
+  void ToneReport::print() const {
+    printf("leafsim: tone timing: %u tone changes on a %.0f ms grid\n", changes_, stepUs_ / 1000.0);
+    if (gaps_ == 0) return;
+    printf("leafsim:   gaps off the grid: mean %.0f us, max %u us\n",
+           (double)totalOffUs_ / gaps_, maxOffUs_);
+    printf("leafsim:   < 100 us %u, < 1 ms %u, < 5 ms %u, >= 5 ms %u\n", buckets_[0],
+           buckets_[1], buckets_[2], buckets_[3]);
+  }
+
+}  // namespace sim
@@ -0,0 +1,40 @@
+// How steadily the speaker kept time during a headless run.
+//
+// The firmware's audio sequencer changes the tone only on its 40 ms note grid, so the gap between
+// any two tone changes should be a whole number of steps.  This follows the board's tone stream
+// and measures how far each gap strayed from that: a beep stretched by a busy main loop shows up
+// as a gap off the grid.
+#pragma once
+
+#include <stdint.h>
+
+namespace sim {
+
+  class ToneReport {
+   public:
+    explicit ToneReport(uint32_t stepUs) : stepUs_(stepUs) {}
+
+    // Takes in the tone changes since the last call.  Call at least every few hundred tone
+    // changes; the board only keeps a bounded tail of them.
+    void collect();
+
+    void print() const;
+
+   private:
+    // Bucket upper bounds, in microseconds off the grid; the last bucket has no bound
+    static constexpr uint32_t BUCKET_LIMITS_US[] = {100, 1000, 5000};
+    static constexpr int BUCKETS = 4;
+
+    uint32_t stepUs_;
+    uint64_t cursor_ = 0;
+    bool started_ = false;
+    uint64_t lastUs_ = 0;
+
+    uint32_t changes_ = 0;
+    uint32_t gaps_ = 0;
+    uint64_t totalOffUs_ = 0;
+    uint32_t maxOffUs_ = 0;
+    uint32_t buckets_[BUCKETS] = {};
+  };
+
+}  // namespace sim
@@ -17,6 +17,9 @@ class EspClass {
   uint32_t getFreeSketchSpace() const { return 3 * 1024 * 1024; }
   uint32_t getSketchSize() const { return 1500 * 1024; }
   uint32_t getCpuFreqMHz() const { return 240; }
+  // Counts host time at getCpuFreqMHz(), not virtual time: what the firmware times with it is the
+  // work the host did, which virtual time does not see
+  uint32_t getCycleCount() const;
   uint32_t getFlashChipSize() const { return 8 * 1024 * 1024; }
   const char* getChipModel() const { return "ESP32-S3 (emulated)"; }
   uint8_t getChipRevision() const { return 0; }
@@ -46,6 +46,7 @@ namespace fs {
     int read(uint8_t* buffer, size_t length);
     size_t readBytes(char* buffer, size_t length) override;
     void flush() override;
+    bool setBufferSize(size_t size);
 
     bool seek(uint32_t position);
     bool seek(uint32_t position, int mode);
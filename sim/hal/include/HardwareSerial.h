@@ -3,11 +3,13 @@
 // Serial is the device's debug console: it goes to stdout and into the emulator's serial ring
 // buffer so the browser panel can show it.  Serial0 is the GPS UART, wired to the virtual board's
 // GPS pipe -- recorded NMEA played into a scenario is read back by the real LC86G driver, byte by
-// byte, exactly as the receiver's own output would be.
+// byte, exactly as the receiver's own output would be.  As on the device, the driver is handed the
+// bytes by its onReceive callback rather than polling for them.
 #pragma once
 
 #include <stdint.h>
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -23,6 +25,16 @@ class HardwareSerial : public Stream {
     (void)txPin;
   }
   virtual void end() {}
+  // On the device the callback runs in the UART driver's event task when the RX FIFO fills or the
+  // line has been idle for the RX timeout
+  virtual void onReceive(std::function<void(void)> callback, bool onlyOnTimeout = false) {
+    (void)callback;
+    (void)onlyOnTimeout;
+  }
+  virtual bool setRxTimeout(uint8_t symbols) {
+    (void)symbols;
+    return true;
+  }
   void setRxBufferSize(size_t) {}
   void setTxBufferSize(size_t) {}
   void updateBaudRate(unsigned long) {}
@@ -61,6 +73,15 @@ class HostGpsSerial : public HardwareSerial {
   int read() override;
   int peek() override;
   void flush() override {}
+
+  void onReceive(std::function<void(void)> callback, bool onlyOnTimeout = false) override;
+
+  // Stands in for the UART driver's event task: runs the onReceive callback if bytes are waiting.
+  // The emulator calls this on the device thread after every pass through the loop.
+  void deliverReceived();
+
+ private:
+  std::function<void(void)> onReceive_;
 };
 
 #define SERIAL_8N1 0x800001c
@@ -1,5 +1,5 @@
-// NimBLE stand-in: the emulator has no Bluetooth radio, so comms/ble.cpp is replaced by a sim
-// implementation and only these type names are needed to compile comms/ble.h.
+// NimBLE stand-in: comms/ble.cpp is replaced by sim/device/ble.cpp, which carries the stream over
+// sim::bleLink() instead, so only these type names are needed to compile comms/ble.h.
 #pragma once
 
 #include <stdint.h>
@@ -49,6 +49,8 @@ class Preferences {
   double getDouble(const char* key, double defaultValue = NAN);
   bool getBool(const char* key, bool defaultValue = false);
   String getString(const char* key, const String& defaultValue = String());
+  size_t getBytesLength(const char* key);
+  // As on the device: 0, copying nothing, if the value is longer than maxLen
   size_t getBytes(const char* key, void* buf, size_t maxLen);
   size_t freeEntries() { return 1000; }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -18,6 +19,7 @@ size_t heap_caps_get_total_size(uint32_t caps);
 size_t heap_caps_get_minimum_free_size(uint32_t caps);
 void* heap_caps_malloc(size_t size, uint32_t caps);
 void heap_caps_free(void* ptr);
+bool heap_caps_check_integrity_all(bool print_errors);
 
 #ifdef __cplusplus
 }
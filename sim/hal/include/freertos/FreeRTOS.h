@@ -38,10 +38,10 @@ typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
 #define configMAX_PRIORITIES 25
 #define portYIELD_FROM_ISR(x) ((void)(x))
 #define taskYIELD() vPortYield()
-#define taskENTER_CRITICAL(mux) ((void)(mux))
-#define taskEXIT_CRITICAL(mux) ((void)(mux))
-#define portENTER_CRITICAL(mux) ((void)(mux))
-#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define taskENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
 #define eSetValueWithOverwrite 3
 #define eSetValueWithoutOverwrite 4
 #define eIncrement 1
@@ -49,12 +49,19 @@ typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
 
 typedef int eNotifyAction;
 
-// Critical sections have no meaning on the host's cooperative device thread, but the type and
-// initialiser have to exist for code that declares a spinlock.
-typedef int portMUX_TYPE;
-#define portMUX_INITIALIZER_UNLOCKED 0
+// Critical sections are spinlocks, as on the dual-core device: the device thread, the service task
+// and the display send task all run firmware code, and the last of those runs alongside the others.
+typedef struct {
+  int locked;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define tskNO_AFFINITY 0x7FFFFFFF
 
 void vPortYield(void);
+void vPortEnterCritical(portMUX_TYPE* mux);
+void vPortExitCritical(portMUX_TYPE* mux);
+// The core the calling task was pinned to; the device thread (the Arduino loop task) is core 1
+BaseType_t xPortGetCoreID(void);
 
 // ---------------------------------------------------------------- semaphores
 SemaphoreHandle_t xSemaphoreCreateMutex(void);
@@ -66,6 +73,7 @@ BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
 BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticksToWait);
 BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore);
 BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityTaskWoken);
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore);
 void vSemaphoreDelete(SemaphoreHandle_t semaphore);
 
 // ---------------------------------------------------------------- queues
@@ -95,6 +103,7 @@ const char* pcTaskGetName(TaskHandle_t task);
 BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
 BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
                               BaseType_t* woken);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
 uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
 BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value,
                            TickType_t ticksToWait);
@@ -0,0 +1,110 @@
+// The emulated Bluetooth link between the BLE stand-in in sim/device and a central.
+//
+// The central is a TCP client on --ble-port (a flight app that reads NMEA over TCP, or nc piping
+// into a recorder), or with no port a virtual one that connects as soon as the device advertises
+// and reads everything, so a headless run can measure the stream by itself.  Either way it
+// negotiates --ble-mtu shortly after connecting, as flight apps do.
+//
+// The link runs in device time.  A notification waits in the controller's buffer for the next
+// connection event, every intervalMs, and each event carries at most packetsPerEvent of them.
+// One that finds the buffer full is refused, which the firmware counts as a failed notify, as it
+// does when NimBLE runs out of buffers.  A TCP client that stops reading leaves notifications in
+// the buffer the same way.  Everything here is called from the device thread except stats().
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+  class BleLink {
+   public:
+    struct Config {
+      bool enabled = false;
+      int port = -1;  // TCP port a central connects on, or -1 for the virtual central
+      uint16_t mtu = 247;
+      uint32_t intervalMs = 30;  // Connection interval
+      uint8_t packetsPerEvent = 4;
+      uint8_t bufferedPackets = 12;  // Notifications the controller holds for the central
+      std::string logPath;           // Records every notification delivered, with its time
+    };
+
+    struct Stats {
+      uint32_t connections = 0;
+      uint32_t notifications = 0;  // Accepted into the buffer
+      uint32_t refused = 0;        // ...found it full
+      uint32_t delivered = 0;      // ...sent at a connection event
+      uint64_t bytes = 0;          // Delivered
+      uint32_t maxBuffered = 0;
+      uint32_t firstMs = 0;  // Device time of the first and last delivery
+      uint32_t lastMs = 0;
+      // Age of the oldest sentence in each delivered notification, formatting to delivery
+      uint64_t ageMsTotal = 0;
+      uint32_t ageMsMax = 0;
+      // Complete sentences delivered, by type
+      uint32_t sentences = 0;
+      uint32_t lk8ex1 = 0;
+      uint32_t gga = 0;
+      uint32_t rmc = 0;
+      uint32_t pflaa = 0;
+    };
+
+    enum class Event { None, Connected, MtuChanged, Disconnected };
+
+    // From main(), before boot.  False if the port cannot be listened on or the log opened.
+    bool configure(const Config& config, std::string& error);
+    const Config& config() const { return config_; }
+    bool enabled() const { return config_.enabled; }
+
+    // The device advertises (accepts a central) or stops.  An existing connection is kept.
+    void advertise(bool on) { advertising_ = on; }
+    // Drops the central, if any, and whatever it had not been sent
+    void disconnect();
+
+    // Runs the link up to `nowMs`: returns the next connection event, if any, and otherwise
+    // delivers what is due.  Call until it returns None.
+    Event poll(uint32_t nowMs);
+
+    // Hands a notification to the controller.  `formattedMs` is when its oldest sentence was
+    // formatted.  False if there is no central or the buffer is full.
+    bool notify(const uint8_t* data, size_t length, uint32_t formattedMs);
+
+    uint16_t mtu() const { return config_.mtu; }
+
+    Stats stats() const;
+
+   private:
+    struct Pending {
+      std::vector<uint8_t> bytes;
+      size_t sent = 0;  // Bytes a TCP client has already taken
+      uint32_t formattedMs;
+    };
+
+    bool deliver(Pending& notification, uint32_t nowMs);
+    void count(const uint8_t* data, size_t length);
+
+    Config config_;
+    int listenSocket_ = -1;
+    int client_ = -1;
+    FILE* log_ = nullptr;
+
+    bool advertising_ = false;
+    bool connected_ = false;
+    bool mtuExchanged_ = false;
+    uint32_t nextEventMs_ = 0;
+    std::deque<Pending> buffer_;
+    std::string line_;  // Sentence being reassembled, for the counts
+
+    mutable std::mutex statsMutex_;
+    Stats stats_;
+  };
+
+  BleLink& bleLink();
+
+}  // namespace sim
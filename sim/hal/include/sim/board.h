@@ -19,6 +19,7 @@ namespace sim {
 
   struct ToneEvent {
     uint32_t atMs = 0;
+    uint64_t atUs = 0;         // Same instant, for timing the sequencer
     uint32_t frequencyHz = 0;  // 0 means silence
     uint8_t volume = 0;        // 0..3, from the speaker's two volume pins
   };
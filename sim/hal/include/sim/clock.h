@@ -16,6 +16,8 @@ namespace sim {
   // Registered callbacks fire from whichever call advanced virtual time past their deadline, which
   // is the same place the device sees them: in the middle of the main loop.
   using TimerCallback = void (*)();
+  // esp_timer callbacks, which carry an argument
+  using TimerArgCallback = void (*)(void*);
 
   // Everything the device thread owns is plain; the four fields below are atomic because the
   // emulator's HTTP threads drive the clock directly rather than through the runtime's command
@@ -42,7 +44,9 @@ namespace sim {
     // Runs one timer slot; returns the handle index used by timerBegin()/timerAlarm().
     int addTimer(uint32_t frequencyHz);
     void setTimerCallback(int handle, TimerCallback callback);
+    void setTimerCallback(int handle, TimerArgCallback callback, void* arg);
     void setTimerAlarm(int handle, uint64_t ticks, bool autoReload);
+    void setTimerPeriodUs(int handle, uint64_t periodUs, bool autoReload);
     void removeTimer(int handle);
 
     // Drops every timer.  Used when the emulated device reboots: setup() installs its timers
@@ -68,6 +72,8 @@ namespace sim {
       uint64_t nextUs = 0;
       bool autoReload = true;
       TimerCallback callback = nullptr;
+      TimerArgCallback argCallback = nullptr;
+      void* arg = nullptr;
     };
 
     static constexpr int MAX_TIMERS = 8;
@@ -0,0 +1,57 @@
+// The virtual LoRa channel between a scenario's FANET swarm and the emulated radio.
+//
+// The scenario player puts frames on air -- the bytes another aircraft's radio transmitted, with
+// the RSSI and SNR they arrive at -- and the FanetRadio stand-in in sim/device listens between
+// the firmware's begin() and end(), which is when an SX1262 would be receiving.  A frame the
+// medium lost, or one sent while nothing was listening, is counted and goes no further.
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace sim {
+
+  struct FanetFrame {
+    uint32_t atMs = 0;  // Scenario time it is sent at
+    std::vector<uint8_t> bytes;
+    float rssi = 0;     // dBm
+    float snr = 0;      // dB
+    bool lost = false;  // Below sensitivity or collided: never demodulated
+  };
+
+  class FanetAir {
+   public:
+    struct Stats {
+      uint32_t sent = 0;         // Frames put on air by the swarm
+      uint32_t lost = 0;         // ...lost on the way
+      uint32_t unheard = 0;      // ...arriving while the radio was not receiving
+      uint32_t received = 0;     // ...handed to the radio
+      uint32_t transmitted = 0;  // Frames the device itself sent
+      uint64_t receiveNs = 0;    // Host time the firmware spent on received frames
+      uint64_t maxReceiveNs = 0;
+    };
+
+    using Receiver = std::function<void(const FanetFrame& frame)>;
+
+    // The radio starts (a receiver) or stops (nullptr) listening.
+    void listen(Receiver receiver);
+
+    // Called from the device thread, which is where the firmware then processes the frame.
+    void send(const FanetFrame& frame);
+
+    void noteTransmitted();
+
+    Stats stats() const;
+
+   private:
+    mutable std::mutex mutex_;
+    Receiver receiver_;
+    Stats stats_;
+  };
+
+  FanetAir& fanetAir();
+
+}  // namespace sim
@@ -0,0 +1,201 @@
+#include "sim/ble_link.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace sim {
+
+  namespace {
+    // ATT_MTU before the central asks for more
+    constexpr uint16_t DEFAULT_MTU = 23;
+
+    bool isType(const std::string& line, const char* type) {
+      return line.size() > 6 && line.compare(3, 3, type) == 0;
+    }
+  }  // namespace
+
+  BleLink& bleLink() {
+    static BleLink instance;
+    return instance;
+  }
+
+  bool BleLink::configure(const Config& config, std::string& error) {
+    config_ = config;
+    if (!config_.enabled) return true;
+    if (config_.intervalMs == 0) config_.intervalMs = 1;
+    if (config_.mtu < DEFAULT_MTU) config_.mtu = DEFAULT_MTU;
+
+    if (config_.port >= 0) {
+      // Close-on-exec, as for the HTTP server: a device restart replaces the process image and
+      // binds the port again.  Non-blocking, as the device thread polls it.
+      listenSocket_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+      int reuse = 1;
+      setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_ANY);
+      address.sin_port = htons(config_.port);
+      if (listenSocket_ < 0 || ::bind(listenSocket_, (sockaddr*)&address, sizeof(address)) < 0 ||
+          ::listen(listenSocket_, 1) < 0) {
+        error = "cannot listen on BLE port " + std::to_string(config_.port) + ": " +
+                strerror(errno);
+        if (listenSocket_ >= 0) ::close(listenSocket_);
+        listenSocket_ = -1;
+        return false;
+      }
+    }
+    if (!config_.logPath.empty()) {
+      log_ = fopen(config_.logPath.c_str(), "we");
+      if (log_ == nullptr) {
+        error = "cannot write " + config_.logPath + ": " + strerror(errno);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void BleLink::disconnect() {
+    if (client_ >= 0) ::close(client_);
+    client_ = -1;
+    connected_ = false;
+    buffer_.clear();
+    line_.clear();
+  }
+
+  BleLink::Event BleLink::poll(uint32_t nowMs) {
+    if (!config_.enabled) return Event::None;
+
+    if (!connected_) {
+      if (!advertising_) return Event::None;
+      if (listenSocket_ >= 0) {
+        client_ = ::accept4(listenSocket_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (client_ < 0) return Event::None;
+      }
+      connected_ = true;
+      mtuExchanged_ = false;
+      nextEventMs_ = nowMs + config_.intervalMs;
+      std::lock_guard<std::mutex> lock(statsMutex_);
+      stats_.connections++;
+      return Event::Connected;
+    }
+
+    // A TCP central hangs up by closing its end.  Anything it writes is discarded: there is no
+    // writable characteristic to send it to.
+    if (client_ >= 0) {
+      char discard[256];
+      const ssize_t n = ::recv(client_, discard, sizeof(discard), MSG_DONTWAIT);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        disconnect();
+        return Event::Disconnected;
+      }
+    }
+
+    if ((int32_t)(nowMs - nextEventMs_) < 0) return Event::None;
+    nextEventMs_ += config_.intervalMs;
+    // After a stall (the device paused in the debugger, say) resume from now rather than
+    // running every missed event at once
+    if ((int32_t)(nowMs - nextEventMs_) >= 0) nextEventMs_ = nowMs + config_.intervalMs;
+
+    // The central's first event goes on exchanging MTUs
+    if (!mtuExchanged_) {
+      mtuExchanged_ = true;
+      return config_.mtu > DEFAULT_MTU ? Event::MtuChanged : Event::None;
+    }
+
+    for (uint8_t packet = 0; packet < config_.packetsPerEvent && !buffer_.empty(); packet++) {
+      if (!deliver(buffer_.front(), nowMs)) break;
+      buffer_.pop_front();
+    }
+    if (!connected_) return Event::Disconnected;
+    return Event::None;
+  }
+
+  bool BleLink::notify(const uint8_t* data, size_t length, uint32_t formattedMs) {
+    if (!connected_) return false;
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    if (buffer_.size() >= config_.bufferedPackets) {
+      stats_.refused++;
+      return false;
+    }
+    buffer_.push_back(Pending{std::vector<uint8_t>(data, data + length), 0, formattedMs});
+    stats_.notifications++;
+    if (buffer_.size() > stats_.maxBuffered) stats_.maxBuffered = buffer_.size();
+    return true;
+  }
+
+  // False if the notification could not be sent whole, leaving it at the front of the buffer:
+  // the TCP client is not keeping up, or has gone (and the link is disconnected).
+  bool BleLink::deliver(Pending& notification, uint32_t nowMs) {
+    if (client_ >= 0) {
+      while (notification.sent < notification.bytes.size()) {
+        const ssize_t n = ::send(client_, notification.bytes.data() + notification.sent,
+                                 notification.bytes.size() - notification.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+          if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+          if (errno == EINTR) continue;
+          disconnect();
+          return false;
+        }
+        notification.sent += n;
+      }
+    }
+
+    if (log_ != nullptr) {
+      fprintf(log_, "%u ", nowMs);
+      for (uint8_t c : notification.bytes) {
+        if (c == '\r') {
+          fputs("\\r", log_);
+        } else if (c == '\n') {
+          fputs("\\n", log_);
+        } else {
+          fputc(c, log_);
+        }
+      }
+      fputc('\n', log_);
+      fflush(log_);
+    }
+
+    count(notification.bytes.data(), notification.bytes.size());
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    const uint32_t ageMs = nowMs - notification.formattedMs;
+    if (stats_.delivered == 0) stats_.firstMs = nowMs;
+    stats_.lastMs = nowMs;
+    stats_.delivered++;
+    stats_.bytes += notification.bytes.size();
+    stats_.ageMsTotal += ageMs;
+    if (ageMs > stats_.ageMsMax) stats_.ageMsMax = ageMs;
+    return true;
+  }
+
+  // Reassembles lines across notifications, as a central does, and counts them by type
+  void BleLink::count(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      if (data[i] != '\n') {
+        line_ += (char)data[i];
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(statsMutex_);
+      stats_.sentences++;
+      if (line_.compare(0, 7, "$LK8EX1") == 0) {
+        stats_.lk8ex1++;
+      } else if (line_.compare(0, 6, "$PFLAA") == 0) {
+        stats_.pflaa++;
+      } else if (isType(line_, "GGA")) {
+        stats_.gga++;
+      } else if (isType(line_, "RMC")) {
+        stats_.rmc++;
+      }
+      line_.clear();
+    }
+  }
+
+  BleLink::Stats BleLink::stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+  }
+
+}  // namespace sim
@@ -79,7 +79,8 @@ namespace sim {
     if (frequencyHz == tone_) return;
     tone_ = frequencyHz;
     ToneEvent event;
-    event.atMs = clock().millis();
+    event.atUs = clock().nowUs();
+    event.atMs = (uint32_t)(event.atUs / 1000);
     event.frequencyHz = frequencyHz;
     event.volume = (uint8_t)((volA_ ? 1 : 0) + (volB_ ? 2 : 0));
     toneEvents_.push_back(event);
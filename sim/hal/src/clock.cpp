@@ -70,7 +70,7 @@ namespace sim {
       uint64_t soonestAt = until;
       for (int i = 0; i < MAX_TIMERS; i++) {
         const Timer& t = timers_[i];
-        if (!t.active || !t.callback || t.periodUs == 0) continue;
+        if (!t.active || (!t.callback && !t.argCallback) || t.periodUs == 0) continue;
         if (t.nextUs <= soonestAt) {
           soonest = i;
           soonestAt = t.nextUs;
@@ -85,7 +85,11 @@ namespace sim {
       } else {
         t.periodUs = 0;
       }
-      t.callback();
+      if (t.callback) {
+        t.callback();
+      } else {
+        t.argCallback(t.arg);
+      }
     }
   }
 
@@ -105,13 +109,26 @@ namespace sim {
     timers_[handle].callback = callback;
   }
 
+  void Clock::setTimerCallback(int handle, TimerArgCallback callback, void* arg) {
+    if (handle < 0 || handle >= MAX_TIMERS) return;
+    timers_[handle].callback = nullptr;
+    timers_[handle].argCallback = callback;
+    timers_[handle].arg = arg;
+  }
+
   void Clock::setTimerAlarm(int handle, uint64_t ticks, bool autoReload) {
     if (handle < 0 || handle >= MAX_TIMERS) return;
-    Timer& t = timers_[handle];
     // timerBegin() takes a tick frequency and timerAlarm() a tick count, so the period in
     // microseconds is ticks / frequency, the same arithmetic the ESP timer does.
-    t.periodUs = (uint64_t)((double)ticks * 1000000.0 / (double)t.frequencyHz);
-    if (t.periodUs == 0) t.periodUs = 1;
+    setTimerPeriodUs(handle,
+                     (uint64_t)((double)ticks * 1000000.0 / (double)timers_[handle].frequencyHz),
+                     autoReload);
+  }
+
+  void Clock::setTimerPeriodUs(int handle, uint64_t periodUs, bool autoReload) {
+    if (handle < 0 || handle >= MAX_TIMERS) return;
+    Timer& t = timers_[handle];
+    t.periodUs = periodUs ? periodUs : 1;
     t.autoReload = autoReload;
     t.nextUs = nowUs_ + t.periodUs;
   }
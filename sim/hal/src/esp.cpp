@@ -4,6 +4,7 @@
 #include <esp_debug_helpers.h>
 #include <esp_heap_caps.h>
 #include <esp_mac.h>
+#include <esp_rom_crc.h>
 #include <esp_sleep.h>
 #include <esp_system.h>
 #include <esp_wifi.h>
@@ -26,6 +27,9 @@ namespace sim {
 uint32_t EspClass::getFreeHeap() const { return 200 * 1024; }
 uint32_t EspClass::getMinFreeHeap() const { return 150 * 1024; }
 uint32_t EspClass::getMaxAllocHeap() const { return 120 * 1024; }
+uint32_t EspClass::getCycleCount() const {
+  return (uint32_t)(sim::Clock::hostUs() * getCpuFreqMHz());
+}
 void EspClass::restart() { sim::g_restartRequested = true; }
 
 extern "C" {
@@ -90,6 +94,7 @@ size_t heap_caps_get_total_size(uint32_t caps) {
 size_t heap_caps_get_minimum_free_size(uint32_t caps) { return heap_caps_get_free_size(caps) / 2; }
 void* heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
 void heap_caps_free(void* ptr) { free(ptr); }
+bool heap_caps_check_integrity_all(bool print_errors) { return true; }
 
 esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type) {
   // Locally-administered, obviously synthetic: nothing here can be mistaken for a real unit.
@@ -129,4 +134,13 @@ void esp_rom_install_channel_putc(int channel, void (*putc)(char)) {
 
 void esp_rom_install_uart_printf(void) {}
 
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const* buf, uint32_t len) {
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
 }  // extern "C"
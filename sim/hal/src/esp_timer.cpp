@@ -0,0 +1,55 @@
+// esp_timer on the virtual clock's timer slots.
+
+#include <esp_timer.h>
+
+#include "sim/clock.h"
+
+// The clock slot is claimed when the timer starts and released when it stops
+struct esp_timer {
+  int handle;
+  esp_timer_cb_t callback;
+  void* arg;
+};
+
+extern "C" {
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args,
+                           esp_timer_handle_t* out_handle) {
+  if (!create_args || !create_args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+  *out_handle = new esp_timer{-1, create_args->callback, create_args->arg};
+  return ESP_OK;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t periodUs, bool autoReload) {
+  if (!timer) return ESP_ERR_INVALID_ARG;
+  if (timer->handle >= 0) return ESP_ERR_INVALID_STATE;
+  timer->handle = sim::clock().addTimer(1000000);
+  if (timer->handle < 0) return ESP_ERR_NO_MEM;
+  sim::clock().setTimerCallback(timer->handle, timer->callback, timer->arg);
+  sim::clock().setTimerPeriodUs(timer->handle, periodUs, autoReload);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+  return start(timer, period, true);
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  return start(timer, timeout_us, false);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer || timer->handle < 0) return ESP_ERR_INVALID_STATE;
+  sim::clock().removeTimer(timer->handle);
+  timer->handle = -1;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  if (!timer) return ESP_ERR_INVALID_ARG;
+  if (timer->handle >= 0) return ESP_ERR_INVALID_STATE;
+  delete timer;
+  return ESP_OK;
+}
+
+}  // extern "C"
@@ -0,0 +1,57 @@
+#include "sim/fanet_air.h"
+
+#include <chrono>
+
+namespace sim {
+
+  FanetAir& fanetAir() {
+    static FanetAir instance;
+    return instance;
+  }
+
+  void FanetAir::listen(Receiver receiver) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    receiver_ = std::move(receiver);
+  }
+
+  void FanetAir::send(const FanetFrame& frame) {
+    Receiver receiver;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.sent++;
+      if (frame.lost) {
+        stats_.lost++;
+        return;
+      }
+      if (!receiver_) {
+        stats_.unheard++;
+        return;
+      }
+      receiver = receiver_;
+    }
+
+    // Run outside the lock: the firmware may stop the radio from another thread meanwhile, and
+    // that must not wait behind the whole receive path.  Timed in host time, like the task report.
+    const auto start = std::chrono::steady_clock::now();
+    receiver(frame);
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.received++;
+    stats_.receiveNs += ns;
+    if (ns > stats_.maxReceiveNs) stats_.maxReceiveNs = ns;
+  }
+
+  void FanetAir::noteTransmitted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.transmitted++;
+  }
+
+  FanetAir::Stats FanetAir::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+}  // namespace sim
@@ -1,13 +1,21 @@
 // FreeRTOS primitives on host threads.
 //
-// Almost all firmware code runs on the single device thread, so these mostly serve the message
-// bus's recursive mutex and the heap monitor's task bookkeeping.  Tasks that the firmware does
-// spawn become host threads whose delays consume virtual time, so they stay in step with the
-// device loop rather than racing ahead in real time.
+// The device thread is the Arduino loop task on core 1.  Tasks that the firmware spawns become
+// host threads whose delays consume virtual time, so they stay in step with the device loop rather
+// than racing ahead in real time.
+//
+// A task the device thread wakes with a notification (the service task, which runs the other
+// core's share of every 10ms block) runs in lockstep with it: the notifying call returns once the
+// task is waiting for its next notification.  The two cores' work then interleaves the same way on
+// every run, and virtual time cannot move under either of them, while each still runs on its own
+// thread with its own core ID, locks and queues, as on the device.
 
 #include <freertos/FreeRTOS.h>
 
+#include <stdio.h>
+
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
 #include <deque>
@@ -22,8 +30,15 @@ namespace {
 
   struct SimMutex {
     std::recursive_timed_mutex mutex;
-    bool binary = false;
-    std::atomic<int> count{0};
+    std::atomic<void*> holder{nullptr};
+    int depth = 0;  // Only touched by the holder
+
+    // Binary and counting semaphores have no owner and may be given by a task that never took them
+    bool counting = false;
+    int maxCount = 1;
+    std::mutex countMutex;
+    std::condition_variable countCv;
+    int count = 0;
   };
 
   struct SimQueue {
@@ -37,19 +52,66 @@ namespace {
   struct SimTask {
     std::thread thread;
     std::string name;
+    BaseType_t core = 0;
     std::atomic<bool> stop{false};
     std::atomic<uint32_t> notifyValue{0};
+    // Spawned tasks sleep on these until notified (see ulTaskNotifyTake)
+    std::mutex notifyMutex;
+    std::condition_variable notifyCv;
+    bool waiting = false;  // In ulTaskNotifyTake; guarded by notifyMutex
   };
 
+  // How long the device thread waits for a task it notified to go back to waiting before carrying
+  // on without it, so a task stuck on something else cannot hang the emulator
+  constexpr auto LOCKSTEP_TIMEOUT = std::chrono::seconds(5);
+
   struct SimTimer {
     std::string name;
     TickType_t period = 0;
     bool autoReload = false;
     void* id = nullptr;
     TimerCallbackFunction_t callback = nullptr;
+    int clockTimer = -1;  // Slot on the virtual clock while started
   };
 
   SimTask g_loopTask;
+  thread_local SimTask* t_currentTask = &g_loopTask;
+
+  struct LoopTaskCore {
+    LoopTaskCore() { g_loopTask.core = 1; }
+  } g_loopTaskCore;
+
+  // Called on the device thread after notifying a spawned task
+  void waitForTask(SimTask* t) {
+    std::unique_lock<std::mutex> lock(t->notifyMutex);
+    const bool idle = t->notifyCv.wait_for(lock, LOCKSTEP_TIMEOUT, [t] {
+      return t->stop.load() || (t->waiting && t->notifyValue.load() == 0);
+    });
+    if (!idle) {
+      fprintf(stderr, "leafsim: task %s still busy %llds after being notified; not waiting\n",
+              t->name.c_str(), (long long)LOCKSTEP_TIMEOUT.count());
+    }
+  }
+
+  BaseType_t takeCount(SimMutex* m, TickType_t ticksToWait) {
+    std::unique_lock<std::mutex> lock(m->countMutex);
+    const auto available = [m] { return m->count > 0; };
+    if (ticksToWait == portMAX_DELAY) {
+      m->countCv.wait(lock, available);
+    } else if (!m->countCv.wait_for(lock, std::chrono::milliseconds(ticksToWait), available)) {
+      return pdFALSE;
+    }
+    m->count--;
+    return pdTRUE;
+  }
+
+  BaseType_t giveCount(SimMutex* m) {
+    std::lock_guard<std::mutex> lock(m->countMutex);
+    if (m->count >= m->maxCount) return pdFALSE;
+    m->count++;
+    m->countCv.notify_one();
+    return pdTRUE;
+  }
 
 }  // namespace
 
@@ -61,11 +123,13 @@ SemaphoreHandle_t xSemaphoreCreateMutex(void) { return new SimMutex(); }
 SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) { return new SimMutex(); }
 SemaphoreHandle_t xSemaphoreCreateBinary(void) {
   auto* m = new SimMutex();
-  m->binary = true;
+  m->counting = true;  // Created empty, as on the device
   return m;
 }
 SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
   auto* m = new SimMutex();
+  m->counting = true;
+  m->maxCount = (int)maxCount;
   m->count = (int)initialCount;
   return m;
 }
@@ -73,21 +137,30 @@ SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t ini
 BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
   auto* m = (SimMutex*)semaphore;
   if (!m) return pdFALSE;
+  if (m->counting) return takeCount(m, ticksToWait);
   if (ticksToWait == portMAX_DELAY) {
     m->mutex.lock();
-    return pdTRUE;
+  } else if (!m->mutex.try_lock_for(std::chrono::milliseconds(ticksToWait))) {
+    return pdFALSE;
   }
-  const bool locked = m->mutex.try_lock_for(std::chrono::milliseconds(ticksToWait));
-  return locked ? pdTRUE : pdFALSE;
+  if (m->depth++ == 0) m->holder = t_currentTask;
+  return pdTRUE;
 }
 
 BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
   auto* m = (SimMutex*)semaphore;
   if (!m) return pdFALSE;
+  if (m->counting) return giveCount(m);
+  if (--m->depth == 0) m->holder = nullptr;
   m->mutex.unlock();
   return pdTRUE;
 }
 
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore) {
+  auto* m = (SimMutex*)semaphore;
+  return m && !m->counting ? m->holder.load() : nullptr;
+}
+
 BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
   return xSemaphoreTake(semaphore, ticksToWait);
 }
@@ -161,22 +234,37 @@ void vQueueDelete(QueueHandle_t queue) { delete (SimQueue*)queue; }
 
 BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* parameters,
                        UBaseType_t priority, TaskHandle_t* createdTask) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, parameters, priority, createdTask,
+                                 tskNO_AFFINITY);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* parameters, UBaseType_t priority,
+                                   TaskHandle_t* createdTask, BaseType_t core) {
   auto* task = new SimTask();
   task->name = name ? name : "task";
-  task->thread = std::thread([fn, parameters] {
+  // Unpinned tasks report core 0, where the device's scheduler mostly finds room for them
+  task->core = core == tskNO_AFFINITY ? 0 : core;
+  task->thread = std::thread([fn, parameters, task] {
+    t_currentTask = task;
     if (fn) fn(parameters);
+    std::lock_guard<std::mutex> lock(task->notifyMutex);
+    task->stop = true;  // Returned, so nobody waits for it again
+    task->notifyCv.notify_all();
   });
   task->thread.detach();
   if (createdTask) *createdTask = task;
   return pdPASS;
 }
 
-BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
-                                   void* parameters, UBaseType_t priority,
-                                   TaskHandle_t* createdTask, BaseType_t core) {
-  return xTaskCreate(fn, name, stackDepth, parameters, priority, createdTask);
+BaseType_t xPortGetCoreID(void) { return t_currentTask->core; }
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+  while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) std::this_thread::yield();
 }
 
+void vPortExitCritical(portMUX_TYPE* mux) { __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE); }
+
 void vTaskDelete(TaskHandle_t task) {
   if (!task) return;  // NULL means "delete self"; the host thread just returns instead
   auto* t = (SimTask*)task;
@@ -199,7 +287,7 @@ UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
   return 10;
 }
 
-TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &g_loopTask; }
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return t_currentTask; }
 TickType_t xTaskGetTickCount(void) { return sim::clock().millis(); }
 
 UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
@@ -215,11 +303,16 @@ const char* pcTaskGetName(TaskHandle_t task) {
 BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
   auto* t = (SimTask*)task;
   if (!t) return pdFALSE;
-  if (action == eIncrement) {
-    t->notifyValue++;
-  } else {
-    t->notifyValue = value;
+  {
+    std::lock_guard<std::mutex> lock(t->notifyMutex);
+    if (action == eIncrement) {
+      t->notifyValue++;
+    } else {
+      t->notifyValue = value;
+    }
+    t->notifyCv.notify_all();
   }
+  if (t_currentTask == &g_loopTask && t != &g_loopTask) waitForTask(t);
   return pdTRUE;
 }
 
@@ -229,11 +322,42 @@ BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction a
   return xTaskNotify(task, value, action);
 }
 
+BaseType_t xTaskNotifyGive(TaskHandle_t task) { return xTaskNotify(task, 0, eIncrement); }
+
 uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
-  auto* t = &g_loopTask;
+  auto* t = t_currentTask;
+  if (t != &g_loopTask) {
+    // A spawned task must not move the virtual clock (only the device thread does), so it sleeps
+    // in real time until notified.  A task waiting forever is woken by the notification itself.
+    std::unique_lock<std::mutex> lock(t->notifyMutex);
+    const auto notified = [t] { return t->notifyValue.load() != 0; };
+    // A task blocking here is done with its last notification, which releases a device thread
+    // waiting for it (waitForTask); a task only polling is not
+    t->waiting = ticksToWait > 0;
+    if (t->waiting) t->notifyCv.notify_all();
+    if (ticksToWait == portMAX_DELAY) {
+      t->notifyCv.wait(lock, notified);
+    } else if (ticksToWait > 0) {
+      t->notifyCv.wait_for(lock, std::chrono::milliseconds(ticksToWait), notified);
+    }
+    t->waiting = false;
+    const uint32_t value = t->notifyValue.load();
+    if (clearOnExit) {
+      t->notifyValue = 0;
+    } else if (value > 0) {
+      t->notifyValue--;
+    }
+    return value;
+  }
+  // The device thread does not wait: the emulator advances virtual time between passes through
+  // loop(), firing the timer interrupts that would have woken it, and sleeping here instead would
+  // overshoot them
   const uint32_t value = t->notifyValue.load();
-  if (clearOnExit) t->notifyValue = 0;
-  if (value == 0 && ticksToWait > 0) vTaskDelay(ticksToWait > 10 ? 10 : ticksToWait);
+  if (clearOnExit) {
+    t->notifyValue = 0;
+  } else if (value > 0) {
+    t->notifyValue--;
+  }
   return value;
 }
 
@@ -257,17 +381,38 @@ TimerHandle_t xTimerCreate(const char* name, TickType_t period, BaseType_t autoR
   return t;
 }
 
+// Started timers run on the virtual clock, so their callbacks fire on the device thread at the
+// device time they fall due, as the hardware's timer task would run them between other tasks.
 BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait) {
-  // Only the BLE task uses software timers, and that subsystem is not emulated; accepting the
-  // start without scheduling anything keeps its setup path honest about succeeding.
-  (void)timer;
   (void)ticksToWait;
+  auto* t = (SimTimer*)timer;
+  if (t == nullptr) return pdFAIL;
+  if (t->clockTimer < 0) t->clockTimer = sim::clock().addTimer(1000000);
+  if (t->clockTimer < 0) return pdFAIL;
+  sim::clock().setTimerCallback(
+      t->clockTimer,
+      [](void* arg) {
+        auto* started = (SimTimer*)arg;
+        started->callback(started);
+      },
+      t);
+  // Ticks are milliseconds (configTICK_RATE_HZ is 1000)
+  sim::clock().setTimerPeriodUs(t->clockTimer, (uint64_t)t->period * 1000, t->autoReload);
   return pdPASS;
 }
 
-BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait) { return pdPASS; }
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait) {
+  (void)ticksToWait;
+  auto* t = (SimTimer*)timer;
+  if (t != nullptr && t->clockTimer >= 0) {
+    sim::clock().removeTimer(t->clockTimer);
+    t->clockTimer = -1;
+  }
+  return pdPASS;
+}
 
 BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticksToWait) {
+  xTimerStop(timer, ticksToWait);
   delete (SimTimer*)timer;
   return pdPASS;
 }
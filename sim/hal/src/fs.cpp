@@ -158,6 +158,12 @@ namespace fs {
     if (impl_ && impl_->file()) fflush(impl_->file());
   }
 
+  // As on the device, the stdio buffer; only takes effect before the first read or write
+  bool File::setBufferSize(size_t size) {
+    if (!impl_ || !impl_->file()) return false;
+    return setvbuf(impl_->file(), nullptr, _IOFBF, size) == 0;
+  }
+
   bool File::seek(uint32_t position) { return seek(position, SEEK_SET); }
 
   bool File::seek(uint32_t position, int mode) {
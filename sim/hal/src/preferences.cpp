@@ -211,10 +211,14 @@ String Preferences::getString(const char* key, const String& defaultValue) {
   auto it = values_.find(key ? key : "");
   return it == values_.end() ? defaultValue : String(it->second);
 }
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = values_.find(key ? key : "");
+  return it == values_.end() ? 0 : it->second.size();
+}
+
 size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
   auto it = values_.find(key ? key : "");
-  if (it == values_.end()) return 0;
-  const size_t n = it->second.size() < maxLen ? it->second.size() : maxLen;
-  memcpy(buf, it->second.data(), n);
-  return n;
+  if (it == values_.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
 }
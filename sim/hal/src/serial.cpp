@@ -2,7 +2,8 @@
 //
 // Serial is the debug console: it goes to the host's stdout and into a ring buffer the emulator
 // UI drains, so the browser panel shows the same boot log you would see over USB.
-// Serial0 is the GPS UART, wired to the virtual board's byte pipe.
+// Serial0 is the GPS UART, wired to the virtual board's byte pipe.  Bytes fed into it reach the
+// driver through its onReceive callback, which the emulator runs between loop passes.
 
 #include <HardwareSerial.h>
 #include <stdio.h>
@@ -81,3 +82,12 @@ size_t HostGpsSerial::write(uint8_t c) {
 int HostGpsSerial::available() { return sim::board().gpsAvailable(); }
 int HostGpsSerial::read() { return sim::board().gpsRead(); }
 int HostGpsSerial::peek() { return sim::board().gpsPeek(); }
+
+void HostGpsSerial::onReceive(std::function<void(void)> callback, bool onlyOnTimeout) {
+  (void)onlyOnTimeout;
+  onReceive_ = std::move(callback);
+}
+
+void HostGpsSerial::deliverReceived() {
+  if (onReceive_ && available() > 0) onReceive_();
+}
@@ -0,0 +1,102 @@
+# Gzip the Leaf Web App's static files into flash.
+#
+# Every file in src/vario/comms/web_assets/ becomes a gzip blob in PROGMEM with a precomputed ETag,
+# written to src/vario/comms/web_assets_gz.h (not checked in).  The web server sends the blobs as
+# they are with Content-Encoding: gzip and answers If-None-Match with 304 Not Modified, so a phone
+# reopening the app over the softAP only downloads what changed since the last firmware update.
+#
+# Anything that depends on settings at request time must not live in these files; the app fetches
+# it from /app/config.js, which the web server builds per request.
+#
+# Runs as a PlatformIO pre-script, or standalone: python src/scripts/web_assets.py
+
+import gzip
+import hashlib
+import os
+import pathlib
+
+try:
+    Import("env")
+    PROJECT_DIR = pathlib.Path(env["PROJECT_DIR"])
+except NameError:
+    PROJECT_DIR = pathlib.Path(__file__).resolve().parents[2]
+
+ASSET_DIR = PROJECT_DIR / "src" / "vario" / "comms" / "web_assets"
+HEADER_PATH = PROJECT_DIR / "src" / "vario" / "comms" / "web_assets_gz.h"
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+}
+
+BYTES_PER_LINE = 20
+
+
+def _symbol(path: pathlib.Path) -> str:
+    """app.html -> APP_HTML"""
+    return "".join(c if c.isalnum() else "_" for c in path.name).upper()
+
+
+def _c_array(data: bytes) -> str:
+    lines = []
+    for i in range(0, len(data), BYTES_PER_LINE):
+        chunk = data[i : i + BYTES_PER_LINE]
+        lines.append("    " + ",".join(f"0x{b:02x}" for b in chunk) + ",")
+    return "\n".join(lines)
+
+
+def render_header() -> tuple[str, list[str]]:
+    out = [
+        "// Generated by src/scripts/web_assets.py from comms/web_assets/.  Do not edit.",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char* contentType;",
+        "  const uint8_t* gzip;",
+        "  size_t gzipLength;",
+        "  const char* etag;  // Quoted, as sent in the ETag header",
+        "};",
+        "",
+        "namespace web_assets {",
+    ]
+    report = []
+    for path in sorted(ASSET_DIR.iterdir()):
+        if not path.is_file() or path.suffix not in CONTENT_TYPES:
+            continue
+        raw = path.read_bytes()
+        # mtime=0 keeps the blob (and the firmware image) identical between builds
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '\\"' + hashlib.sha256(raw).hexdigest()[:16] + '\\"'
+        name = _symbol(path)
+        out += [
+            f"  // {path.name}: {len(raw)} bytes, {len(packed)} gzipped",
+            f"  static const uint8_t {name}_GZ[] PROGMEM = {{",
+            _c_array(packed),
+            "  };",
+            f"  static const WebAsset {name} = {{",
+            f"      \"{CONTENT_TYPES[path.suffix]}\", {name}_GZ, sizeof({name}_GZ), \"{etag}\"}};",
+            "",
+        ]
+        report.append(f"{path.name} {len(raw)} -> {len(packed)} bytes")
+    out += ["}  // namespace web_assets", ""]
+    return "\n".join(out), report
+
+
+def main() -> None:
+    header, report = render_header()
+    existing = HEADER_PATH.read_text() if HEADER_PATH.exists() else None
+    if header == existing:
+        # Leave the timestamp alone so nothing that includes it is rebuilt
+        print("[web_assets.py] web_assets_gz.h is up to date")
+        return
+    HEADER_PATH.write_text(header)
+    for line in report:
+        print("[web_assets.py] " + line)
+
+
+main()
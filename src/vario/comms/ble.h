@@ -1,12 +1,21 @@
 #pragma once
 
 #include <NimBLEDevice.h>
-#include "TinyGPSPlus.h"
+#include <atomic>
+#include "instruments/gps_fix.h"
 
+#include "comms/nus_batch.h"
 #include "dispatch/message_sink.h"
 #include "dispatch/message_types.h"
 
-// FreeRTOS Task for handling Bluetooth Operations
+struct TrafficUpdate;
+struct WakeupMessage;
+
+// FreeRTOS Task for handling Bluetooth Operations.
+//
+// ble.cpp is the NimBLE side: the GATT server, advertising, the task and sending notifications.
+// ble_stream.cpp decides what goes into them and when, and touches no NimBLE API, so the emulator
+// runs it unchanged behind its own transport (sim/device/ble.cpp).
 class BLE : public MessageSink<BLE, GpsMessage, FanetPacket> {
  public:
   static BLE& get();
@@ -34,6 +43,12 @@ class BLE : public MessageSink<BLE, GpsMessage, FanetPacket> {
   void on_receive(const FanetPacket& msg);
   void on_receive_unknown(const etl::imessage& msg) {}
 
+  // Connection events, from the Bluetooth stack's callbacks
+  void noteConnected(uint16_t mtu);
+  void noteMtuChanged(uint16_t mtu);
+  void noteDisconnected(int reason);
+  void noteAdvertisingRestarted(bool success);
+
  private:
   BLE()
       : pServer(nullptr),
@@ -67,21 +82,31 @@ class BLE : public MessageSink<BLE, GpsMessage, FanetPacket> {
   static void bleTask(void*);
   static void timerCallback(TimerHandle_t timer);
 
+  void createWakeupQueue();
+  /// @brief Waits up to `wait` for the next wakeup and handles it.  False if none came.
+  bool processWakeup(TickType_t wait);
+  // Formats whatever `message` woke the task for into nusBatch, at the rates the user chose
+  void handleWakeup(WakeupMessage& message);
   void sendVarioUpdate();
+  void sendGpsSentence(const NMEAString& nmea, unsigned long& lastSentMs);
   // NimBLE reports whether an update was submitted, not final over-the-air delivery.
   void recordNusNotifyResult(bool success);
   void processDiagnostics();
-  void sendGpsUpdate(TinyGPSPlus& gps);
-  void sendFanetUpdate(FanetPacket& packetMsg);
-
-  /**
-   * Add's the checksum and postfix characters to a NMEA string. It may contain an existing checksum
-   * that will be overwritten When the capacity is not enough, the result is undefined Note: Must
-   * start with the prefix character $ (for performance reasons)
-   * @param nmea example '$PFEC,GPint,RMC05'
-   * @return             '$PFEC,GPint,RMC05*2D\r\n'
-   */
-  void addChecksumToNMEA(etl::istring& nmea);
+  void sendGpsUpdate(GpsFix& gps);
+  void sendFanetUpdate(TrafficUpdate& update);
+
+  /// @brief Adds a sentence (checksum and CRLF are appended) to the next notifications
+  void queueNus(const char* sentence);
+  /// @brief Notifies everything queued, in as few notifications as the MTU allows
+  void flushNus();
+
+  // Sentences formatted since the last flush
+  nus_batch::Batch nusBatch;
+  // Periodic timer ticks since the last LK8EX1
+  uint8_t varioTicks = 0;
+  // Centrals connected, and the ATT_MTU negotiated with them
+  std::atomic<uint8_t> connections{0};
+  std::atomic<uint16_t> nusMtu{nus_batch::DEFAULT_MTU};
 
   unsigned long lastGpsGgaMs = 0;
   unsigned long lastGpsGprmcMs = 0;
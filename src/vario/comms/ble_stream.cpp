@@ -0,0 +1,323 @@
+#include "comms/ble.h"
+
+#include <Arduino.h>
+#include <algorithm>
+
+#include "comms/fanet_radio.h"
+#include "diagnostics/diagnostic_logs.h"
+#include "diagnostics/heap_monitor.h"
+#include "esp_heap_caps.h"
+#include "etl/variant.h"
+#include "instruments/ambient.h"
+#include "instruments/baro.h"
+#include "power.h"
+#include "ui/settings/settings.h"
+
+// The Nordic UART sentence stream: which sentences are due, how they are formatted, and the
+// diagnostics kept about them.  The transport (ble.cpp on the device) creates the task and the
+// timer, calls processWakeup() from the task and sends what flushNus() hands it.
+
+namespace {
+  constexpr unsigned long BLE_HEAP_CHECK_INTERVAL_MS = 5000;
+
+  // The periodic timer's rate, which is the fastest LK8EX1 can go out
+  constexpr uint8_t PERIODIC_HZ = 10;
+
+  enum BleDiagnosticEvent : uint32_t {
+    BLE_DIAG_CONNECTED = 1 << 0,
+    BLE_DIAG_DISCONNECTED = 1 << 1,
+    BLE_DIAG_ADV_RESTARTED = 1 << 2,
+    BLE_DIAG_ADV_RESTART_FAILED = 1 << 3,
+    BLE_DIAG_NUS_NOTIFY_FAILED = 1 << 4,
+    BLE_DIAG_PERIODIC_QUEUE_FULL = 1 << 5,
+    BLE_DIAG_GPS_QUEUE_FULL = 1 << 6,
+    BLE_DIAG_FANET_QUEUE_FULL = 1 << 7,
+    BLE_DIAG_NUS_SENTENCE_DROPPED = 1 << 8,
+  };
+
+  std::atomic<uint32_t> pendingBleDiagnosticEvents{0};
+  std::atomic<int> lastBleDisconnectReason{0};
+  std::atomic<uint32_t> nusNotifySuccessCount{0};
+  std::atomic<uint32_t> nusNotifyFailureCount{0};
+  std::atomic<uint32_t> nusSentenceCount{0};
+  std::atomic<uint32_t> nusSentenceDropCount{0};
+
+  void markBleDiagnosticEvent(BleDiagnosticEvent event) {
+    pendingBleDiagnosticEvents.fetch_or(static_cast<uint32_t>(event), std::memory_order_relaxed);
+  }
+}  // namespace
+
+/// @brief A received FANET packet, with where its sender was relative to us when it arrived
+struct TrafficUpdate {
+  FanetPacket packet;
+  fanet_traffic::Report report;
+};
+
+/// @brief Internal struct to be passed in the message queues to wakup the BLE task
+struct WakeupMessage {
+  enum Reason { PERIODIC, FANET_RX, GPS_GPGGA, GPS_GPRMC } reason;
+  using MessageVariant = etl::variant<NMEAString, TrafficUpdate>;
+  MessageVariant message;
+
+  WakeupMessage(Reason reason, MessageVariant message) : reason(reason), message(message) {}
+  WakeupMessage(Reason reason) : reason(reason) {}
+  WakeupMessage() { reason = Reason::PERIODIC; }
+};
+
+void BLE::noteConnected(uint16_t mtu) {
+  connections.fetch_add(1, std::memory_order_relaxed);
+  nusMtu.store(mtu, std::memory_order_relaxed);
+  markBleDiagnosticEvent(BLE_DIAG_CONNECTED);
+}
+
+void BLE::noteMtuChanged(uint16_t mtu) { nusMtu.store(mtu, std::memory_order_relaxed); }
+
+void BLE::noteDisconnected(int reason) {
+  if (connections.load(std::memory_order_relaxed) > 0) {
+    connections.fetch_sub(1, std::memory_order_relaxed);
+  }
+  lastBleDisconnectReason.store(reason, std::memory_order_relaxed);
+  nusMtu.store(nus_batch::DEFAULT_MTU, std::memory_order_relaxed);
+  markBleDiagnosticEvent(BLE_DIAG_DISCONNECTED);
+}
+
+void BLE::noteAdvertisingRestarted(bool success) {
+  markBleDiagnosticEvent(success ? BLE_DIAG_ADV_RESTARTED : BLE_DIAG_ADV_RESTART_FAILED);
+}
+
+void BLE::createWakeupQueue() {
+  // Create a queue the size of a couple of WakeupMessage length.
+  // If say a GPS and periodic send request comes in too close together
+  // one of them may be dropped for this cycle.
+  xQueue = xQueueCreate(4, sizeof(WakeupMessage));
+}
+
+void BLE::on_receive(const GpsMessage& msg) {
+  // Short circuit if not initialized
+  if (pServer == nullptr) return;
+
+  // If the GPS message is a GPGGA or GPRMC, we store it in the buffers
+  // for the next periodic send.
+  if (msg.nmea.substr(0, 6) == "$GPGGA" || msg.nmea.substr(0, 6) == "$GNGGA") {
+    WakeupMessage message(WakeupMessage::Reason::GPS_GPGGA, msg.nmea);
+    if (xQueueSend(BLE::get().xQueue, &message, 0) != pdTRUE) {
+      markBleDiagnosticEvent(BLE_DIAG_GPS_QUEUE_FULL);
+    }
+  } else if (msg.nmea.substr(0, 6) == "$GPRMC" || msg.nmea.substr(0, 6) == "$GNRMC") {
+    WakeupMessage message(WakeupMessage::Reason::GPS_GPRMC, msg.nmea);
+    if (xQueueSend(BLE::get().xQueue, &message, 0) != pdTRUE) {
+      markBleDiagnosticEvent(BLE_DIAG_GPS_QUEUE_FULL);
+    }
+  }
+}
+
+void BLE::on_receive(const FanetPacket& msg) {
+  // Short circuit if not initialized
+  if (pServer == nullptr) return;
+
+  // FanetNeighbors subscribed ahead of us, so its traffic table already holds this packet
+  TrafficUpdate update{msg, fanetRadio.getTrafficReport(msg.packet.source())};
+  WakeupMessage message(WakeupMessage::Reason::FANET_RX, update);
+  if (xQueueSend(BLE::get().xQueue, &message, 0) != pdTRUE) {
+    markBleDiagnosticEvent(BLE_DIAG_FANET_QUEUE_FULL);
+  }
+}
+
+bool BLE::processWakeup(TickType_t wait) {
+  WakeupMessage message;  // Reason for waking up, message to send out
+  if (xQueueReceive(xQueue, &message, wait) != pdTRUE) return false;
+  processDiagnostics();
+  handleWakeup(message);
+
+  // GPS and FANET sentences wait in the batch for the next timer tick, at most 100 ms, and go
+  // out in the same notifications as LK8EX1 instead of one notification each
+  if (message.reason == WakeupMessage::Reason::PERIODIC) flushNus();
+  return true;
+}
+
+void BLE::handleWakeup(WakeupMessage& message) {
+  // Nobody to send to; don't bother formatting
+  if (connections.load(std::memory_order_relaxed) == 0) return;
+
+  switch (message.reason) {
+    case WakeupMessage::Reason::PERIODIC:
+      // Periodic wakeup to send out the last known Vario & Baro data, on every tick at the
+      // full 10 Hz or every few ticks at lower rates
+      if (++varioTicks < PERIODIC_HZ / settings.labs_bleVarioHz) break;
+      varioTicks = 0;
+      sendVarioUpdate();
+      break;
+    case WakeupMessage::Reason::FANET_RX:
+      sendFanetUpdate(etl::get<TrafficUpdate>(message.message));
+      break;
+    case WakeupMessage::Reason::GPS_GPGGA:
+      sendGpsSentence(etl::get<NMEAString>(message.message), lastGpsGgaMs);
+      break;
+    case WakeupMessage::Reason::GPS_GPRMC:
+      sendGpsSentence(etl::get<NMEAString>(message.message), lastGpsGprmcMs);
+      break;
+  }
+}
+
+void BLE::sendGpsSentence(const NMEAString& nmea, unsigned long& lastSentMs) {
+  // Skip sentences that come too soon for the chosen rate, allowing a quarter of the interval
+  // for jitter in when they arrive so that a matching GPS rate passes every fix
+  const unsigned long intervalMs = 1000 / settings.labs_bleGpsHz;
+  const unsigned long now = millis();
+  if (now - lastSentMs < intervalMs - intervalMs / 4) return;
+  lastSentMs = now;
+  queueNus(nmea.c_str());
+}
+
+void BLE::timerCallback(TimerHandle_t timer) {
+  // Send a message on the queue that it's time to do a periodic task send
+  // (wake up the BLE task)
+  if (BLE::get().xQueue == nullptr) return;
+  WakeupMessage message(WakeupMessage::Reason::PERIODIC);
+  if (xQueueSend(BLE::get().xQueue, &message, 0) != pdTRUE) {
+    markBleDiagnosticEvent(BLE_DIAG_PERIODIC_QUEUE_FULL);
+  }
+}
+
+void BLE::sendVarioUpdate() {
+  if (baro.state() != Barometer::State::Ready) return;
+  int32_t climbRate = baro.climbRateFilteredValid() ? baro.climbRateFiltered() : 0;
+  char temperature[16] = "99";
+  if (ambient.state() == Ambient::State::Ready) {
+    snprintf(temperature, sizeof(temperature), "%.1f", ambient.temp());
+  }
+  const int battery = std::clamp<int>(power.info().batteryPercent, 0, 100);
+
+  char sentence[80];
+  snprintf(sentence, sizeof(sentence), "$LK8EX1,%d,%u,%d,%s,%d,",
+           static_cast<int>(baro.pressure()), static_cast<unsigned>(baro.altF()),
+           static_cast<int>(climbRate), temperature, 1000 + battery);
+  queueNus(sentence);
+}
+
+void BLE::queueNus(const char* sentence) {
+  if (!nusBatch.add(sentence)) {
+    // Full: send what is there and start again
+    flushNus();
+    if (!nusBatch.add(sentence)) {
+      nusSentenceDropCount.fetch_add(1, std::memory_order_relaxed);
+      markBleDiagnosticEvent(BLE_DIAG_NUS_SENTENCE_DROPPED);
+      return;
+    }
+  }
+  nusSentenceCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BLE::recordNusNotifyResult(bool success) {
+  if (success) {
+    nusNotifySuccessCount.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    nusNotifyFailureCount.fetch_add(1, std::memory_order_relaxed);
+    markBleDiagnosticEvent(BLE_DIAG_NUS_NOTIFY_FAILED);
+  }
+}
+
+void BLE::processDiagnostics() {
+  const uint32_t events = pendingBleDiagnosticEvents.exchange(0, std::memory_order_relaxed);
+  if (events & BLE_DIAG_CONNECTED) heap_monitor::checkpoint("ble-connected");
+  if (events & BLE_DIAG_DISCONNECTED) {
+    const int reason = lastBleDisconnectReason.load(std::memory_order_relaxed);
+    diagnostic_logs::appendSystemEvent("ble", "disconnected", String(reason), "reason", reason,
+                                       true);
+    diagnostic_logs::appendSystemEvent(
+        "ble", "notify_success", String(), "count",
+        static_cast<int32_t>(nusNotifySuccessCount.load(std::memory_order_relaxed)), true);
+    diagnostic_logs::appendSystemEvent(
+        "ble", "notify_failure", String(), "count",
+        static_cast<int32_t>(nusNotifyFailureCount.load(std::memory_order_relaxed)), true);
+    diagnostic_logs::appendSystemEvent(
+        "ble", "sentences", String(), "count",
+        static_cast<int32_t>(nusSentenceCount.load(std::memory_order_relaxed)), true);
+    diagnostic_logs::appendSystemEvent(
+        "ble", "sentence_dropped", String(), "count",
+        static_cast<int32_t>(nusSentenceDropCount.load(std::memory_order_relaxed)), true);
+    heap_monitor::checkpoint("ble-disconnected");
+  }
+  if (events & BLE_DIAG_ADV_RESTARTED) heap_monitor::checkpoint("ble-adv-restart-ok");
+  if (events & BLE_DIAG_ADV_RESTART_FAILED) heap_monitor::checkpoint("ble-adv-restart-fail");
+  if (events & BLE_DIAG_NUS_NOTIFY_FAILED) heap_monitor::checkpoint("ble-notify-fail");
+  if (events & BLE_DIAG_PERIODIC_QUEUE_FULL) heap_monitor::checkpoint("ble-periodic-q-full");
+  if (events & BLE_DIAG_GPS_QUEUE_FULL) heap_monitor::checkpoint("ble-gps-q-full");
+  if (events & BLE_DIAG_FANET_QUEUE_FULL) heap_monitor::checkpoint("ble-fanet-q-full");
+  if (events & BLE_DIAG_NUS_SENTENCE_DROPPED) heap_monitor::checkpoint("ble-sentence-drop");
+
+  const unsigned long now = millis();
+  if (now - lastBleHeapCheckMs >= BLE_HEAP_CHECK_INTERVAL_MS) {
+    if (!heap_caps_check_integrity_all(false)) {
+      heap_monitor::checkpoint("ble-heap-invalid");
+    }
+    lastBleHeapCheckMs = now;
+  }
+}
+
+void BLE::sendFanetUpdate(TrafficUpdate& update) {
+  // Is processed when a Fanet packet is received
+  // We only want to send BLE updates if it's a Tracking update
+
+  auto& msg = update.packet;
+  auto& packet = msg.packet;
+  if (packet.header().type() != FANET::Header::MessageType::TRACKING) {
+    return;
+  }
+
+  // The traffic table works out our offsets; it has none until we have a fix
+  const fanet_traffic::Report& report = update.report;
+  if (!report.valid) {
+    return;
+  }
+
+  auto& payload = etl::get<FANET::TrackingPayload>(packet.payload().value());
+
+  // PFLAA lines to notify where the traffic is
+  // PFLAA,<AlarmLevel>,<RelativeNorth>,<RelativeEast>,
+  // <RelativeVertical>,<IDType>,<ID>,<Track>,<TurnRate>,<GroundSpeed>,
+  // <ClimbRate>,<AcftType>[,<NoTrack>[,<Source>,<RSSI>]]
+  // See https://
+  // www.flarm.com/wp-content/uploads/2024/04/FTD-012-Data-Port-Interface-Control-Document-ICD-7.19.pdf
+
+  // Aircraft type does not marry up between PFLAA and Fanet types
+  char aircraftType;
+  switch (payload.aircraftType()) {
+    case FANET::TrackingPayload::AircraftType::GLIDER:
+      aircraftType = '6';  //  hang glider (hard)
+      break;
+    case FANET::TrackingPayload::AircraftType::PARAGLIDER:
+      aircraftType = '7';  // paraglider (soft)
+      break;
+    default:
+      aircraftType = 'A';
+      break;
+  }
+
+  // Example of one that works: $PFLAA,0,-4,9,-3,2,FB5F20,98,,0,0.0,7,0*0B
+  char sentence[120];
+  snprintf(sentence, sizeof(sentence),
+           "$PFLAA,"  // FLARM/FANET Aircraft Update
+           "%d,"      // Alarm level, 0 means informational
+           "%d,"      // Relative north in meters
+           "%d,"      // Relative east
+           "%d,"      // Relative vertical
+           "2,"       // IDType
+           "%s,"      // ID of aircraft
+           "%d,"      // Track heading
+           ","        // Turn rate
+           "%.2f,"    // Ground speed
+           "%.2f,"    // Climb rate
+           "%c,"      // Aircraft type
+           "%d,"      // No track
+           "0,"       // source is FLARM
+           "%d",      // RSSI
+           static_cast<int>(report.alarm), static_cast<int>(report.north),
+           static_cast<int>(report.east), static_cast<int>(report.up),
+           FanetAddressToString(packet.source()).c_str(), static_cast<int>(payload.groundTrack()),
+           payload.speed() / 3.6, payload.climbRate(), aircraftType, payload.tracking() ? 0 : 1,
+           static_cast<int>(msg.rssi));
+
+  queueNus(sentence);
+  Serial.println(sentence);
+}
@@ -4,16 +4,22 @@
 #include <etl/message_router.h>
 #include <etl/optional.h>
 #include <etl/set.h>
+#include "comms/fanet_traffic.h"
 #include "dispatch/message_types.h"
 #include "fanet/groundTracking.hpp"
 #include "fanet/neighbourTable.hpp"
 #include "fanet/protocol.hpp"
+#include "instruments/baro.h"
 #include "instruments/gps.h"
+#include "logging/log.h"
 
 #include "logging/telemetry.h"
+#include "utils/lock_guard.h"
 
 /// @brief A class to handle FANET neighbor statistics in addition to base Fanet neighbor table.
-struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket>,
+/// Tracking reports also feed the traffic table, which predicts conflicts at each GPS fix.  The
+/// table is updated by bus handlers and read by the display and BLE, so it has its own mutex.
+struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket, GpsReading>,
                         public IMessageSource {
  public:
   struct Neighbor {
@@ -27,6 +33,7 @@ struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket>,
   };
 
   using NeighborMap = etl::map<uint32_t, Neighbor, FANET::Protocol::FANET_MAX_NEIGHBORS>;
+  using TrafficTable = fanet_traffic::Table<FANET::Protocol::FANET_MAX_NEIGHBORS>;
 
   // IMessageSource
   void publishTo(etl::imessage_bus* bus) { bus_ = bus; }
@@ -34,11 +41,30 @@ struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket>,
 
  private:
   NeighborMap neighbors_;
+  TrafficTable traffic_;
   etl::imessage_bus* bus_ = nullptr;
 
+  // Guards traffic_
+  static SemaphoreHandle_t trafficMutex() {
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    return mutex;
+  }
+
  public:
   const NeighborMap& get() const { return neighbors_; }
 
+  /// @brief The aircraft with the highest collision alarm at the last GPS fix
+  fanet_traffic::Report threat() const {
+    LockGuard lock(trafficMutex());
+    return traffic_.threat();
+  }
+
+  /// @brief Where an aircraft is relative to us, and its alarm level
+  fanet_traffic::Report report(const FANET::Address& address) const {
+    LockGuard lock(trafficMutex());
+    return traffic_.report(address.asUint());
+  }
+
 #ifdef UNIT_TESTING
   // Test accessor methods
   void addNeighborForTesting(const Neighbor& neighbor) {
@@ -108,8 +134,16 @@ struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket>,
         lon = longitude;
         hasLocationData = true;
 
+        fanet_traffic::Report report;
+        {
+          LockGuard lock(trafficMutex());
+          traffic_.update(neighbor.address.asUint(), latitude, longitude,
+                          trackingPayload.altitude(), trackingPayload.speed() / 3.6f,
+                          trackingPayload.groundTrack(), trackingPayload.climbRate(), millis());
+          report = traffic_.report(neighbor.address.asUint());
+        }
         neighbor.distanceKm =
-            gps.distanceBetween(gps.location.lat(), gps.location.lng(), latitude, longitude) / 1000;
+            report.valid ? etl::optional<float>(report.distance / 1000) : etl::nullopt;
         neighbor.groundTrackingMode = etl::nullopt;
 
       } else if (msg.packet.header().type() == FANET::Header::MessageType::GROUND_TRACKING) {
@@ -127,8 +161,15 @@ struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket>,
         lon = longitude;
         hasLocationData = true;
 
-        neighbor.distanceKm =
-            gps.distanceBetween(gps.location.lat(), gps.location.lng(), latitude, longitude) / 1000;
+        float distance;
+        bool hasDistance;
+        {
+          LockGuard lock(trafficMutex());
+          // On the ground, so no longer traffic to us
+          traffic_.remove(neighbor.address.asUint());
+          hasDistance = traffic_.distanceTo(latitude, longitude, distance);
+        }
+        neighbor.distanceKm = hasDistance ? etl::optional<float>(distance / 1000) : etl::nullopt;
         neighbor.groundTrackingMode = trackingPayload.groundType();
       }
 
@@ -149,5 +190,22 @@ struct FanetNeighbors : public etl::message_router<FanetNeighbors, FanetPacket>,
     }
   }
 
+  // Re-predicts every aircraft in the traffic table from our new position and velocity
+  void on_receive(const GpsReading& msg) {
+    GpsFix fix = msg.gps;  // Needed as lat() calls are not const
+    if (!fix.location.isValid()) return;
+
+    fanet_traffic::Own own;
+    own.lat = fix.location.lat();
+    own.lon = fix.location.lng();
+    own.altitude = fix.altitude.meters();
+    own.speed = fix.speed.mps();
+    own.track = fix.course.deg();
+    own.climb = baro.climbRateFilteredValid() ? baro.climbRateFiltered() / 100.0f : 0;
+    own.flying = flightTimer_isRunning();
+    LockGuard lock(trafficMutex());
+    traffic_.assess(own, millis());
+  }
+
   void on_receive_unknown(const etl::imessage& msg) {}
 };
\ No newline at end of file
@@ -29,6 +29,8 @@ namespace {
   constexpr uint32_t FANET_SPI_PROBE_BUSY_TIMEOUT_MS = 100;
   constexpr uint32_t FANET_SPI_LOCK_TIMEOUT_MS = 25;
   constexpr uint32_t FANET_RADIO_SPI_CLOCK_HZ = 1000000;
+  // The service core: core 1 belongs to the realtime loop
+  constexpr BaseType_t FANET_TASK_CORE = 0;
 
   bool sx1262StatusLooksValid(uint8_t status) { return status != 0x00 && status != 0xFF; }
 
@@ -529,9 +531,9 @@ void FanetRadio::setup() {
   setupFanetHandler();
 
   // Create the TX Task
-  auto taskCreateCode = xTaskCreate(taskRadioTx, "FanetTx", 4096, nullptr,
-                                    1,  // Typical lower priority task
-                                    &x_fanet_tx_task);
+  auto taskCreateCode = xTaskCreatePinnedToCore(taskRadioTx, "FanetTx", 4096, nullptr,
+                                                1,  // Typical lower priority task
+                                                &x_fanet_tx_task, FANET_TASK_CORE);
   if (taskCreateCode != pdPASS) {
     Serial.println((String) "Creating Tx task failed: " + taskCreateCode);
     state = FanetRadioState::FAILED_OTHER;
@@ -542,9 +544,9 @@ void FanetRadio::setup() {
   heap_monitor::checkpoint("fanet-tx-task");
 
   // Create the RX Task
-  taskCreateCode = xTaskCreate(taskRadioRx, "FanetRx", 4096, nullptr,
-                               1,  // Typical lower priority task
-                               &x_fanet_rx_task);
+  taskCreateCode = xTaskCreatePinnedToCore(taskRadioRx, "FanetRx", 4096, nullptr,
+                                           1,  // Typical lower priority task
+                                           &x_fanet_rx_task, FANET_TASK_CORE);
   if (taskCreateCode != pdPASS) {
     Serial.print((String) "Creating Rx task failed: " + taskCreateCode);
     state = FanetRadioState::FAILED_OTHER;
@@ -822,7 +824,7 @@ void FanetRadio::on_receive(const GpsReading& msg) {
   }
 
   // Update the FANet radio module of our current location
-  TinyGPSPlus gps = msg.gps;  // Needed as lat() calls are not const :'(
+  GpsFix gps = msg.gps;  // Needed as lat() calls are not const :'(
   float climbRate = 0;
   if (baro.climbRateFilteredValid()) {
     climbRate = baro.climbRateFiltered() / 100.0f;
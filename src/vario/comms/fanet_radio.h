@@ -77,6 +77,14 @@ class FanetRadio : public etl::message_router<FanetRadio, GpsReading>,
   /// @brief Gets a copy of the neighbor table
   const FanetNeighbors::NeighborMap& getNeighborTable() const;
 
+  /// @brief The aircraft with the highest collision alarm, as of the last GPS fix
+  fanet_traffic::Report getTrafficThreat() const { return neighbors.threat(); }
+
+  /// @brief Where an aircraft is relative to us, and its collision alarm
+  fanet_traffic::Report getTrafficReport(const FANET::Address& address) const {
+    return neighbors.report(address);
+  }
+
   // IMessageSource
   void publishTo(etl::imessage_bus* bus) {
     bus_ = bus;
@@ -0,0 +1,103 @@
+#include "comms/fanet_traffic.h"
+
+namespace fanet_traffic {
+  namespace {
+    // WGS84 equatorial radius, as the PFLAA offsets were always computed with
+    constexpr double EARTH_RADIUS_M = 6378137;
+    constexpr float METRES_PER_E7 = EARTH_RADIUS_M * M_PI / 180 / 1e7;
+    constexpr int64_t FULL_CIRCLE_E7 = 3600000000LL;
+
+    // Relative speeds below this (m/s) are treated as no relative motion
+    constexpr float STILL = 0.01f;
+  }  // namespace
+
+  Prediction predict(const Relative& r) {
+    Prediction p;
+    const float vv = r.velocityEast * r.velocityEast + r.velocityNorth * r.velocityNorth;
+    const float rv = r.east * r.velocityEast + r.north * r.velocityNorth;
+    const float rr = r.east * r.east + r.north * r.north;
+
+    p.timeToCpa = vv > STILL * STILL && rv < 0 ? -rv / vv : 0;
+    const float cpaEast = r.east + r.velocityEast * p.timeToCpa;
+    const float cpaNorth = r.north + r.velocityNorth * p.timeToCpa;
+    p.distanceAtCpa = sqrtf(cpaEast * cpaEast + cpaNorth * cpaNorth);
+    p.timeToConflict = INFINITY;
+
+    // When the aircraft is within the conflict radius of us...
+    float horizontalEnter = 0;
+    float horizontalLeave = HORIZON_S;
+    if (vv <= STILL * STILL) {
+      if (rr > CONFLICT_RADIUS_M * CONFLICT_RADIUS_M) return p;
+    } else {
+      // |r + vt| = radius
+      const float discriminant = rv * rv - vv * (rr - CONFLICT_RADIUS_M * CONFLICT_RADIUS_M);
+      if (discriminant < 0) return p;
+      const float root = sqrtf(discriminant);
+      horizontalEnter = (-rv - root) / vv;
+      horizontalLeave = (-rv + root) / vv;
+    }
+
+    // ...and when it is within the conflict height
+    float verticalEnter = 0;
+    float verticalLeave = HORIZON_S;
+    if (fabsf(r.climb) <= STILL) {
+      if (fabsf(r.up) > CONFLICT_HEIGHT_M) return p;
+    } else {
+      const float below = (-CONFLICT_HEIGHT_M - r.up) / r.climb;
+      const float above = (CONFLICT_HEIGHT_M - r.up) / r.climb;
+      verticalEnter = below < above ? below : above;
+      verticalLeave = below < above ? above : below;
+    }
+
+    float enter = horizontalEnter > verticalEnter ? horizontalEnter : verticalEnter;
+    float leave = horizontalLeave < verticalLeave ? horizontalLeave : verticalLeave;
+    if (enter < 0) enter = 0;
+    if (leave > HORIZON_S) leave = HORIZON_S;
+    if (enter > leave) return p;
+
+    // Already close but moving apart, as when circling together in a thermal
+    if (enter == 0 && rv >= 0) return p;
+
+    p.timeToConflict = enter;
+    return p;
+  }
+
+  Alarm alarmFor(float timeToConflict) {
+    if (timeToConflict <= 8) return Alarm::Urgent;
+    if (timeToConflict <= 12) return Alarm::Important;
+    if (timeToConflict <= 18) return Alarm::Low;
+    return Alarm::None;
+  }
+
+  void assess(const Relative& relative, float ownTrack, bool alarms, Report& report) {
+    report.valid = true;
+    report.north = relative.north;
+    report.east = relative.east;
+    report.up = relative.up;
+    report.distance = sqrtf(relative.east * relative.east + relative.north * relative.north);
+    report.timeToConflict = alarms ? predict(relative).timeToConflict : INFINITY;
+    report.alarm = alarmFor(report.timeToConflict);
+
+    float bearing = atan2f(relative.east, relative.north) * 180 / (float)M_PI - ownTrack;
+    while (bearing < 0) bearing += 360;
+    const uint8_t clock = (uint8_t)lroundf(bearing / 30) % 12;
+    report.clock = clock == 0 ? 12 : clock;
+  }
+
+  int32_t toE7(double degrees) { return (int32_t)lround(degrees * 1e7); }
+
+  void Frame::centreOn(double lat, double lon) {
+    latE7_ = toE7(lat);
+    lonE7_ = toE7(lon);
+    metresPerE7East_ = METRES_PER_E7 * cosf((float)(lat * M_PI / 180));
+    valid_ = true;
+  }
+
+  void Frame::offset(int32_t latE7, int32_t lonE7, float& east, float& north) const {
+    north = (latE7 - latE7_) * METRES_PER_E7;
+    int64_t dLon = (int64_t)lonE7 - lonE7_;
+    if (dLon > FULL_CIRCLE_E7 / 2) dLon -= FULL_CIRCLE_E7;
+    if (dLon < -FULL_CIRCLE_E7 / 2) dLon += FULL_CIRCLE_E7;
+    east = dLon * metresPerE7East_;
+  }
+}  // namespace fanet_traffic
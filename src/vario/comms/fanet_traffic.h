@@ -0,0 +1,241 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Collision prediction for FANET traffic.
+//
+// A Table keeps the last report of each neighbour (position, velocity, climb and when it was
+// heard) in parallel arrays, one slot per aircraft.  Once per GPS fix assess() sweeps the whole
+// table: each aircraft is dead-reckoned to the present, placed in a flat-earth frame centred on
+// us, and its closest point of approach (CPA) and time to conflict found.  The time to conflict
+// sets the FLARM alarm level that PFLAA reports and the flight pages warn with.
+//
+// Nothing here allocates or locks; FanetNeighbors guards its table.
+namespace fanet_traffic {
+  // As PFLAA reports them
+  enum class Alarm : uint8_t { None = 0, Low = 1, Important = 2, Urgent = 3 };
+
+  // An aircraft predicted to come within both of these of us is a conflict
+  constexpr float CONFLICT_RADIUS_M = 50;
+  constexpr float CONFLICT_HEIGHT_M = 25;
+  // How far ahead conflicts are looked for.  FLARM's lowest alarm starts 18 s out.
+  constexpr float HORIZON_S = 20;
+  // Reports older than this are not extrapolated further and raise no alarm
+  constexpr uint32_t MAX_EXTRAPOLATION_MS = 10000;
+  // Aircraft not heard from for this long are dropped
+  constexpr uint32_t EXPIRY_MS = 120000;
+
+  // Our own state at a GPS fix
+  struct Own {
+    double lat;
+    double lon;
+    float altitude;       // m
+    float speed;          // Ground speed, m/s
+    float track;          // Degrees true
+    float climb;          // m/s
+    bool flying = false;  // No alarms are raised on the ground
+  };
+
+  // An aircraft relative to us: metres and m/s, east, north and up
+  struct Relative {
+    float east;
+    float north;
+    float up;
+    float velocityEast;
+    float velocityNorth;
+    float climb;
+  };
+
+  struct Prediction {
+    float timeToCpa;       // s from now, 0 if already diverging
+    float distanceAtCpa;   // m, horizontal
+    float timeToConflict;  // s from now, or INFINITY if no conflict within HORIZON_S
+  };
+
+  Prediction predict(const Relative& relative);
+
+  // FLARM's bands: urgent up to 8 s to conflict, important to 12 s, low to 18 s
+  Alarm alarmFor(float timeToConflict);
+
+  // One aircraft as of the last assessment
+  struct Report {
+    uint32_t address = 0;
+    bool valid = false;  // False until we and the aircraft both have a position
+    Alarm alarm = Alarm::None;
+    float north = 0;     // m from us
+    float east = 0;      // m from us
+    float up = 0;        // m above us
+    float distance = 0;  // m, horizontal
+    float timeToConflict = INFINITY;
+    uint8_t clock = 12;  // Bearing relative to our track, as a clock position (1-12)
+  };
+
+  // Converts reported positions into metres from us
+  class Frame {
+   public:
+    void centreOn(double lat, double lon);
+    bool valid() const { return valid_; }
+
+    void offset(int32_t latE7, int32_t lonE7, float& east, float& north) const;
+
+   private:
+    bool valid_ = false;
+    int32_t latE7_ = 0;
+    int32_t lonE7_ = 0;
+    float metresPerE7East_ = 0;
+  };
+
+  int32_t toE7(double degrees);
+
+  // Fills in everything but the address from an aircraft's position and velocity relative to us
+  void assess(const Relative& relative, float ownTrack, bool alarms, Report& report);
+
+  template <size_t CAPACITY>
+  class Table {
+   public:
+    size_t size() const { return count_; }
+
+    // A report from a flying aircraft.  speed is ground speed in m/s, track in degrees true and
+    // climb in m/s.  When the table is full the aircraft heard from longest ago makes way.
+    void update(uint32_t address, double lat, double lon, float altitude, float speed, float track,
+                float climb, uint32_t nowMs) {
+      int i = find(address);
+      if (i < 0) i = allocate(address);
+      latE7_[i] = toE7(lat);
+      lonE7_[i] = toE7(lon);
+      altitude_[i] = altitude;
+      const float radians = track * (float)M_PI / 180;
+      velocityEast_[i] = speed * sinf(radians);
+      velocityNorth_[i] = speed * cosf(radians);
+      climb_[i] = climb;
+      heardMs_[i] = nowMs;
+      if (frame_.valid()) assessOne(i, nowMs);
+    }
+
+    void remove(uint32_t address) {
+      const int i = find(address);
+      if (i >= 0) removeAt(i);
+    }
+
+    // Re-centres the table on our latest fix and re-predicts every aircraft
+    void assess(const Own& own, uint32_t nowMs) {
+      frame_.centreOn(own.lat, own.lon);
+      own_ = own;
+      const float radians = own.track * (float)M_PI / 180;
+      ownVelocityEast_ = own.speed * sinf(radians);
+      ownVelocityNorth_ = own.speed * cosf(radians);
+
+      threat_ = Report();
+      for (size_t i = 0; i < count_;) {
+        if (nowMs - heardMs_[i] > EXPIRY_MS) {
+          removeAt(i);
+          continue;
+        }
+        assessOne(i, nowMs);
+        const Report& r = reports_[i];
+        if (r.alarm > threat_.alarm ||
+            (r.alarm == threat_.alarm && r.alarm != Alarm::None &&
+             r.timeToConflict < threat_.timeToConflict)) {
+          threat_ = r;
+        }
+        i++;
+      }
+    }
+
+    // The last assessment of an aircraft, not valid if it is not in the table
+    Report report(uint32_t address) const {
+      const int i = find(address);
+      return i < 0 ? Report() : reports_[i];
+    }
+
+    // The aircraft with the highest alarm at the last assess(); alarm is None if there is none
+    const Report& threat() const { return threat_; }
+
+    // Horizontal distance in metres from our last fix to a position, false before the first fix
+    bool distanceTo(double lat, double lon, float& distance) const {
+      if (!frame_.valid()) return false;
+      float east, north;
+      frame_.offset(toE7(lat), toE7(lon), east, north);
+      distance = sqrtf(east * east + north * north);
+      return true;
+    }
+
+   private:
+    int find(uint32_t address) const {
+      for (size_t i = 0; i < count_; i++) {
+        if (address_[i] == address) return i;
+      }
+      return -1;
+    }
+
+    int allocate(uint32_t address) {
+      size_t i = count_;
+      if (count_ < CAPACITY) {
+        count_++;
+      } else {
+        i = 0;
+        for (size_t j = 1; j < count_; j++) {
+          if ((int32_t)(heardMs_[j] - heardMs_[i]) < 0) i = j;
+        }
+      }
+      address_[i] = address;
+      reports_[i] = Report();
+      reports_[i].address = address;
+      return i;
+    }
+
+    // Keeps the slots packed by moving the last one into the gap
+    void removeAt(size_t i) {
+      const size_t last = --count_;
+      if (i == last) return;
+      address_[i] = address_[last];
+      latE7_[i] = latE7_[last];
+      lonE7_[i] = lonE7_[last];
+      altitude_[i] = altitude_[last];
+      velocityEast_[i] = velocityEast_[last];
+      velocityNorth_[i] = velocityNorth_[last];
+      climb_[i] = climb_[last];
+      heardMs_[i] = heardMs_[last];
+      reports_[i] = reports_[last];
+    }
+
+    void assessOne(size_t i, uint32_t nowMs) {
+      const uint32_t ageMs = nowMs - heardMs_[i];
+      const bool current = ageMs <= MAX_EXTRAPOLATION_MS;
+      const float age = (current ? ageMs : MAX_EXTRAPOLATION_MS) / 1000.0f;
+
+      Relative relative;
+      frame_.offset(latE7_[i], lonE7_[i], relative.east, relative.north);
+      relative.east += velocityEast_[i] * age;
+      relative.north += velocityNorth_[i] * age;
+      relative.up = altitude_[i] + climb_[i] * age - own_.altitude;
+      relative.velocityEast = velocityEast_[i] - ownVelocityEast_;
+      relative.velocityNorth = velocityNorth_[i] - ownVelocityNorth_;
+      relative.climb = climb_[i] - own_.climb;
+
+      fanet_traffic::assess(relative, own_.track, own_.flying && current, reports_[i]);
+    }
+
+    // Last reports, one slot per aircraft, [0, count_) in use
+    uint32_t address_[CAPACITY];
+    int32_t latE7_[CAPACITY];
+    int32_t lonE7_[CAPACITY];
+    float altitude_[CAPACITY];       // m
+    float velocityEast_[CAPACITY];   // m/s
+    float velocityNorth_[CAPACITY];  // m/s
+    float climb_[CAPACITY];          // m/s
+    uint32_t heardMs_[CAPACITY];
+    size_t count_ = 0;
+
+    // Results of the last assessment of each slot
+    Report reports_[CAPACITY];
+    Report threat_;
+
+    Frame frame_;
+    Own own_ = {};
+    float ownVelocityEast_ = 0;
+    float ownVelocityNorth_ = 0;
+  };
+}  // namespace fanet_traffic
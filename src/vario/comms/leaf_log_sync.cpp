@@ -1,6 +1,5 @@
 #include "comms/leaf_log_sync.h"
 
-#include <SD_MMC.h>
 #include <WiFi.h>
 #include <time.h>
 
@@ -31,17 +30,24 @@ void LeafLogSync::beginSession(bool fromEject) {
 }
 
 void LeafLogSync::beginEligibilityScan() {
-  if (scanDirectory_) scanDirectory_.close();
+  endEligibilityScan();
   current_ = LeafLogCandidate();
   pendingCount_ = 0;
   cancelRequested_.store(false, std::memory_order_release);
   wifiAttemptStarted_ = false;
   timeStarted_ = false;
-  scanDirectory_ = SD_MMC.open(LogbookStore::directoryPath());
+  scanListed_ = LogbookStore::entryPaths(scanPaths_);
   state_ = State::CheckingEligibility;
   stateStartedMs_ = millis();
 }
 
+void LeafLogSync::endEligibilityScan() {
+  scanPaths_.clear();
+  scanPaths_.shrink_to_fit();
+  scanIndex_ = 0;
+  scanListed_ = false;
+}
+
 void LeafLogSync::update() {
   if (state_ == State::Idle) {
     if (sdcard.takeExplicitEject())
@@ -83,15 +89,13 @@ void LeafLogSync::update() {
     case State::CheckingEligibility: {
       const auto credential = leaf_log_credentials::load();
       if (!settings.labs_leafLog || !credential.linked() || !sdcard.isMounted() ||
-          !scanDirectory_) {
+          !scanListed_) {
         finishToMassStorage();
         return;
       }
 
-      String path;
-      while (!(path = scanDirectory_.getNextFileName()).isEmpty()) {
-        path = LogbookStore::normalizePath(path);
-        if (!LogbookStore::isLogbookJsonPath(path)) continue;
+      while (scanIndex_ < scanPaths_.size()) {
+        const String path = scanPaths_[scanIndex_++];
         LeafLogCandidate candidate;
         if (!LogbookStore::classifyForLeafLog(path, candidate)) return;
         if (candidate.disposition == LeafLogCandidate::Disposition::Rejected &&
@@ -109,7 +113,7 @@ void LeafLogSync::update() {
         }
         return;
       }
-      scanDirectory_.close();
+      endEligibilityScan();
       if (!sessionTotalKnown_) {
         sessionTotalCount_ = pendingCount_;
         sessionTotalKnown_ = true;
@@ -219,7 +223,7 @@ void LeafLogSync::update() {
 }
 
 void LeafLogSync::prepareForCharging() {
-  if (scanDirectory_) scanDirectory_.close();
+  endEligibilityScan();
   buttons.disarmUrgentPressCapture();
   cancelRequested_.store(false, std::memory_order_release);
   powerOnRequested_.store(false, std::memory_order_release);
@@ -230,7 +234,7 @@ void LeafLogSync::prepareForCharging() {
 }
 
 void LeafLogSync::prepareForOperating() {
-  if (scanDirectory_) scanDirectory_.close();
+  endEligibilityScan();
   buttons.disarmUrgentPressCapture();
   cancelRequested_.store(false, std::memory_order_release);
   powerOnRequested_.store(false, std::memory_order_release);
@@ -261,7 +265,7 @@ void LeafLogSync::finishRequestedExit() {
 void LeafLogSync::finishForPowerOn() {
   buttons.disarmUrgentPressCapture();
   buttons.suppressEventsUntilRelease();
-  if (scanDirectory_) scanDirectory_.close();
+  endEligibilityScan();
   leaf_wifi::disconnectFromNetwork();
   cancelRequested_.store(false, std::memory_order_release);
   centerIntentStartedMs_ = 0;
@@ -279,7 +283,7 @@ void LeafLogSync::finishToMassStorage() {
   const bool suppressButton = buttons.urgentPressLatched();
   buttons.disarmUrgentPressCapture();
   if (suppressButton) buttons.suppressEventsUntilRelease();
-  if (scanDirectory_) scanDirectory_.close();
+  endEligibilityScan();
   leaf_wifi::disconnectFromNetwork();
   cancelRequested_.store(false, std::memory_order_release);
   powerOnRequested_.store(false, std::memory_order_release);
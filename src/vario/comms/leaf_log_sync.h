@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <FS.h>
 #include <atomic>
+#include <vector>
 
 #include "logbook/logbook_store.h"
 
@@ -44,6 +45,7 @@ class LeafLogSync {
  private:
   void beginSession(bool fromEject);
   void beginEligibilityScan();
+  void endEligibilityScan();
   void finishRequestedExit();
   void finishForPowerOn();
   void finishToMassStorage();
@@ -51,7 +53,10 @@ class LeafLogSync {
                               size_t fileSize = 0, size_t responseSize = 0);
 
   State state_ = State::Idle;
-  File scanDirectory_;
+  // Logbook entries to check, listed when the scan begins and checked one per update()
+  std::vector<String> scanPaths_;
+  size_t scanIndex_ = 0;
+  bool scanListed_ = false;
   LeafLogCandidate current_;
   std::atomic<bool> cancelRequested_{false};
   std::atomic<bool> powerOnRequested_{false};
@@ -0,0 +1,46 @@
+#include "comms/nus_batch.h"
+
+namespace nus_batch {
+  namespace {
+    // '*', two hex digits, CR and LF
+    constexpr size_t SUFFIX_LENGTH = 5;
+
+    constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+  }  // namespace
+
+  bool Batch::add(const char* sentence, size_t length) {
+    if (length == 0 || sentence[0] != '$') return false;
+
+    // The body runs from after the '$' to the checksum, line ending or end of string
+    uint8_t checksum = 0;
+    size_t end = 1;
+    while (end < length && sentence[end] != '*' && sentence[end] != '\r' && sentence[end] != '\n' &&
+           sentence[end] != '\0') {
+      checksum ^= (uint8_t)sentence[end];
+      end++;
+    }
+    if (length_ + end + SUFFIX_LENGTH > CAPACITY) return false;
+
+    memcpy(buffer_ + length_, sentence, end);
+    uint8_t* suffix = buffer_ + length_ + end;
+    suffix[0] = '*';
+    suffix[1] = HEX_DIGITS[checksum >> 4];
+    suffix[2] = HEX_DIGITS[checksum & 0x0F];
+    suffix[3] = '\r';
+    suffix[4] = '\n';
+    length_ += end + SUFFIX_LENGTH;
+    sentences_++;
+    return true;
+  }
+
+  size_t Batch::nextChunk(size_t offset, size_t payload) const {
+    const size_t remaining = length_ - offset;
+    if (remaining <= payload) return remaining;
+
+    // End on the last line ending that fits, so no sentence straddles two notifications
+    for (size_t i = offset + payload; i > offset; i--) {
+      if (buffer_[i - 1] == '\n') return i - offset;
+    }
+    return payload;
+  }
+}  // namespace nus_batch
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// NMEA sentences coalesced into Nordic UART (NUS) notifications.
+//
+// The BLE task formats sentences into one Batch as they become due and flushes it on each tick of
+// its 10 Hz timer.  Each notification carries as many whole sentences as fit in the connection's
+// ATT payload (the negotiated MTU less the 3 byte ATT header), so LK8EX1, GGA, RMC and a few
+// PFLAA lines together cost one or two notifications instead of one each.  A sentence is only
+// split across notifications when it is longer than a whole payload, which happens before the
+// client has exchanged MTUs (the 23 byte default leaves 20); clients reassemble lines on CRLF.
+//
+// Nothing here allocates; the buffer lives in the BLE singleton.
+namespace nus_batch {
+  // ATT_MTU until the client asks for more, and the notification header that comes out of it
+  constexpr uint16_t DEFAULT_MTU = 23;
+  constexpr uint16_t ATT_HEADER = 3;
+  // One wakeup's worth of sentences: LK8EX1, GGA, RMC and several PFLAA lines
+  constexpr size_t CAPACITY = 512;
+
+  // Bytes of sentence one notification can carry at `mtu`
+  inline size_t payloadSize(uint16_t mtu) {
+    return (mtu > DEFAULT_MTU ? mtu : DEFAULT_MTU) - ATT_HEADER;
+  }
+
+  class Batch {
+   public:
+    // Appends the sentence that starts at `sentence` ('$'), up to any checksum or line ending it
+    // already has, followed by its checksum and CRLF.  Returns false, appending nothing, if it
+    // does not fit.
+    bool add(const char* sentence, size_t length);
+    bool add(const char* sentence) { return add(sentence, strlen(sentence)); }
+
+    // Length of the notification that starts at `offset`: the whole sentences that fit in
+    // `payload` bytes, or the first `payload` bytes of one that is longer on its own.
+    size_t nextChunk(size_t offset, size_t payload) const;
+
+    // Hands the batch to `notify(const uint8_t* data, size_t length)` one notification at a time
+    // and empties it.  Returns how many notifications it took.
+    template <typename Notify>
+    size_t flush(uint16_t mtu, Notify&& notify) {
+      const size_t payload = payloadSize(mtu);
+      size_t notifications = 0;
+      for (size_t offset = 0; offset < length_;) {
+        const size_t chunk = nextChunk(offset, payload);
+        notify(buffer_ + offset, chunk);
+        offset += chunk;
+        notifications++;
+      }
+      length_ = 0;
+      sentences_ = 0;
+      return notifications;
+    }
+
+    size_t size() const { return length_; }
+    size_t sentences() const { return sentences_; }
+    bool empty() const { return length_ == 0; }
+    void clear() { length_ = sentences_ = 0; }
+
+   private:
+    uint8_t buffer_[CAPACITY];
+    size_t length_ = 0;
+    size_t sentences_ = 0;
+  };
+}  // namespace nus_batch
@@ -11,12 +11,17 @@
 #include <esp_heap_caps.h>
 #include <math.h>
 #include <time.h>
+#include <atomic>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <vector>
 #include "comms/ble.h"
 #include "comms/factory_discovery.h"
 #include "comms/fanet_radio.h"
 #include "comms/leaf_log_credentials.h"
 #include "comms/ota.h"
+#include "comms/web_assets_gz.h"
 #include "comms/wifi_coordinator.h"
 #include "diagnostics/diagnostic_logs.h"
 #include "diagnostics/heap_monitor.h"
@@ -24,13 +29,19 @@
 #include "diagnostics/self_test/selfTest.h"
 #include "etl/string_stream.h"
 #include "logbook/logbook_store.h"
+#include "logbook/track_preview.h"
 #include "navigation/gpx.h"
 #include "navigation/route_store.h"
 #include "navigation/user_waypoints.h"
 #include "power.h"
 #include "profiles/profile_store.h"
+#include "storage/dir_cache.h"
+#include "storage/preallocated_file.h"
 #include "storage/sd_card.h"
+#include "storage/zip_export.h"
 #include "system/version_info.h"
+#include "taskman.h"
+#include "ui/audio/vario_tones.h"
 #include "ui/display/display.h"
 #include "ui/settings/settings.h"
 #include "utils/lock_guard.h"
@@ -43,9 +54,10 @@ namespace {
   bool user_server_routes_configured = false;
   bool commissioning_routes_configured = false;
   bool debug_routes_configured = false;
-  bool user_app_enabled = false;
-  bool user_app_using_leaf_wifi = false;
-  bool user_app_provisioning = false;
+  // Set by the menus (service task) and read by the web task
+  std::atomic<bool> user_app_enabled{false};
+  std::atomic<bool> user_app_using_leaf_wifi{false};
+  std::atomic<bool> user_app_provisioning{false};
   bool user_app_services_paused = false;
   bool user_app_dns_started = false;
   bool user_app_restart_ble = false;
@@ -96,6 +108,14 @@ namespace {
   static constexpr const char* NAV_UPLOAD_TEMP_FILE = "/waypoints/upload.tmp";
   static constexpr size_t WIFI_SETUP_NETWORKS_JSON_RESERVE = 896;
   static constexpr uint32_t WEB_REQUEST_SLOW_MS = 1000;
+  static constexpr size_t STREAM_BUFFER_BYTES = 4096;
+  // The server runs on core 0 with the WiFi stack, so the flight loop on core 1 never waits on it
+  static constexpr uint32_t WEB_TASK_STACK_BYTES = 12 * 1024;
+  static constexpr UBaseType_t WEB_TASK_PRIORITY = 2;
+  static constexpr BaseType_t WEB_TASK_CORE = 0;
+  static constexpr uint32_t WEB_TASK_POLL_MS = 5;
+  // Longest a handler waits for the main loop to finish its task block before answering 503
+  static constexpr uint32_t MAIN_LOOP_LOCK_TIMEOUT_MS = 250;
   static constexpr const char* LEAF_LOG_BASE_URL = "https://leaflog.norcalflight.com";
   static constexpr uint32_t LEAF_LOG_TIME_MIN_EPOCH = 1704067200UL;
 
@@ -133,9 +153,13 @@ namespace {
       "-----END CERTIFICATE-----\n";
 
   SelfTestMode last_self_test_mode = SelfTestMode::None;
-  bool interactive_self_test_pending = false;
+  // Set by a handler; the main loop powers on and starts the test (webserver_main_loop)
+  volatile bool interactive_self_test_pending = false;
+  bool interactive_self_test_powered_on = false;
   uint32_t interactive_self_test_start_ms = 0;
 
+  TaskHandle_t web_task = NULL;
+
   uint32_t wifi_setup_cycle = 0;
   uint32_t wifi_setup_started_ms = 0;
   uint32_t wifi_setup_last_diag_ms = 0;
@@ -150,6 +174,30 @@ namespace {
   String leaf_log_pair_expires_at = "";
   String leaf_log_previous_token = "";
 
+  // Held by the web task while it serves requests.  The main loop only ever tries it, since a
+  // request in flight (such as a download) can hold it for as long as the client takes.
+  SemaphoreHandle_t serverMutex() {
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    return mutex;
+  }
+
+  // What the menus ask of the server.  They start and stop the radio themselves, then post the
+  // rest (routes, DNS, the network scan and setup state) for the web task to carry out between
+  // requests, so starting or stopping the web app never waits for a client.
+  enum class ServerChange : uint8_t { StartUserApp, StartWifiSetup, Stop };
+
+  QueueHandle_t serverChanges() {
+    static QueueHandle_t queue = xQueueCreate(4, sizeof(ServerChange));
+    return queue;
+  }
+
+  void postServerChange(ServerChange change) {
+    // The menus post at most a start and a stop per visit, so this never fills
+    if (xQueueSend(serverChanges(), &change, 0) != pdTRUE) {
+      Serial.println("WebServer: server change queue full");
+    }
+  }
+
   bool diagnosticsEnabled() {
     return diagnostic_logs::enabled(diagnostic_logs::Log::NetworkEvents);
   }
@@ -579,6 +627,7 @@ namespace {
 
   void beginInteractiveSelfTest() {
     interactive_self_test_pending = false;
+    interactive_self_test_powered_on = false;
     last_self_test_mode = SelfTestMode::Interactive;
     selfTest.begin(false);
   }
@@ -586,32 +635,39 @@ namespace {
   void requestInteractiveSelfTest() {
     last_self_test_mode = SelfTestMode::Interactive;
 
-    if (interactive_self_test_pending) return;
+    if (interactive_self_test_pending || selfTest.updateNeeded()) return;
+
+    interactive_self_test_pending = true;
+  }
+
+  // Main loop only: the self test drives the display, buttons and speaker
+  void updatePendingInteractiveSelfTest() {
+    if (!interactive_self_test_pending) return;
 
     if (power.info().onState == PowerState::OffUSB) {
       display.clear();
       display.showOnSplash();
       display.setPage(MainPage::User);
       power.switchToOnState();
-      if (selfTest.updateNeeded()) return;
+      if (selfTest.updateNeeded()) {
+        interactive_self_test_pending = false;
+        return;
+      }
 
-      interactive_self_test_pending = true;
+      interactive_self_test_powered_on = true;
       interactive_self_test_start_ms = millis();
       return;
     }
 
-    if (selfTest.updateNeeded()) return;
-
-    beginInteractiveSelfTest();
-  }
-
-  void updatePendingInteractiveSelfTest() {
-    if (!interactive_self_test_pending) return;
+    if (selfTest.updateNeeded()) {
+      interactive_self_test_pending = false;
+      return;
+    }
 
     const uint32_t elapsed_ms = millis() - interactive_self_test_start_ms;
-    if (elapsed_ms >= SELF_TEST_POWER_ON_DELAY_MS) {
-      beginInteractiveSelfTest();
-    }
+    if (interactive_self_test_powered_on && elapsed_ms < SELF_TEST_POWER_ON_DELAY_MS) return;
+
+    beginInteractiveSelfTest();
   }
 
   bool isHexDigit(char c) {
@@ -992,6 +1048,7 @@ namespace {
           failNavUpload("Unable to save waypoint file.");
           return;
         }
+        dir_cache::noteChanged(nav_upload_final_path);
         nav_upload_saved_name = filenameFromUploadPath(nav_upload_final_path);
         break;
       case UPLOAD_FILE_ABORTED:
@@ -1021,8 +1078,21 @@ namespace {
 
     const String savedPath = nav_upload_final_path;
     const String savedName = nav_upload_saved_name;
-    const bool loaded = nav_readFile(SD_MMC, savedPath);
-    if (loaded) user_waypoints::loadIntoNavigator();
+    bool loaded = false;
+    uint8_t pointCount = 0;
+    uint8_t routeCount = 0;
+    // Parse into a copy so the main loop keeps running while the card is read
+    std::unique_ptr<Navigator> staged(new (std::nothrow) Navigator());
+    if (staged && nav_readFile(SD_MMC, savedPath, *staged)) {
+      user_waypoints::loadIntoNavigator(*staged);
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (lock) {
+        navigator = *staged;
+        loaded = true;
+        pointCount = staged->loadedFileWaypointCount();
+        routeCount = staged->totalRoutes;
+      }
+    }
 
     String json = "{\"saved\":true,\"loaded\":";
     json += loaded ? "true" : "false";
@@ -1031,9 +1101,9 @@ namespace {
     json += "\",\"path\":\"";
     json += jsonEscape(savedPath);
     json += "\",\"points\":";
-    json += loaded ? navigator.loadedFileWaypointCount() : 0;
+    json += pointCount;
     json += ",\"routes\":";
-    json += loaded ? navigator.totalRoutes : 0;
+    json += routeCount;
     if (!loaded) {
       json += ",\"detail\":\"File was saved, but Leaf could not load it.\"";
     }
@@ -1181,6 +1251,115 @@ namespace {
     target.sendHeader("Expires", "0");
   }
 
+  // Handlers run on the web task and take MainLoopLockGuard around anything the main loop owns.
+  // If the main loop keeps it (a long task block, or a menu starting or stopping this server while
+  // the request is in flight), the request is refused rather than waited for.
+  void sendBusy(WebServer& target) {
+    target.sendHeader("Retry-After", "1");
+    target.send(503, "application/json", "{\"detail\":\"Leaf is busy. Try again.\"}");
+  }
+
+  // Static app files are gzipped at build time (src/scripts/web_assets.py).  The browser must
+  // revalidate every time, but after a firmware update is the only time it gets more than a 304.
+  void sendGzipAsset(WebServer& target, const WebAsset& asset) {
+    target.sendHeader("Cache-Control", "no-cache");
+    target.sendHeader("ETag", asset.etag);
+    const String ifNoneMatch = target.header("If-None-Match");
+    if (ifNoneMatch.indexOf(asset.etag) >= 0 || ifNoneMatch == "*") {
+      target.send(304);
+      return;
+    }
+
+    target.sendHeader("Content-Encoding", "gzip");
+    target.send_P(200, asset.contentType, reinterpret_cast<PGM_P>(asset.gzip), asset.gzipLength);
+  }
+
+  enum class ByteRange { Whole, Partial, Unsatisfiable };
+
+  bool parseRangeNumber(const String& text, size_t& value) {
+    if (text.isEmpty()) return false;
+    for (size_t i = 0; i < text.length(); i++) {
+      if (!isdigit(static_cast<unsigned char>(text[i]))) return false;
+    }
+    value = strtoul(text.c_str(), nullptr, 10);
+    return true;
+  }
+
+  // A single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range.  Anything else,
+  // including multiple ranges, is answered with the whole file, as HTTP allows.
+  ByteRange parseByteRange(String header, size_t size, size_t& first, size_t& last) {
+    header.trim();
+    if (!header.startsWith("bytes=") || header.indexOf(',') >= 0) return ByteRange::Whole;
+    const int dash = header.indexOf('-');
+    if (dash < 0) return ByteRange::Whole;
+    const String firstText = header.substring(6, dash);
+    const String lastText = header.substring(dash + 1);
+
+    size_t value;
+    if (firstText.isEmpty()) {
+      if (!parseRangeNumber(lastText, value)) return ByteRange::Whole;
+      if (value == 0 || size == 0) return ByteRange::Unsatisfiable;
+      first = value >= size ? 0 : size - value;
+      last = size - 1;
+      return ByteRange::Partial;
+    }
+
+    if (!parseRangeNumber(firstText, first)) return ByteRange::Whole;
+    if (first >= size) return ByteRange::Unsatisfiable;
+    last = size - 1;
+    if (!lastText.isEmpty()) {
+      if (!parseRangeNumber(lastText, value) || value < first) return ByteRange::Whole;
+      if (value < last) last = value;
+    }
+    return ByteRange::Partial;
+  }
+
+  // streamFile with Range support, so an interrupted download of a big track can resume.  Only the
+  // first size bytes are served: less than file.size() for a track that is still being written.
+  void streamFileRange(WebServer& target, File& file, size_t size, const char* contentType) {
+    target.sendHeader("Accept-Ranges", "bytes");
+    size_t first = 0;
+    size_t last = 0;
+    const ByteRange range = parseByteRange(target.header("Range"), size, first, last);
+    if (range == ByteRange::Unsatisfiable) {
+      target.sendHeader("Content-Range", "bytes */" + String(size));
+      target.send(416, "application/json", "{\"detail\":\"Requested range is not available.\"}");
+      return;
+    }
+    if (range == ByteRange::Whole && size == file.size()) {
+      target.streamFile(file, contentType);
+      return;
+    }
+    if (range == ByteRange::Whole && size == 0) {
+      target.send(200, contentType, "");
+      return;
+    }
+    if (range == ByteRange::Whole) last = size - 1;
+
+    uint8_t* buffer = new (std::nothrow) uint8_t[STREAM_BUFFER_BYTES];
+    if (!buffer || !file.seek(first)) {
+      delete[] buffer;
+      target.send(500, "application/json", "{\"detail\":\"Track file could not be read.\"}");
+      return;
+    }
+    if (range == ByteRange::Partial) {
+      target.sendHeader("Content-Range", "bytes " + String(first) + "-" + String(last) + "/" +
+                                             String(size));
+    }
+    target.setContentLength(last - first + 1);
+    target.send(range == ByteRange::Partial ? 206 : 200, contentType, "");
+
+    WiFiClient client = target.client();
+    size_t remaining = last - first + 1;
+    while (remaining > 0) {
+      const size_t want = remaining < STREAM_BUFFER_BYTES ? remaining : STREAM_BUFFER_BYTES;
+      const int got = file.read(buffer, want);
+      if (got <= 0 || client.write(buffer, got) != static_cast<size_t>(got)) break;
+      remaining -= got;
+    }
+    delete[] buffer;
+  }
+
   void setWifiSetupNetworksJson(const char* json) {
     wifi_setup_networks_json = "";
     wifi_setup_networks_json.reserve(WIFI_SETUP_NETWORKS_JSON_RESERVE);
@@ -1414,6 +1593,90 @@ namespace {
     target.send(200, "application/json", "{\"saved\":true}");
   }
 
+  void sendVarioTones(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "application/json", "{\"detail\":\"Leaf Web App is not active.\"}");
+      return;
+    }
+
+    if (!sdcard.isMounted() || !SD_MMC.exists(vario_tones::filePath())) {
+      // Built-in tones
+      sendNoStoreHeaders(target);
+      target.send(200, "application/json", "{\"schema\":\"leaf.tones\",\"points\":[]}");
+      return;
+    }
+
+    File file = SD_MMC.open(vario_tones::filePath(), "r");
+    if (!file) {
+      target.send(500, "application/json", "{\"detail\":\"Vario sound could not be opened.\"}");
+      return;
+    }
+
+    sendNoStoreHeaders(target);
+    target.streamFile(file, "application/json");
+    file.close();
+  }
+
+  void saveVarioTones(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "application/json", "{\"detail\":\"Leaf Web App is not active.\"}");
+      return;
+    }
+
+    if (!sdcard.isMounted()) {
+      target.send(404, "application/json", "{\"detail\":\"SD card is not mounted.\"}");
+      return;
+    }
+
+    JsonDocument input;
+    vario_tones::Curve curve;
+    String detail;
+    if (deserializeJson(input, target.arg("plain"))) {
+      detail = "Invalid vario sound data.";
+    } else if (vario_tones::parse(input.as<JsonVariantConst>(), curve, detail) &&
+               vario_tones::save(curve, detail)) {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      vario_tones::use(curve);
+      target.send(200, "application/json", "{\"saved\":true}");
+      return;
+    }
+
+    String json = "{\"saved\":false,\"detail\":\"";
+    json += jsonEscape(detail);
+    json += "\"}";
+    target.send(400, "application/json", json);
+  }
+
+  void deleteVarioTones(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "application/json", "{\"detail\":\"Leaf Web App is not active.\"}");
+      return;
+    }
+
+    String detail;
+    if (!vario_tones::remove(detail)) {
+      String json = "{\"deleted\":false,\"detail\":\"";
+      json += jsonEscape(detail);
+      json += "\"}";
+      target.send(500, "application/json", json);
+      return;
+    }
+
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      vario_tones::useDefault();
+    }
+    target.send(200, "application/json", "{\"deleted\":true}");
+  }
+
   bool leafLogNetworkReady() {
     return user_app_enabled && !user_app_using_leaf_wifi && WiFi.status() == WL_CONNECTED;
   }
@@ -1674,8 +1937,27 @@ namespace {
     }
     doc.clear();
 
+    // An activated route is loaded into a copy, and only swapped in under the lock
+    std::unique_ptr<Navigator> staged;
+    if (activate) {
+      staged.reset(new (std::nothrow) Navigator());
+      if (!staged) {
+        target.send(500, "application/json", "{\"detail\":\"Not enough memory to load route.\"}");
+        return;
+      }
+    }
     route_store::ImportResult result;
-    if (!route_store::importRouteText(name, data, activate, result)) {
+    const bool imported = route_store::importRouteText(name, data, activate, result,
+                                                       staged ? *staged : navigator);
+    if (imported && result.active) {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      navigator = *staged;
+    }
+    if (!imported) {
       String json = "{\"saved\":";
       json += result.path.isEmpty() ? "false" : "true";
       json += ",\"detail\":\"";
@@ -1707,6 +1989,34 @@ namespace {
     }
 
     const bool includePoints = target.hasArg("points") && target.arg("points") == "1";
+    String loadedFile;
+    String loadedPath;
+    uint8_t pointCount;
+    uint8_t routeCount;
+    const char* activeType = "";
+    String activeName;
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      loadedFile = navigator.loadedNavFilename();
+      loadedPath = navigator.loadedNavPath();
+      pointCount = navigator.loadedFileWaypointCount();
+      routeCount = navigator.totalRoutes;
+      if (navigator.activeRouteIndex) {
+        activeType = "route";
+      } else if (navigator.activeWaypointIndex) {
+        activeType = "point";
+      }
+      if (navigator.activeRouteIndex && navigator.activeRouteIndex <= navigator.totalRoutes) {
+        activeName = navigator.routes[navigator.activeRouteIndex].name;
+      } else if (navigator.activeWaypointIndex) {
+        activeName = navigator.activePoint.name;
+      }
+    }
+
     target.setContentLength(CONTENT_LENGTH_UNKNOWN);
     const bool lowHeap = includePoints && (ESP.getFreeHeap() < NAV_POINTS_MIN_FREE_HEAP ||
                                            ESP.getMaxAllocHeap() < NAV_POINTS_MIN_MAX_ALLOC);
@@ -1714,25 +2024,17 @@ namespace {
     char responseBuffer[1024];
     JsonStream json(target, responseBuffer, sizeof(responseBuffer));
     json.write("{\"loaded_file\":\"");
-    json.writeEscaped(navigator.loadedNavFilename());
+    json.writeEscaped(loadedFile.c_str());
     json.write("\",\"loaded_path\":\"");
-    json.writeEscaped(navigator.loadedNavPath());
+    json.writeEscaped(loadedPath.c_str());
     json.write("\",\"point_count\":");
-    json.writeUInt(navigator.loadedFileWaypointCount());
+    json.writeUInt(pointCount);
     json.write(",\"route_count\":");
-    json.writeUInt(navigator.totalRoutes);
+    json.writeUInt(routeCount);
     json.write(",\"active_type\":\"");
-    if (navigator.activeRouteIndex) {
-      json.write("route");
-    } else if (navigator.activeWaypointIndex) {
-      json.write("point");
-    }
+    json.write(activeType);
     json.write("\",\"active_name\":\"");
-    if (navigator.activeRouteIndex && navigator.activeRouteIndex <= navigator.totalRoutes) {
-      json.writeEscaped(navigator.routes[navigator.activeRouteIndex].name);
-    } else if (navigator.activeWaypointIndex) {
-      json.writeEscaped(navigator.activePoint.name);
-    }
+    json.writeEscaped(activeName.c_str());
     json.write("\"");
     if (!includePoints) {
       json.write("}");
@@ -1748,10 +2050,15 @@ namespace {
       return;
     }
 
+    // Copy one point at a time so the main loop is never held up by the client's download
     json.write(",\"points\":[");
-    const uint8_t pointCount = navigator.loadedFileWaypointCount();
     for (uint8_t i = 1; i <= pointCount; i++) {
-      const Waypoint& waypoint = navigator.waypoint(WaypointID(i));
+      Waypoint waypoint;
+      {
+        MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+        if (!lock || i > navigator.loadedFileWaypointCount()) break;
+        waypoint = navigator.waypoint(WaypointID(i));
+      }
       if (i > 1) json.write(",");
       json.write("{\"index\":");
       json.writeUInt(i);
@@ -1785,20 +2092,30 @@ namespace {
     }
 
     const uint8_t index = doc["index"] | 0;
-    if (index == 0 || index > navigator.totalWaypoints) {
-      target.send(400, "application/json", "{\"detail\":\"Choose a valid waypoint.\"}");
-      return;
-    }
+    String name;
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      if (index == 0 || index > navigator.totalWaypoints) {
+        target.send(400, "application/json", "{\"detail\":\"Choose a valid waypoint.\"}");
+        return;
+      }
 
-    if (!navigator.activatePoint(WaypointID(index), true)) {
-      target.send(400, "application/json", "{\"detail\":\"Leaf could not activate this point.\"}");
-      return;
+      if (!navigator.activatePoint(WaypointID(index), true)) {
+        target.send(400, "application/json",
+                    "{\"detail\":\"Leaf could not activate this point.\"}");
+        return;
+      }
+      name = navigator.activePoint.name;
     }
 
     String json = "{\"active\":true,\"index\":";
     json += index;
     json += ",\"name\":\"";
-    json += jsonEscape(navigator.activePoint.name);
+    json += jsonEscape(name);
     json += "\"}";
     target.send(200, "application/json", json);
   }
@@ -1814,35 +2131,31 @@ namespace {
       return;
     }
 
+    // Copied out of the listing first so a slow client doesn't hold the directory cache
+    std::vector<String> names;
+    dir_cache::forEach(WAYPOINTS_DIR, [&names](const dir_cache::Entry& entry) {
+      if (entry.directory) return;
+      String name(entry.name);
+      if (supportedNavUploadExtension(lowerFileExtension(name))) names.push_back(std::move(name));
+    });
+
     target.setContentLength(CONTENT_LENGTH_UNKNOWN);
     target.send(200, "application/json", "");
     char responseBuffer[1024];
     JsonStream json(target, responseBuffer, sizeof(responseBuffer));
     json.write("{\"files\":[");
     bool first = true;
-    File dir = SD_MMC.open(WAYPOINTS_DIR);
-    if (dir && dir.isDirectory()) {
-      File entry = dir.openNextFile();
-      while (entry) {
-        if (!entry.isDirectory()) {
-          const String name = filenameFromUploadPath(entry.name());
-          if (supportedNavUploadExtension(lowerFileExtension(name))) {
-            if (!first) json.write(",");
-            first = false;
-            json.write("{\"name\":\"");
-            json.writeEscaped(name.c_str());
-            json.write("\",\"path\":\"");
-            json.writeEscaped(WAYPOINTS_DIR);
-            json.write("/");
-            json.writeEscaped(name.c_str());
-            json.write("\"}");
-          }
-        }
-        entry.close();
-        entry = dir.openNextFile();
-      }
+    for (const String& name : names) {
+      if (!first) json.write(",");
+      first = false;
+      json.write("{\"name\":\"");
+      json.writeEscaped(name.c_str());
+      json.write("\",\"path\":\"");
+      json.writeEscaped(WAYPOINTS_DIR);
+      json.write("/");
+      json.writeEscaped(name.c_str());
+      json.write("\"}");
     }
-    if (dir) dir.close();
     json.write("]}");
     json.finish();
   }
@@ -1878,19 +2191,36 @@ namespace {
       return;
     }
 
-    if (!nav_readFile(SD_MMC, path)) {
+    // Parse into a copy so the main loop keeps running while the card is read
+    std::unique_ptr<Navigator> staged(new (std::nothrow) Navigator());
+    if (!staged) {
+      target.send(500, "application/json",
+                  "{\"detail\":\"Not enough memory to load waypoints.\"}");
+      return;
+    }
+    if (!nav_readFile(SD_MMC, path, *staged)) {
       target.send(400, "application/json",
                   "{\"detail\":\"Leaf could not parse this waypoint file.\"}");
       return;
     }
-    user_waypoints::loadIntoNavigator();
+    user_waypoints::loadIntoNavigator(*staged);
+    const uint8_t pointCount = staged->loadedFileWaypointCount();
+    const uint8_t routeCount = staged->totalRoutes;
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      navigator = *staged;
+    }
 
     String json = "{\"loaded\":true,\"filename\":\"";
     json += jsonEscape(name);
     json += "\",\"points\":";
-    json += navigator.loadedFileWaypointCount();
+    json += pointCount;
     json += ",\"routes\":";
-    json += navigator.totalRoutes;
+    json += routeCount;
     json += "}";
     target.send(200, "application/json", json);
   }
@@ -1970,8 +2300,28 @@ namespace {
     }
     input.clear();
 
+    // An activated route is loaded into a copy, and only swapped in under the lock
+    std::unique_ptr<Navigator> staged;
+    if (activate) {
+      staged.reset(new (std::nothrow) Navigator());
+      if (!staged) {
+        target.send(500, "application/json", "{\"detail\":\"Not enough memory to load route.\"}");
+        return;
+      }
+    }
     route_store::ImportResult result;
-    if (!route_store::saveRouteJson(routeDoc, activate, result)) {
+    const bool saved =
+        route_store::saveRouteJson(routeDoc, activate, result, staged ? *staged : navigator);
+    if (saved && result.active) {
+      user_waypoints::loadIntoNavigator(*staged);
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      navigator = *staged;
+    }
+    if (!saved) {
       String json = "{\"saved\":";
       json += result.path.isEmpty() ? "false" : "true";
       json += ",\"detail\":\"";
@@ -1981,7 +2331,6 @@ namespace {
       target.send(result.path.isEmpty() ? 400 : 500, "application/json", json);
       return;
     }
-    if (result.active) user_waypoints::loadIntoNavigator();
 
     String json = "{\"saved\":true,\"active\":";
     json += result.active ? "true" : "false";
@@ -2045,7 +2394,11 @@ namespace {
       const double lat = point["lat"] | NAN;
       const double lon = point["lon"] | NAN;
       if (!validUserWaypointJson(point)) continue;
-      const uint8_t navigatorIndex = mergeUserWaypointIntoNavigator(point);
+      uint8_t navigatorIndex = 0;
+      {
+        MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+        if (lock) navigatorIndex = mergeUserWaypointIntoNavigator(point);
+      }
 
       if (!first) json.write(",");
       first = false;
@@ -2083,7 +2436,17 @@ namespace {
     }
 
     String detail;
-    if (!user_waypoints::renameFromJson(input, detail)) {
+    bool saved;
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      saved = user_waypoints::renameFromJson(input, detail);
+      if (saved) user_waypoints::loadIntoNavigator();
+    }
+    if (!saved) {
       String json = "{\"saved\":false,\"detail\":\"";
       json += jsonEscape(detail);
       json += "\"}";
@@ -2091,7 +2454,6 @@ namespace {
       return;
     }
 
-    user_waypoints::loadIntoNavigator();
     target.send(200, "application/json", "{\"saved\":true}");
   }
 
@@ -2104,7 +2466,16 @@ namespace {
     String id = target.arg("id");
     id.trim();
     String detail;
-    if (!user_waypoints::deleteById(id.c_str(), detail)) {
+    bool deleted;
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      deleted = user_waypoints::deleteById(id.c_str(), detail);
+    }
+    if (!deleted) {
       String json = "{\"deleted\":false,\"detail\":\"";
       json += jsonEscape(detail);
       json += "\"}";
@@ -2142,115 +2513,32 @@ namespace {
       return;
     }
 
-    static constexpr char USER_APP_PAGE[] PROGMEM =
-        R"leafapp(<!doctype html><html lang=en><head><meta charset=utf-8><meta name=viewport content="width=device-width,initial-scale=1"><meta http-equiv=Cache-Control content=no-store><title>Leaf</title><style>:root{font-family:-apple-system,BlinkMacSystemFont,"Segoe UI",sans-serif;color:#202423;background:#363636;line-height:1.35;--leaf:#d8ff00;--ink:#202423;--panel:#565656;--sub:#4d4d4d;--danger:#7a1d1d}body{margin:0;background:#363636}header{background:var(--leaf);color:#0b0d0b;padding:11px 20px;text-align:center}main{max-width:640px;margin:auto;padding:18px}h1{font-family:Arial,sans-serif;font-size:38px;font-weight:500;letter-spacing:.12em;line-height:1;margin:0}h2{position:relative;font-size:18px;margin:-16px -14px 14px;padding:12px 12px;color:#0b0d0b;background:var(--leaf);text-align:center;border-radius:5px 5px 0 0}section{background:var(--panel);border-radius:8px;margin:0 0 14px;padding:16px 14px}.status-panel{padding-top:14px}.status-panel h2{background:var(--panel);color:white;border-bottom:1px solid #a9a9a9;margin:-14px -14px 14px}.view{display:none}.view.active{display:block}.subbar{position:relative;display:flex;align-items:center;justify-content:center;min-height:34px;color:white;margin:0 0 14px}.back{position:absolute;left:0;top:-3px;width:44px;height:40px;background:white;color:var(--ink);border-color:white;box-shadow:none;padding:3px 8px;font-size:32px;font-weight:900;line-height:.85}.subbar h2{color:white;background:transparent;margin:0;padding:0;font-size:18px}.row{display:flex;gap:8px}.row>*{flex:1}.row>.small{flex:0 0 94px}.actions{display:flex;align-items:center;gap:10px;margin-top:10px}.actions .msg{flex:1;margin:0}.actions button,.profile-actions button{width:auto;padding:8px 10px;font-size:14px}.profile-actions{margin-top:12px;gap:14px}label{display:block;font-size:13px;font-weight:700;margin:10px 0 4px;color:white}input,select,textarea,button{box-sizing:border-box;width:100%;font:inherit;padding:11px;border:1px solid #b9c0b2;border-radius:7px;background:white;color:var(--ink)}textarea{min-height:112px;resize:vertical}.checkline{display:flex;align-items:center;gap:8px;width:auto;margin:0}.checkline input{width:auto;accent-color:var(--leaf)}.route-actions{align-items:center;justify-content:space-between}.route-actions .checkline{flex:1}.route-actions button{flex:0 0 auto}.route-edit-list{margin-top:4px;background:var(--sub);border-radius:7px;padding:8px 10px;min-height:34px}.route-point-row{display:grid;grid-template-columns:minmax(0,1fr) 74px 34px 34px 34px;gap:6px;align-items:center;margin:7px 0}.route-point-name{color:white;font-weight:750;overflow:hidden;text-overflow:ellipsis;white-space:nowrap}.route-point-row input{padding:7px}.route-point-row button{width:34px;height:34px;padding:0}.user-waypoint-row{display:grid;grid-template-columns:minmax(0,1fr) auto;gap:8px;align-items:center;margin:7px 0}.user-waypoint-row input{padding:8px}.user-waypoint-meta{color:#e2e7dc;font-size:12px;white-space:nowrap}.route-add-grid{display:grid;grid-template-columns:minmax(0,1fr) 122px;gap:8px;align-items:end}.route-add-grid label{margin-top:10px}.card-nav{position:absolute;right:8px;top:5px;display:flex;align-items:center;justify-content:center;width:44px;height:38px;padding:0 0 4px;background:white;color:var(--ink);border:1px solid #0b0d0b;box-shadow:none;font-size:34px;line-height:1}.waypoint-status-row{display:grid;grid-template-columns:minmax(0,1fr) auto;gap:10px;align-items:start}.waypoint-status-row button{width:auto;padding:8px 10px;font-size:14px}.file-activate{display:block;margin-top:8px}.nav-tools-blocked{color:white;font-weight:750;margin:8px 0}.nav-summary{font-family:ui-monospace,SFMono-Regular,Consolas,monospace;font-size:13px;white-space:pre-wrap;color:white}input:focus,select:focus,textarea:focus,button:focus{outline:2px solid var(--leaf);outline-offset:1px}select:disabled,button:disabled,.secondary:disabled,.danger:disabled{background:#686868;border-color:#686868;color:#8a8a8a;opacity:1;box-shadow:none}button{background:var(--ink);color:white;font-weight:750;border-color:var(--ink);box-shadow:inset 0 -2px 0 rgba(0,0,0,.22)}.secondary{background:white;color:var(--ink);border-color:#89917f;box-shadow:none}.danger{background:var(--danger);border-color:var(--danger);color:white}.hero{background:var(--leaf);border-color:var(--leaf);color:#0b0d0b}.profile-actions button:first-child:not(:disabled){background:var(--leaf);border-color:var(--leaf);color:#0b0d0b}.muted{color:#e2e7dc}.msg{min-height:0;margin:6px 0 0;line-height:1.2}.msg:empty{display:none}#mainView section{padding-bottom:10px}#profilesView section{padding-bottom:4px}#profilesView .msg{min-height:0;margin:6px 0 0;line-height:1.2}.leaf-log-panel{display:none;margin-top:10px;background:rgba(0,0,0,.16);border-radius:7px;padding:10px}.leaf-log-panel.active{display:block}.leaf-log-step{display:grid;grid-template-columns:1fr auto;gap:8px;align-items:center;color:white;font-weight:700}.leaf-log-step button,#leafLogWifi{width:auto}.status{font-family:ui-monospace,SFMono-Regular,Consolas,monospace;font-size:13px;white-space:pre-wrap;color:white;min-width:0}.status-body{display:grid;grid-template-columns:minmax(0,1fr) max-content;align-items:start;justify-content:space-between;column-gap:14px}.status-side{display:grid;gap:8px;justify-items:end}.firmware-check{margin-top:8px;justify-content:flex-end}.firmware-check button{width:auto;padding:7px 9px;font-size:13px}#firmwareCheckMsg{text-align:right}.battery-status{color:white;text-align:right;font-size:13px;font-weight:700}.battery-line{display:flex;align-items:center;justify-content:flex-end;gap:7px;margin-bottom:4px}.battery{position:relative;width:44px;height:20px;border:2px solid white;border-radius:4px;box-sizing:border-box}.battery:after{content:"";position:absolute;right:-6px;top:4px;width:4px;height:8px;background:white;border-radius:0 2px 2px 0}.battery-fill{display:block;height:100%;background:var(--leaf);border-radius:2px}.battery-meta{font-size:12px;font-weight:650;color:#e2e7dc}.metrics{display:grid;grid-template-columns:1fr 1fr;gap:9px}.metric{background:var(--sub);border-radius:7px;padding:8px 10px;color:white}.metric span{display:block;color:#dfe5d9;font-size:12px;font-weight:650;margin-bottom:2px}.metric strong{display:block;font-size:16px}#logCount{font-size:34px;line-height:1}.pager{display:grid;grid-template-columns:44px 1fr 44px;align-items:center;gap:8px;margin-bottom:12px}.pager button{height:38px;padding:0;background:var(--leaf);border-color:var(--leaf);color:#0b0d0b}.pager button:disabled{background:#686868;border-color:#686868;color:#8a8a8a;box-shadow:none}.page-title{text-align:center;color:white;font-weight:800}.flight-head{display:grid;grid-template-columns:1fr 1fr 1fr;gap:8px;color:white;margin-bottom:8px}.flight-head div:nth-child(2){text-align:center}.flight-head div:nth-child(3){text-align:right}.flight-head span{display:block;color:#dfe5d9;font-size:12px;font-weight:650}.flight-head strong{display:block;color:white;font-size:14px;font-weight:800;white-space:nowrap}.flight-profiles{display:flex;justify-content:space-between;gap:10px;color:var(--leaf);font-weight:800;margin:0 0 10px}.flight-profiles div{min-width:0;overflow:hidden;text-overflow:ellipsis;white-space:nowrap}.flight-profiles div:last-child{text-align:right}.flight-card{color:white}.alt-box,.vario-box{background:var(--sub);border-radius:7px;padding:12px;margin:10px 0}.alt-box{position:relative;padding:8px 10px 28px}.alt-title{position:absolute;left:0;right:0;bottom:6px;text-align:center}.alt-title,.vario-title{font-size:18px;font-weight:800}.vario-title{text-align:center}.alt-row{position:relative;height:100px;margin-top:0}.alt-row .pill{position:absolute;min-width:74px;background:#111;color:white}.alt-row .pill.high{background:var(--leaf);color:#0b0d0b}.pill{background:var(--leaf);color:#0b0d0b;border-radius:6px;padding:5px 8px;font-weight:800;text-align:center}.pill span{display:block;font-size:11px}.detail-grid{display:grid;grid-template-columns:1fr 1.45fr;gap:10px}.vario-box{display:flex;flex-direction:column;justify-content:center;gap:9px}.vario-title{order:2}.vario-values{display:contents}#climbMax{order:1}#sinkMax{order:3}.sink{background:#111;color:white}.mini-metrics{background:var(--sub);border-radius:7px;padding:8px 10px}.mini-row{display:flex;justify-content:space-between;gap:8px;border-bottom:1px solid #777;padding:5px 0}.mini-row:last-child{border-bottom:0}.track{overflow-wrap:anywhere;color:#e2e7dc;margin-top:12px;font-size:13px;display:flex;justify-content:flex-start;gap:8px;align-items:center}.track-file-name{color:var(--leaf);font-weight:800}.track-actions{display:inline-flex;align-items:center;gap:8px;flex-wrap:nowrap;min-width:0}.track-actions span{min-width:0}.track-actions button{width:auto;padding:6px 9px;font-size:13px;background:var(--leaf);border-color:var(--leaf);color:#0b0d0b}.delete-area{margin-top:10px;display:flex;justify-content:flex-end}.delete-area>button{width:auto;padding:8px 10px;font-size:14px}.delete-confirm{display:none;width:100%;text-align:left;background:rgba(0,0,0,.18);border-radius:7px;padding:7px 8px}.delete-confirm button{width:100%;font-size:15px;padding:8px 9px}.delete-warning{font-weight:500;margin:0 0 7px;color:white}#logDetailMsg{min-height:0;margin:6px 0 0}#logDetailMsg:empty{display:none}.preview-card{height:calc(100vh - 156px);height:calc(100svh - 116px);max-height:430px;min-height:280px;display:flex;flex-direction:column;padding:10px 10px 8px;margin-bottom:0}.preview-head{display:flex;justify-content:space-between;gap:10px;align-items:center;color:white;font-weight:800;margin-bottom:8px}.preview-head button{width:48px;height:44px;padding:0;background:white;color:var(--ink);border-color:white;font-size:30px;line-height:1}#previewStats{line-height:1.25;font-weight:650}#previewStats div{margin-top:1px}.preview-duration{color:var(--leaf);font-weight:800}.preview-stage{flex:1;min-height:140px;background:var(--sub);border-radius:7px;padding:8px;display:flex;align-items:center;justify-content:center}.preview-stage canvas{display:block;max-width:100%;max-height:100%}.preview-legend{display:grid;grid-template-columns:auto 1fr auto;gap:8px;align-items:center;color:#e2e7dc;font-size:12px;margin-top:8px}.preview-ramp{height:8px;border-radius:8px;background:linear-gradient(90deg,#111,#3a9cff,var(--leaf))}@media(max-width:520px){.detail-grid{grid-template-columns:1fr 1.45fr}.status-body{grid-template-columns:minmax(0,1fr) max-content}.status-side{justify-items:end}.battery-status{text-align:right}.battery-line{justify-content:flex-end}}</style></head><body><header><h1>Leaf</h1></header><main><div id=mainView class="view active"><section class=status-panel><h2>Status</h2><div class=status-body><div class=status id=status>Loading...</div><div class=status-side><div class=battery-status id=batteryBox><div class=battery-line><span id=batteryText>--%</span><div class=battery><span class=battery-fill id=batteryFill></span></div></div><div class=battery-meta id=batteryCharge>Unknown</div></div><div class="actions firmware-check" id=firmwareCheckRow><button class=secondary id=firmwareCheck>Check for Updates</button></div></div></div><p class="muted msg" id=firmwareCheckMsg></p></section><section><h2>Profiles<button class=card-nav id=openProfiles aria-label="Edit Profiles">&#x276f;</button></h2><label>Active pilot</label><select id=activePilotList></select><label>Active glider</label><select id=activeGliderList></select><p class="muted msg" id=mainProfileMsg></p></section><section><h2>Logbook<button class=card-nav id=openLogbook aria-label="Open Logbook">&#x276f;</button></h2><div class=metrics><div class=metric><span>Total Flights</span><strong id=logCount>--</strong></div><div class=metric><span>Last Flight</span><strong id=logLatest>Loading...</strong></div></div><p class="muted msg" id=logMsg></p></section><section><h2>Waypoints & Routes<button class=card-nav id=openNavTools aria-label="Open Waypoints and Routes">&#x276f;</button></h2><div class=nav-summary id=navSummary>Loading...</div></section><section id=leafLogCard><h2>Leaf Log</h2><label>Default pilot</label><select id=leafLogPilot></select><label>Leaf Log Account Email</label><input id=leafLogEmail maxlength=80 type=email autocomplete=email><div class=actions><button class=hero id=leafLogStart disabled>Get Activation Code</button><button class=secondary id=leafLogWifi>WiFi Setup</button><p class="muted msg" id=leafLogStatus></p></div><div class=leaf-log-panel id=leafLogPanel><div class=leaf-log-step><span id=leafLogCodeText></span><button class=hero id=leafLogOpen>Open Leaf Log</button></div><p class="muted msg" id=leafLogMsg></p></div></section></div><div id=navView class=view><div class=subbar><button class=back id=backNavMain aria-label=Back>&#x276e;</button><h2>Waypoints & Routes</h2></div><section><h2>Waypoint Files</h2><div class=waypoint-status-row><div class=nav-summary id=waypointSubStatus>Loading...</div><button class=secondary id=waypointLoad>Import New File</button></div><input id=waypointFile type=file accept=".gpx,.cup,.wpt,.wyp" hidden><div class=file-activate id=waypointActivatePanel><label>Waypoint file</label><select id=waypointFileList></select></div><div class=actions><p class="muted msg" id=waypointMsg></p><button class=hero id=waypointActivate>Activate File</button></div><div id=fileWaypointPanel><label>Waypoint</label><select id=fileWaypointSelect></select><div class=actions><button class=hero id=fileWaypointActivate>Navigate to Point</button><button class=secondary id=fileWaypointMap>Open Map</button></div></div></section><section><h2>User Waypoints</h2><label>Select Waypoint</label><select id=userWaypointSelect></select><div id=userWaypointEditor><div class=row><div><label>Name</label><input id=userWaypointName maxlength=15></div><div class=small><label>&nbsp;</label><button class=hero id=userWaypointRename disabled>Rename</button></div></div><div class=actions><button class=hero id=userWaypointActivate>Navigate to Point</button><button class=secondary id=userWaypointMap>Open Map</button><button class=danger id=userWaypointDelete>Delete</button></div><div class=delete-confirm id=userWaypointDeleteConfirm><p class=delete-warning>Delete saved waypoint?</p><div class=row><button class=danger id=userWaypointConfirmDelete>Confirm Delete</button><button class=hero id=userWaypointCancelDelete>Cancel</button></div></div></div><p class="muted msg" id=userWaypointMsg></p></section><section><h2>Create Route</h2><p class=nav-tools-blocked id=createRouteBlocked>No waypoints available yet.</p><div class=actions id=createRouteLoadPanel><p class="muted msg" id=createRouteLoadMsg></p><button class=hero id=createRouteLoadPoints>Load Points</button></div><div id=createRouteContent><div class=route-edit-list id=editRouteList></div><div class=route-add-grid><div><label id=routeWaypointLabel>First Waypoint</label><select id=routeWaypointList></select></div><div><label>Turn Radius (m)</label><input id=routeDefaultRadius type=number min=10 max=20000 step=10 value=150></div></div><div class=actions><p class="muted msg" id=routeEditHint></p><button class=secondary id=editRouteAdd disabled>Add Point</button></div><label>Route name</label><input id=editRouteName maxlength=48 autocomplete=off><div class="actions route-actions"><label class=checkline><input id=editRouteActivate type=checkbox checked>Set as active route</label><button class=hero id=editRouteSave disabled>Save Route</button></div><p class="muted msg" id=editRouteMsg></p></div></section><section><h2>Import Route</h2><label>Route name</label><input id=routeName maxlength=48 autocomplete=off><label>Task / Route Data</label><textarea id=routeData placeholder="XCTSK:..."></textarea><div class="actions route-actions"><label class=checkline><input id=routeActivate type=checkbox checked>Set as active route</label><button class=hero id=routeSave disabled>Save to Leaf</button></div><p class="muted msg" id=routeMsg></p></section></div><div id=profilesView class=view><div class=subbar><button class=back id=backMain aria-label=Back>&#x276e;</button><h2>Edit Profiles</h2></div><section><h2>Pilots</h2><label>Active pilot</label><select id=pilotList></select><label>Name</label><input id=pilotName maxlength=48 autocomplete=name><div class="row profile-actions"><button id=pilotSave disabled>Save Profile</button><button class=secondary id=pilotNew>New</button><button class="small danger" id=pilotDelete>Delete</button></div><p class="muted msg" id=pilotMsg></p></section><section><h2>Gliders</h2><label>Active glider</label><select id=gliderList></select><div class=row><div><label>Brand</label><input id=gliderBrand maxlength=32></div><div><label>Model</label><input id=gliderModel maxlength=48></div></div><div class=row><div><label>Size</label><input id=gliderSize maxlength=16></div><div><label>Display name</label><input id=gliderDisplay maxlength=64></div></div><div class="row profile-actions"><button id=gliderSave disabled>Save Profile</button><button class=secondary id=gliderNew>New</button><button class="small danger" id=gliderDelete>Delete</button></div><p class="muted msg" id=gliderMsg></p></section></div><div id=logbookView class=view><div class=subbar><button class=back id=backLogMain aria-label=Back>&#x276e;</button><h2>Logbook</h2></div><section class=flight-card><div class=pager><button id=logPrev>&#x276e;</button><div class=page-title id=logPage>--</div><button id=logNext>&#x276f;</button></div><div class=flight-head><div><span id=flightDay>--</span><strong id=flightDate>Loading...</strong></div><div><span>Start:</span><strong id=flightTime>--</strong></div><div><span>Duration:</span><strong id=flightDuration>--</strong></div></div><div class=flight-profiles><div id=flightPilot></div><div id=flightGlider></div></div><div class=alt-box><div class=alt-title>Altitude</div><div class=alt-row><div class=pill id=altStart><span>Start</span>--</div><div class=pill id=altMax><span>Max</span>--</div><div class=pill id=altEnd><span>End</span>--</div></div></div><div class=detail-grid><div class=vario-box><div class=vario-title>Vario</div><div class=vario-values><div class=pill id=climbMax>--</div><div class="pill sink" id=sinkMax></div></div></div><div class=mini-metrics id=flightMetrics></div></div><div class=track id=trackInfo></div><div class=delete-area><button class=danger id=deleteLog>Delete Log</button><div class=delete-confirm id=deleteConfirm><p class=delete-warning>Delete log and track file?</p><div class=row><button class=danger id=confirmDelete>Confirm Delete</button><button class=hero id=cancelDelete>Cancel</button></div></div></div><p class="muted msg" id=logDetailMsg></p></section></div><div id=previewView class=view><section class=preview-card><div class=preview-head><div><div id=previewTitle>Track Preview</div><div class=muted id=previewStats></div></div><button id=previewClose aria-label="Close preview">&times;</button></div><div class=preview-stage><canvas id=previewCanvas></canvas></div><div class=preview-legend><span id=previewLow>Low</span><span class=preview-ramp></span><span id=previewHigh>High</span></div><p class="muted msg" id=previewMsg></p></section></div></main><script>
-const LEAF_LOG_ENABLED=__LEAF_LOG_ENABLED__;
-let profiles={schema:'leaf.profiles',schema_version:'v0.1.0',active_pilot_id:null,active_glider_id:null,pilots:[],gliders:[]},pilotSnap={},gliderSnap={},navPoints=[],loadedNavFile='',userWaypoints=[],userWaypointSnap='',selectedUserWaypointId='',editRoute=[],logState={prev:'',next:'',path:''},unitPrefs={alt_feet:false,climb_fpm:false,speed_mph:false,distance_miles:false,heading_cardinal:false,temp_f:false,time_12h:false},userStatus={mode:'',mac_address:''},previewState={points:[],lo:0,hi:0},leafLogState={linked:false,reconnect_required:false,account:{handle:'',displayName:''}},leafLogActivationUrl='',leafLogPollTimer=0,leafLogBusy=false;
-const $=id=>document.getElementById(id),clean=v=>{v=(v||'').trim();return v?v:null},newId=()=>Math.floor(Math.random()*0xffffffff).toString(16).padStart(8,'0');
-function pilotLabel(p){return p.name||'Unnamed pilot'}function gliderLabel(g){return g.display_name||[g.brand,g.model,g.size].filter(Boolean).join(' ')||'Unnamed glider'}
-function selectedPilot(){return profiles.pilots.find(p=>p.id==profiles.active_pilot_id)}function selectedGlider(){return profiles.gliders.find(g=>g.id==profiles.active_glider_id)}
-function msg(id,t){$(id).textContent=t||''}function validEmail(v){return /^[^\s@]+@[^\s@]+\.[^\s@]+$/.test((v||'').trim())}function show(v){$('mainView').classList.toggle('active',v=='main');$('navView').classList.toggle('active',v=='nav');$('profilesView').classList.toggle('active',v=='profiles');$('logbookView').classList.toggle('active',v=='logbook');$('previewView').classList.toggle('active',v=='preview')}
-function fillSelect(el,items,label){el.textContent='';items.forEach(x=>{let o=document.createElement('option');o.value=x.id;o.textContent=label(x);el.appendChild(o)});el.disabled=!items.length}
-function pilotEditor(){return {id:profiles.active_pilot_id,name:$('pilotName').value||''}}function gliderEditor(){return {id:profiles.active_glider_id,brand:$('gliderBrand').value||'',model:$('gliderModel').value||'',size:$('gliderSize').value||'',display_name:$('gliderDisplay').value||''}}
-function same(a,b){return JSON.stringify(a)==JSON.stringify(b)}function setSnaps(){pilotSnap=pilotEditor();gliderSnap=gliderEditor();buttons()}
-function esc(v){return String(v||'').replace(/[&<>"']/g,c=>({'&':'&amp;','<':'&lt;','>':'&gt;','"':'&quot;',"'":'&#39;'}[c]))}
-const leafLogGlyphRows={uploaded:['e00','bc0','df8','4fe','67f','71f','78f','fc6','fe6','ff4','7fc','008','030','3c0'],not_uploaded:['e00','9c0','838','406','401','401','401','802','802','804','7fc','008','030','3c0'],rejected:['e00','9c0','a2f','50f','48f','46f','426','816','806','800','7e6','00f','026','3c0']}
-const leafLogStatusLabels={uploaded:'Uploaded to Leaf Log',not_uploaded:'Not uploaded to Leaf Log',rejected:'Leaf Log upload rejected'}
-function leafLogIcon(status,detail){let rows=leafLogGlyphRows[status];if(!rows)return'';let d='';rows.forEach((hex,y)=>{let bits=parseInt(hex,16),x=0;while(x<12){while(x<12&&!(bits&(0x800>>x)))x++;let start=x;while(x<12&&(bits&(0x800>>x)))x++;if(start<x)d+=`M${start+1} ${y}h${x-start}v1h-${x-start}z`}});let label=leafLogStatusLabels[status]||'Leaf Log status';if(status=='rejected'&&detail)label+=': '+detail;let safe=esc(label);return `<svg width=14 height=14 viewBox="0 0 14 14" role=img aria-label="${safe}" style="display:inline-block;margin-left:5px;vertical-align:-2px;color:var(--leaf);shape-rendering:crispEdges"><title>${safe}</title><path fill=currentColor d="${d}"/></svg>`}
-function routeEditButtons(hint=true){let n=clean($('editRouteName').value);$('routeWaypointLabel').textContent=editRoute.length?'Next Waypoint':'First Waypoint';$('editRouteAdd').disabled=!navPoints.length;$('editRouteSave').disabled=!n||!editRoute.length;if(!hint)return;if(!navPoints.length)msg('routeEditHint','Load a waypoint file first.');else msg('routeEditHint','Select a point and add to route.');if(!n&&!editRoute.length)msg('editRouteMsg','Add waypoints and enter route name.');else if(!editRoute.length)msg('editRouteMsg','Add waypoints, then Save Route.');else if(!n)msg('editRouteMsg','Enter route name, then Save Route.');else msg('editRouteMsg','Ready to save route.')}
-function mapUrl(p){return 'https://www.google.com/maps/search/?api=1&query='+encodeURIComponent(Number(p.lat).toFixed(7)+','+Number(p.lon).toFixed(7))}
-function selectedFilePoint(){let idx=Number($('fileWaypointSelect').value);return navPoints.find(p=>Number(p.index)==idx)}function syncLoadedWaypointFile(){let sel=$('waypointFileList');if(loadedNavFile&&sel.options.length)sel.value=loadedNavFile}function renderWaypointPicker(){let routeEl=$('routeWaypointList'),fileEl=$('fileWaypointSelect');routeEl.textContent='';fileEl.textContent='';navPoints.forEach(p=>{let label=p.name||('Point '+p.index),o=document.createElement('option');o.value=p.index;o.textContent=label;routeEl.appendChild(o);let f=document.createElement('option');f.value=p.index;f.textContent=label;fileEl.appendChild(f)});routeEl.disabled=!navPoints.length;fileEl.disabled=!navPoints.length;$('fileWaypointPanel').style.display=navPoints.length?'block':'none';$('fileWaypointActivate').disabled=!navPoints.length;$('fileWaypointMap').disabled=!navPoints.length;routeEditButtons()}
-function selectedUserWaypoint(){return userWaypoints.find(p=>p.id==selectedUserWaypointId)||userWaypoints[0]}
-function resetUserWaypointDelete(){$('userWaypointDelete').style.display='block';$('userWaypointDeleteConfirm').style.display='none'}
-function userWaypointChanged(){let p=selectedUserWaypoint(),i=$('userWaypointName'),name=i.value.trim();$('userWaypointRename').disabled=!p||!name||name==(p.name||'');if(i.value.length>=15)msg('userWaypointMsg','15 character limit.');else if(p)msg('userWaypointMsg','')}
-function renderUserWaypoints(){let sel=$('userWaypointSelect');sel.textContent='';userWaypoints.forEach(p=>{let o=document.createElement('option');o.value=p.id;o.textContent=p.name||'Saved Point';sel.appendChild(o)});if(!userWaypoints.length){$('userWaypointEditor').style.display='none';msg('userWaypointMsg','Use Save Point on Leaf to add one.');return}let p=selectedUserWaypoint();selectedUserWaypointId=p.id;sel.value=p.id;$('userWaypointEditor').style.display='block';$('userWaypointName').value=p.name||'';userWaypointChanged();resetUserWaypointDelete();msg('userWaypointMsg','')}
-async function loadUserWaypoints(){try{let d=await(await fetch('/api/user-waypoints')).json();userWaypoints=d.points||[];if(!userWaypoints.find(p=>p.id==selectedUserWaypointId))selectedUserWaypointId=userWaypoints.length?userWaypoints[0].id:'';userWaypointSnap=JSON.stringify(userWaypoints);renderUserWaypoints()}catch(e){userWaypoints=[];selectedUserWaypointId='';userWaypointSnap='[]';renderUserWaypoints();msg('userWaypointMsg','Unable to read saved points.')}}
-async function renameUserWaypoint(){let p=selectedUserWaypoint(),name=$('userWaypointName').value.trim();if(!p||!name)return;msg('userWaypointMsg','Renaming...');try{let r=await fetch('/api/user-waypoints',{method:'PUT',headers:{'Content-Type':'application/json'},body:JSON.stringify({points:[{id:p.id,name:name}]})}),d=await r.json().catch(()=>({}));if(!r.ok||!d.saved)throw d;p.name=name;userWaypointSnap=JSON.stringify(userWaypoints);await loadUserWaypoints();msg('userWaypointMsg','Waypoint renamed.')}catch(x){msg('userWaypointMsg',x&&x.detail?x.detail:'Unable to rename waypoint.')}}
-async function deleteUserWaypoint(){let p=selectedUserWaypoint();if(!p)return;msg('userWaypointMsg','Deleting...');try{let r=await fetch('/api/user-waypoints?id='+encodeURIComponent(p.id),{method:'DELETE'}),d=await r.json().catch(()=>({}));if(!r.ok||!d.deleted)throw d;selectedUserWaypointId='';await loadUserWaypoints();msg('userWaypointMsg','Waypoint deleted.')}catch(x){msg('userWaypointMsg',x&&x.detail?x.detail:'Unable to delete waypoint.');resetUserWaypointDelete()}}
-function routePointRow(p,i){return '<div class=route-point-row><div class=route-point-name>'+esc(p.name||('Point '+(i+1)))+'</div><input type=number min=10 max=20000 step=10 value="'+(p.radius_m||150)+'" data-r="'+i+'"><button type=button data-act=up data-i="'+i+'">&uarr;</button><button type=button data-act=down data-i="'+i+'">&darr;</button><button type=button data-act=remove data-i="'+i+'">&times;</button></div>'}
-function renderEditRoute(){$('editRouteList').innerHTML=editRoute.map(routePointRow).join('');routeEditButtons()}
-function navSummaryText(d){let lines=[];lines.push(d.loaded_file||'No waypoint file loaded');lines.push('Points: '+(d.point_count||0)+' Routes: '+(d.route_count||0));if(d.active_name)lines.push('Active '+(d.active_type=='route'?'Route':'Point')+': '+d.active_name);return lines.join('\n')}
-function renderNavStatus(d){loadedNavFile=d.loaded_file||'';syncLoadedWaypointFile();$('navSummary').textContent=navSummaryText(d);$('waypointSubStatus').textContent=navSummaryText(d);let ready=!!navPoints.length,canLoad=!ready&&!!(d.point_count||0);$('createRouteBlocked').textContent=ready?'':(canLoad?'Waypoint file loaded. Load points to create a route.':'No waypoints available yet.');$('createRouteBlocked').style.display=ready?'none':'block';$('createRouteLoadPanel').style.display=canLoad?'flex':'none';$('createRouteContent').style.display=ready?'block':'none'}
-let navDataQueue=Promise.resolve(),navDataSeq=0,navDataFullSeq=0;
-function navDataFresh(includePoints,seq){return seq==navDataSeq||(includePoints&&seq==navDataFullSeq)}
-async function loadNavData(includePoints=false){let seq=++navDataSeq;if(includePoints)navDataFullSeq=seq;navDataQueue=navDataQueue.catch(()=>{}).then(()=>loadNavDataSerial(includePoints,seq));return navDataQueue}
-async function loadNavDataSerial(includePoints,seq){if(!navDataFresh(includePoints,seq))return false;try{let r=await fetch('/api/nav-data'+(includePoints?'?points=1':'')),d=await r.json().catch(()=>({}));if(!r.ok||d.points_unavailable)throw d;if(!navDataFresh(includePoints,seq))return false;if(includePoints)navPoints=d.points||[];renderNavStatus(d);if(includePoints)renderWaypointPicker();return true}catch(e){if(!navDataFresh(includePoints,seq))return false;if(includePoints){try{let d=await(await fetch('/api/nav-data')).json();if(!navDataFresh(includePoints,seq))return false;renderNavStatus(d);renderWaypointPicker();msg('routeEditHint','Unable to refresh waypoint list.');msg('waypointMsg','Unable to refresh waypoint list.');return false}catch(x){}}$('navSummary').textContent='Unable to read navigation data.';$('waypointSubStatus').textContent='Unable to read navigation data.';if(includePoints)msg('routeEditHint','Unable to refresh waypoint list.');else msg('routeEditHint','Unable to read waypoints.');return false}}
-async function loadRoutePoints(){msg('createRouteLoadMsg','Loading points...');$('createRouteLoadPoints').disabled=true;let ok=await loadNavData(true);msg('createRouteLoadMsg',ok?(navPoints.length?('Loaded '+navPoints.length+' points.'):'No points available.'):'Unable to refresh waypoint list.');$('createRouteLoadPoints').disabled=false}
-async function activatePointIndex(index,msgId){if(!index){msg(msgId,'Point is not loaded yet.');return}msg(msgId,'Activating point...');try{let r=await fetch('/api/nav/activate-point',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({index:index})}),d=await r.json().catch(()=>({}));if(!r.ok||!d.active)throw d;msg(msgId,'Active: '+(d.name||'point'));loadNavData(!!navPoints.length)}catch(x){msg(msgId,x&&x.detail?x.detail:'Unable to activate point.')}}
-async function loadWaypointFileList(){msg('waypointMsg','Loading files...');try{let d=await(await fetch('/api/waypoints/files')).json(),files=d.files||[],sel=$('waypointFileList'),current=loadedNavFile||sel.value;sel.textContent='';files.forEach(f=>{let o=document.createElement('option');o.value=f.name;o.textContent=f.name;sel.appendChild(o)});if(current)sel.value=current;msg('waypointMsg',files.length?'Choose a file, then Activate File.':'No waypoint files found.')}catch(e){msg('waypointMsg','Unable to list waypoint files.')}}async function activateWaypointFile(){let sel=$('waypointFileList');if(!sel.options.length)await loadWaypointFileList();let name=sel.value;if(!name){msg('waypointMsg','Choose a waypoint file.');return}msg('waypointMsg','Activating '+name+'...');try{let r=await fetch('/api/waypoints/activate',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({name:name})}),d=await r.json().catch(()=>({}));if(!r.ok||!d.loaded)throw d;msg('waypointMsg','Activated '+(d.filename||name)+'.');await loadNavData(true);await loadUserWaypoints()}catch(x){msg('waypointMsg',x&&x.detail?x.detail:'Unable to activate file.')}}
-function addSelectedRoutePoint(){let idx=Number($('routeWaypointList').value),p=navPoints.find(x=>Number(x.index)==idx);if(!p)return;let radius=Math.max(10,Math.min(20000,Math.round(Number($('routeDefaultRadius').value)||150)));$('routeDefaultRadius').value=radius;editRoute.push({name:p.name,lat:p.lat,lon:p.lon,alt_m:p.alt_m||0,radius_m:radius});renderEditRoute()}
-async function saveEditedRoute(){let name=clean($('editRouteName').value);if(!name||!editRoute.length){routeEditButtons();return}msg('editRouteMsg','Saving route...');$('editRouteSave').disabled=true;try{let r=await fetch('/api/routes/save',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({name:name,activate:$('editRouteActivate').checked,points:editRoute})}),d=await r.json().catch(()=>({}));if(!r.ok||!d.saved)throw d;msg('editRouteMsg','Saved '+(d.points||0)+' points'+(d.active?' and set active.':'.'))}catch(x){msg('editRouteMsg',x&&x.detail?x.detail:'Unable to save route.')}routeEditButtons(false)}function routeButtons(hint=true){let n=clean($('routeName').value),d=clean($('routeData').value);$('routeSave').disabled=!n||!d;if(!hint)return;if(!n&&!d)msg('routeMsg','Enter route name and data, then Save to Leaf.');else if(!n)msg('routeMsg','Enter route name, then Save to Leaf.');else if(!d)msg('routeMsg','Paste route data, then Save to Leaf.');else msg('routeMsg','Ready to save route.')}async function uploadWaypointFile(file){if(!file)return;msg('waypointMsg','Uploading '+file.name+'...');$('waypointLoad').disabled=true;let form=new FormData();form.append('file',file,file.name);try{let r=await fetch('/api/waypoints/upload',{method:'POST',body:form}),d=await r.json().catch(()=>({}));if(!d.saved)throw d;let counts=(d.points||0)+' pts';if(d.routes)counts+=', '+d.routes+' rtes';if(d.loaded){msg('waypointMsg','Loaded '+(d.filename||file.name)+': '+counts+'.');await loadNavData(true);await loadWaypointFileList()}else msg('waypointMsg','Saved '+(d.filename||file.name)+', but Leaf could not load it.')}catch(x){msg('waypointMsg',x&&x.detail?x.detail:'Unable to load file.')} $('waypointLoad').disabled=false}function buttons(){let p=pilotEditor(),g=gliderEditor();$('pilotSave').disabled=!clean(p.name)||same(p,pilotSnap);$('pilotDelete').disabled=!selectedPilot();$('pilotNew').disabled=!profiles.pilots.length;$('gliderSave').disabled=!([g.brand,g.model,g.size,g.display_name].some(v=>clean(v)))||same(g,gliderSnap);$('gliderDelete').disabled=!selectedGlider();$('gliderNew').disabled=!profiles.gliders.length;leafLogButtons();routeButtons()}
-function render(){fillSelect($('pilotList'),profiles.pilots,pilotLabel);fillSelect($('activePilotList'),profiles.pilots,pilotLabel);$('leafLogPilot').style.display='none';$('leafLogPilot').previousElementSibling.style.display='none';$('leafLogEmail').style.display='none';$('leafLogEmail').previousElementSibling.style.display='none';if(profiles.active_pilot_id){$('pilotList').value=profiles.active_pilot_id;$('activePilotList').value=profiles.active_pilot_id}let p=selectedPilot();$('pilotName').value=p?p.name||'':'';if(!profiles.pilots.length)msg('pilotMsg','Enter pilot name, then Save Profile.');fillSelect($('gliderList'),profiles.gliders,gliderLabel);fillSelect($('activeGliderList'),profiles.gliders,gliderLabel);if(profiles.active_glider_id){$('gliderList').value=profiles.active_glider_id;$('activeGliderList').value=profiles.active_glider_id}let g=selectedGlider();$('gliderBrand').value=g?g.brand||'':'';$('gliderModel').value=g?g.model||'':'';$('gliderSize').value=g?g.size||'':'';$('gliderDisplay').value=g?g.display_name||'':'';if(!profiles.gliders.length)msg('gliderMsg','Enter glider details, then Save Profile.');setSnaps()}
-function normalize(){profiles.schema='leaf.profiles';profiles.schema_version='v0.1.0';delete profiles.leaf_log;profiles.pilots=(profiles.pilots||[]).filter(p=>p&&p.id&&p.name);profiles.gliders=(profiles.gliders||[]).filter(g=>g&&g.id&&g.model);if(!profiles.pilots.find(p=>p.id==profiles.active_pilot_id))profiles.active_pilot_id=profiles.pilots.length==1?profiles.pilots[0].id:null;if(!profiles.gliders.find(g=>g.id==profiles.active_glider_id))profiles.active_glider_id=profiles.gliders.length==1?profiles.gliders[0].id:null}
-async function save(){normalize();let r=await fetch('/api/profiles',{method:'PUT',headers:{'Content-Type':'application/json'},body:JSON.stringify(profiles)});if(!r.ok)throw new Error();render()}
-function leafLogLinked(){return !!leafLogState.linked}function leafLogButtons(){let card=$('leafLogCard');if(!LEAF_LOG_ENABLED){card.style.display='none';return}card.style.display='block';let network=userStatus.mode=='network',linked=leafLogLinked(),a=leafLogState.account||{};if(leafLogBusy){$('leafLogStart').textContent='Getting Code...';$('leafLogStart').disabled=true;$('leafLogWifi').style.display='none';msg('leafLogStatus','Getting activation code...');msg('leafLogMsg','Contacting Leaf Log. This can take a few seconds.');return}$('leafLogStart').textContent=linked?'Linked':'Get Activation Code';$('leafLogStart').disabled=linked||!network;$('leafLogWifi').style.display=(linked||!network)?'block':'none';$('leafLogWifi').textContent=linked?'Unlink':'WiFi Setup';if(linked){$('leafLogPanel').classList.remove('active');msg('leafLogMsg','');msg('leafLogStatus','Linked to '+(a.displayName||'Leaf Log')+(a.handle?' (@'+a.handle+')':''));}else if(leafLogState.reconnect_required)msg('leafLogStatus','Reconnect required.');else if(!network)msg('leafLogStatus','Join a WiFi network to link.');else msg('leafLogStatus','Not linked.')}async function loadLeafLogStatus(){try{leafLogState=await(await fetch('/api/leaf-log/status')).json()}catch(e){leafLogState={linked:false,reconnect_required:false,account:{}}}leafLogButtons()}async function startLeafLog(){leafLogButtons();if($('leafLogStart').disabled)return;leafLogBusy=true;leafLogButtons();try{let r=await fetch('/api/leaf-log/pair/start',{method:'POST'}),d=await r.json().catch(()=>({}));if(!r.ok||!d.ok)throw d;leafLogBusy=false;leafLogActivationUrl=d.activation_url||'';$('leafLogCodeText').textContent=d.code?'Code '+d.code:'Open Leaf Log to continue';$('leafLogPanel').classList.add('active');$('leafLogStart').textContent='Get Activation Code';msg('leafLogStatus','Activation code ready.');msg('leafLogMsg','Open Leaf Log, sign in, then approve this device.');pollLeafLog()}catch(x){leafLogBusy=false;msg('leafLogMsg',x&&x.detail?x.detail:'Unable to start Leaf Log linking.');leafLogButtons()}}function pollLeafLog(){if(leafLogPollTimer)clearTimeout(leafLogPollTimer);leafLogPollTimer=setTimeout(async()=>{try{let r=await fetch('/api/leaf-log/pair/poll',{method:'POST'}),d=await r.json().catch(()=>({}));if(!r.ok)throw d;if(d.status=='pending'){msg('leafLogMsg','Waiting for Leaf Log approval...');pollLeafLog();return}if(d.status=='claimed'&&d.saved){msg('leafLogMsg','Leaf Log linked.');await loadLeafLogStatus();return}msg('leafLogMsg','Linking ended: '+(d.status||'unknown')+'.')}catch(x){msg('leafLogMsg',x&&x.detail?x.detail:'Unable to check Leaf Log approval.')}} ,3000)}async function unlinkLeafLog(){if(!confirm('Unlink this Leaf from Leaf Log?'))return;msg('leafLogStatus','Unlinking...');try{await fetch('/api/leaf-log/unlink',{method:'POST'})}finally{await loadLeafLogStatus()}}function leafLogUrl(){return leafLogActivationUrl}function versionText(s){let fw=s.firmware_display_version||'',hw=s.hardware_display_version||'';if(!fw){let a=(s.firmware_version||'').split('+');fw=a[0]||'unknown';hw=a[1]||hw||'';if(fw[0]!='v')fw='v'+fw;if(hw&&hw[0]=='h')hw=hw.slice(1);if(hw&&hw[0]!='v')hw='v'+hw}return `firmware: ${fw}`+(hw?`\nhardware: ${hw}`:'')}
-async function checkFirmware(){let b=$('firmwareCheck');msg('firmwareCheckMsg','checking...');b.disabled=true;try{let r=await fetch('/api/firmware/update-status',{method:'POST'}),d=await r.json().catch(()=>({}));if(!r.ok||!d.ok)throw d;msg('firmwareCheckMsg',d.message||'')}catch(x){msg('firmwareCheckMsg','unable to check for updates')}b.disabled=false}function useUnits(u){if(u)unitPrefs=u}function logParts(t,h12){if(!t)return{day:'--',date:'--',time:'--'};let a=t.split('T'),d=a[0]||'--',hm=(a[1]||'').slice(0,5)||'--',dt=new Date(t),day=isNaN(dt)?'--':dt.toLocaleDateString('en-US',{weekday:'long'}),date=isNaN(dt)?d:dt.toLocaleDateString('en-GB',{day:'numeric',month:'short',year:'numeric'}),h=Number(hm.slice(0,2)),m=hm.slice(3,5);if(h12&&Number.isFinite(h)){let ap=h>=12?'PM':'AM';h=h%12||12;hm=h+':'+m+'\u00a0'+ap}return{day:day,date:date,time:hm}}function logDateTime(t,h12){let p=logParts(t,h12);return p.date?(p.date+'  '+p.time):''}
-function dur(s){s=Number(s)||0;let h=Math.floor(s/3600),m=Math.floor((s%3600)/60);return h?h+'h '+m+'m':m+'m'}
-function good(v){return v!==null&&v!==undefined&&v!==""&&Number.isFinite(Number(v))}function m(v){if(!good(v))return'--';v=Number(v);return unitPrefs.alt_feet?Math.round(v*3.28084)+' ft':Math.round(v)+' m'}function ms(v){if(!good(v))return'--';v=Number(v);return unitPrefs.climb_fpm?Math.round(v*196.85)+' fpm':v.toFixed(1)+' m/s'}function spd(v){if(!good(v))return'--';v=Number(v);return unitPrefs.speed_mph?(v*2.23694).toFixed(1)+' mph':(v*3.6).toFixed(1)+' kph'}function windSpd(v){if(!good(v))return'--';v=Number(v);return unitPrefs.speed_mph?Math.round(v*2.23694)+' mph':Math.round(v*3.6)+' kph'}function dist(v){if(!good(v))return'--';v=Number(v);if(unitPrefs.distance_miles)return v>805?(v*0.000621371).toFixed(2)+' mi':Math.round(v*3.28084)+' ft';return v>=1000?(v/1000).toFixed(2)+' km':Math.round(v)+' m'}function tempVal(c){if(!good(c))return'--';c=Number(c);return unitPrefs.temp_f?Math.round(c*9/5+32):Math.round(c)}function tempRange(a,b){return good(a)&&good(b)?tempVal(a)+'\u00b0 / '+tempVal(b)+'\u00b0'+(unitPrefs.temp_f?'F':'C'):'--'}function hdg(d){if(!good(d))return'--';d=(Math.round(Number(d))%360+360)%360;if(!unitPrefs.heading_cardinal)return d+' deg';let a=['N','NNE','NE','ENE','E','ESE','SE','SSE','S','SSW','SW','WSW','W','WNW','NW','NNW'];return a[Math.round(d/22.5)%16]}function wind(v,d){return windSpd(v)+' '+hdg(d)}
-function altShown(v){if(!good(v))return NaN;v=Number(v);return unitPrefs.alt_feet?Math.round(v*3.28084):Math.round(v)}
-function renderAlt(e){let s=Number(e.start_altitude_m),x=Number(e.max_altitude_m),n=Number(e.min_altitude_m),end=Number(e.end_altitude_m);let vals=[s,x,end].filter(Number.isFinite),a=$('altStart'),b=$('altMax'),c=$('altEnd');[a,b,c].forEach(q=>{q.classList.remove('high');q.style.display='none'});if(!vals.length)return;if(!Number.isFinite(n))n=Math.min(...vals,0);let hi=Math.max(...vals,0),lo=Math.min(n,...vals,0),range=Math.max(1,hi-lo),top=v=>Number.isFinite(v)?Math.round((hi-v)/range*64)+2:32,sv=Number.isFinite(s),ev=Number.isFinite(end),showMax=Number.isFinite(x)&&altShown(x)>Math.max(sv?altShown(s):-1e9,ev?altShown(end):-1e9);if(sv){a.style.display='block';a.lastChild.textContent=m(s);a.style.left='0';a.style.top=top(s)+'px'}if(showMax){b.style.display='block';b.lastChild.textContent=m(x);b.style.left='50%';b.style.transform='translateX(-50%)';b.style.top=top(x)+'px'}if(ev){c.style.display='block';c.lastChild.textContent=m(end);c.style.right='0';c.style.top=top(end)+'px'}if(showMax)b.classList.add('high');else if(sv&&(!ev||altShown(s)>=altShown(end)))a.classList.add('high');else if(ev)c.classList.add('high')}
-async function loadStatus(){try{let s=await(await fetch('/api/user/status')).json();userStatus=s;$('status').textContent=`mode: ${s.mode}\nssid: ${s.ssid||'(none)'}\nip: ${s.ip_address||'(none)'}\n`+versionText(s);leafLogButtons();let fwRow=$("firmwareCheckRow"),fwVisible=s.mode=="network";fwRow.style.display=fwVisible?"flex":"none";if(!fwVisible)msg("firmwareCheckMsg","");if(Number.isFinite(Number(s.battery_percent))){let p=Math.max(0,Math.min(100,Number(s.battery_percent)));$('batteryFill').style.width=p+'%';$('batteryText').textContent=p+'%';$('batteryCharge').textContent=s.battery_charging?'Charging':'Not charging'}else $('batteryBox').style.display='none'}catch(e){$('status').textContent='Unable to read status.';$('firmwareCheckRow').style.display='none'}}
-async function loadLogbook(){try{let d=await(await fetch('/api/logbook')).json();useUnits(d.units);$('logCount').textContent=d.count||0;$('logLatest').textContent=d.latest&&d.latest.start_time_local?logDateTime(d.latest.start_time_local,unitPrefs.time_12h):(d.count?'Unknown':'No flights')}catch(e){$('logLatest').textContent='Unavailable'}}
-function resetDelete(){$('deleteLog').style.display='block';$('deleteConfirm').style.display='none'}
-function clearLogCard(d){logState={prev:d&&d.previous_path||'',next:d&&d.next_path||'',path:d&&d.path||''};$('logPage').textContent=((d&&d.position)||'--')+'/'+((d&&d.total)||'--');$('logPrev').disabled=!logState.next;$('logNext').disabled=!logState.prev;$('flightDay').textContent='--';$('flightDate').textContent='Date unknown';$('flightTime').textContent='--';$('flightDuration').textContent='--';$('flightPilot').textContent='';$('flightGlider').textContent='';renderAlt({});$('climbMax').style.display='none';$('sinkMax').style.display='none';$('flightMetrics').innerHTML=['Straight Dist','Path Dist','Max Speed','Accel','Temp'].map(x=>`<div class=mini-row><span>${x}</span><strong>--</strong></div>`).join('');$('trackInfo').textContent=(d&&d.filename?'Bad log: '+d.filename:'Bad log');$('deleteLog').disabled=!logState.path}
-function igcCoord(s,d){let deg=Number(s.substr(0,d)),min=Number(s.substr(d,2)+'.'+s.substr(d+2,3)),h=s.substr(d+5,1);if(!Number.isFinite(deg)||!Number.isFinite(min))return NaN;let v=deg+min/60;return h=='S'||h=='W'?-v:v}function parseIgc(t){let pts=[];t.split(/\r?\n/).forEach(l=>{if(!l||l[0]!='B'||l.length<35)return;let lat=igcCoord(l.substr(7,8),2),lon=igcCoord(l.substr(15,9),3),alt=parseInt(l.substr(30,5),10);if(!Number.isFinite(alt))alt=parseInt(l.substr(25,5),10);if(Number.isFinite(lat)&&Number.isFinite(lon))pts.push({lat:lat,lon:lon,alt:Number.isFinite(alt)?alt:0})});return pts}function previewColor(t){t=Math.max(0,Math.min(1,t));let r,g,b;if(t<.5){let k=t*2;r=Math.round(17+41*k);g=Math.round(17+139*k);b=Math.round(17+238*k)}else{let k=(t-.5)*2;r=Math.round(58+158*k);g=Math.round(156+99*k);b=Math.round(255*(1-k))}return `rgb(${r},${g},${b})`}function scaleChoice(maxM){let unit=unitPrefs.distance_miles?1609.344:1000,label=unitPrefs.distance_miles?'mi':'km',vals=[100,50,10,5,1,.5,.1];for(let v of vals){if(v*unit<=maxM)return{m:v*unit,label:(v<1?v.toFixed(1):String(v))+' '+label}}return{m:.1*unit,label:'0.1 '+label}}function previewInfo(e){let lp=logParts(e.start_time_local,unitPrefs.time_12h),du=dur(e.duration_seconds),when=(lp.date||'Date unknown')+(lp.time?' '+lp.time:''),people=[];if(e.pilot_name)people.push(e.pilot_name);if(e.glider_display_name)people.push(e.glider_display_name);return '<div>'+esc(when)+(du!='--'?' <span class=preview-duration>'+esc(du)+'</span>':'')+'</div>'+(people.length?'<div>'+people.map(esc).join(' | ')+'</div>':'')}function renderPreview(){let pts=previewState.points,c=$('previewCanvas'),stage=c.parentElement,ctx=c.getContext('2d'),w=Math.max(220,Math.floor(stage.clientWidth-16)),h=Math.max(130,Math.floor(stage.clientHeight-16)),dpr=window.devicePixelRatio||1;c.style.width=w+'px';c.style.height=h+'px';c.width=Math.round(w*dpr);c.height=Math.round(h*dpr);ctx.setTransform(dpr,0,0,dpr,0,0);ctx.clearRect(0,0,w,h);ctx.fillStyle='#4d4d4d';ctx.fillRect(0,0,w,h);if(pts.length<2)return;let mid=pts.reduce((a,p)=>a+p.lat,0)/pts.length,cs=Math.cos(mid*Math.PI/180),xs=pts.map(p=>p.lon*cs),ys=pts.map(p=>p.lat),minX=Math.min(...xs),maxX=Math.max(...xs),minY=Math.min(...ys),maxY=Math.max(...ys),pad=16,s=Math.min((w-pad*2)/Math.max(1e-9,maxX-minX),(h-pad*2)/Math.max(1e-9,maxY-minY)),ox=(w-(maxX-minX)*s)/2,oy=(h-(maxY-minY)*s)/2,xy=(i)=>[ox+(xs[i]-minX)*s,h-(oy+(ys[i]-minY)*s)],lo=previewState.lo,hi=previewState.hi,ar=Math.max(1,hi-lo);ctx.lineCap='round';ctx.lineJoin='round';ctx.lineWidth=3;for(let i=1;i<pts.length;i++){let a=xy(i-1),b=xy(i),t=(pts[i].alt-lo)/ar;ctx.strokeStyle=previewColor(t);ctx.beginPath();ctx.moveTo(a[0],a[1]);ctx.lineTo(b[0],b[1]);ctx.stroke()}let st=xy(0),en=xy(pts.length-1);ctx.fillStyle='white';ctx.beginPath();ctx.arc(st[0],st[1],5,0,7);ctx.fill();ctx.fillStyle='#d8ff00';ctx.beginPath();ctx.arc(en[0],en[1],5,0,7);ctx.fill();ctx.fillStyle='white';ctx.font='12px sans-serif';ctx.fillText('S',st[0]+7,st[1]-7);ctx.fillText('E',en[0]+7,en[1]-7);let mPerPx=111320/Math.max(1e-9,s),sc=scaleChoice(w*.82*mPerPx),sw=Math.max(24,sc.m/mPerPx),sx=14,sy=h-18;ctx.strokeStyle='white';ctx.lineWidth=3;ctx.beginPath();ctx.moveTo(sx,sy);ctx.lineTo(sx+sw,sy);ctx.stroke();ctx.lineWidth=2;ctx.beginPath();ctx.moveTo(sx,sy-5);ctx.lineTo(sx,sy+5);ctx.moveTo(sx+sw,sy-5);ctx.lineTo(sx+sw,sy+5);ctx.stroke();ctx.fillStyle='white';ctx.font='12px sans-serif';ctx.fillText(sc.label,sx,sy-9)}async function openPreview(path,title,info){previewState={points:[],lo:0,hi:0};show('preview');$('previewTitle').textContent=title||'Track Preview';$('previewStats').innerHTML=info||'Loading...';$('previewLow').textContent='Low';$('previewHigh').textContent='High';msg('previewMsg','');renderPreview();try{let r=await fetch('/api/logbook/track?inline=1&path='+encodeURIComponent(path)),t=await r.text();if(!r.ok)throw new Error(t);let pts=parseIgc(t);if(pts.length<2)throw new Error('No GPS points found.');let alts=pts.map(p=>p.alt).filter(Number.isFinite);previewState={points:pts,lo:Math.min(...alts),hi:Math.max(...alts)};$('previewLow').textContent=m(previewState.lo);$('previewHigh').textContent=m(previewState.hi);renderPreview()}catch(e){previewState={points:[],lo:0,hi:0};$('previewStats').innerHTML='';msg('previewMsg','Unable to preview this track.');renderPreview()}}async function loadLogEntry(path){msg('logDetailMsg','Loading...');resetDelete();$('deleteLog').disabled=false;let url='/api/logbook/entry'+(path?'?path='+encodeURIComponent(path):'');try{let r=await fetch(url),d=await r.json().catch(()=>({}));useUnits(d.units);if(!r.ok||!d.ok){clearLogCard(d);throw d}let e=d.entry;logState={prev:d.previous_path||'',next:d.next_path||'',path:e.path||''};$('logPage').textContent=(d.position||'--')+'/'+(d.total||'--');$('logPrev').disabled=!logState.next;$('logNext').disabled=!logState.prev;let lp=logParts(e.start_time_local,unitPrefs.time_12h);$('flightDay').textContent=lp.day||'--';$('flightDate').textContent=lp.date||'Date unknown';$('flightTime').textContent=lp.time||'--';$('flightDuration').textContent=dur(e.duration_seconds);$('flightPilot').textContent=e.pilot_name||'';$('flightGlider').textContent=e.glider_display_name||'';renderAlt(e);$('climbMax').style.display=good(e.max_climb_rate_mps)?'block':'none';$('sinkMax').style.display=good(e.max_sink_rate_mps)?'block':'none';$('climbMax').textContent=ms(e.max_climb_rate_mps);$('sinkMax').textContent=ms(e.max_sink_rate_mps);let rows=[['Straight Dist',dist(e.straight_line_distance_m)],['Path Dist',dist(e.path_distance_m)],['Max Speed',spd(e.max_ground_speed_mps)],['Accel',(good(e.min_accel_g)&&good(e.max_accel_g)?Number(e.min_accel_g).toFixed(1)+' / '+Number(e.max_accel_g).toFixed(1)+' G':'--')],['Temp',tempRange(e.min_temperature_c,e.max_temperature_c)]];if(e.max_wind_valid)rows.push(['Wind',wind(e.max_wind_speed_mps,e.max_wind_direction_from_deg)]);$('flightMetrics').innerHTML=rows.map(r=>`<div class=mini-row><span>${r[0]}</span><strong>${r[1]}</strong></div>`).join('');let tn=e.track_path?e.track_path.split('/').pop():'',igc=tn.toLowerCase().endsWith('.igc'),leafLogIconMarkup=leafLogIcon(e.leaf_log_status,e.leaf_log_rejection_label),leafLogDetail=e.leaf_log_status=='rejected'?'<br><span>Leaf Log: '+esc(e.leaf_log_rejection_label||'Upload rejected')+'</span>':'',leafLog=leafLogIconMarkup+leafLogDetail,track=e.track_saved?(igc?('<span class=track-actions><button class=hero id=previewTrack>Preview</button><span>Track File: <a class=track-file-name href="/api/logbook/track?path='+encodeURIComponent(e.path)+'" download>'+esc(tn)+'</a>'+leafLog+'</span></span>'):('Track File: <span class=track-file-name>'+esc(tn)+'</span>'+leafLog)):('No track file'+leafLog);$('trackInfo').innerHTML=track;let pb=$('previewTrack');if(pb)pb.onclick=()=>openPreview(e.path,tn||'Track Preview',previewInfo(e));$('deleteLog').disabled=!logState.path;msg('logDetailMsg','')}catch(x){resetDelete();if(!(x&&x.path))$('deleteLog').disabled=true;msg('logDetailMsg',x&&x.detail?x.detail:'Unable to load log.')}}
-function previewInfo(e){let lp=logParts(e.start_time_local,unitPrefs.time_12h),du=dur(e.duration_seconds),when=[esc(lp.date||'Date unknown')];if(lp.time)when.push(esc(lp.time));if(du!='--')when.push('<span class=preview-duration>'+esc(du)+'</span>');let people=[];if(e.pilot_name)people.push(e.pilot_name);if(e.glider_display_name)people.push(e.glider_display_name);return '<div>'+when.join(' | ')+'</div>'+(people.length?'<div>'+people.map(esc).join(' | ')+'</div>':'')}
-async function loadProfiles(){try{profiles=await(await fetch('/api/profiles')).json();normalize();msg('pilotMsg','');msg('gliderMsg','');render()}catch(e){msg('pilotMsg','Unable to read profiles.')}}
-$('previewClose').onclick=()=>show('logbook');window.addEventListener('resize',()=>{if($('previewView').classList.contains('active'))renderPreview()});$('firmwareCheck').onclick=checkFirmware;$('openProfiles').onclick=()=>show('profiles');$('backMain').onclick=()=>show('main');$('openNavTools').onclick=async()=>{show('nav');await loadUserWaypoints();await loadNavData(true);await loadWaypointFileList()};$('backNavMain').onclick=()=>show('main');$('backLogMain').onclick=()=>show('main');$('openLogbook').onclick=()=>{show('logbook');loadLogEntry('')};$('waypointActivate').onclick=activateWaypointFile;$('waypointLoad').onclick=()=>{$('waypointFile').value='';$('waypointFile').click()};$('waypointFile').onchange=()=>uploadWaypointFile($('waypointFile').files[0]);$('fileWaypointActivate').onclick=()=>{let p=selectedFilePoint();if(p)activatePointIndex(Number(p.index),'waypointMsg')};$('fileWaypointMap').onclick=()=>{let p=selectedFilePoint();if(p)window.open(mapUrl(p),'_blank','noopener')};$('userWaypointSelect').onchange=e=>{selectedUserWaypointId=e.target.value;renderUserWaypoints()};$('userWaypointName').oninput=userWaypointChanged;$('userWaypointRename').onclick=renameUserWaypoint;$('userWaypointActivate').onclick=()=>{let p=selectedUserWaypoint();if(p)activatePointIndex(Number(p.index),'userWaypointMsg')};$('userWaypointMap').onclick=()=>{let p=selectedUserWaypoint();if(p)window.open(mapUrl(p),'_blank','noopener')};$('userWaypointDelete').onclick=()=>{if(!selectedUserWaypoint())return;$('userWaypointDelete').style.display='none';$('userWaypointDeleteConfirm').style.display='block';msg('userWaypointMsg','')};$('userWaypointCancelDelete').onclick=resetUserWaypointDelete;$('userWaypointConfirmDelete').onclick=deleteUserWaypoint;$('createRouteLoadPoints').onclick=loadRoutePoints;$('editRouteName').oninput=routeEditButtons;$('editRouteAdd').onclick=addSelectedRoutePoint;$('editRouteSave').onclick=saveEditedRoute;$('editRouteList').onclick=e=>{let b=e.target.closest('button');if(!b)return;let i=Number(b.dataset.i),a=b.dataset.act;if(a=='remove')editRoute.splice(i,1);else if(a=='up'&&i>0)[editRoute[i-1],editRoute[i]]=[editRoute[i],editRoute[i-1]];else if(a=='down'&&i<editRoute.length-1)[editRoute[i+1],editRoute[i]]=[editRoute[i],editRoute[i+1]];renderEditRoute()};$('editRouteList').oninput=e=>{if(e.target.dataset.r===undefined)return;let i=Number(e.target.dataset.r),v=Number(e.target.value)||150;editRoute[i].radius_m=Math.max(10,Math.min(20000,Math.round(v)))};$('logPrev').onclick=()=>{if(logState.next)loadLogEntry(logState.next)};$('logNext').onclick=()=>{if(logState.prev)loadLogEntry(logState.prev)};$('deleteLog').onclick=()=>{if(!logState.path)return;$('deleteLog').style.display='none';$('deleteConfirm').style.display='block';msg('logDetailMsg','')};$('cancelDelete').onclick=resetDelete;$('confirmDelete').onclick=async()=>{if(!logState.path)return;msg('logDetailMsg','Deleting...');try{let r=await fetch('/api/logbook/entry?path='+encodeURIComponent(logState.path),{method:'DELETE'}),d=await r.json().catch(()=>({}));if(!r.ok||!d.ok)throw d;await loadLogbook();if(d.count>0)loadLogEntry(d.next_path||'');else{show('main');msg('logMsg','Log deleted.')}}catch(x){msg('logDetailMsg',x&&x.detail?x.detail:'Unable to delete log.');resetDelete()}};['pilotName','gliderBrand','gliderModel','gliderSize','gliderDisplay'].forEach(x=>$(x).oninput=buttons);['leafLogEmail'].forEach(x=>$(x).oninput=buttons);$('leafLogPilot').onchange=buttons;['routeName','routeData'].forEach(x=>$(x).oninput=routeButtons);$('leafLogStart').onclick=startLeafLog;$('leafLogWifi').onclick=()=>{location.href='/wifi?scan=1&return=app'};$('leafLogOpen').onclick=()=>{let u=leafLogUrl();if(u)window.open(u,'_blank','noopener')};$('routeSave').onclick=async()=>{let name=clean($('routeName').value),data=clean($('routeData').value);if(!name||!data){routeButtons();return}msg('routeMsg','Saving route...');$('routeSave').disabled=true;try{let r=await fetch('/api/routes/import',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({name:name,data:data,activate:$('routeActivate').checked})}),d=await r.json().catch(()=>({}));if(!r.ok||!d.saved)throw d;msg('routeMsg','Saved '+(d.points||0)+' points'+(d.active?' and set active.':'.'));$('routeData').value=''}catch(x){msg('routeMsg',x&&x.detail?x.detail:'Unable to save route.')}routeButtons(false)};
-$('activePilotList').onchange=()=>{profiles.active_pilot_id=$('activePilotList').value;render();save().then(()=>msg('mainProfileMsg','Active pilot saved.')).catch(()=>msg('mainProfileMsg','Unable to save.'))};
-$('activeGliderList').onchange=()=>{profiles.active_glider_id=$('activeGliderList').value;render();save().then(()=>msg('mainProfileMsg','Active glider saved.')).catch(()=>msg('mainProfileMsg','Unable to save.'))};
-$('pilotList').onchange=()=>{profiles.active_pilot_id=$('pilotList').value;render();save().then(()=>msg('pilotMsg','Active pilot selected.')).catch(()=>msg('pilotMsg','Unable to save.'))};
-$('gliderList').onchange=()=>{profiles.active_glider_id=$('gliderList').value;render();save().then(()=>msg('gliderMsg','Active glider selected.')).catch(()=>msg('gliderMsg','Unable to save.'))};
-$('pilotNew').onclick=()=>{profiles.active_pilot_id=null;$('pilotName').value='';setSnaps();$('pilotName').focus();msg('pilotMsg','Enter pilot name, then Save Profile.')};
-$('gliderNew').onclick=()=>{profiles.active_glider_id=null;['gliderBrand','gliderModel','gliderSize','gliderDisplay'].forEach(x=>$(x).value='');setSnaps();$('gliderModel').focus();msg('gliderMsg','Enter glider details, then Save Profile.')};
-$('pilotSave').onclick=()=>{let name=clean($('pilotName').value);if(!name){msg('pilotMsg','Pilot name is required.');return}let p=selectedPilot();if(!p){p={id:newId(),name:''};profiles.pilots.push(p);profiles.active_pilot_id=p.id;if(!leafLog().pilot_id)leafLog().pilot_id=p.id}p.name=name;save().then(()=>msg('pilotMsg','Pilot profile saved.')).catch(()=>msg('pilotMsg','Unable to save pilot.'))};
-$('gliderSave').onclick=()=>{let model=clean($('gliderModel').value);if(!model){msg('gliderMsg','Glider model is required.');return}let g=selectedGlider();if(!g){g={id:newId(),model:''};profiles.gliders.push(g);profiles.active_glider_id=g.id}g.brand=clean($('gliderBrand').value);g.model=model;g.size=clean($('gliderSize').value);g.display_name=clean($('gliderDisplay').value);save().then(()=>msg('gliderMsg','Glider profile saved.')).catch(()=>msg('gliderMsg','Unable to save glider.'))};
-$('pilotDelete').onclick=()=>{let p=selectedPilot();if(!p)return;profiles.pilots=profiles.pilots.filter(x=>x.id!=p.id);profiles.active_pilot_id=null;save().then(()=>msg('pilotMsg','Pilot profile deleted.')).catch(()=>msg('pilotMsg','Unable to delete pilot.'))};
-$('gliderDelete').onclick=()=>{let g=selectedGlider();if(!g)return;profiles.gliders=profiles.gliders.filter(x=>x.id!=g.id);profiles.active_glider_id=null;save().then(()=>msg('gliderMsg','Glider profile deleted.')).catch(()=>msg('gliderMsg','Unable to delete glider.'))};
-$('leafLogWifi').onclick=()=>{if(leafLogLinked())unlinkLeafLog();else location.href='/wifi?scan=1&return=app'};
-leafLogButtons();routeButtons();routeEditButtons();loadStatus();loadProfiles();loadLeafLogStatus();loadLogbook();loadNavData();loadUserWaypoints();
-</script></body></html>)leafapp";
+    sendGzipAsset(target, web_assets::APP_HTML);
+  }
+
+  // Everything in the app shell that depends on settings, so the shell itself can be cached
+  void sendUserAppConfig(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "text/plain", "Leaf Web App is not active.");
+      return;
+    }
+
     sendNoStoreHeaders(target);
-    target.setContentLength(CONTENT_LENGTH_UNKNOWN);
-    target.send(200, "text/html", "");
-    PGM_P cursor = USER_APP_PAGE;
-    const char placeholder[] = "__LEAF_LOG_ENABLED__";
-    const size_t placeholderLen = sizeof(placeholder) - 1;
-    while (const char* match = strstr_P(cursor, placeholder)) {
-      target.sendContent_P(cursor, match - cursor);
-      target.sendContent(settings.labs_leafLog ? "true" : "false");
-      cursor = match + placeholderLen;
-    }
-    target.sendContent_P(cursor);
-    if (!settings.dev_mode) {
-      return;
-    }
-
-    static constexpr char USER_APP_DEVELOPER_SCRIPT[] PROGMEM =
-        R"leafdev(<script>
-(function(){
-function el(t,a,c){let n=document.createElement(t);if(a)Object.keys(a).forEach(k=>{if(k=="text")n.textContent=a[k];else n.setAttribute(k,a[k])});(c||[]).forEach(x=>n.appendChild(x));return n}
-function row(label,id){let l=el("label",{class:"checkline"}),i=el("input",{id:id,type:"checkbox"}),s=el("span",{text:label});l.appendChild(i);l.appendChild(s);return l}
-function msg(t){let m=document.getElementById("devMsg");if(m)m.textContent=t||""}
-let main=document.getElementById("mainView");if(!main)return;
-let s=el("section",{id:"developerCard"}),h=el("h2",{text:"Developer"}),status=el("div",{class:"status",id:"devStatus",text:"Loading..."}),actions=el("div",{class:"actions"}),msgEl=el("p",{class:"muted msg",id:"devMsg"});
-let shot=el("button",{class:"hero",id:"devScreenshot",text:"Screenshot"}),msc=el("button",{class:"secondary",id:"devMassStorage",text:"Mass Storage"}),mem=el("button",{class:"secondary",id:"devMemory",text:"Memory"}),fan=el("button",{class:"secondary",id:"devFanet",text:"FANET"});
-actions.style.flexWrap="wrap";
-actions.appendChild(shot);actions.appendChild(msc);actions.appendChild(mem);actions.appendChild(fan);
-s.appendChild(h);s.appendChild(status);s.appendChild(row("Keep web app on","devAlwaysOn"));s.appendChild(row("Keep Bluetooth disabled","devKeepBleDisabled"));s.appendChild(row("System events log","devDiagSystem"));s.appendChild(row("Network events log","devDiagNetwork"));s.appendChild(row("Web requests log","devDiagWeb"));s.appendChild(row("Vario log","devDiagVario"));s.appendChild(row("CPU utilization log","devDiagCpu"));s.appendChild(actions);s.appendChild(msgEl);main.appendChild(s);
-async function load(){try{let r=await Promise.all([fetch("/api/debug/session"),fetch("/api/user/status")]),d=await r[0].json(),u=await r[1].json();document.getElementById("devAlwaysOn").checked=!!d.always_on;document.getElementById("devKeepBleDisabled").checked=!!d.keep_bluetooth_disabled;document.getElementById("devDiagSystem").checked=!!d.diag_system_events;document.getElementById("devDiagNetwork").checked=!!d.diag_network_events;document.getElementById("devDiagWeb").checked=!!d.diag_web_requests;document.getElementById("devDiagVario").checked=!!d.diag_vario;document.getElementById("devDiagCpu").checked=!!d.diag_cpu_utilization;status.textContent="web app: "+(d.web_app_active?"active":"off")+"\nmode: "+(d.using_leaf_wifi?"Leaf AP":"network")+"\nfirmware: "+(u.firmware_display_version||u.firmware_version||"")+"\nmac: "+(u.mac_address||"")}catch(e){status.textContent="Developer controls unavailable."}}
-async function save(){msg("Saving...");try{let body={always_on:document.getElementById("devAlwaysOn").checked,keep_bluetooth_disabled:document.getElementById("devKeepBleDisabled").checked,diag_system_events:document.getElementById("devDiagSystem").checked,diag_network_events:document.getElementById("devDiagNetwork").checked,diag_web_requests:document.getElementById("devDiagWeb").checked,diag_vario:document.getElementById("devDiagVario").checked,diag_cpu_utilization:document.getElementById("devDiagCpu").checked};await fetch("/api/debug/session",{method:"POST",headers:{"Content-Type":"application/json"},body:JSON.stringify(body)});msg("Saved.");load()}catch(e){msg("Unable to save developer settings.")}}
-["devAlwaysOn","devKeepBleDisabled","devDiagSystem","devDiagNetwork","devDiagWeb","devDiagVario","devDiagCpu"].forEach(id=>document.getElementById(id).onchange=save);
-shot.onclick=()=>window.open("/app/debug/screenshot","_blank","noopener");
-mem.onclick=()=>window.open("/app/debug/memory","_blank","noopener");
-fan.onclick=()=>window.open("/app/debug/fanet","_blank","noopener");
-msc.onclick=async()=>{if(!confirm("Start SD mass storage?"))return;msg("Starting mass storage...");try{await fetch("/api/debug/mass-storage");msg("Mass storage requested.")}catch(e){msg("Unable to start mass storage.")}};
-load();
-})();
-</script>)leafdev";
-    target.sendContent_P(USER_APP_DEVELOPER_SCRIPT);
-    target.sendContent("");
-    return;
+    String script = "window.LEAF_CONFIG={leaf_log:";
+    script += settings.labs_leafLog ? "true" : "false";
+    script += ",developer:";
+    script += settings.dev_mode ? "true" : "false";
+    script += "};";
+    target.send(200, "application/javascript", script);
+  }
+
+  void sendUserAppDeveloperScript(WebServer& target) {
+    if (!user_app_enabled || !settings.dev_mode) {
+      target.send(404, "text/plain", "Not found");
+      return;
+    }
+
+    sendGzipAsset(target, web_assets::DEVELOPER_JS);
   }
 
   void sendWifiSetupPage(WebServer& target) {
@@ -2259,10 +2547,7 @@ load();
       return;
     }
 
-    sendNoStoreHeaders(target);
-    static constexpr char WIFI_SETUP_PAGE[] PROGMEM =
-        R"leafhtml(<!doctype html><html><head><meta name=viewport content="width=device-width,initial-scale=1"><meta http-equiv=Cache-Control content=no-store><title>Leaf WiFi</title><style>:root{font-family:-apple-system,BlinkMacSystemFont,"Segoe UI",sans-serif;color:#202423;background:#363636;line-height:1.35;--leaf:#d8ff00;--ink:#202423;--panel:#565656;--sub:#4d4d4d}body{margin:0;background:#363636}header{background:var(--leaf);color:#0b0d0b;padding:11px 20px;text-align:center}main{max-width:640px;margin:auto;padding:18px}h1{font-family:Arial,sans-serif;font-size:38px;font-weight:500;letter-spacing:.12em;line-height:1;margin:0}.subbar{display:flex;align-items:center;justify-content:center;min-height:34px;color:white;margin:0 0 14px}.subbar h2{color:white;background:transparent;margin:0;padding:0;font-size:18px}section{background:var(--panel);border-radius:8px;margin:0 0 14px;padding:16px 14px}label{display:block;font-size:13px;font-weight:700;margin:10px 0 4px;color:white}input,select,button{box-sizing:border-box;width:100%;font:inherit;padding:11px;border:1px solid #b9c0b2;border-radius:7px;background:white;color:var(--ink)}input:focus,select:focus,button:focus{outline:2px solid var(--leaf);outline-offset:1px}button{background:var(--ink);color:white;font-weight:750;border-color:var(--ink);box-shadow:inset 0 -2px 0 rgba(0,0,0,.22)}button:disabled{background:#686868;border-color:#686868;color:#8a8a8a;opacity:1;box-shadow:none}.hero:not(:disabled){background:var(--leaf);border-color:var(--leaf);color:#0b0d0b}.status{min-height:20px;margin:0 0 12px;color:#e2e7dc}.network-row,.row{display:flex;gap:8px}.network-row select,.row input{flex:1}.refresh{flex:0 0 44px;width:44px;height:44px;padding:0;font-size:23px;line-height:1}.show{display:flex;align-items:center;gap:6px;width:auto;white-space:nowrap;color:white;font-weight:700}.show input{width:auto;accent-color:var(--leaf)}#n{margin-top:8px}#save{margin-top:16px}</style><script>async function init(){let s=document.getElementById('s'),l=document.getElementById('l'),n=document.getElementById('n'),p=document.getElementById('p'),w=document.getElementById('w'),f=document.getElementById('f'),r=document.getElementById('r'),save=document.getElementById('save');function chosen(){let o=l.options[l.selectedIndex];return o&&o.value&&o.value==n.value.trim()?o:null}function buttons(){let o=chosen(),need=o&&o.dataset.secure=='1';save.disabled=!n.value.trim()||(need&&!p.value)}l.onchange=()=>{if(l.value)n.value=l.value;buttons()};n.oninput=buttons;p.oninput=buttons;w.onchange=()=>p.type=w.checked?'text':'password';r.onclick=()=>nets(true);let params=new URLSearchParams(location.search),autoScan=params.has('scan');async function nets(refresh){try{let d=await(await fetch('/api/wifi/networks'+(refresh?'?refresh=1':''))).json();if(d.scanning){s.textContent='Scanning for networks...';setTimeout(nets,1500);return}l.innerHTML='<option value="">Select network...</option>';d.networks.forEach(x=>{let o=document.createElement('option');o.value=x.ssid;o.dataset.secure=x.secure?'1':'0';o.textContent=x.ssid+' ('+x.rssi+' dBm)';l.appendChild(o)});s.textContent=d.networks.length?'Choose a network or type one manually.':'No networks found. Type the network name manually.';buttons()}catch(e){s.textContent='Unable to read network list. Type the network name manually.';buttons()}}async function poll(){try{let d=await(await fetch('/api/wifi/status')).json();if(d.connected){f.style.display='none';s.textContent='Connected to '+d.ssid+'. To use the Leaf Web App, open Menu > Web App on Leaf.';return}if(d.error){s.textContent='Unable to connect. Check password and try again.';return}s.textContent=d.target_ssid?'Trying to connect to '+d.target_ssid+'...':'Trying to connect...';setTimeout(poll,1500)}catch(e){s.textContent='Trying to connect...';setTimeout(poll,2000)}}f.onsubmit=async e=>{e.preventDefault();let ssid=n.value.trim();if(save.disabled)return;s.textContent='Saving credentials...';try{await fetch('/api/wifi/connect',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({ssid:ssid,password:p.value})});save.disabled=true;poll()}catch(x){s.textContent='Unable to save network details. Try again.';buttons()}};buttons();nets(autoScan)}</script></head><body onload=init()><header><h1>Leaf</h1></header><main><div class=subbar><h2>WiFi Setup</h2></div><section><p class=status id=s>Loading...</p><form id=f><label>Network</label><div class=network-row><select id=l><option value="">Select network...</option></select><button type=button id=r class=refresh title=Refresh aria-label=Refresh>&#x21bb;</button></div><input id=n autocomplete=off placeholder="Type network name"><label>Password</label><div class=row><input id=p type=password autocomplete=current-password><label class=show><input id=w type=checkbox>Show</label></div><button id=save class=hero disabled>Save and Connect</button></form></section></main></body></html>)leafhtml";
-    target.send_P(200, "text/html", WIFI_SETUP_PAGE);
+    sendGzipAsset(target, web_assets::WIFI_HTML);
   }
 
   void sendUserStatus(WebServer& target) {
@@ -2337,16 +2622,23 @@ load();
     user_app_always_on = extractJsonBoolValue(body, "always_on", user_app_always_on);
     user_app_keep_bluetooth_disabled =
         extractJsonBoolValue(body, "keep_bluetooth_disabled", user_app_keep_bluetooth_disabled);
-    settings.diag_systemEvents =
-        extractJsonBoolValue(body, "diag_system_events", settings.diag_systemEvents);
-    settings.diag_networkEvents =
-        extractJsonBoolValue(body, "diag_network_events", settings.diag_networkEvents);
-    settings.diag_webRequests =
-        extractJsonBoolValue(body, "diag_web_requests", settings.diag_webRequests);
-    settings.diag_vario = extractJsonBoolValue(body, "diag_vario", settings.diag_vario);
-    settings.diag_cpuUtilization =
-        extractJsonBoolValue(body, "diag_cpu_utilization", settings.diag_cpuUtilization);
-    settings.save();
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      settings.diag_systemEvents =
+          extractJsonBoolValue(body, "diag_system_events", settings.diag_systemEvents);
+      settings.diag_networkEvents =
+          extractJsonBoolValue(body, "diag_network_events", settings.diag_networkEvents);
+      settings.diag_webRequests =
+          extractJsonBoolValue(body, "diag_web_requests", settings.diag_webRequests);
+      settings.diag_vario = extractJsonBoolValue(body, "diag_vario", settings.diag_vario);
+      settings.diag_cpuUtilization =
+          extractJsonBoolValue(body, "diag_cpu_utilization", settings.diag_cpuUtilization);
+      settings.save();
+    }
     sendDebugSessionStatus(target);
   }
 
@@ -2403,11 +2695,18 @@ load();
       return;
     }
 
-    settings.fanet_address = fanet_address;
-    settings.save();
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      settings.fanet_address = fanet_address;
+      settings.save();
+    }
 
     String json = "{\"fanet_address\":\"";
-    json += settings.fanet_address;
+    json += fanet_address;
     json += "\",\"saved\":true}";
     target.send(200, "application/json", json);
   }
@@ -2418,9 +2717,16 @@ load();
     // The diagnostic network defers the production test while commissioning is pending so the
     // factory interface can format the SD card first. Mark the explicitly requested test as the
     // production test without preventing a failed test from being restarted.
-    if (!settings.productionTest) {
-      settings.productionTest = true;
-      settings.save();
+    {
+      MainLoopLockGuard lock(MAIN_LOOP_LOCK_TIMEOUT_MS, false);
+      if (!lock) {
+        sendBusy(target);
+        return;
+      }
+      if (!settings.productionTest) {
+        settings.productionTest = true;
+        settings.save();
+      }
     }
     requestInteractiveSelfTest();
     target.send(200, "application/json", selfTestSnapshotJson());
@@ -2862,19 +3168,15 @@ load();
     return LogbookStore::filenameFromPath(normalizedPath).length() > 4;
   }
 
-  void sendLogbookTrack(WebServer& target) {
-    if (!user_app_enabled) {
-      target.send(404, "application/json", "{\"ok\":false,\"error\":\"inactive\"}");
-      return;
-    }
-
-    heap_monitor::checkpoint("logbook-track-start");
+  // Resolve the IGC track behind the logbook entry named by the "path" argument.  Sends the error
+  // response and returns false if there isn't one.
+  bool resolveLogbookTrack(WebServer& target, String& trackPath) {
     const String logbookPath = LogbookStore::normalizePath(target.arg("path"));
     if (!LogbookStore::isLogbookJsonPath(logbookPath)) {
       heap_monitor::checkpoint("logbook-track-bad-log-path");
       target.send(400, "application/json",
                   "{\"ok\":false,\"error\":\"bad_path\",\"detail\":\"Invalid log path.\"}");
-      return;
+      return false;
     }
 
     LogbookEntrySummary summary;
@@ -2882,23 +3184,35 @@ load();
       heap_monitor::checkpoint("logbook-track-missing-log");
       target.send(404, "application/json",
                   "{\"ok\":false,\"error\":\"missing\",\"detail\":\"Log file was not found.\"}");
-      return;
+      return false;
     }
 
-    const String trackPath = normalizeTrackPath(summary.trackPath);
+    trackPath = normalizeTrackPath(summary.trackPath);
     if (!summary.trackSaved || !isIgcTrackPath(trackPath)) {
       heap_monitor::checkpoint("logbook-track-no-igc");
       target.send(404, "application/json",
                   "{\"ok\":false,\"error\":\"no_igc\",\"detail\":\"No IGC track file found.\"}");
-      return;
+      return false;
     }
     if (!SD_MMC.exists(trackPath)) {
       heap_monitor::checkpoint("logbook-track-missing-file");
       target.send(404, "application/json",
                   "{\"ok\":false,\"error\":\"missing\",\"detail\":\"Track file was not found.\"}");
+      return false;
+    }
+    return true;
+  }
+
+  void sendLogbookTrack(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "application/json", "{\"ok\":false,\"error\":\"inactive\"}");
       return;
     }
 
+    heap_monitor::checkpoint("logbook-track-start");
+    String trackPath;
+    if (!resolveLogbookTrack(target, trackPath)) return;
+
     File file = SD_MMC.open(trackPath, "r");
     if (!file) {
       heap_monitor::checkpoint("logbook-track-open-fail");
@@ -2914,12 +3228,98 @@ load();
     if (!target.hasArg("inline")) {
       target.sendHeader("Content-Disposition", "attachment; filename=\"" + filename + "\"");
     }
+    // A track still being logged is served as far as it has reached the card
+    size_t size = file.size();
+    uint32_t written;
+    if (PreallocatedFile::writtenLength(trackPath, written) && written < size) size = written;
     sendNoStoreHeaders(target);
-    target.streamFile(file, target.hasArg("inline") ? "text/plain" : "application/octet-stream");
+    streamFileRange(target, file, size,
+                    target.hasArg("inline") ? "text/plain" : "application/octet-stream");
     file.close();
     heap_monitor::checkpoint("logbook-track-end");
   }
 
+  void sendExportZip(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "application/json", "{\"ok\":false,\"error\":\"inactive\"}");
+      return;
+    }
+    if (!sdcard.isMounted()) {
+      target.send(404, "application/json", "{\"detail\":\"SD card is not mounted.\"}");
+      return;
+    }
+
+    heap_monitor::checkpoint("export-start");
+    const zip_export::Source sources[] = {{"/tracks", NULL},
+                                          {"/logbook", LogbookStore::fileMutex()}};
+    zip_export::Plan plan;
+    if (!zip_export::plan(SD_MMC, sources, 2, plan)) {
+      target.send(413, "application/json",
+                  "{\"detail\":\"Too many flights for one download.\"}");
+      return;
+    }
+
+    const uint32_t startedMs = millis();
+    target.sendHeader("Content-Disposition", "attachment; filename=\"leaf-flights.zip\"");
+    sendNoStoreHeaders(target);
+    target.setContentLength(plan.archiveBytes);
+    target.send(200, "application/zip", "");
+    WiFiClient client = target.client();
+    const bool sent = zip_export::write(SD_MMC, sources, 2, plan, client);
+    if (!sent) client.stop();
+    const uint32_t elapsedMs = millis() - startedMs;
+    Serial.printf("Export: %s %u files, %lu bytes in %lu ms (%lu kB/s)\n",
+                  sent ? "sent" : "aborted", plan.fileCount,
+                  static_cast<unsigned long>(plan.archiveBytes),
+                  static_cast<unsigned long>(elapsedMs),
+                  static_cast<unsigned long>(elapsedMs ? plan.archiveBytes / elapsedMs : 0));
+    heap_monitor::checkpoint(sent ? "export-end" : "export-aborted");
+  }
+
+  void sendLogbookTrackPreview(WebServer& target) {
+    if (!user_app_enabled) {
+      target.send(404, "application/json", "{\"ok\":false,\"error\":\"inactive\"}");
+      return;
+    }
+
+    heap_monitor::checkpoint("logbook-track-preview-start");
+    String trackPath;
+    if (!resolveLogbookTrack(target, trackPath)) return;
+
+    // A preview built now would be cached without the rest of the flight
+    uint32_t written;
+    if (PreallocatedFile::writtenLength(trackPath, written)) {
+      heap_monitor::checkpoint("logbook-track-preview-recording");
+      target.send(409, "application/json",
+                  "{\"ok\":false,\"error\":\"recording\",\"detail\":\"Track is still being "
+                  "recorded.\"}");
+      return;
+    }
+
+    // Flights recorded before previews existed get their sidecar built on first request
+    if (!track_preview::ensureSidecar(trackPath)) {
+      heap_monitor::checkpoint("logbook-track-preview-build-fail");
+      target.send(500, "application/json",
+                  "{\"ok\":false,\"error\":\"preview_failed\",\"detail\":\"Track preview could "
+                  "not be built.\"}");
+      return;
+    }
+
+    File file = SD_MMC.open(track_preview::sidecarPathFor(trackPath), "r");
+    if (!file) {
+      heap_monitor::checkpoint("logbook-track-preview-open-fail");
+      target.send(500, "application/json",
+                  "{\"ok\":false,\"error\":\"open_failed\",\"detail\":\"Track preview could not "
+                  "be opened.\"}");
+      return;
+    }
+
+    sendNoStoreHeaders(target);
+    target.streamFile(file, "application/json");
+    file.close();
+    heap_monitor::checkpoint("logbook-track-preview-end");
+  }
+
   String wifiNetworksJsonFromScan(int16_t scan_result) {
     if (scan_result < 0) {
       return "{\"scanning\":false,\"networks\":[]}";
@@ -3072,6 +3472,13 @@ load();
           sendUserAppShell(user_server);
         });
       });
+      user_server.on("/app/config.js", HTTP_GET, []() {
+        handleUserRequest("GET /app/config.js", []() { sendUserAppConfig(user_server); });
+      });
+      user_server.on("/app/developer.js", HTTP_GET, []() {
+        handleUserRequest("GET /app/developer.js",
+                          []() { sendUserAppDeveloperScript(user_server); });
+      });
       user_server.on("/wifi", HTTP_GET, []() {
         handleUserRequest("GET /wifi", []() { sendWifiSetupPage(user_server); });
       });
@@ -3100,6 +3507,15 @@ load();
           saveProfiles(user_server);
         });
       });
+      user_server.on("/api/vario-tones", HTTP_GET, []() {
+        handleUserRequest("GET /api/vario-tones", []() { sendVarioTones(user_server); });
+      });
+      user_server.on("/api/vario-tones", HTTP_PUT, []() {
+        handleUserRequest("PUT /api/vario-tones", []() { saveVarioTones(user_server); });
+      });
+      user_server.on("/api/vario-tones", HTTP_DELETE, []() {
+        handleUserRequest("DELETE /api/vario-tones", []() { deleteVarioTones(user_server); });
+      });
       user_server.on("/api/leaf-log/pair/start", HTTP_POST, []() {
         handleUserRequest("POST /api/leaf-log/pair/start", []() { startLeafLogPair(user_server); });
       });
@@ -3168,6 +3584,13 @@ load();
       user_server.on("/api/logbook/track", HTTP_GET, []() {
         handleUserRequest("GET /api/logbook/track", []() { sendLogbookTrack(user_server); });
       });
+      user_server.on("/api/export.zip", HTTP_GET, []() {
+        handleUserRequest("GET /api/export.zip", []() { sendExportZip(user_server); });
+      });
+      user_server.on("/api/logbook/track-preview", HTTP_GET, []() {
+        handleUserRequest("GET /api/logbook/track-preview",
+                          []() { sendLogbookTrackPreview(user_server); });
+      });
       user_server.on("/api/logbook/entry", HTTP_DELETE, []() {
         handleUserRequest("DELETE /api/logbook/entry", []() {
           if (diagnosticsEnabled()) user_app_route_logbook_delete_count++;
@@ -3220,6 +3643,82 @@ load();
     }
     Serial.printf("Leaf Web App started: %s\n", userAppUrl().c_str());
   }
+
+  void startUserAppServer() {
+    resetUserAppCounters();
+    if (user_app_using_leaf_wifi) startLeafApDns();
+    setupUserAppServer();
+    heap_monitor::checkpoint("after-user-server");
+    webserver_setup();
+    heap_monitor::checkpoint("enabled");
+  }
+
+  void startWifiSetupServer() {
+    resetUserAppCounters();
+    setupUserAppServer();
+    heap_monitor::checkpoint("wifi-setup-server");
+    logWifiSetupTiming("after-user-server");
+    startLeafApDns();
+    heap_monitor::checkpoint("wifi-setup-dns");
+    logWifiSetupTiming("after-dns");
+    webserver_setup();
+    logWifiSetupTiming("after-main-server");
+    startWifiNetworkScan();
+    logWifiSetupTiming("after-scan-start");
+    appendWifiSetupDiagnostics("setup-started", true);
+  }
+
+  void stopUserAppServer() {
+    stopLeafApDns();
+    if (wifi_setup_scan_running) WiFi.scanDelete();
+    wifi_setup_scan_running = false;
+    releaseWifiSetupNetworksJson();
+    wifi_setup_connecting = false;
+    wifi_setup_connected_ms = 0;
+    wifi_setup_connect_ssid = "";
+    wifi_setup_connect_password = "";
+    wifi_setup_connect_error = "";
+    wifi_setup_connect_saved = false;
+    if (user_server_started) {
+      user_server.stop();
+      user_server_started = false;
+      heap_monitor::checkpoint("after-user-stop");
+    }
+  }
+
+  // Carry out what the menus posted, in order; called by the web task between requests
+  void applyServerChanges() {
+    ServerChange change;
+    while (xQueueReceive(serverChanges(), &change, 0) == pdTRUE) {
+      switch (change) {
+        case ServerChange::StartUserApp:
+          startUserAppServer();
+          break;
+        case ServerChange::StartWifiSetup:
+          startWifiSetupServer();
+          break;
+        case ServerChange::Stop:
+          stopUserAppServer();
+          break;
+      }
+    }
+  }
+
+  void webServerTask(void*) {
+    while (true) {
+      factoryDiscovery.update();
+      {
+        LockGuard lock(serverMutex(), portMAX_DELAY);
+        applyServerChanges();
+        if (sdcard.firmwareOwnsMassStorage() &&
+            (WiFi.status() == WL_CONNECTED || user_app_enabled)) {
+          webserver_setup();
+          webserver_loop();
+        }
+      }
+      vTaskDelay(pdMS_TO_TICKS(WEB_TASK_POLL_MS));
+    }
+  }
 }  // namespace
 
 const char* leafLogBaseUrl() { return LEAF_LOG_BASE_URL; }
@@ -3235,6 +3734,12 @@ void writeScreenshotBuffer(const char* buffer) {
 
 void webserver_setup() {
   configureCommissioningRoutes();
+  if (!user_server_started) {
+    // For conditional requests of the gzipped app files (sendGzipAsset) and resumed downloads
+    // (streamFileRange)
+    static const char* collectedHeaders[] = {"If-None-Match", "Range"};
+    user_server.collectHeaders(collectedHeaders, 2);
+  }
   if (!user_server_started && commissioningHttpAllowed()) {
     user_server.begin();
     user_server_started = true;
@@ -3405,22 +3910,45 @@ void webserver_loop() {
       if (user_app_dns_started) dns_server.processNextRequest();
       if (diagnosticsEnabled()) user_app_handle_count++;
       if (user_app_provisioning) appendWifiSetupDiagnostics("loop");
-      if (webserver_wifi_setup_ready_to_finish()) {
-        appendWifiSetupDiagnostics("transition-start", true);
-        Serial.printf("Leaf WiFi setup connected to %s; closing setup portal\n",
-                      WiFi.SSID().c_str());
-        webserver_disable_user_app();
-        appendWifiSetupDiagnostics("transition-finished", true);
-        display.update();
-      }
     }
-    updatePendingInteractiveSelfTest();
   }
 }
 
+void webserver_start_task() {
+  if (web_task) return;
+  if (xTaskCreatePinnedToCore(webServerTask, "WebServer", WEB_TASK_STACK_BYTES, NULL,
+                              WEB_TASK_PRIORITY, &web_task, WEB_TASK_CORE) != pdPASS) {
+    Serial.println("WebServer: could not start task");
+    web_task = NULL;
+    return;
+  }
+  heap_monitor::checkpoint("web-task");
+}
+
+void webserver_main_loop() {
+  updatePendingInteractiveSelfTest();
+
+  bool finishWifiSetup;
+  {
+    // Never wait here: the web task may be in the middle of a long download
+    LockGuard lock(serverMutex(), 0, false);
+    if (!lock) return;
+    finishWifiSetup = webserver_wifi_setup_ready_to_finish();
+    if (finishWifiSetup) {
+      appendWifiSetupDiagnostics("transition-start", true);
+      Serial.printf("Leaf WiFi setup connected to %s; closing setup portal\n",
+                    WiFi.SSID().c_str());
+    }
+  }
+  if (!finishWifiSetup) return;
+
+  webserver_disable_user_app();
+  appendWifiSetupDiagnostics("transition-finished", true);
+  display.update();
+}
+
 void webserver_enable_user_app(bool useLeafWifi) {
   heap_monitor::clear();
-  resetUserAppCounters();
   heap_monitor::checkpoint("enable-start");
   pauseServicesForUserApp();
   heap_monitor::checkpoint("after-pause-services");
@@ -3430,7 +3958,6 @@ void webserver_enable_user_app(bool useLeafWifi) {
     WiFi.mode(WIFI_AP);
     WiFi.setSleep(false);
     startLeafAp();
-    startLeafApDns();
     heap_monitor::checkpoint("after-softap");
     user_app_using_leaf_wifi = true;
   } else {
@@ -3440,10 +3967,7 @@ void webserver_enable_user_app(bool useLeafWifi) {
 
   user_app_enabled = true;
   user_app_provisioning = false;
-  setupUserAppServer();
-  heap_monitor::checkpoint("after-user-server");
-  webserver_setup();
-  heap_monitor::checkpoint("enabled");
+  postServerChange(ServerChange::StartUserApp);
   appendWifiSetupDiagnostics(useLeafWifi ? "enable-user-app-ap" : "enable-user-app-network", true);
 }
 
@@ -3468,17 +3992,7 @@ void webserver_enable_wifi_setup() {
   user_app_enabled = true;
   user_app_using_leaf_wifi = true;
   user_app_provisioning = true;
-  setupUserAppServer();
-  heap_monitor::checkpoint("wifi-setup-server");
-  logWifiSetupTiming("after-user-server");
-  startLeafApDns();
-  heap_monitor::checkpoint("wifi-setup-dns");
-  logWifiSetupTiming("after-dns");
-  webserver_setup();
-  logWifiSetupTiming("after-main-server");
-  startWifiNetworkScan();
-  logWifiSetupTiming("after-scan-start");
-  appendWifiSetupDiagnostics("setup-started", true);
+  postServerChange(ServerChange::StartWifiSetup);
   Serial.printf("Leaf WiFi setup started: http://%s/wifi\n", WiFi.softAPIP().toString().c_str());
 }
 
@@ -3487,22 +4001,8 @@ void webserver_disable_user_app() {
   heap_monitor::checkpoint("disable-start");
   dumpUserAppCounters("disable-start");
   user_app_enabled = false;
-  stopLeafApDns();
   user_app_provisioning = false;
-  if (wifi_setup_scan_running) WiFi.scanDelete();
-  wifi_setup_scan_running = false;
-  releaseWifiSetupNetworksJson();
-  wifi_setup_connecting = false;
-  wifi_setup_connected_ms = 0;
-  wifi_setup_connect_ssid = "";
-  wifi_setup_connect_password = "";
-  wifi_setup_connect_error = "";
-  wifi_setup_connect_saved = false;
-  if (user_server_started) {
-    user_server.stop();
-    user_server_started = false;
-    heap_monitor::checkpoint("after-user-stop");
-  }
+  postServerChange(ServerChange::Stop);
   if (user_app_using_leaf_wifi) {
     WiFi.softAPdisconnect(true);
     WiFi.mode(WIFI_STA);
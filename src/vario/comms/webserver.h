@@ -2,6 +2,12 @@
 
 #include <Arduino.h>
 
+// Start the task that serves HTTP requests (and factory discovery) off the main loop
+void webserver_start_task();
+// Called every main loop pass to carry out what web handlers may not do from their own task
+// (display, power and self-test changes)
+void webserver_main_loop();
+
 void webserver_setup();
 void webserver_loop();
 void webserver_enable_user_app(bool useLeafWifi);
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "diagnostics/diagnostic_logs.h"
+#include "task_schedule.h"
 
 namespace cpu_utilization {
   namespace {
@@ -18,12 +19,27 @@ namespace cpu_utilization {
       uint16_t overrunCount;
       uint16_t droppedReports;
       uint32_t previousWriteUs;
+      uint16_t displayFlushes;
+      uint32_t displayBytes;
+      uint32_t displayFullFrameBytes;
+      uint32_t displayLockUs;
+      uint32_t displayLockMaxUs;
+      uint16_t varioLayerFlushes;
+      uint32_t varioLayerBytes;
+      uint32_t varioLayerLockUs;
+      uint32_t varioLayerLockMaxUs;
+      uint32_t taskUs[task_schedule::MAX_TASKS];
+      uint32_t taskMaxUs[task_schedule::MAX_TASKS];
+      uint16_t taskOverBudget[task_schedule::MAX_TASKS];
+      uint16_t taskDeadlineMisses[task_schedule::MAX_TASKS];
       uint32_t blocksUs[BLOCKS_PER_SECOND];
       uint8_t buttonMasks[BLOCKS_PER_SECOND];
       uint8_t buttonEventMasks[BLOCKS_PER_SECOND];
       uint8_t displayContexts[BLOCKS_PER_SECOND];
     };
 
+    // Guards everything below but `writing`
+    portMUX_TYPE reportLock = portMUX_INITIALIZER_UNLOCKED;
     Report active = {};
     Report pending = {};
     bool pendingReady = false;
@@ -31,42 +47,23 @@ namespace cpu_utilization {
     uint16_t droppedReports = 0;
     uint32_t lastWriteUs = 0;
     uint8_t currentButtonEventMask = 0;
+    // The pending report, copied out so the file is written without holding reportLock
+    Report writing = {};
 
-    const char* blockLabel(uint8_t blockIndex) {
-      switch (blockIndex) {
-        case 3:
-          return "cpu_report";
-        case 9:
-        case 59:
-          return "gps";
-        case 19:
-          return "thermal_detect_nav";
-        case 29:
-          return "log";
-        case 39:
-        case 89:
-          return "display";
-        case 49:
-          return "temp_rh_start";
-        case 69:
-          return "thermal_track";
-        case 79:
-          return "power_sd";
-        case 99:
-          return "temp_rh_read";
-      }
-
-      switch (blockIndex % 10) {
-        case 0:
-        case 5:
-          return "baro_adc";
-        case 2:
-          return "imu_wind";
-        case 7:
-          return "imu";
-        default:
-          return "base";
+    // The realtime tasks the schedule runs in this block, other than those that run in every block
+    void printBlockLabel(File& file, uint8_t blockIndex) {
+      bool any = false;
+      for (uint8_t i = 0; i < task_schedule::taskCount(); i++) {
+        const task_schedule::Task& task = task_schedule::task(i);
+        if (task.core != task_schedule::Core::Realtime || task.period == 1 ||
+            !task_schedule::runsIn(task, blockIndex)) {
+          continue;
+        }
+        file.print(any ? "_" : "");
+        file.print(task.name);
+        any = true;
       }
+      if (!any) file.print("base");
     }
 
     void resetActive() {
@@ -81,9 +78,18 @@ namespace cpu_utilization {
       if (existed && file.size() > 0) return;
 
       file.print(
-          "millis,sequence,total_us,max_us,avg_us,overrun_count,dropped_reports,previous_write_us");
+          "millis,sequence,total_us,max_us,avg_us,overrun_count,dropped_reports,previous_write_us,"
+          "display_flushes,display_bytes,display_full_frame_bytes,display_lock_us,"
+          "display_lock_max_us,vario_layer_flushes,vario_layer_bytes,vario_layer_lock_us,"
+          "vario_layer_lock_max_us");
+      for (uint8_t i = 0; i < task_schedule::taskCount(); i++) {
+        const char* name = task_schedule::task(i).name;
+        file.printf(",%s_us,%s_max_us,%s_over_budget,%s_deadline_misses", name, name, name, name);
+      }
       for (uint8_t i = 0; i < BLOCKS_PER_SECOND; i++) {
-        file.printf(",b%02u_%s_us", i, blockLabel(i));
+        file.printf(",b%02u_", i);
+        printBlockLabel(file, i);
+        file.print("_us");
       }
       for (uint8_t i = 0; i < BLOCKS_PER_SECOND; i++) {
         file.printf(",b%02u_button_mask", i);
@@ -105,6 +111,20 @@ namespace cpu_utilization {
                   static_cast<unsigned long>(report.maxUs), static_cast<unsigned long>(avgUs),
                   report.overrunCount, report.droppedReports,
                   static_cast<unsigned long>(report.previousWriteUs));
+      file.printf(",%u,%lu,%lu,%lu,%lu", report.displayFlushes,
+                  static_cast<unsigned long>(report.displayBytes),
+                  static_cast<unsigned long>(report.displayFullFrameBytes),
+                  static_cast<unsigned long>(report.displayLockUs),
+                  static_cast<unsigned long>(report.displayLockMaxUs));
+      file.printf(",%u,%lu,%lu,%lu", report.varioLayerFlushes,
+                  static_cast<unsigned long>(report.varioLayerBytes),
+                  static_cast<unsigned long>(report.varioLayerLockUs),
+                  static_cast<unsigned long>(report.varioLayerLockMaxUs));
+      for (uint8_t i = 0; i < task_schedule::taskCount(); i++) {
+        file.printf(",%lu,%lu,%u,%u", static_cast<unsigned long>(report.taskUs[i]),
+                    static_cast<unsigned long>(report.taskMaxUs[i]), report.taskOverBudget[i],
+                    report.taskDeadlineMisses[i]);
+      }
       for (uint8_t i = 0; i < BLOCKS_PER_SECOND; i++) {
         file.printf(",%lu", static_cast<unsigned long>(report.blocksUs[i]));
       }
@@ -153,32 +173,85 @@ namespace cpu_utilization {
 
     uint8_t mask = buttonPinMask(button);
     if (mask == 0) mask = 1u << 5;
+    portENTER_CRITICAL(&reportLock);
     currentButtonEventMask |= mask;
+    portEXIT_CRITICAL(&reportLock);
   }
 
-  void recordBlock(uint8_t blockIndex, uint32_t startUs, uint32_t endUs, uint8_t buttonMask,
-                   uint8_t displayContext) {
+  void recordBlock(uint8_t blockIndex, uint32_t startUs, uint32_t endUs, uint8_t buttonMask) {
     if (!enabled()) return;
-
-    if (active.sequence == 0) resetActive();
     if (blockIndex >= BLOCKS_PER_SECOND) return;
 
     const uint32_t elapsedUs = endUs - startUs;
+    portENTER_CRITICAL(&reportLock);
+    if (active.sequence == 0) resetActive();
     active.blocksUs[blockIndex] = elapsedUs;
     active.buttonMasks[blockIndex] = buttonMask;
     active.buttonEventMasks[blockIndex] = currentButtonEventMask;
-    active.displayContexts[blockIndex] = displayContext;
     currentButtonEventMask = 0;
     active.totalUs += elapsedUs;
     if (elapsedUs > active.maxUs) active.maxUs = elapsedUs;
     if (elapsedUs > 10000) active.overrunCount++;
 
     if (blockIndex == LAST_BLOCK_INDEX) finalizeActive();
+    portEXIT_CRITICAL(&reportLock);
+  }
+
+  void recordDisplayContext(uint8_t blockIndex, uint8_t displayContext) {
+    if (!enabled()) return;
+    if (blockIndex >= BLOCKS_PER_SECOND) return;
+
+    portENTER_CRITICAL(&reportLock);
+    if (active.sequence == 0) resetActive();
+    active.displayContexts[blockIndex] = displayContext;
+    portEXIT_CRITICAL(&reportLock);
+  }
+
+  void recordTask(uint8_t taskIndex, uint32_t elapsedUs, bool overBudget, bool missedDeadline) {
+    if (!enabled()) return;
+    if (taskIndex >= task_schedule::MAX_TASKS) return;
+
+    portENTER_CRITICAL(&reportLock);
+    if (active.sequence == 0) resetActive();
+    active.taskUs[taskIndex] += elapsedUs;
+    if (elapsedUs > active.taskMaxUs[taskIndex]) active.taskMaxUs[taskIndex] = elapsedUs;
+    if (overBudget) active.taskOverBudget[taskIndex]++;
+    if (missedDeadline) active.taskDeadlineMisses[taskIndex]++;
+    portEXIT_CRITICAL(&reportLock);
+  }
+
+  void recordDisplayFlush(uint32_t bytesSent, uint32_t fullFrameBytes, uint32_t spiLockUs) {
+    if (!enabled()) return;
+
+    portENTER_CRITICAL(&reportLock);
+    if (active.sequence == 0) resetActive();
+    active.displayFlushes++;
+    active.displayBytes += bytesSent;
+    active.displayFullFrameBytes += fullFrameBytes;
+    active.displayLockUs += spiLockUs;
+    if (spiLockUs > active.displayLockMaxUs) active.displayLockMaxUs = spiLockUs;
+    portEXIT_CRITICAL(&reportLock);
+  }
+
+  void recordVarioLayerFlush(uint32_t bytesSent, uint32_t spiLockUs) {
+    if (!enabled()) return;
+
+    portENTER_CRITICAL(&reportLock);
+    if (active.sequence == 0) resetActive();
+    active.varioLayerFlushes++;
+    active.varioLayerBytes += bytesSent;
+    active.varioLayerLockUs += spiLockUs;
+    if (spiLockUs > active.varioLayerLockMaxUs) active.varioLayerLockMaxUs = spiLockUs;
+    portEXIT_CRITICAL(&reportLock);
   }
 
   void writePendingReport() {
     if (!enabled()) return;
-    if (!pendingReady) return;
+    portENTER_CRITICAL(&reportLock);
+    const bool ready = pendingReady;
+    if (ready) writing = pending;
+    portEXIT_CRITICAL(&reportLock);
+    if (!ready) return;
     if (!diagnostic_logs::ensureDirectory()) return;
 
     const uint32_t writeStartUs = micros();
@@ -187,10 +260,13 @@ namespace cpu_utilization {
     if (!file) return;
 
     writeHeaderIfNeeded(file, existed);
-    writeReport(file, pending);
+    writeReport(file, writing);
     file.close();
+    portENTER_CRITICAL(&reportLock);
     lastWriteUs = micros() - writeStartUs;
-    pendingReady = false;
+    // A report that replaced this one while it was written has been counted as dropped
+    if (pending.sequence == writing.sequence) pendingReady = false;
+    portEXIT_CRITICAL(&reportLock);
   }
 
 }  // namespace cpu_utilization
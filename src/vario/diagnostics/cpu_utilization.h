@@ -4,13 +4,27 @@
 
 #include "ui/input/buttons.h"
 
+// Recorded from both cores and the display send task; the report is only written by the service
+// core.
 namespace cpu_utilization {
 
   bool enabled();
   void recordButtonEvent(Button button, ButtonEvent event);
   uint8_t buttonPinMask(Button button);
-  void recordBlock(uint8_t blockIndex, uint32_t startUs, uint32_t endUs, uint8_t buttonMask,
-                   uint8_t displayContext);
+  // One block of the realtime loop
+  void recordBlock(uint8_t blockIndex, uint32_t startUs, uint32_t endUs, uint8_t buttonMask);
+  // What the service core drew in this block (DisplayRenderContext)
+  void recordDisplayContext(uint8_t blockIndex, uint8_t displayContext);
   void writePendingReport();
 
+  // One run of a scheduled task (task_schedule.h), by its index in the schedule
+  void recordTask(uint8_t taskIndex, uint32_t elapsedUs, bool overBudget, bool missedDeadline);
+
+  // One Display::update frame: bytes sent to the LCD, bytes a full-frame flush would have sent,
+  // and how long the display send task held the SPI bus sending it
+  void recordDisplayFlush(uint32_t bytesSent, uint32_t fullFrameBytes, uint32_t spiLockUs);
+
+  // One Display::updateVarioLayer frame: bytes sent to the LCD and how long the SPI bus was held
+  void recordVarioLayerFlush(uint32_t bytesSent, uint32_t spiLockUs);
+
 }  // namespace cpu_utilization
@@ -13,6 +13,7 @@ namespace diagnostic_logs {
   constexpr const char* WEB_REQUESTS_PATH = "/diagnostics/web_requests.csv";
   constexpr const char* VARIO_PATH = "/diagnostics/vario.csv";
   constexpr const char* CPU_UTILIZATION_PATH = "/diagnostics/cpu_utilization.csv";
+  constexpr const char* SD_LATENCY_PATH = "/diagnostics/sd_latency.csv";
 
   bool enabled(Log log);
   bool ensureDirectory();
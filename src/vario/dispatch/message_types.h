@@ -6,10 +6,10 @@
   the ETL Message Bus between modules of the system
 */
 
-#include "TinyGPSPlus.h"
 #include "etl/message.h"
 #include "etl/string.h"
 #include "fanet/packet.hpp"
+#include "instruments/gps_fix.h"
 #include "ui/input/buttons.h"
 
 #define FANET_MAX_FRAME_SIZE 244  // Maximum size of a FANET frame
@@ -32,8 +32,8 @@ enum MessageType : etl::message_id_t {
 
 /// @brief A GPS update received
 struct GpsReading : public etl::message<GPS_UPDATE> {
-  GpsReading(TinyGPSPlus reading) : gps(reading) {}
-  TinyGPSPlus gps;
+  GpsReading(const GpsFix& reading) : gps(reading) {}
+  GpsFix gps;
 };
 
 struct GpsMessage : public etl::message<GPS_MESSAGE> {
@@ -33,6 +33,11 @@ class SpiLockGuard : public LockGuard {
   explicit SpiLockGuard(uint32_t timeoutMs, bool fatalOnTimeout = true)
       : LockGuard(spiMutex, pdMS_TO_TICKS(timeoutMs), fatalOnTimeout) {}
 
+  // True if the calling task already holds the lock (taking it again would deadlock)
+  static bool heldByThisTask() {
+    return spiMutex && xSemaphoreGetMutexHolder(spiMutex) == xTaskGetCurrentTaskHandle();
+  }
+
  private:
   static SemaphoreHandle_t spiMutex;
 };
@@ -18,7 +18,14 @@ class Buttons : IMessageSource {
 
   // Call to indicate that the current button has produced its only action, so therefore no more
   // action events (CLICKED, HELD, HELD_LONG, INCREMENTED) should be emitted.
-  void consumeButton() { consumed_ = true; }
+  void consumeButton() {
+    consumed_ = true;
+    consumeCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Changes whenever consumeButton is called, so the UI can drop action events for the press that
+  // were already queued when it was consumed (see ButtonDispatcher)
+  uint32_t consumeCount() const { return consumeCount_.load(std::memory_order_relaxed); }
 
   // check the instantaneous state of the button hardware pins
   Button inspectPins();
@@ -65,7 +72,8 @@ class Buttons : IMessageSource {
 
   // True when input from the current button has been consumed and so the current button should not
   // emit any additional action events other than RELEASED.
-  bool consumed_ = false;
+  std::atomic<bool> consumed_{false};
+  std::atomic<uint32_t> consumeCount_{0};
   bool suppressUntilRelease_ = false;
   std::atomic<bool> urgentPressArmed_{false};
   std::atomic<bool> urgentPressLatched_{false};
@@ -18,12 +18,11 @@ LC86G lc86g(Serial0);
 
 // Setup GPS
 #define GPSBaud 115200
+// Idle character times after which received characters are handed over without a full FIFO
+#define GPS_RX_TIMEOUT_SYMBOLS 2
 // #define GPSSerialBufferSize 2048
 
 void LC86G::init() {
-  // Ensure we can write individual characters to the full capacity of newLine_
-  newLine_.resize(newLine_.capacity());
-
   // Set pins
   Serial.print("GPS set pins... ");
   if (!GPS_BACKUP_EN_IOEX) pinMode(GPS_BACKUP_EN, OUTPUT);
@@ -39,82 +38,136 @@ void LC86G::init() {
   Serial.print("GPS being serial port... ");
   gpsPort_.begin(GPSBaud);
   // gpsPort.setRxBufferSize(GPSSerialBufferSize);
+  // Have the UART driver's event task hand us characters whenever its FIFO fills or the line has
+  // been idle for GPS_RX_TIMEOUT_SYMBOLS character times (the gap after each NMEA burst), instead
+  // of polling for them
+  gpsPort_.setRxTimeout(GPS_RX_TIMEOUT_SYMBOLS);
+  gpsPort_.onReceive([this]() { receive(); });
+
+  // The output configuration is sent by publishPending() once the receiver is ready for commands
+  reconfigure_.store(true, std::memory_order_release);
+}
+
+void LC86G::setFixRate(uint8_t hz) {
+  if (hz < 1) hz = 1;
+  if (hz > MAX_FIX_RATE_HZ) hz = MAX_FIX_RATE_HZ;
+  fixRateHz_.store(hz, std::memory_order_relaxed);
+  reconfigure_.store(true, std::memory_order_release);
+}
+
+void LC86G::sendCommand(const char* body) {
+  uint8_t checksum = 0;
+  for (const char* c = body; *c; c++) checksum ^= (uint8_t)*c;
+  char command[48];
+  snprintf(command, sizeof(command), "$%s*%02X\r\n", body, checksum);
+  gpsPort_.write(command);
+  if (DEBUG_GPS) Serial.printf("LC86G command: %s", command);
+}
 
-  // Serial.println("Setting GPS messages");
-
-  /*
-    gps.send_P( &gpsPort, (const __FlashStringHelper *) enableGGA );
-    delay(50);
-    gps.send_P( &gpsPort, (const __FlashStringHelper *) enableGSV );
-    delay(50);
-    gps.send_P( &gpsPort, (const __FlashStringHelper *) enableRMC );
-    delay(50);
-    gps.send_P( &gpsPort, (const __FlashStringHelper *) disableGLL );
-    delay(50);
-    gps.send_P( &gpsPort, (const __FlashStringHelper *) disableGSA );
-    delay(50);
-    gps.send_P( &gpsPort, (const __FlashStringHelper *) disableVTG );
-    delay(50);
-  */
-
-  /*
-    gpsPort.println("$PAIR062,0,1*3F");	//turn on GGA at 1 sec
-    gpsPort.println("$PAIR062,1,0*3F");	//turn off GLL
-    gpsPort.println("$PAIR062,2,0*3C");	//turn off GSA
-    gpsPort.println("$PAIR062,3,4*39");	//turn on GSV at 4 sec (up to 3 sentences)  //was 00,01*23"
-    gpsPort.println("$PAIR062,4,1*3B");	//turn on RMC at 1 sec
-    gpsPort.println("$PAIR062,5,0*3B");	//turn off VTG
-  */
-
-  /*
-  0 = NMEA_SEN_GGA    $PAIR062,0,0*3E   $PAIR062,0,1*3F
-  1 = NMEA_SEN_GLL    $PAIR062,1,0*3F   $PAIR062,1,1*3E
-  2 = NMEA_SEN_GSA    $PAIR062,2,0*3C   $PAIR062,2,1*3D
-  3 = NMEA_SEN_GSV    $PAIR062,3,0*3D   $PAIR062,3,1*3C   $PAIR062,3,4*39
-  4 = NMEA_SEN_RMC    $PAIR062,4,0*3A   $PAIR062,4,1*3B
-  5 = NMEA_SEN_VTG    $PAIR062,5,0*3B   $PAIR062,5,1*3A
-  6 = NMEA_SEN_ZDA    $PAIR062,6,0*38   $PAIR062,6,1*39
-  7 = NMEA_SEN_GRS    $PAIR062,7,0*39   $PAIR062,7,1*38
-  8 = NMEA_SEN_GST    $PAIR062,8,0*36   $PAIR062,8,1*37
-  9 = NMEA_SEN_GNS    $PAIR062,9,0*37   $PAIR062,9,1*36
-
-  */
+// Sentence types of $PAIR062, and how often each is output at a rate of `hz` fixes per second, in
+// fixes per sentence (0 = off).  GGA and RMC between them carry the whole fix, so they go out with
+// every one; GSA and GSV only feed the fix-mode and satellite displays, so once a second is plenty
+// even at 10Hz.  GLL and VTG repeat what GGA and RMC carry.
+//
+//   0 = NMEA_SEN_GGA    1 = NMEA_SEN_GLL    2 = NMEA_SEN_GSA    3 = NMEA_SEN_GSV
+//   4 = NMEA_SEN_RMC    5 = NMEA_SEN_VTG    6 = NMEA_SEN_ZDA    7 = NMEA_SEN_GRS
+//   8 = NMEA_SEN_GST    9 = NMEA_SEN_GNS
+bool LC86G::sendConfiguration(uint8_t step, uint8_t hz) {
+  char body[24];
+  switch (step) {
+    case 0:
+      // Position fix interval in milliseconds
+      snprintf(body, sizeof(body), "PAIR050,%u", 1000 / hz);
+      break;
+    case 1:
+      snprintf(body, sizeof(body), "PAIR062,0,1");  // GGA
+      break;
+    case 2:
+      snprintf(body, sizeof(body), "PAIR062,1,0");  // GLL
+      break;
+    case 3:
+      snprintf(body, sizeof(body), "PAIR062,2,%u", hz);  // GSA
+      break;
+    case 4:
+      snprintf(body, sizeof(body), "PAIR062,3,%u", hz);  // GSV
+      break;
+    case 5:
+      snprintf(body, sizeof(body), "PAIR062,4,1");  // RMC
+      break;
+    case 6:
+      snprintf(body, sizeof(body), "PAIR062,5,0");  // VTG
+      break;
+    default:
+      return false;
+  }
+  sendCommand(body);
+  return true;
+}
+
+void LC86G::configureOutput() {
+  if (reconfigure_.exchange(false, std::memory_order_acquire)) {
+    configStep_ = 0;
+    configRateHz_ = fixRateHz_.load(std::memory_order_relaxed);
+  }
+  if (configStep_ == CONFIGURED) return;
+  // The receiver ignores commands until it has booted
+  if ((int32_t)(millis() - bootReady_) < 0) return;
+
+  // One command per call, so the receiver has time to take each in and the caller never waits
+  if (sendConfiguration(configStep_, configRateHz_)) {
+    configStep_++;
+  } else {
+    Serial.printf("LC86G configured for %u fixes per second\n", configRateHz_);
+    configStep_ = CONFIGURED;
+  }
 }
 
-bool LC86G::readLine() {
+void LC86G::receive() {
   while (gpsPort_.available()) {
     char c = gpsPort_.read();
     if (c == '\n' || c == '\r') {
-      // End of line
-      newLine_[newLineIndex_] = '\0';
-      if (newLineIndex_ > 0) {  // Ignore blank lines and second character in CR+LF
-        newLine_.resize(newLineIndex_);
-        etl::imessage_bus* bus = bus_;
-        if (bus) {
-          bus->receive(GpsMessage(newLine_));  // Send the complete NMEA sentence to the bus
-        }
-        newLine_.resize(newLine_.capacity());
-        newLineIndex_ = 0;
-        return true;  // Return immediately after the line even though there may still be
-                      // data available from gpsPort
-      }
+      // Ignore blank lines and the second character in CR+LF
+      if (newLine_.length == 0) continue;
+      newLine_.text[newLine_.length] = '\0';
+      if (!sentences_.push(newLine_)) dropped_.fetch_add(1, std::memory_order_relaxed);
+      newLine_.length = 0;
     } else {
-      // New character for line
-      newLine_[newLineIndex_] = c;
-      newLineIndex_++;
-      if (newLineIndex_ >= newLine_.capacity()) {
-        // This could reasonably happen if there were electrical noise on the serial line
-        // and we can recover by simply continuing to wait for a newline after clearing
-        // out the current sentence.
-        Serial.printf(
-            "WARNING: LC86G sentence length %d was exceeded with sentence (index %d length %d): "
-            "'%s'\n",
-            newLine_.capacity(), newLineIndex_, newLine_.length(), newLine_.c_str());
-        newLineIndex_ = 0;
+      newLine_.text[newLine_.length++] = c;
+      if (newLine_.length >= MAX_NMEA_SENTENCE_LENGTH) {
+        // This could reasonably happen if there were electrical noise on the serial line and we can
+        // recover by simply continuing to wait for a newline after clearing out the current
+        // sentence.  It is reported by publishPending() since this runs in the UART driver.
+        overlong_.fetch_add(1, std::memory_order_relaxed);
+        newLine_.length = 0;
       }
     }
   }
-  return false;
+}
+
+size_t LC86G::publishPending() {
+  configureOutput();
+
+  const uint32_t overlong = overlong_.exchange(0, std::memory_order_relaxed);
+  if (overlong) {
+    Serial.printf("WARNING: LC86G sentence length %d was exceeded %lu time(s)\n",
+                  MAX_NMEA_SENTENCE_LENGTH, static_cast<unsigned long>(overlong));
+  }
+  const uint32_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+  if (dropped) {
+    Serial.printf("WARNING: LC86G dropped %lu sentence(s) waiting to be published\n",
+                  static_cast<unsigned long>(dropped));
+  }
+
+  size_t published = 0;
+  Sentence sentence;
+  while (sentences_.pop(sentence)) {
+    etl::imessage_bus* bus = bus_;
+    if (bus) {
+      bus->receive(GpsMessage(NMEAString(sentence.text, sentence.length)));
+    }
+    published++;
+  }
+  return published;
 }
 
 // Enable GPS Backup Power (to save satellite data and allow faster start-ups)
@@ -166,6 +219,9 @@ void LC86G::softReset(void) {
   ioexDigitalWrite(GPS_RESET_IOEX, GPS_RESET, LOW);
   delay(100);
   ioexDigitalWrite(GPS_RESET_IOEX, GPS_RESET, HIGH);
+  // The receiver comes back up with its default output, so configure it again once it is ready
+  bootReady_ = millis() + 300;
+  reconfigure_.store(true, std::memory_order_release);
 }
 
 void LC86G::enterBackupMode(void) {
@@ -1,21 +1,40 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 #include "etl/message_bus.h"
 
 #include "dispatch/message_source.h"
 #include "dispatch/message_types.h"
 #include "hardware/power_control.h"
+#include "utils/spsc_queue.h"
 
 // The LC86G class interacts with an LC86G GPS module to present the abstract IGPS hardware
 // abstraction interface.
+//
+// Received characters are assembled into sentences by the UART driver's event task as they arrive
+// (see receive()), so nothing has to poll the serial port.  Complete sentences wait in a queue
+// until the service task publishes them to the bus with publishPending().
+//
+// The receiver's output is configured the same way, from publishPending(): once it has booted, the
+// position fix rate and the sentences to send are set one command per call.
 class LC86G : IPowerControl, IMessageSource {
  public:
   // serial: Serial interface via which the LC86G module is controlled and read.
   LC86G(HardwareSerial& serial) : gpsPort_(serial) {}
 
+  static constexpr uint8_t MAX_FIX_RATE_HZ = 10;
+
   void init();
-  bool readLine();
+
+  // Position fixes per second, 1 to MAX_FIX_RATE_HZ; 1 until set.  Takes effect over the next
+  // few calls to publishPending(), and again whenever the receiver is reset.
+  void setFixRate(uint8_t hz);
+  uint8_t fixRate() const { return fixRateHz_.load(std::memory_order_relaxed); }
+
+  // Publish the sentences received since the last call to the bus, after sending the receiver any
+  // configuration it is due.  Call from one task only.  Returns the number of sentences published.
+  size_t publishPending();
 
   // IPowerControl
   void sleep();
@@ -30,8 +49,39 @@ class LC86G : IPowerControl, IMessageSource {
 
   uint32_t bootReady_ = 0;
 
-  size_t newLineIndex_ = 0;
-  NMEAString newLine_;
+  struct Sentence {
+    uint8_t length;
+    char text[MAX_NMEA_SENTENCE_LENGTH];
+  };
+
+  // Filled by receive() and emptied by publishPending().  Holds more than one fix's worth of
+  // sentences, including a full set of GSVs, in case the service task falls behind.
+  SpscQueue<Sentence, 32> sentences_;
+  Sentence newLine_ = {};  // Only touched by receive()
+
+  // Counted by receive() and reported by publishPending()
+  std::atomic<uint32_t> dropped_{0};   // Complete sentences that found the queue full
+  std::atomic<uint32_t> overlong_{0};  // Lines too long to be NMEA, discarded
+
+  std::atomic<uint8_t> fixRateHz_{1};
+  // Set when the receiver needs configuring: at boot, after a reset and when the rate changes
+  std::atomic<bool> reconfigure_{false};
+  // Configuration command publishPending() sends next, and the rate it is configuring; only
+  // touched by publishPending()
+  static constexpr uint8_t CONFIGURED = UINT8_MAX;
+  uint8_t configStep_ = CONFIGURED;
+  uint8_t configRateHz_ = 1;
+
+  // Send the next configuration command if the receiver is due one and ready for it
+  void configureOutput();
+  // Send configuration command `step` for `hz` fixes per second; false once past the last one
+  bool sendConfiguration(uint8_t step, uint8_t hz);
+  // body: the command between "$" and "*", which this checksums and terminates
+  void sendCommand(const char* body);
+
+  // Called by the UART driver's event task when its FIFO fills or the line goes idle, with the
+  // characters received so far waiting in gpsPort_
+  void receive();
 
   void setBackupPower(bool backupPowerOn);
 
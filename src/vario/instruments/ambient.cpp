@@ -10,41 +10,47 @@ namespace {
 }
 
 void Ambient::on_receive(const AmbientUpdate& msg) {
-  temperature_ = msg.temperature;
-  relativeHumidity_ = msg.relativeHumidity;
-  lastMeasurement_ = millis();
+  measurement_.write({msg.temperature, msg.relativeHumidity, millis()});
 }
 
-Ambient::State Ambient::state() const {
-  if (lastMeasurement_ == 0) {
+Ambient::State Ambient::stateOf(const Measurement& measurement) {
+  if (measurement.measuredMs == 0) {
     return State::NoData;
-  } else if (millis() - lastMeasurement_ > MAXIMUM_FRESH_DURATION_MS) {
+  } else if (millis() - measurement.measuredMs > MAXIMUM_FRESH_DURATION_MS) {
     return State::Stale;
   } else {
     return State::Ready;
   }
 }
 
+Ambient::State Ambient::state() const { return stateOf(measurement_.read()); }
+
 void Ambient::onUnexpectedState(const char* action, State actual) const {
   if (actual == State::NoData) {
     fatalError("%s without data", action);
   } else if (actual == State::Ready) {
     fatalError("%s while ready", action);
   } else if (actual == State::Stale) {
-    fatalError("%s with %lums stale data", action, millis() - lastMeasurement_);
+    fatalError("%s with %lums stale data", action, millis() - measurement_.read().measuredMs);
   } else {
     fatalError("%s in unknown state %d", action, actual);
   }
 }
 
 float Ambient::temp() const {
-  assertState("Ambient::temp() called", State::Ready, State::Stale);
-  return temperature_;
+  const Measurement measurement = measurement_.read();
+  if (stateOf(measurement) == State::NoData) {
+    onUnexpectedState("Ambient::temp() called", State::NoData);
+  }
+  return measurement.temperature;
 }
 
 float Ambient::humidity() const {
-  assertState("Ambient::humidity() called", State::Ready, State::Stale);
-  return relativeHumidity_;
+  const Measurement measurement = measurement_.read();
+  if (stateOf(measurement) == State::NoData) {
+    onUnexpectedState("Ambient::humidity() called", State::NoData);
+  }
+  return measurement.relativeHumidity;
 }
 
 Ambient ambient;
@@ -2,8 +2,11 @@
 
 #include "dispatch/message_sink.h"
 #include "dispatch/message_types.h"
+#include "utils/seqlock.h"
 #include "utils/state_assert_mixin.h"
 
+// Updated on the realtime loop and read on the service core, through a Seqlock so a temperature is
+// never paired with the wrong humidity or time
 class Ambient : public MessageSink<Ambient, AmbientUpdate>, private StateAssertMixin<Ambient> {
  public:
   enum class State : uint8_t { NoData, Ready, Stale };
@@ -24,9 +27,15 @@ class Ambient : public MessageSink<Ambient, AmbientUpdate>, private StateAssertM
   void onUnexpectedState(const char* action, State actual) const;
   friend struct StateAssertMixin<Ambient>;
 
-  float temperature_;
-  float relativeHumidity_;
-  unsigned long lastMeasurement_ = 0;
+  struct Measurement {
+    float temperature;
+    float relativeHumidity;
+    unsigned long measuredMs;  // 0 before the first
+  };
+
+  static State stateOf(const Measurement& measurement);
+
+  Seqlock<Measurement> measurement_;
 };
 
 extern Ambient ambient;
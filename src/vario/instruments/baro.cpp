@@ -54,29 +54,27 @@ void Barometer::adjustAltSetting(int8_t dir, uint8_t count) {
   if (count >= 1) increase *= 10;
   if (count >= 8) increase *= 5;
 
+  float setting = altimeterSetting_;
   if (dir >= 1) {
-    altimeterSetting += increase;
-    if (altimeterSetting > 32.0) altimeterSetting = 32.0;
+    setting += increase;
+    if (setting > 32.0) setting = 32.0;
   } else if (dir <= -1) {
-    altimeterSetting -= increase;
-    if (altimeterSetting < 28.0) altimeterSetting = 28.0;
+    setting -= increase;
+    if (setting < 28.0) setting = 28.0;
   }
-  settings.vario_altSetting = altimeterSetting;
-
-  // Invalidate adjusted altitudes
-  validAltAdjusted_ = false;
+  altimeterSetting_ = setting;
+  settings.vario_altSetting = setting;
 }
 
 bool Barometer::syncToGPSAlt() {
-  if (state_ != State::Ready) return false;
+  const Reading current = reading();
+  if (current.state != State::Ready) return false;
   if (!gps.altitude.isValid()) return false;
-  altimeterSetting =
-      pressure_ / (3386.389 * pow(1 - gps.altitude.meters() * 100 / 4433100.0, 1 / 0.190264));
+  const double ratio = 1 - gps.altitude.meters() * 100 / 4433100.0;
+  const float setting = current.pressure / (3386.389 * pow(ratio, 1 / 0.190264));
+  altimeterSetting_ = setting;
   // TODO(#192): check whether settings is initialized before reading/using
-  settings.vario_altSetting = altimeterSetting;
-
-  // Invalidate adjusted altitudes
-  validAltAdjusted_ = false;
+  settings.vario_altSetting = setting;
 
   return true;
 }
@@ -113,14 +111,12 @@ void Barometer::init(void) {
   // recover saved altimeter setting
   // TODO(#192): check whether settings is initialized before reading/using
   if (settings.vario_altSetting > 28.0 && settings.vario_altSetting < 32.0) {
-    altimeterSetting = settings.vario_altSetting;
+    altimeterSetting_ = settings.vario_altSetting;
   } else {
-    altimeterSetting = 29.921;
+    altimeterSetting_ = 29.921;
   }
 
   // Clear any state
-  validAltF_ = false;
-  validAltAdjusted_ = false;
   validAltAtLaunch_ = false;
   validAltInitial_ = false;
   validClimbRateRaw_ = false;
@@ -154,18 +150,20 @@ void Barometer::on_receive(const PressureUpdate& msg) {
   } else {
     fatalError("Barometer state %s (%u) in on_receive", nameOf(state_).c_str(), state_);
   }
+  publish();
 }
 
 void Barometer::firstReading(const PressureUpdate& msg) {
   state_ = State::Ready;
   setPressureAlt(msg.pressure);
+  // The launch and initial altitudes are taken from the published reading
+  publish();
   setAltInitial();
   setLaunchAlt();
 }
 
 void Barometer::setLaunchAlt() {
-  assertState("Barometer::setLaunchAlt", State::Ready);
-  altAtLaunch_ = altAdjusted();
+  altAtLaunch_ = readyReading("Barometer::setLaunchAlt").altAdjusted;
   validAltAtLaunch_ = true;
 }
 
@@ -178,8 +176,7 @@ int32_t Barometer::altAtLaunch() {
 }
 
 void Barometer::setAltInitial() {
-  assertState("Barometer::setAltInitial", State::Ready);
-  altInitial_ = alt();
+  altInitial_ = int32_t(readyReading("Barometer::setAltInitial").altF * 100);
   validAltInitial_ = true;
 }
 
@@ -191,7 +188,7 @@ int32_t Barometer::altAboveInitial() {
   return alt() - altInitial_;
 }
 
-void Barometer::setFilterSamples(size_t nSamples) { climbFilter.setSampleCount(nSamples); }
+void Barometer::setFilterSamples(size_t nSamples) { requestedFilterSamples_ = nSamples; }
 
 void Barometer::sleep() {
   // TODO: only put Barometer to sleep once and remove Sleeping as a valid state to tell Barometer
@@ -204,11 +201,13 @@ void Barometer::sleep() {
 
   speaker.updateVarioNote(0);
   state_ = State::Sleeping;
+  publish();
 }
 
 void Barometer::wake() {
   assertState("Barometer::wake", State::Sleeping);
   state_ = State::WaitingForFirstReading;
+  publish();
 }
 
 // ^^^ Device Management ^^^
@@ -219,40 +218,53 @@ void Barometer::onUnexpectedState(const char* action, State actual) const {
 
 // vvv Device reading & data processing vvv
 
-Pressure Barometer::pressure() const {
-  assertState("Barometer::pressure", State::Ready);
-  return pressure_;
+Barometer::Reading Barometer::readyReading(const char* action) const {
+  const Reading current = reading();
+  if (current.state != State::Ready) onUnexpectedState(action, current.state);
+  return current;
 }
 
-float Barometer::altF() {
-  assertState("Barometer::altF", State::Ready);
-  if (!validAltF_) {
-    // float altitude in meters with standard altimeter setting
-    altF_ = 44331.0 * (1.0 - pow((float)pressure_ / 101325.0, (.190264)));
-    if (isnan(altF_) || isinf(altF_)) {
-      fatalError("altF was %g after calculating from pressure", altF_);
-    }
-    validAltF_ = true;
+void Barometer::publish() {
+  Reading current;
+  current.state = state_;
+  current.pressure = pressure_;
+  current.altF = altF_;
+  current.altAdjusted = altAdjusted_;
+  current.climbRateFilteredValid = validClimbRateFiltered_;
+  current.climbRateFiltered = climbRateFiltered_;
+  current.climbRate1SecAverageValid = validClimbRate1SecAverage_;
+  current.climbRate1SecAverage = climbRate1SecAverage_;
+  current.climbRateAverageValid = nInitSamplesRemaining_ == 0;
+  current.climbRateAverage = climbRateAverage_;
+  if (state_ == State::Uninitialized || state_ == State::Sleeping) {
+    current.startupSamplesCompleted = 0;
+  } else if (state_ != State::WaitingForFirstReading) {
+    current.startupSamplesCompleted = BARO_STARTUP_DISCARD_SAMPLES;
+  } else {
+    current.startupSamplesCompleted =
+        BARO_STARTUP_DISCARD_SAMPLES - startupDiscardSamplesRemaining_;
   }
-  return altF_;
+  reading_.write(current);
 }
 
+Pressure Barometer::pressure() const { return readyReading("Barometer::pressure").pressure; }
+
+float Barometer::altF() { return readyReading("Barometer::altF").altF; }
+
 int32_t Barometer::alt() { return int32_t(altF() * 100); }
 
-int32_t Barometer::altAdjusted() {
-  assertState("Barometer::altAdjusted", State::Ready);
-  if (!validAltAdjusted_) {
-    validAltAdjusted_ = true;
-    altAdjusted_ =
-        4433100.0 * (1.0 - pow((float)pressure_ / (altimeterSetting * 3386.389), (.190264)));
-  }
-  return altAdjusted_;
-}
+int32_t Barometer::altAdjusted() { return readyReading("Barometer::altAdjusted").altAdjusted; }
 
 void Barometer::setPressureAlt(int32_t newPressure) {
   pressure_ = newPressure;
-  validAltF_ = false;
-  validAltAdjusted_ = false;
+
+  // float altitude in meters with standard altimeter setting
+  altF_ = 44331.0 * (1.0 - pow((float)pressure_ / 101325.0, (.190264)));
+  if (isnan(altF_) || isinf(altF_)) {
+    fatalError("altF was %g after calculating from pressure", altF_);
+  }
+  altAdjusted_ =
+      4433100.0 * (1.0 - pow((float)pressure_ / (altimeterSetting_ * 3386.389), (.190264)));
 
   if (LOG::BARO && bus_) {
     String baroName = "baro mb*100,";
@@ -262,52 +274,45 @@ void Barometer::setPressureAlt(int32_t newPressure) {
 }
 
 int32_t Barometer::climbRateFiltered() {
-  assertState("Barometer::climbRateFiltered", State::Ready);
-  if (!validClimbRateFiltered_) {
+  const Reading current = readyReading("Barometer::climbRateFiltered");
+  if (!current.climbRateFilteredValid) {
     fatalError("Barometer::climbRateFiltered accessed before valid");
   }
-  return climbRateFiltered_;
+  return current.climbRateFiltered;
 }
 
 bool Barometer::climbRateFilteredValid() {
-  if (state_ != State::Ready) return false;
-  if (!validClimbRateFiltered_) return false;
-  return true;
+  const Reading current = reading();
+  return current.state == State::Ready && current.climbRateFilteredValid;
 }
 
 int32_t Barometer::climbRate1SecAverage() {
-  assertState("Barometer::climbRate1SecAverage", State::Ready);
-  if (!validClimbRate1SecAverage_) {
+  const Reading current = readyReading("Barometer::climbRate1SecAverage");
+  if (!current.climbRate1SecAverageValid) {
     fatalError("Barometer::climbRate1SecAverage accessed before valid");
   }
-  return climbRate1SecAverage_;
+  return current.climbRate1SecAverage;
 }
 
 bool Barometer::climbRate1SecAverageValid() {
-  if (state_ != State::Ready) return false;
-  if (!validClimbRate1SecAverage_) return false;
-  return true;
+  const Reading current = reading();
+  return current.state == State::Ready && current.climbRate1SecAverageValid;
 }
 
 float Barometer::climbRateAverage() {
-  assertState("Barometer::climbRateAverage", State::Ready);
-  if (nInitSamplesRemaining_ > 0) {
-    fatalError(
-        "Barometer::climbRateAverage accessed before initialized; waiting for %d samples more",
-        nInitSamplesRemaining_);
+  const Reading current = readyReading("Barometer::climbRateAverage");
+  if (!current.climbRateAverageValid) {
+    fatalError("Barometer::climbRateAverage accessed before initialized");
   }
-  return climbRateAverage_;
+  return current.climbRateAverage;
 }
 
 bool Barometer::climbRateAverageValid() {
-  return state_ == State::Ready && nInitSamplesRemaining_ == 0;
+  const Reading current = reading();
+  return current.state == State::Ready && current.climbRateAverageValid;
 }
 
-uint16_t Barometer::startupSamplesCompleted() const {
-  if (state_ == State::Uninitialized || state_ == State::Sleeping) return 0;
-  if (state_ != State::WaitingForFirstReading) return BARO_STARTUP_DISCARD_SAMPLES;
-  return BARO_STARTUP_DISCARD_SAMPLES - startupDiscardSamplesRemaining_;
-}
+uint16_t Barometer::startupSamplesCompleted() const { return reading().startupSamplesCompleted; }
 
 uint16_t Barometer::startupSamplesRequired() const { return BARO_STARTUP_DISCARD_SAMPLES; }
 
@@ -340,6 +345,9 @@ void Barometer::filterAltitude() {
 void Barometer::filterClimb() {
   if (!validClimbRateRaw_) return;
 
+  const size_t filterSamples = requestedFilterSamples_.exchange(0);
+  if (filterSamples > 0) climbFilter.setSampleCount(filterSamples);
+
   // filter climb rate
   if (isnan(climbRateRaw_) || isinf(climbRateRaw_)) {
     fatalError("climbRateRaw_ in Barometer::filterClimb was %g before climbFilter.update",
@@ -397,7 +405,7 @@ void Barometer::filterClimb() {
           "%.6f,%.6f,%.6f,%u,%.6f,%.6f,%.6f,%.6f,%ld,%.6f,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%"
           "lu\n",
           static_cast<unsigned long>(millis()), static_cast<unsigned long>(imu.lastMotionTime()),
-          static_cast<long>(pressure_), altF(), static_cast<long>(altAdjusted()), imu.getAccel(),
+          static_cast<long>(pressure_), altF_, static_cast<long>(altAdjusted_), imu.getAccel(),
           imu.lastDeviceAccelX(), imu.lastDeviceAccelY(), imu.lastDeviceAccelZ(), imu.lastQuatX(),
           imu.lastQuatY(), imu.lastQuatZ(), imu.lastWorldAccelX(), imu.lastWorldAccelY(),
           imu.lastWorldVerticalAccel(), imu.gravityEstimate(), imu.verticalAccel(),
@@ -7,6 +7,8 @@
 
 #include <Arduino.h>
 
+#include <atomic>
+
 #include "dispatch/message_sink.h"
 #include "dispatch/message_source.h"
 #include "dispatch/message_types.h"
@@ -14,6 +16,7 @@
 #include "math/linear_regression.h"
 #include "math/running_average.h"
 #include "units/pressure.h"
+#include "utils/seqlock.h"
 #include "utils/state_assert_mixin.h"
 
 #define FILTER_VALS_MAX 20  // total array size max;
@@ -22,6 +25,11 @@
 
 // Barometer reporting altitude, adjusted altitude, climb rate, and other information.
 // Requires a pressure source.
+//
+// Readings arrive and are filtered on the realtime loop.  Each one is published as a Reading, which
+// the getters copy whole, so the service core never sees a half-updated filter.  The altimeter
+// setting, launch and initial altitudes may be changed from either core; a new altimeter setting
+// shows in altAdjusted() from the next reading.
 class Barometer : public MessageSink<Barometer, PressureUpdate>,
                   public IMessageSource,
                   public IPowerControl,
@@ -29,7 +37,25 @@ class Barometer : public MessageSink<Barometer, PressureUpdate>,
  public:
   enum class State : uint8_t { Uninitialized, WaitingForFirstReading, Ready, Sleeping };
 
-  State state() const { return state_; }
+  // Everything the getters report, as of the last reading
+  struct Reading {
+    State state;
+    Pressure pressure;
+    float altF;           // m, standard altimeter setting
+    int32_t altAdjusted;  // cm, corrected by the altimeter setting
+    bool climbRateFilteredValid;
+    int32_t climbRateFiltered;
+    bool climbRate1SecAverageValid;
+    int32_t climbRate1SecAverage;
+    bool climbRateAverageValid;
+    float climbRateAverage;
+    uint16_t startupSamplesCompleted;
+  };
+
+  State state() const { return reading_.read().state; }
+
+  // A consistent copy of everything below, for callers that read several values together
+  Reading reading() const { return reading_.read(); }
 
   // MessageSink<Barometer, PressureUpdate>
   void on_receive(const PressureUpdate& msg);
@@ -47,7 +73,8 @@ class Barometer : public MessageSink<Barometer, PressureUpdate>,
   Pressure pressure() const;
 
   Pressure pressureFiltered;
-  float altimeterSetting = 29.921;
+  float altimeterSetting() const { return altimeterSetting_; }
+
   // raw pressure altitude in meters with standard altimeter setting (29.92)
   float altF();
 
@@ -78,7 +105,8 @@ class Barometer : public MessageSink<Barometer, PressureUpdate>,
 
   // == State adjustments ==
 
-  // Change the number of samples over which pressure and climb rate are averaged
+  // Change the number of samples over which pressure and climb rate are averaged, from the next
+  // reading
   void setFilterSamples(size_t nSamples);
 
   // Incrementally adjust altitude (generally from user input)
@@ -107,6 +135,8 @@ class Barometer : public MessageSink<Barometer, PressureUpdate>,
   int32_t altAboveInitial();
 
  private:
+  // == Owned by the realtime loop (or whoever holds it off with RealtimeLockGuard) ==
+
   State state_ = State::Uninitialized;
 
   etl::imessage_bus* bus_ = nullptr;
@@ -114,7 +144,6 @@ class Barometer : public MessageSink<Barometer, PressureUpdate>,
   Pressure pressure_;
 
   float altF_;
-  bool validAltF_ = false;
 
   float climbRateRaw_;
   bool validClimbRateRaw_ = false;
@@ -134,22 +163,34 @@ class Barometer : public MessageSink<Barometer, PressureUpdate>,
   size_t startupDiscardSamplesRemaining_;
 
   int32_t altAdjusted_;
-  bool validAltAdjusted_ = false;
 
-  int32_t altAtLaunch_;
-  bool validAltAtLaunch_ = false;
+  RunningAverage<float, FILTER_VALS_MAX> climbFilter{DEFAULT_SAMPLES_TO_AVERAGE};
+  RunningAverage<float, BARO_SAMPLES_PER_SECOND> climb1SecFilter{BARO_SAMPLES_PER_SECOND};
 
-  int32_t altInitial_;
-  bool validAltInitial_ = false;
+  // == Shared between the cores ==
 
-  // == User Settings for Vario ==
+  Seqlock<Reading> reading_;
 
-  RunningAverage<float, FILTER_VALS_MAX> climbFilter{DEFAULT_SAMPLES_TO_AVERAGE};
-  RunningAverage<float, BARO_SAMPLES_PER_SECOND> climb1SecFilter{BARO_SAMPLES_PER_SECOND};
+  std::atomic<float> altimeterSetting_{29.921f};
+
+  // Set by setFilterSamples for the realtime loop to apply; 0 when there is nothing to apply
+  std::atomic<size_t> requestedFilterSamples_{0};
+
+  std::atomic<int32_t> altAtLaunch_{0};
+  std::atomic<bool> validAltAtLaunch_{false};
+
+  std::atomic<int32_t> altInitial_{0};
+  std::atomic<bool> validAltInitial_{false};
 
   void onUnexpectedState(const char* action, State actual) const;
   friend struct StateAssertMixin<Barometer>;
 
+  // The current reading, which must be from a Ready barometer
+  Reading readyReading(const char* action) const;
+
+  // Copy the realtime loop's state out to reading_
+  void publish();
+
   // == Device Management ==
 
   // Initialize the baro
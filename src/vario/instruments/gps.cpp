@@ -6,7 +6,6 @@
 #include "instruments/gps.h"
 
 #include <Arduino.h>
-#include <TinyGPSPlus.h>
 #include <sys/time.h>
 
 #include "dispatch/message_types.h"
@@ -67,64 +66,11 @@ namespace {
     setenv("TZ", timezone, 1);
     tzset();
   }
-
-  bool isGsvSentence(const NMEAString& nmea) {
-    return nmea.length() >= 7 && nmea[0] == '$' && nmea[3] == 'G' && nmea[4] == 'S' &&
-           nmea[5] == 'V' && nmea[6] == ',';
-  }
-
-  bool parseNmeaIntField(const NMEAString& nmea, uint8_t targetField, int& value) {
-    uint8_t field = 0;
-    size_t start = nmea[0] == '$' ? 1 : 0;
-
-    for (size_t i = start; i <= nmea.length(); ++i) {
-      char c = i < nmea.length() ? nmea[i] : '\0';
-      if (c == ',' || c == '*' || c == '\0') {
-        if (field == targetField) {
-          if (i == start) return false;
-
-          int parsed = 0;
-          for (size_t j = start; j < i; ++j) {
-            if (nmea[j] < '0' || nmea[j] > '9') return false;
-            parsed = parsed * 10 + (nmea[j] - '0');
-          }
-
-          value = parsed;
-          return true;
-        }
-
-        ++field;
-        start = i + 1;
-        if (c == '*' || c == '\0') return false;
-      }
-    }
-
-    return false;
-  }
 }  // namespace
 
-const char enableGGA[] PROGMEM = "$PAIR062,0,1";  // enable GGA message every 1 second
-const char enableGSV[] PROGMEM = "PAIR062,3,4";   // enable GSV message every 1 second
-const char enableRMC[] PROGMEM = "PAIR062,4,1";   // enable RMC message every 1 second
-
-const char disableGLL[] PROGMEM = "$PAIR062,1,0";  // disable message
-const char disableGSA[] PROGMEM = "$PAIR062,2,0";  // disable message
-const char disableVTG[] PROGMEM = "$PAIR062,5,0";  // disable message
-
 // Lock for GPS
 SemaphoreHandle_t GpsLockGuard::mutex = NULL;
 
-LeafGPS::LeafGPS() {
-  totalGPGSVMessages.begin(gps, "GPGSV", 1);
-  messageNumber.begin(gps, "GPGSV", 2);
-  satsInView.begin(gps, "GPGSV", 3);
-
-  latAccuracy.begin(gps, "GPGST", 6);
-  lonAccuracy.begin(gps, "GPGST", 7);
-  fix.begin(gps, "GNGGA", 6);
-  fixMode.begin(gps, "GNGSA", 2);
-}
-
 void LeafGPS::init(void) {
   // Create the GPS Mutex for multi-threaded locking
   GpsLockGuard::mutex = xSemaphoreCreateMutex();
@@ -132,18 +78,13 @@ void LeafGPS::init(void) {
   // init nav class (TODO: may not need this here, just for testing at startup for ease)
   navigator.init();
 
-  // Initialize all the uninitialized TinyGPSCustom objects
-  Serial.print("GPS initialize sat messages... ");
-  for (int i = 0; i < 4; ++i) {
-    satNumber[i].begin(gps, "GPGSV", 4 + 4 * i);  // offsets 4, 8, 12, 16
-    elevation[i].begin(gps, "GPGSV", 5 + 4 * i);  // offsets 5, 9, 13, 17
-    azimuth[i].begin(gps, "GPGSV", 6 + 4 * i);    // offsets 6, 10, 14, 18
-    snr[i].begin(gps, "GPGSV", 7 + 4 * i);        // offsets 7, 11, 15, 19
-  }
-
   Serial.print("GPS initialize done... ");
 }  // gps_init
 
+void LeafGPS::setFixRate(uint8_t hz) { lc86g.setFixRate(hz); }
+
+uint8_t LeafGPS::fixRate() const { return lc86g.fixRate(); }
+
 void LeafGPS::calculateGlideRatio() {
   if (!baro.climbRateAverageValid()) {
     glideRatio = 0;
@@ -165,8 +106,8 @@ void LeafGPS::calculateGlideRatio() {
 
 void LeafGPS::updateFixInfo() {
   // fix status and mode
-  fixInfo.fix = atoi(fix.value());
-  fixInfo.fixMode = atoi(fixMode.value());
+  fixInfo.fix = fixQuality;
+  fixInfo.fixMode = fixMode;
 
   // solution accuracy
   // gpsFixInfo.latError = 2.5; //atof(latAccuracy.value());
@@ -199,82 +140,58 @@ void LeafGPS::on_receive(const GpsMessage& msg) {
   if (DEBUG_GPS) {
     Serial.printf("LeafGPS::on_receive %d %s\n", msg.nmea.length(), msg.nmea.c_str());
   }
-  bool newSentence;
+  const nmea::Sentence sentence(msg.nmea.c_str(), msg.nmea.length());
+  if (!sentence.valid()) {
+    failedChecksum_++;
+    Serial.printf("NMEA sentence was not valid: %s\n", msg.nmea.c_str());
+    return;
+  }
+  passedChecksum_++;
+
+  bool hasFix;
   {
     GpsLockGuard mutex;  // Ensure we have a lock on write
-    for (size_t i = 0; i < msg.nmea.length(); i++) {
-      char a = msg.nmea[i];
-      newSentence = gps.encode(a);
-      if (newSentence) {
-        // TinyGPSPlus is more forgiving than the NMEA standard by detecting a new sentence even
-        // when not followed by a new line.  Encountering this block means there is a sentence
-        // available, just not without the required trailing new line.  In this case, we will
-        // discard the rest of the line but keep the sentence found at the beginning of the line.
-        break;
-      }
-    }
-    if (!newSentence) {
-      newSentence = gps.encode('\r');
-    }
+    hasFix = nmea::decode(sentence, *this);
   }
-  if (newSentence) {
-    updateSatList(msg.nmea);
-    syncSystemClockIfNeeded();
-
-    NMEASentenceContents contents = {.speed = gps.speed.isUpdated(),
-                                     .course = gps.course.isUpdated()};
-    // Push the parsed reading onto the bus!
-    if (bus_ && gps.location.isUpdated()) {
-      bus_->receive(GpsReading(gps));
-    }
-  } else {
-    Serial.printf("NMEA sentence was not valid: %s\n", msg.nmea.c_str());
+  if (hasFix) sentencesWithFix_++;
+  updateSatList(sentence);
+  syncSystemClockIfNeeded();
+
+  // Push the parsed reading onto the bus!
+  if (bus_ && location.isUpdated()) {
+    bus_->receive(GpsReading(*this));
   }
 }
 
 // copy data from each satellite message into the sats[] array.  Then, if we reach the complete set
 // of sentences, copy the fresh sat data into the satDisplay[] array for showing on LCD screen when
 // needed.
-void LeafGPS::updateSatList(const NMEAString& nmea) {
-  if (!isGsvSentence(nmea)) {
-    gsvSentenceGroupActive = false;
-    return;
-  }
-
-  int totalMessages = 0;
-  int currentMessage = 0;
-  if (!parseNmeaIntField(nmea, 1, totalMessages) || !parseNmeaIntField(nmea, 2, currentMessage)) {
+void LeafGPS::updateSatList(const nmea::Sentence& sentence) {
+  nmea::SatellitePage page;
+  if (!nmea::decode(sentence, page)) {
+    if (sentence.type() != nmea::Type::GSV) gsvSentenceGroupActive = false;
     return;
   }
 
-  if (currentMessage == 1 && !gsvSentenceGroupActive) {
+  if (page.number == 1 && !gsvSentenceGroupActive) {
     for (int i = 0; i < MAX_SATELLITES; ++i) {
       sats[i].active = false;
     }
   }
   gsvSentenceGroupActive = true;
 
-  for (int i = 0; i < 4; ++i) {
-    int no = 0;
-    int elevationValue = 0;
-    int azimuthValue = 0;
-    int snrValue = 0;
-    const uint8_t field = 4 + 4 * i;
-
-    if (parseNmeaIntField(nmea, field, no) && no >= 1 && no <= MAX_SATELLITES &&
-        parseNmeaIntField(nmea, field + 1, elevationValue) &&
-        parseNmeaIntField(nmea, field + 2, azimuthValue)) {
-      parseNmeaIntField(nmea, field + 3, snrValue);
-
-      sats[no - 1].elevation = constrain(elevationValue, 0, 90);
-      sats[no - 1].azimuth = constrain(azimuthValue, 0, 359);
-      sats[no - 1].snr = constrain(snrValue, 0, 99);
-      sats[no - 1].active = true;
-    }
+  for (uint8_t i = 0; i < page.count; ++i) {
+    const nmea::Satellite& satellite = page.satellites[i];
+    if (satellite.id > MAX_SATELLITES) continue;
+    GPSSatInfo& sat = sats[satellite.id - 1];
+    sat.elevation = satellite.elevation;
+    sat.azimuth = satellite.azimuth;
+    sat.snr = satellite.snr;
+    sat.active = true;
   }
 
   // If we're on the final sentence, then copy data into the display array
-  if (totalMessages == currentMessage) {
+  if (page.total == page.number) {
     uint8_t satelliteCount = 0;
 
     for (int i = 0; i < MAX_SATELLITES; ++i) {
@@ -319,81 +236,6 @@ void LeafGPS::updateLastValidFix() {
   lastValidFix_.capturedAtMs = millis();
 }
 
-void LeafGPS::testSats() {
-  if (totalGPGSVMessages.isUpdated()) {
-    for (int i = 0; i < 4; ++i) {
-      int no = atoi(satNumber[i].value());
-      // Serial.print(F("SatNumber is ")); Serial.println(no);
-      if (no >= 1 && no <= MAX_SATELLITES) {
-        sats[no - 1].elevation = constrain(atoi(elevation[i].value()), 0, 90);
-        sats[no - 1].azimuth = constrain(atoi(azimuth[i].value()), 0, 359);
-        sats[no - 1].snr = constrain(atoi(snr[i].value()), 0, 99);
-        sats[no - 1].active = true;
-      }
-    }
-
-    int totalMessages = atoi(totalGPGSVMessages.value());
-    int currentMessage = atoi(messageNumber.value());
-    if (totalMessages == currentMessage) {
-      /*
-      // Print Sat Info
-      Serial.print(F("Sats=")); Serial.print(gps.satellites.value());
-      Serial.print(F(" Nums="));
-      for (int i=0; i<MAX_SATELLITES; ++i)
-        if (sats[i].active)
-        {
-          Serial.print(i+1);
-          Serial.print(F(" "));
-        }
-      Serial.print(F(" Elevation="));
-      for (int i=0; i<MAX_SATELLITES; ++i)
-        if (sats[i].active)
-        {
-          Serial.print(sats[i].elevation);
-          Serial.print(F(" "));
-        }
-      Serial.print(F(" Azimuth="));
-      for (int i=0; i<MAX_SATELLITES; ++i)
-        if (sats[i].active)
-        {
-          Serial.print(sats[i].azimuth);
-          Serial.print(F(" "));
-        }
-
-      Serial.print(F(" SNR="));
-      for (int i=0; i<MAX_SATELLITES; ++i)
-        if (sats[i].active)
-        {
-          Serial.print(sats[i].snr);
-          Serial.print(F(" "));
-        }
-      Serial.println();
-
-      Serial.print("|TIME| isValid: "); Serial.print(gps.time.isValid());
-      Serial.print(", isUpdated:"); Serial.print(gps.time.isUpdated());
-      Serial.print(", hour: "); Serial.print(gps.time.hour());
-      Serial.print(", minute: "); Serial.print(gps.time.minute());
-      Serial.print(", second: "); Serial.print(gps.time.second());
-      Serial.print(", age: "); Serial.print(gps.time.age());
-      Serial.print(", value: "); Serial.print(gps.time.value());
-
-      Serial.print("  |DATE| isValid: "); Serial.print(gps.date.isValid());
-      Serial.print(" isUpdated: "); Serial.print(gps.date.isUpdated());
-      Serial.print(" year: "); Serial.print(gps.date.year());
-      Serial.print(" month: "); Serial.print(gps.date.month());
-      Serial.print(" day: "); Serial.print(gps.date.day());
-      Serial.print(" age: "); Serial.print(gps.date.age());
-      Serial.print(" value: "); Serial.println(gps.date.value());
-      */
-
-      // Reset Active
-      for (int i = 0; i < MAX_SATELLITES; ++i) {
-        sats[i].active = false;
-      }
-    }
-  }
-}
-
 bool LeafGPS::getUtcDateTime(tm& cal) {
   if (!gps.date.isValid() || !gps.time.isValid()) {
     return false;
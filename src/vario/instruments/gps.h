@@ -17,12 +17,13 @@
 #ifndef gps_h
 #define gps_h
 
-#include <TinyGPSPlus.h>
 #include "dispatch/message_sink.h"
 #include "dispatch/message_source.h"
 #include "dispatch/message_types.h"
 #include "etl/message_bus.h"
 #include "hardware/power_control.h"
+#include "instruments/gps_fix.h"
+#include "instruments/nmea.h"
 #include "time.h"
 #include "utils/lock_guard.h"
 
@@ -61,10 +62,10 @@ struct GPSPositionSnapshot {
 
 // enum time_formats {hhmmss, }
 
-class LeafGPS : public TinyGPSPlus, IMessageSource, public MessageSink<LeafGPS, GpsMessage> {
+// Each NMEA sentence from the GPS is parsed in place (instruments/nmea.h) and decoded straight
+// into the fix this class presents.
+class LeafGPS : public GpsFix, IMessageSource, public MessageSink<LeafGPS, GpsMessage> {
  public:
-  LeafGPS();
-
   void init();
 
   void update();
@@ -99,6 +100,15 @@ class LeafGPS : public TinyGPSPlus, IMessageSource, public MessageSink<LeafGPS,
 
   float getGlideRatio(void) { return glideRatio; }
 
+  // Position fixes the receiver is asked for each second (see LC86G::setFixRate)
+  void setFixRate(uint8_t hz);
+  uint8_t fixRate() const;
+
+  // Sentences that passed their checksum, and those of them that reported a fix
+  uint32_t passedChecksum() const { return passedChecksum_; }
+  uint32_t sentencesWithFix() const { return sentencesWithFix_; }
+  uint32_t failedChecksum() const { return failedChecksum_; }
+
   // Cached version of the sat info for showing on display (this will be re-written each time a
   // total set of new sat info is available)
   struct GPSSatInfo satsDisplay[MAX_SATELLITES];
@@ -107,46 +117,27 @@ class LeafGPS : public TinyGPSPlus, IMessageSource, public MessageSink<LeafGPS,
 
  private:
   void updateFixInfo();
-  void updateSatList(const NMEAString& nmea);
+  void updateSatList(const nmea::Sentence& sentence);
   void updateLastValidFix();
   void syncSystemClockIfNeeded();
 
   void calculateGlideRatio();
 
-  void testSats();
-
   // Satellite tracking
 
   // GPS satellite info for storing values straight from the GPS
   struct GPSSatInfo sats[MAX_SATELLITES];
 
-  // $GPGSV sentence parsing
-  TinyGPSCustom totalGPGSVMessages;  // first element is # messages (N) total
-  TinyGPSCustom messageNumber;       // second element is message number (x of N)
-  TinyGPSCustom satsInView;          // third element is # satellites in view
-
-  // Fields for capturing the information from GSV strings
-  // (each GSV sentence will have info for at most 4 satellites)
-  TinyGPSCustom satNumber[4];  // to be initialized later
-  TinyGPSCustom elevation[4];  // to be initialized later
-  TinyGPSCustom azimuth[4];    // to be initialized later
-  TinyGPSCustom snr[4];        // to be initialized later
-
-  // Custom objects for position/fix accuracy.
-  // Need to read from the GST sentence which TinyGPS doesn't do by default
-  TinyGPSCustom latAccuracy;  // Latitude error - standard deviation
-  TinyGPSCustom lonAccuracy;  // Longitude error - standard deviation
-  TinyGPSCustom fix;          // Fix (0=none, 1=GPS, 2=DGPS, 3=Valid PPS)
-  TinyGPSCustom fixMode;      // Fix mode (1=No fix, 2=2D fix, 3=3D fix)
-
   // Message bus to let the rest of the application know when new GPS updates are
   // available
   etl::imessage_bus* bus_ = nullptr;
 
   float glideRatio;
 
-  NMEAString nmeaBuffer = {'\0'};  // buffer for reading NMEA sentences
-  int nmeaBufferIndex = 0;         // index into the buffer currently writing to
+  uint32_t passedChecksum_ = 0;
+  uint32_t sentencesWithFix_ = 0;
+  uint32_t failedChecksum_ = 0;
+
   bool gsvSentenceGroupActive = false;
   bool systemTimeSyncedThisBoot_ = false;
   GPSPositionSnapshot lastValidFix_;
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <Arduino.h>
+#include <TinyGPSPlus.h>
+
+// The latest GPS fix, as decoded from NMEA sentences by instruments/nmea.h.
+//
+// Each value has the accessors TinyGPSPlus gave it (isValid, isUpdated, age and the unit
+// conversions), so the rest of the firmware reads the fix as it always has.  As in TinyGPSPlus,
+// reading a value clears its updated flag, and values are stored in the units NMEA sends them in:
+// hundredths of knots, degrees and metres, hhmmsscc and ddmmyy.
+
+class GpsValue {
+ public:
+  bool isValid() const { return valid_; }
+  bool isUpdated() const { return updated_; }
+  uint32_t age() const { return valid_ ? millis() - lastCommitMs_ : UINT32_MAX; }
+
+ protected:
+  void commit() {
+    lastCommitMs_ = millis();
+    valid_ = updated_ = true;
+  }
+
+  bool valid_ = false;
+  bool updated_ = false;
+  uint32_t lastCommitMs_ = 0;
+};
+
+class GpsLocation : public GpsValue {
+ public:
+  double lat() {
+    updated_ = false;
+    return lat_;
+  }
+  double lng() {
+    updated_ = false;
+    return lng_;
+  }
+
+  void set(double lat, double lng) {
+    lat_ = lat;
+    lng_ = lng;
+    commit();
+  }
+
+ private:
+  double lat_ = 0;
+  double lng_ = 0;
+};
+
+class GpsDate : public GpsValue {
+ public:
+  uint32_t value() {
+    updated_ = false;
+    return date_;
+  }
+  uint16_t year() { return value() % 100 + 2000; }
+  uint8_t month() { return (value() / 100) % 100; }
+  uint8_t day() { return value() / 10000; }
+
+  // ddmmyy
+  void set(uint32_t date) {
+    date_ = date;
+    commit();
+  }
+
+ private:
+  uint32_t date_ = 0;
+};
+
+class GpsTime : public GpsValue {
+ public:
+  uint32_t value() {
+    updated_ = false;
+    return time_;
+  }
+  uint8_t hour() { return value() / 1000000; }
+  uint8_t minute() { return (value() / 10000) % 100; }
+  uint8_t second() { return (value() / 100) % 100; }
+  uint8_t centisecond() { return value() % 100; }
+
+  // hhmmsscc
+  void set(uint32_t time) {
+    time_ = time;
+    commit();
+  }
+
+ private:
+  uint32_t time_ = 0;
+};
+
+// A value in hundredths of its unit
+class GpsDecimal : public GpsValue {
+ public:
+  int32_t value() {
+    updated_ = false;
+    return value_;
+  }
+
+  void set(int32_t hundredths) {
+    value_ = hundredths;
+    commit();
+  }
+
+ private:
+  int32_t value_ = 0;
+};
+
+class GpsInteger : public GpsValue {
+ public:
+  uint32_t value() {
+    updated_ = false;
+    return value_;
+  }
+
+  void set(uint32_t value) {
+    value_ = value;
+    commit();
+  }
+
+ private:
+  uint32_t value_ = 0;
+};
+
+class GpsSpeed : public GpsDecimal {
+ public:
+  double knots() { return value() / 100.0; }
+  double mph() { return _GPS_MPH_PER_KNOT * value() / 100.0; }
+  double mps() { return _GPS_MPS_PER_KNOT * value() / 100.0; }
+  double kmph() { return _GPS_KMPH_PER_KNOT * value() / 100.0; }
+};
+
+class GpsCourse : public GpsDecimal {
+ public:
+  double deg() { return value() / 100.0; }
+};
+
+class GpsAltitude : public GpsDecimal {
+ public:
+  double meters() { return value() / 100.0; }
+  double miles() { return _GPS_MILES_PER_METER * value() / 100.0; }
+  double kilometers() { return _GPS_KM_PER_METER * value() / 100.0; }
+  double feet() { return _GPS_FEET_PER_METER * value() / 100.0; }
+};
+
+class GpsHdop : public GpsDecimal {
+ public:
+  double hdop() { return value() / 100.0; }
+};
+
+struct GpsFix {
+  GpsLocation location;
+  GpsDate date;
+  GpsTime time;
+  GpsSpeed speed;
+  GpsCourse course;
+  GpsAltitude altitude;
+  GpsInteger satellites;  // Used in the fix
+  GpsHdop hdop;
+
+  uint8_t fixQuality = 0;  // GGA: 0 = none, 1 = GPS, 2 = DGPS, ...
+  uint8_t fixMode = 0;     // GSA: 1 = none, 2 = 2D, 3 = 3D
+
+  // Great-circle helpers, still TinyGPSPlus's own
+  static double distanceBetween(double lat1, double long1, double lat2, double long2) {
+    return TinyGPSPlus::distanceBetween(lat1, long1, lat2, long2);
+  }
+  static double courseTo(double lat1, double long1, double lat2, double long2) {
+    return TinyGPSPlus::courseTo(lat1, long1, lat2, long2);
+  }
+  static const char* cardinal(double course) { return TinyGPSPlus::cardinal(course); }
+};
@@ -273,6 +273,7 @@ void IMU::on_receive(const MotionUpdate& msg) {
     }
     // Gravity can update without baro, but Kalman needs simultaneous barometer-measured altitude.
     motionSampleBaroNotReadyCount_++;
+    publish();
     return;
   }
   if (!msg.hasAcceleration || !msg.hasOrientation) {
@@ -280,6 +281,7 @@ void IMU::on_receive(const MotionUpdate& msg) {
     // In the future, we could potentially collect them separately, but that seems unnecessary given
     // that they almost always occur together.
     motionSampleMissingFieldsCount_++;
+    publish();
     return;
   }
 
@@ -305,6 +307,7 @@ void IMU::on_receive(const MotionUpdate& msg) {
       bus_->receive(CommentMessage(kalmanEntryString));
     }
   }
+  publish();
 }
 
 void IMU::wake() {
@@ -314,117 +317,167 @@ void IMU::wake() {
   startupReadinessStartMs_ = 0;
   tLastGravityUpdate_ = 0;
   kalmanStartupSamplesRemaining_ = KALMAN_STARTUP_REPORT_SAMPLES;
+  publish();
 }
 
-bool IMU::accelValid() { return validAccelTot_; }
+void IMU::publish() {
+  Reading current;
+  current.accelValid = validAccelTot_;
+  current.accel = (float)accelTot_;
+  current.velocityValid =
+      kalmanvert_.initialized() && kalmanStartupSamplesRemaining_ == 0 &&
+      (startupNonVertSamples_ >= STARTUP_NON_VERT_SAMPLES || startupReadinessTimedOut());
+  current.kalmanValid = kalmanvert_.initialized();
+  current.kalmanPosition = current.kalmanValid ? (float)kalmanvert_.getPosition() : 0.0f;
+  current.kalmanVelocity = current.kalmanValid ? (float)kalmanvert_.getVelocity() : 0.0f;
+  current.velocity = current.kalmanVelocity;
+  current.gravityEstimate = (float)gravity_;
+  current.verticalAccel = (float)accelVert_;
+  current.kalmanAccelInput = (float)kalmanAccelVert_;
+  current.kalmanAcceleration = current.kalmanValid ? (float)kalmanvert_.getAcceleration() : 0.0f;
+  current.lastMotionTime = lastMotionTime_;
+  current.lastDeviceAccelX = (float)lastDeviceAccelX_;
+  current.lastDeviceAccelY = (float)lastDeviceAccelY_;
+  current.lastDeviceAccelZ = (float)lastDeviceAccelZ_;
+  current.lastQuatX = (float)lastQuatX_;
+  current.lastQuatY = (float)lastQuatY_;
+  current.lastQuatZ = (float)lastQuatZ_;
+  current.lastWorldAccelX = (float)lastWorldAccelX_;
+  current.lastWorldAccelY = (float)lastWorldAccelY_;
+  current.lastWorldVerticalAccel = (float)lastWorldVerticalAccel_;
+  current.worldVerticalAccelValid = validLastWorldVerticalAccel_;
+  current.gravityInitResetCount = gravityInitResetCount_;
+  current.lastRejectedGravityEstimate = (float)lastRejectedGravity_;
+  current.motionSampleCount = motionSampleCount_;
+  current.motionSampleBaroNotReadyCount = motionSampleBaroNotReadyCount_;
+  current.motionSampleMissingFieldsCount = motionSampleMissingFieldsCount_;
+  current.motionSampleProcessedCount = motionSampleProcessedCount_;
+  current.motionSampleRejectedQuaternionCount = motionSampleRejectedQuaternionCount_;
+  current.gravityInitSampleCount = gravityInitSampleCount_;
+  current.gravityUpdateCandidateCount = gravityUpdateCandidateCount_;
+  current.gravityUpdateAcceptedCount = gravityUpdateAcceptedCount_;
+  current.gravityUpdateRejectedAccelCount = gravityUpdateRejectedAccelCount_;
+  current.gravityUpdateRejectedVerticalCount = gravityUpdateRejectedVerticalCount_;
+  current.gravityUpdateRejectedTimeCount = gravityUpdateRejectedTimeCount_;
+  current.gravityUpdateRejectedPlausibilityCount = gravityUpdateRejectedPlausibilityCount_;
+  current.gravityUpdateSlewLimitedCount = gravityUpdateSlewLimitedCount_;
+  current.kalmanUpdateSampleCount = kalmanUpdateSampleCount_;
+  current.startupSamplesCompleted = computeStartupSamplesCompleted();
+  reading_.write(current);
+}
+
+bool IMU::accelValid() const { return reading().accelValid; }
 
-float IMU::getAccel() {
-  if (!accelValid()) {
+float IMU::getAccel() const {
+  const Reading current = reading();
+  if (!current.accelValid) {
     fatalError("IMU::getAccel when not valid");
   }
-  return accelTot_;
+  return current.accel;
 }
 
-bool IMU::velocityValid() {
-  return kalmanvert_.initialized() && kalmanStartupSamplesRemaining_ == 0 &&
-         (startupNonVertSamples_ >= STARTUP_NON_VERT_SAMPLES || startupReadinessTimedOut());
-}
+bool IMU::velocityValid() const { return reading().velocityValid; }
 
-float IMU::getVelocity() {
-  if (!velocityValid()) {
+float IMU::getVelocity() const {
+  const Reading current = reading();
+  if (!current.velocityValid) {
     fatalError("IMU::getVelocity when not valid");
   }
-  return (float)kalmanvert_.getVelocity();
+  return current.velocity;
 }
 
 uint16_t IMU::gravityInitSamplesRemaining() const { return 0; }
 
-float IMU::gravityEstimate() const { return (float)gravity_; }
+float IMU::gravityEstimate() const { return reading().gravityEstimate; }
 
-float IMU::verticalAccel() const { return (float)accelVert_; }
+float IMU::verticalAccel() const { return reading().verticalAccel; }
 
-float IMU::kalmanAccelInput() const { return (float)kalmanAccelVert_; }
+float IMU::kalmanAccelInput() const { return reading().kalmanAccelInput; }
 
-bool IMU::kalmanValid() const { return kalmanvert_.initialized(); }
+bool IMU::kalmanValid() const { return reading().kalmanValid; }
 
-float IMU::kalmanPosition() const {
-  return kalmanvert_.initialized() ? (float)kalmanvert_.getPosition() : 0.0f;
-}
+float IMU::kalmanPosition() const { return reading().kalmanPosition; }
 
-float IMU::kalmanVelocity() const {
-  return kalmanvert_.initialized() ? (float)kalmanvert_.getVelocity() : 0.0f;
-}
+float IMU::kalmanVelocity() const { return reading().kalmanVelocity; }
 
-float IMU::kalmanAcceleration() const {
-  return kalmanvert_.initialized() ? (float)kalmanvert_.getAcceleration() : 0.0f;
-}
+float IMU::kalmanAcceleration() const { return reading().kalmanAcceleration; }
 
-unsigned long IMU::lastMotionTime() const { return lastMotionTime_; }
+unsigned long IMU::lastMotionTime() const { return reading().lastMotionTime; }
 
-float IMU::lastDeviceAccelX() const { return (float)lastDeviceAccelX_; }
+float IMU::lastDeviceAccelX() const { return reading().lastDeviceAccelX; }
 
-float IMU::lastDeviceAccelY() const { return (float)lastDeviceAccelY_; }
+float IMU::lastDeviceAccelY() const { return reading().lastDeviceAccelY; }
 
-float IMU::lastDeviceAccelZ() const { return (float)lastDeviceAccelZ_; }
+float IMU::lastDeviceAccelZ() const { return reading().lastDeviceAccelZ; }
 
-float IMU::lastQuatX() const { return (float)lastQuatX_; }
+float IMU::lastQuatX() const { return reading().lastQuatX; }
 
-float IMU::lastQuatY() const { return (float)lastQuatY_; }
+float IMU::lastQuatY() const { return reading().lastQuatY; }
 
-float IMU::lastQuatZ() const { return (float)lastQuatZ_; }
+float IMU::lastQuatZ() const { return reading().lastQuatZ; }
 
-float IMU::lastWorldAccelX() const { return (float)lastWorldAccelX_; }
+float IMU::lastWorldAccelX() const { return reading().lastWorldAccelX; }
 
-float IMU::lastWorldAccelY() const { return (float)lastWorldAccelY_; }
+float IMU::lastWorldAccelY() const { return reading().lastWorldAccelY; }
 
-float IMU::lastWorldVerticalAccel() const { return (float)lastWorldVerticalAccel_; }
+float IMU::lastWorldVerticalAccel() const { return reading().lastWorldVerticalAccel; }
 
-bool IMU::worldVerticalAccelValid() const { return validLastWorldVerticalAccel_; }
+bool IMU::worldVerticalAccelValid() const { return reading().worldVerticalAccelValid; }
 
-uint16_t IMU::gravityInitResetCount() const { return gravityInitResetCount_; }
+uint16_t IMU::gravityInitResetCount() const { return reading().gravityInitResetCount; }
 
-float IMU::lastRejectedGravityEstimate() const { return (float)lastRejectedGravity_; }
+float IMU::lastRejectedGravityEstimate() const { return reading().lastRejectedGravityEstimate; }
 
-uint32_t IMU::motionSampleCount() const { return motionSampleCount_; }
+uint32_t IMU::motionSampleCount() const { return reading().motionSampleCount; }
 
-uint32_t IMU::motionSampleBaroNotReadyCount() const { return motionSampleBaroNotReadyCount_; }
+uint32_t IMU::motionSampleBaroNotReadyCount() const {
+  return reading().motionSampleBaroNotReadyCount;
+}
 
-uint32_t IMU::motionSampleMissingFieldsCount() const { return motionSampleMissingFieldsCount_; }
+uint32_t IMU::motionSampleMissingFieldsCount() const {
+  return reading().motionSampleMissingFieldsCount;
+}
 
-uint32_t IMU::motionSampleProcessedCount() const { return motionSampleProcessedCount_; }
+uint32_t IMU::motionSampleProcessedCount() const { return reading().motionSampleProcessedCount; }
 
 uint32_t IMU::motionSampleRejectedQuaternionCount() const {
-  return motionSampleRejectedQuaternionCount_;
+  return reading().motionSampleRejectedQuaternionCount;
 }
 
-uint32_t IMU::gravityInitSampleCount() const { return gravityInitSampleCount_; }
+uint32_t IMU::gravityInitSampleCount() const { return reading().gravityInitSampleCount; }
 
-uint32_t IMU::gravityUpdateCandidateCount() const { return gravityUpdateCandidateCount_; }
+uint32_t IMU::gravityUpdateCandidateCount() const { return reading().gravityUpdateCandidateCount; }
 
-uint32_t IMU::gravityUpdateAcceptedCount() const { return gravityUpdateAcceptedCount_; }
+uint32_t IMU::gravityUpdateAcceptedCount() const { return reading().gravityUpdateAcceptedCount; }
 
-uint32_t IMU::gravityUpdateRejectedAccelCount() const { return gravityUpdateRejectedAccelCount_; }
+uint32_t IMU::gravityUpdateRejectedAccelCount() const {
+  return reading().gravityUpdateRejectedAccelCount;
+}
 
 uint32_t IMU::gravityUpdateRejectedVerticalCount() const {
-  return gravityUpdateRejectedVerticalCount_;
+  return reading().gravityUpdateRejectedVerticalCount;
 }
 
-uint32_t IMU::gravityUpdateRejectedTimeCount() const { return gravityUpdateRejectedTimeCount_; }
+uint32_t IMU::gravityUpdateRejectedTimeCount() const {
+  return reading().gravityUpdateRejectedTimeCount;
+}
 
 uint32_t IMU::gravityUpdateRejectedPlausibilityCount() const {
-  return gravityUpdateRejectedPlausibilityCount_;
+  return reading().gravityUpdateRejectedPlausibilityCount;
 }
 
-uint32_t IMU::gravityUpdateSlewLimitedCount() const { return gravityUpdateSlewLimitedCount_; }
+uint32_t IMU::gravityUpdateSlewLimitedCount() const {
+  return reading().gravityUpdateSlewLimitedCount;
+}
 
-uint32_t IMU::kalmanUpdateSampleCount() const { return kalmanUpdateSampleCount_; }
+uint32_t IMU::kalmanUpdateSampleCount() const { return reading().kalmanUpdateSampleCount; }
 
 bool IMU::startupReadinessTimedOut() const {
   return startupReadinessStartMs_ != 0 &&
          static_cast<uint32_t>(millis() - startupReadinessStartMs_) >= STARTUP_IMU_MAX_READINESS_MS;
 }
 
-uint16_t IMU::startupSamplesCompleted() const {
+uint16_t IMU::computeStartupSamplesCompleted() const {
   uint16_t kalmanCompleted = KALMAN_STARTUP_REPORT_SAMPLES - kalmanStartupSamplesRemaining_;
   if (kalmanStartupSamplesRemaining_ == 0 && startupReadinessTimedOut()) {
     return KALMAN_STARTUP_REPORT_SAMPLES;
@@ -435,4 +488,6 @@ uint16_t IMU::startupSamplesCompleted() const {
   return kalmanCompleted < nonVertCompleted ? kalmanCompleted : nonVertCompleted;
 }
 
+uint16_t IMU::startupSamplesCompleted() const { return reading().startupSamplesCompleted; }
+
 uint16_t IMU::startupSamplesRequired() const { return KALMAN_STARTUP_REPORT_SAMPLES; }
@@ -6,14 +6,64 @@
 #include "dispatch/message_source.h"
 #include "dispatch/message_types.h"
 #include "math/kalman.h"
+#include "utils/seqlock.h"
 
 #define POSITION_MEASURE_STANDARD_DEVIATION 0.1f
 #define ACCELERATION_MEASURE_STANDARD_DEVIATION 0.3f
 
+// Motion samples arrive and the vertical Kalman filter runs on the realtime loop.  After each sample
+// everything the getters report is published as a Reading, which they copy whole, so the service
+// core never sees the filter half-updated.
 class IMU : public MessageSink<IMU, MotionUpdate>, public IMessageSource {
  public:
+  // Everything the getters report, as of the last motion sample
+  struct Reading {
+    bool accelValid;
+    float accel;
+    bool velocityValid;
+    float velocity;
+    float gravityEstimate;
+    float verticalAccel;
+    float kalmanAccelInput;
+    bool kalmanValid;
+    float kalmanPosition;
+    float kalmanVelocity;
+    float kalmanAcceleration;
+    unsigned long lastMotionTime;
+    float lastDeviceAccelX;
+    float lastDeviceAccelY;
+    float lastDeviceAccelZ;
+    float lastQuatX;
+    float lastQuatY;
+    float lastQuatZ;
+    float lastWorldAccelX;
+    float lastWorldAccelY;
+    float lastWorldVerticalAccel;
+    bool worldVerticalAccelValid;
+    uint16_t gravityInitResetCount;
+    float lastRejectedGravityEstimate;
+    uint32_t motionSampleCount;
+    uint32_t motionSampleBaroNotReadyCount;
+    uint32_t motionSampleMissingFieldsCount;
+    uint32_t motionSampleProcessedCount;
+    uint32_t motionSampleRejectedQuaternionCount;
+    uint32_t gravityInitSampleCount;
+    uint32_t gravityUpdateCandidateCount;
+    uint32_t gravityUpdateAcceptedCount;
+    uint32_t gravityUpdateRejectedAccelCount;
+    uint32_t gravityUpdateRejectedVerticalCount;
+    uint32_t gravityUpdateRejectedTimeCount;
+    uint32_t gravityUpdateRejectedPlausibilityCount;
+    uint32_t gravityUpdateSlewLimitedCount;
+    uint32_t kalmanUpdateSampleCount;
+    uint16_t startupSamplesCompleted;
+  };
+
   IMU();
 
+  // A consistent copy of everything below, for callers that read several values together
+  Reading reading() const { return reading_.read(); }
+
   void wake();
 
   // MessageSink<IMU, MotionUpdate>
@@ -24,11 +74,11 @@ class IMU : public MessageSink<IMU, MotionUpdate>, public IMessageSource {
   void publishTo(etl::imessage_bus* bus) { bus_ = bus; }
   void stopPublishing() { bus_ = nullptr; }
 
-  bool accelValid();
-  float getAccel();
+  bool accelValid() const;
+  float getAccel() const;
 
-  bool velocityValid();
-  float getVelocity();
+  bool velocityValid() const;
+  float getVelocity() const;
 
   uint16_t gravityInitSamplesRemaining() const;
   float gravityEstimate() const;
@@ -71,6 +121,14 @@ class IMU : public MessageSink<IMU, MotionUpdate>, public IMessageSource {
  private:
   void processMotion(const MotionUpdate& m);
   bool startupReadinessTimedOut() const;
+  uint16_t computeStartupSamplesCompleted() const;
+
+  // Copy the realtime loop's state out to reading_
+  void publish();
+
+  Seqlock<Reading> reading_;
+
+  // == Everything below is owned by the realtime loop ==
 
   etl::imessage_bus* bus_ = nullptr;
 
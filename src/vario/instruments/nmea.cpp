@@ -0,0 +1,316 @@
+#include "instruments/nmea.h"
+
+#include <string.h>
+
+namespace nmea {
+  namespace {
+    // Decimal digits a 32-bit value can always hold
+    constexpr uint8_t MAX_DIGITS = 9;
+
+    constexpr double MPS_PER_KNOT = _GPS_MPS_PER_KNOT;
+
+    // PQTMPVT fields, message version 1:
+    //   $PQTMPVT,<MsgVer>,<TOW>,<Date>,<Time>,<Res>,<FixMode>,<NumSatUsed>,<LeapS>,<Lat>,<Lon>,
+    //   <Alt>,<Sep>,<VelN>,<VelE>,<VelD>,<Spd>,<Heading>,<HDOP>,<PDOP>*CS
+    constexpr uint8_t PVT_VERSION = 1;
+    constexpr uint8_t PVT_MSG_VER = 1;
+    constexpr uint8_t PVT_DATE = 3;      // yyyymmdd
+    constexpr uint8_t PVT_TIME = 4;      // hhmmss.sss
+    constexpr uint8_t PVT_FIX_MODE = 6;  // 0 = none, 2 = 2D, 3 = 3D
+    constexpr uint8_t PVT_SATS_USED = 7;
+    constexpr uint8_t PVT_LAT = 9;  // Signed decimal degrees
+    constexpr uint8_t PVT_LON = 10;
+    constexpr uint8_t PVT_ALT = 11;    // Metres above mean sea level
+    constexpr uint8_t PVT_SPEED = 16;  // m/s
+    constexpr uint8_t PVT_HEADING = 17;
+    constexpr uint8_t PVT_HDOP = 18;
+
+    int hexValue(char c) {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      return -1;
+    }
+
+    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    Type typeOf(Field address) {
+      if (address.length == 7 && memcmp(address.text, "PQTMPVT", 7) == 0) return Type::PQTMPVT;
+      // Any talker: GP, GN, GL, ...
+      if (address.length != 5) return Type::Other;
+      const char* formatter = address.text + 2;
+      if (memcmp(formatter, "GGA", 3) == 0) return Type::GGA;
+      if (memcmp(formatter, "RMC", 3) == 0) return Type::RMC;
+      if (memcmp(formatter, "GSA", 3) == 0) return Type::GSA;
+      if (memcmp(formatter, "GSV", 3) == 0) return Type::GSV;
+      return Type::Other;
+    }
+
+    uint8_t clampTo(uint32_t value, uint8_t max) { return value > max ? max : value; }
+
+    bool decodeGga(const Sentence& s, GpsFix& fix) {
+      uint32_t quality = 0;
+      parseUnsigned(s.field(6), quality);
+      fix.fixQuality = quality;
+      const bool hasFix = quality > 0;
+
+      uint32_t time;
+      if (parseTime(s.field(1), time)) fix.time.set(time);
+      double lat, lng;
+      int32_t altitude;
+      if (hasFix && parseCoordinate(s.field(2), s.field(3), lat) &&
+          parseCoordinate(s.field(4), s.field(5), lng)) {
+        fix.location.set(lat, lng);
+      }
+      if (hasFix && parseHundredths(s.field(9), altitude)) fix.altitude.set(altitude);
+      uint32_t satellites;
+      if (parseUnsigned(s.field(7), satellites)) fix.satellites.set(satellites);
+      int32_t hdop;
+      if (parseHundredths(s.field(8), hdop)) fix.hdop.set(hdop);
+      return hasFix;
+    }
+
+    bool decodeRmc(const Sentence& s, GpsFix& fix) {
+      const Field status = s.field(2);
+      const bool hasFix = status.length == 1 && status.text[0] == 'A';
+
+      uint32_t time, date;
+      if (parseTime(s.field(1), time)) fix.time.set(time);
+      if (parseUnsigned(s.field(9), date)) fix.date.set(date);
+      if (!hasFix) return false;
+
+      double lat, lng;
+      if (parseCoordinate(s.field(3), s.field(4), lat) &&
+          parseCoordinate(s.field(5), s.field(6), lng)) {
+        fix.location.set(lat, lng);
+      }
+      int32_t speed, course;
+      if (parseHundredths(s.field(7), speed)) fix.speed.set(speed);
+      if (parseHundredths(s.field(8), course)) fix.course.set(course);
+      return true;
+    }
+
+    bool decodePvt(const Sentence& s, GpsFix& fix) {
+      uint32_t version = 0;
+      if (!parseUnsigned(s.field(PVT_MSG_VER), version) || version != PVT_VERSION) return false;
+
+      uint32_t mode = 0;
+      parseUnsigned(s.field(PVT_FIX_MODE), mode);
+      const bool hasFix = mode >= 2;
+      fix.fixMode = mode >= 2 ? mode : 1;
+      fix.fixQuality = hasFix ? 1 : 0;
+
+      uint32_t time, date;
+      if (parseTime(s.field(PVT_TIME), time)) fix.time.set(time);
+      if (parseUnsigned(s.field(PVT_DATE), date)) {
+        // yyyymmdd to ddmmyy
+        fix.date.set((date % 100) * 10000 + (date / 100 % 100) * 100 + date / 10000 % 100);
+      }
+      uint32_t satellites;
+      if (parseUnsigned(s.field(PVT_SATS_USED), satellites)) fix.satellites.set(satellites);
+      int32_t hdop;
+      if (parseHundredths(s.field(PVT_HDOP), hdop)) fix.hdop.set(hdop);
+      if (!hasFix) return false;
+
+      double lat, lng;
+      if (parseDegrees(s.field(PVT_LAT), lat) && parseDegrees(s.field(PVT_LON), lng)) {
+        fix.location.set(lat, lng);
+      }
+      int32_t altitude, speed, heading;
+      if (parseHundredths(s.field(PVT_ALT), altitude)) fix.altitude.set(altitude);
+      if (parseHundredths(s.field(PVT_SPEED), speed)) {
+        fix.speed.set(speed >= 0 ? (int32_t)(speed / MPS_PER_KNOT + 0.5) : 0);
+      }
+      if (parseHundredths(s.field(PVT_HEADING), heading)) fix.course.set(heading);
+      return true;
+    }
+  }  // namespace
+
+  Sentence::Sentence(const char* text, size_t length) : text_(text) {
+    if (length < 4 || length > UINT8_MAX || text[0] != '$') return;
+
+    uint8_t count = 0;
+    uint8_t end = 0;  // One past the last field we keep, if there are more than MAX_FIELDS
+    uint8_t checksum = 0;
+    size_t i = 1;
+    starts_[count++] = i;
+    for (; i < length && text[i] != '*'; i++) {
+      const char c = text[i];
+      checksum ^= c;
+      if (c != ',') continue;
+      if (count < MAX_FIELDS) {
+        starts_[count++] = i + 1;
+      } else if (end == 0) {
+        end = i + 1;
+      }
+    }
+    // "*HH" must end the sentence
+    if (i + 3 != length) return;
+    const int high = hexValue(text[i + 1]);
+    const int low = hexValue(text[i + 2]);
+    if (high < 0 || low < 0 || (high << 4 | low) != checksum) return;
+
+    starts_[count] = end != 0 ? end : i + 1;
+    fieldCount_ = count;
+    type_ = typeOf(field(0));
+  }
+
+  Field Sentence::field(uint8_t index) const {
+    if (index >= fieldCount_) return {"", 0};
+    return {text_ + starts_[index], (uint8_t)(starts_[index + 1] - starts_[index] - 1)};
+  }
+
+  bool parseUnsigned(Field field, uint32_t& value) {
+    if (field.empty() || field.length > MAX_DIGITS) return false;
+    uint32_t parsed = 0;
+    for (uint8_t i = 0; i < field.length; i++) {
+      if (!isDigit(field.text[i])) return false;
+      parsed = parsed * 10 + (field.text[i] - '0');
+    }
+    value = parsed;
+    return true;
+  }
+
+  bool parseHundredths(Field field, int32_t& value) {
+    uint8_t i = 0;
+    const bool negative = field.length > 0 && field.text[0] == '-';
+    if (negative) i++;
+
+    int32_t whole = 0;
+    uint8_t digits = 0;
+    for (; i < field.length && isDigit(field.text[i]); i++, digits++) {
+      if (digits >= MAX_DIGITS - 2) return false;
+      whole = whole * 10 + (field.text[i] - '0');
+    }
+    if (digits == 0) return false;
+
+    int32_t fraction = 0;
+    if (i < field.length) {
+      if (field.text[i++] != '.') return false;
+      for (uint8_t place = 0; i < field.length; i++, place++) {
+        if (!isDigit(field.text[i])) return false;
+        if (place == 0) fraction += 10 * (field.text[i] - '0');
+        if (place == 1) fraction += field.text[i] - '0';
+      }
+    }
+    const int32_t hundredths = whole * 100 + fraction;
+    value = negative ? -hundredths : hundredths;
+    return true;
+  }
+
+  bool parseCoordinate(Field value, Field hemisphere, double& degrees) {
+    if (hemisphere.length != 1) return false;
+    const char h = hemisphere.text[0];
+    if (h != 'N' && h != 'S' && h != 'E' && h != 'W') return false;
+
+    uint8_t i = 0;
+    uint32_t leftOfDecimal = 0;
+    for (; i < value.length && isDigit(value.text[i]); i++) {
+      if (i >= MAX_DIGITS) return false;
+      leftOfDecimal = leftOfDecimal * 10 + (value.text[i] - '0');
+    }
+    if (i < 3) return false;  // At least one degree digit and two of minutes
+    const uint32_t minutes = leftOfDecimal % 100;
+    if (minutes >= 60) return false;
+
+    // The same arithmetic as TinyGPSPlus, so positions match it to the last digit
+    uint32_t multiplier = 10000000;
+    uint32_t tenMillionthsOfMinutes = minutes * multiplier;
+    if (i < value.length) {
+      if (value.text[i++] != '.') return false;
+      for (; i < value.length; i++) {
+        if (!isDigit(value.text[i])) return false;
+        multiplier /= 10;
+        tenMillionthsOfMinutes += (value.text[i] - '0') * multiplier;
+      }
+    }
+    const uint32_t billionths = (5 * tenMillionthsOfMinutes + 1) / 3;
+    const double result = leftOfDecimal / 100 + billionths / 1000000000.0;
+    degrees = h == 'S' || h == 'W' ? -result : result;
+    return true;
+  }
+
+  bool parseDegrees(Field field, double& degrees) {
+    uint8_t i = 0;
+    const bool negative = field.length > 0 && field.text[0] == '-';
+    if (negative) i++;
+
+    uint32_t whole = 0;
+    uint8_t digits = 0;
+    for (; i < field.length && isDigit(field.text[i]); i++, digits++) {
+      if (digits >= 3) return false;
+      whole = whole * 10 + (field.text[i] - '0');
+    }
+    if (digits == 0) return false;
+
+    uint32_t fraction = 0;
+    uint32_t scale = 1;
+    if (i < field.length) {
+      if (field.text[i++] != '.') return false;
+      for (; i < field.length; i++) {
+        if (!isDigit(field.text[i])) return false;
+        if (scale >= 1000000000) continue;  // Beyond a nanodegree
+        fraction = fraction * 10 + (field.text[i] - '0');
+        scale *= 10;
+      }
+    }
+    const double result = whole + (double)fraction / scale;
+    degrees = negative ? -result : result;
+    return true;
+  }
+
+  bool parseTime(Field field, uint32_t& time) {
+    int32_t hundredths;
+    if (field.length < 6 || !parseHundredths(field, hundredths) || hundredths < 0) return false;
+    time = hundredths;
+    return true;
+  }
+
+  bool decode(const Sentence& sentence, GpsFix& fix) {
+    switch (sentence.type()) {
+      case Type::GGA:
+        return decodeGga(sentence, fix);
+      case Type::RMC:
+        return decodeRmc(sentence, fix);
+      case Type::GSA: {
+        uint32_t mode;
+        if (parseUnsigned(sentence.field(2), mode)) fix.fixMode = mode;
+        return false;
+      }
+      case Type::PQTMPVT:
+        return decodePvt(sentence, fix);
+      default:
+        return false;
+    }
+  }
+
+  bool decode(const Sentence& sentence, SatellitePage& page) {
+    if (sentence.type() != Type::GSV) return false;
+    uint32_t total, number;
+    if (!parseUnsigned(sentence.field(1), total) || !parseUnsigned(sentence.field(2), number)) {
+      return false;
+    }
+    page.total = clampTo(total, UINT8_MAX);
+    page.number = clampTo(number, UINT8_MAX);
+    page.count = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+      const uint8_t first = 4 + 4 * i;
+      uint32_t id, elevation, azimuth;
+      uint32_t snr = 0;
+      if (!parseUnsigned(sentence.field(first), id) || id == 0 || id > UINT8_MAX ||
+          !parseUnsigned(sentence.field(first + 1), elevation) ||
+          !parseUnsigned(sentence.field(first + 2), azimuth)) {
+        continue;
+      }
+      parseUnsigned(sentence.field(first + 3), snr);
+
+      Satellite& satellite = page.satellites[page.count++];
+      satellite.id = id;
+      satellite.elevation = clampTo(elevation, 90);
+      satellite.azimuth = azimuth > 359 ? 359 : azimuth;
+      satellite.snr = clampTo(snr, 99);
+    }
+    return true;
+  }
+}  // namespace nmea
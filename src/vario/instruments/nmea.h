@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "instruments/gps_fix.h"
+
+// NMEA 0183 parsing over the sentence buffer, without copying it.
+//
+// A Sentence checks the checksum and finds every field in one pass over the text; the decoders
+// then read the fields they need straight from the buffer, which must outlive the Sentence.  Only
+// the sentences the vario uses are decoded: GGA, RMC, GSA and Quectel's PQTMPVT into the fix, and
+// GSV into a page of satellites.
+namespace nmea {
+  // GSV has 21 fields including the address, PQTMPVT 20
+  constexpr uint8_t MAX_FIELDS = 24;
+
+  enum class Type : uint8_t { Other, GGA, RMC, GSA, GSV, PQTMPVT };
+
+  struct Field {
+    const char* text;
+    uint8_t length;
+
+    bool empty() const { return length == 0; }
+  };
+
+  class Sentence {
+   public:
+    // text: "$<address>,<field>,...*<checksum>" without a line ending
+    Sentence(const char* text, size_t length);
+
+    // Whether the sentence was well formed with a matching checksum
+    bool valid() const { return fieldCount_ > 0; }
+    Type type() const { return type_; }
+
+    uint8_t fieldCount() const { return fieldCount_; }
+
+    // Field 0 is the address, e.g. "GNGGA".  Fields past the end are empty.
+    Field field(uint8_t index) const;
+
+   private:
+    const char* text_;
+    // Offset of each field's first character, then one past the end of the last field
+    uint8_t starts_[MAX_FIELDS + 1];
+    uint8_t fieldCount_ = 0;  // 0 if not valid
+    Type type_ = Type::Other;
+  };
+
+  // Field decoders.  Each returns false, leaving the output unchanged, if the field is empty or
+  // malformed.
+
+  bool parseUnsigned(Field field, uint32_t& value);
+
+  // "-123.456" as -12345: hundredths, truncated, as TinyGPSPlus stored them
+  bool parseHundredths(Field field, int32_t& value);
+
+  // ddmm.mmmm or dddmm.mmmm with its N/S/E/W hemisphere field
+  bool parseCoordinate(Field value, Field hemisphere, double& degrees);
+
+  // Signed decimal degrees
+  bool parseDegrees(Field field, double& degrees);
+
+  // hhmmss.ss as hhmmsscc
+  bool parseTime(Field field, uint32_t& time);
+
+  // Decode a GGA, RMC, GSA or PQTMPVT sentence into the fix, committing the values it carries as
+  // TinyGPSPlus did: position, speed, course and altitude only when the sentence reports a fix.
+  // Returns whether the sentence reported a fix.
+  bool decode(const Sentence& sentence, GpsFix& fix);
+
+  struct Satellite {
+    uint8_t id;
+    uint8_t elevation;  // Degrees
+    uint16_t azimuth;   // Degrees
+    uint8_t snr;        // dB-Hz, 0 if not tracked
+  };
+
+  // One GSV sentence: part `number` of `total`, with up to four satellites
+  struct SatellitePage {
+    uint8_t total;
+    uint8_t number;
+    uint8_t count;
+    Satellite satellites[4];
+  };
+
+  // Returns false if the sentence is not a usable GSV
+  bool decode(const Sentence& sentence, SatellitePage& page);
+}  // namespace nmea
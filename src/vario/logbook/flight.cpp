@@ -1,11 +1,53 @@
 #include "flight.h"
 
+#include <Preferences.h>
 #include <SD_MMC.h>
 
 #include "FS.h"
 #include "instruments/gps.h"
 #include "logging/telemetry.h"
 #include "storage/sd_card.h"
+#include "storage/sd_latency.h"
+
+namespace {
+  constexpr const char* COUNTER_NAMESPACE = "flightCount";
+  constexpr const char* PREFIX_KEY = "prefix";
+  constexpr const char* NUMBER_KEY = "number";
+
+  // The last flight-of-the-day number used for a track file prefix (which carries the date).
+  // Persisted so the first flight after a restart starts from it rather than listing /tracks, and
+  // held in memory along with the mount it was last confirmed against: within one mount the
+  // firmware is the only thing creating track files, so nothing can have taken the next number.
+  struct FlightCounter {
+    String prefix;
+    int number = 0;
+    uint32_t mountGeneration = 0;
+    bool confirmed = false;
+  };
+  FlightCounter counter;
+
+  String flightFileName(const String& prefix, int number, const String& suffix) {
+    return prefix + "-" + (number < 10 ? String(0) + number : String(number)) + "." + suffix;
+  }
+
+  void loadCounter(const String& prefix) {
+    counter.prefix = prefix;
+    counter.number = 0;
+    counter.confirmed = false;
+    Preferences prefs;
+    if (!prefs.begin(COUNTER_NAMESPACE, true)) return;
+    if (prefs.getString(PREFIX_KEY) == prefix) counter.number = prefs.getInt(NUMBER_KEY, 0);
+    prefs.end();
+  }
+
+  void storeCounter() {
+    Preferences prefs;
+    if (!prefs.begin(COUNTER_NAMESPACE, false)) return;
+    if (prefs.getString(PREFIX_KEY) != counter.prefix) prefs.putString(PREFIX_KEY, counter.prefix);
+    prefs.putInt(NUMBER_KEY, counter.number);
+    prefs.end();
+  }
+}  // namespace
 
 bool Flight::startFlight() {
   // Short circuit if the card is not mounted or reading properly
@@ -15,48 +57,43 @@ bool Flight::startFlight() {
     return false;
   }
 
-  Serial.printf("Sectors: %d\n", SD_MMC.numSectors());
-  File trackLogsDir = SD_MMC.open(this->desiredFilePath());
-
   auto filePrefix = this->desiredFilePath() + "/" + this->desiredFileName();
   auto suffix = this->fileNameSuffix();
-  // Perform a directory listing of all the file in the tracks directory
-  auto nextFile = trackLogsDir.getNextFileName();
-  auto desiredFlightNum = 1;
-  while (!nextFile.isEmpty()) {
-    if (!nextFile.endsWith(suffix) || !nextFile.startsWith(filePrefix)) {
-      nextFile = trackLogsDir.getNextFileName();
-      continue;
-    }
-
-    // This file matches the format we're after.  Find the flight number
-    // igc-file-01.igc should match 01
-    auto flightNumStr =
-        nextFile.substring(filePrefix.length() + 1, nextFile.length() - suffix.length());
-    auto flightNum = flightNumStr.toInt();
-    if (flightNum >= desiredFlightNum) {
-      desiredFlightNum = flightNum + 1;
-    }
-
-    nextFile = trackLogsDir.getNextFileName();
-  }
+  const String counterPrefix = filePrefix + "." + suffix;
+  if (counter.prefix != counterPrefix) loadCounter(counterPrefix);
 
-  String fileName = filePrefix + "-" +
-                    (desiredFlightNum < 10 ? String(0) + desiredFlightNum : desiredFlightNum) +
-                    "." + suffix;
+  // Starting a log is a launch-time operation, so the next number comes from the counter rather
+  // than a listing of every track on the card.  If the card has been remounted since the counter
+  // was last confirmed it may be a different card, or tracks may have been copied onto it over
+  // USB, so step past any file already holding the number; usually that is a single lookup.  A
+  // card whose files were removed may leave a gap in the numbering, which the IGC spec permits.
+  const uint32_t mountGeneration = sdcard.mountGeneration();
+  int desiredFlightNum = counter.number + 1;
+  if (!counter.confirmed || counter.mountGeneration != mountGeneration) {
+    while (SD_MMC.exists(flightFileName(filePrefix, desiredFlightNum, suffix))) desiredFlightNum++;
+  }
+  String fileName = flightFileName(filePrefix, desiredFlightNum, suffix);
 
   // Create the file for writing
-  file = SD_MMC.open(fileName, "w", true);
+  file = trackFile_.open(fileName, expectedFileSize());
   if (!file) {
     filePath_ = "";
     return false;
   }
 
+  counter.number = desiredFlightNum;
+  counter.mountGeneration = mountGeneration;
+  counter.confirmed = true;
+  storeCounter();
+
   filePath_ = fileName;
   return true;
 }
 
-void Flight::end(const FlightStats stats, bool showSummary) { file.close(); }
+void Flight::end(const FlightStats stats, bool showSummary) {
+  trackFile_.close();
+  sd_latency::writeReport();
+}
 
 bool Flight::started() { return (boolean)file; }
 
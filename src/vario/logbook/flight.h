@@ -3,6 +3,7 @@
 #include "Arduino.h"
 #include "FS.h"
 #include "flight_stats.h"
+#include "storage/preallocated_file.h"
 
 class Flight {
  public:
@@ -30,6 +31,11 @@ class Flight {
   // Directory where the track log is to be stored
   virtual const String desiredFilePath() const { return "/tracks"; }
 
+  // Space to reserve on the card, ahead of time, for a track log; a longer log grows as it is
+  // written
+  virtual uint32_t expectedFileSize() const { return 0; }
+
   File file;
+  PreallocatedFile trackFile_;
   String filePath_;
 };
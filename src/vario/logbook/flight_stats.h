@@ -2,6 +2,7 @@
 
 #include "Arduino.h"
 #include "instruments/baro.h"
+#include "logbook/xc_score.h"
 #include "ui/settings/settings.h"
 
 class FlightStats {
@@ -33,6 +34,7 @@ class FlightStats {
 
   float distanceStraightLine = 0;  // distance between start and end points, in m
   float distanceAlongPath = 0;     // accumulated distance (m) of actual flight path
+  XcScore xc;                      // best XC score found so far (free distance / triangle)
 
   float speed = 0;      // speed in mps
   float speed_max = 0;  // max speed logged in mps
@@ -9,6 +9,7 @@
 #include "instruments/gps.h"
 #include "navigation/gpx.h"
 #include "profiles/profile_store.h"
+#include "storage/sd_latency.h"
 #include "system/version_info.h"
 #include "time.h"
 #include "ui/settings/settings.h"
@@ -206,15 +207,43 @@ const String Igc::desiredFileName() const {
   return ret;
 }
 
+uint32_t Igc::expectedFileSize() const {
+  // Reserved for a flight this long, which few are; the file is cut back to its length as it ends
+  constexpr uint32_t EXPECTED_FLIGHT_SECONDS = 5 * 60 * 60;
+  // A B record with every extension in the I record, and its CRLF
+  constexpr uint32_t B_RECORD_BYTES = 56;
+  // Headers, task declaration and the occasional E or L record
+  constexpr uint32_t OTHER_RECORD_BYTES = 8192;
+  const uint32_t fixRate = max(gps.fixRate(), (uint8_t)1);
+  return OTHER_RECORD_BYTES + EXPECTED_FLIGHT_SECONDS * fixRate * B_RECORD_BYTES;
+}
+
 void Igc::log(unsigned long durationSec) {
   // Short-circuit if we've not yet started a flight
   if (!started()) return;
   if (!gps.hasUsableFix()) return;
 
-  logger.writeBRecord(utcTimeString(),  // Time in HHMMSS
-                      latDegreeToStr(gps.location.lat()), lngDegreeToStr(gps.location.lng()), true,
-                      baro.alt() / 100,  // cm to meters
-                      gps.altitude.meters(), igcBRecordExtensions());
+  String extensions = igcBRecordExtensions();
+  const uint8_t tenths = gps.time.centisecond() / 10;
+  if (logTenths_) {
+    extensions += (char)('0' + tenths);
+  } else {
+    // A record's time is whole seconds, so one record a second, whenever in it the fix came (the
+    // GPS rate may also have gone up since the I record was written without a TDS extension)
+    const int32_t second = gps.time.hour() * 3600 + gps.time.minute() * 60 + gps.time.second();
+    if (second == lastLoggedSecond_) return;
+    lastLoggedSecond_ = second;
+  }
+
+  {
+    sd_latency::Timer timer(sd_latency::Op::Write);
+    logger.writeBRecord(utcTimeString(),  // Time in HHMMSS
+                        latDegreeToStr(gps.location.lat()), lngDegreeToStr(gps.location.lng()),
+                        true, baro.alt() / 100,  // cm to meters
+                        gps.altitude.meters(), extensions);
+  }
+  preview_.addFix(gps.location.lat(), gps.location.lng(), gps.altitude.meters());
+  trackFile_.checkpoint();
 }
 
 bool Igc::startFlight() {
@@ -222,6 +251,7 @@ bool Igc::startFlight() {
   if (!success) return false;
 
   logger.setOutput(file);
+  preview_.reset();
 
   // Log the Header
   // A record to look like "AXLFLeaf1"
@@ -254,11 +284,16 @@ bool Igc::startFlight() {
   logger.fix_accuracy = 2;  // Quectel LC86G spec: 2.0m CEP horizontal accuracy
   logger.writeHeader();
 
-  // Log the I record for the extension values appended to each B fix record.
+  // Log the I record for the extension values appended to each B fix record.  Above 1Hz, B records
+  // also carry the tenths of a second of their fix (TDS), since their time field is whole seconds.
+  logTenths_ = gps.fixRate() > 1;
+  lastLoggedSecond_ = -1;
   const IRecordExtension extensions[] = {IRecordExtension(3, "FXA"), IRecordExtension(3, "GSP"),
                                          IRecordExtension(3, "TRT"), IRecordExtension(3, "WDI"),
-                                         IRecordExtension(3, "WSP"), IRecordExtension(3, "VAR")};
-  logger.writeIRecord(sizeof(extensions) / sizeof(extensions[0]), extensions);
+                                         IRecordExtension(3, "WSP"), IRecordExtension(3, "VAR"),
+                                         IRecordExtension(1, "TDS")};
+  const uint8_t extensionCount = sizeof(extensions) / sizeof(extensions[0]);
+  logger.writeIRecord(logTenths_ ? extensionCount : extensionCount - 1, extensions);
   writeActiveNavigationDeclaration();
 
   return true;
@@ -266,10 +301,14 @@ bool Igc::startFlight() {
 
 void Igc::end(const FlightStats stats, bool showSummary) {
   // If we've not started a flight yet, don't write to disk.
-  if (started()) {
+  const bool wasStarted = started();
+  if (wasStarted) {
     logger.writeGRecord();
   }
   Flight::end(stats, showSummary);
+
+  // Written once here so the web app never has to parse the full IGC to draw a preview
+  if (wasStarted) preview_.writeSidecar(track_preview::sidecarPathFor(filePath_));
 }
 
 void Igc::setPilotFromProfiles() {
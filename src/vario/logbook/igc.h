@@ -1,6 +1,7 @@
 #pragma once
 #include "IgcLogger.h"
 #include "flight.h"
+#include "track_preview.h"
 
 struct Waypoint;
 
@@ -15,11 +16,17 @@ class Igc : public Flight {
   const String fileNameSuffix() const override { return "igc"; }
 
   const String desiredFileName() const override;
+  uint32_t expectedFileSize() const override;
   void log(unsigned long durationSec) override;
   void markSavedPoint(const Waypoint& waypoint);
 
  private:
   IgcLogger logger;
+  TrackPreviewBuilder preview_;
+  // Whether B records end with the TDS extension, fixed by the I record at the start of the flight
+  bool logTenths_ = false;
+  // Without TDS, the GPS second of the last B record, so there is one record a second
+  int32_t lastLoggedSecond_ = -1;
   void setPilotFromProfiles();
   void writeActiveNavigationDeclaration();
 };
@@ -0,0 +1,75 @@
+#include "logbook/igc_fix.h"
+
+#include <SD_MMC.h>
+
+#include "storage/files.h"
+
+namespace {
+  constexpr size_t IGC_LINE_MAX = 96;
+
+  bool parseDigits(const char* s, uint8_t count, int32_t& value) {
+    value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      if (s[i] < '0' || s[i] > '9') return false;
+      value = value * 10 + (s[i] - '0');
+    }
+    return true;
+  }
+
+  bool parseSignedField(const char* s, uint8_t count, int32_t& value) {
+    const bool negative = s[0] == '-';
+    if (!parseDigits(s + (negative ? 1 : 0), count - (negative ? 1 : 0), value)) return false;
+    if (negative) value = -value;
+    return true;
+  }
+
+  // DDMMmmm (minutes in thousandths) plus hemisphere -> degrees * 1e5
+  bool parseIgcCoordinate(const char* s, uint8_t degreeDigits, char negativeHemisphere,
+                          int32_t& e5) {
+    int32_t degrees;
+    int32_t minuteThousandths;
+    if (!parseDigits(s, degreeDigits, degrees)) return false;
+    if (!parseDigits(s + degreeDigits, 5, minuteThousandths)) return false;
+    // One thousandth of a minute is 1e5 / 60000 = 5/3 of a coordinate unit
+    e5 = degrees * igc_fix::COORDINATE_SCALE + (minuteThousandths * 5 + 1) / 3;
+    if (s[degreeDigits + 5] == negativeHemisphere) e5 = -e5;
+    return true;
+  }
+}  // namespace
+
+namespace igc_fix {
+  bool parseBRecord(const char* line, size_t len, IgcFix& fix) {
+    if (len < 35 || line[0] != 'B') return false;
+    if (!parseIgcCoordinate(line + 7, 2, 'S', fix.latE5)) return false;
+    if (!parseIgcCoordinate(line + 15, 3, 'W', fix.lonE5)) return false;
+
+    int32_t altitude;
+    if (!parseSignedField(line + 30, 5, altitude) || altitude == 0) {
+      if (!parseSignedField(line + 25, 5, altitude)) altitude = 0;
+    }
+    fix.altitudeM = static_cast<int16_t>(constrain(altitude, -32768L, 32767L));
+    return true;
+  }
+
+  bool forEachFix(const String& path, void (*onFix)(const IgcFix& fix, void* context),
+                  void* context) {
+    if (path.isEmpty()) return false;
+    FileReader reader(SD_MMC, path[0] == '/' ? path : "/" + path);
+    if (!reader.error().isEmpty()) return false;
+
+    char line[IGC_LINE_MAX];
+    size_t len = 0;
+    IgcFix fix;
+    while (reader.contentRemaining()) {
+      const char c = reader.nextChar();
+      if (c == '\n' || c == '\r') {
+        if (parseBRecord(line, len, fix)) onFix(fix, context);
+        len = 0;
+      } else if (len < IGC_LINE_MAX) {
+        line[len++] = c;
+      }
+    }
+    if (parseBRecord(line, len, fix)) onFix(fix, context);
+    return true;
+  }
+}  // namespace igc_fix
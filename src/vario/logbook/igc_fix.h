@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Arduino.h"
+
+// A position fix read back from an IGC B record, in integer units
+struct IgcFix {
+  int32_t latE5 = 0;  // degrees * 1e5 (~1.1 m)
+  int32_t lonE5 = 0;
+  int16_t altitudeM = 0;  // GPS altitude, or pressure altitude when the fix has no GPS altitude
+};
+
+namespace igc_fix {
+  constexpr int32_t COORDINATE_SCALE = 100000;
+
+  // Parse one line (without its terminator) of the form
+  //   B HHMMSS DDMMmmmN DDDMMmmmE V PPPPP GGGGG ...
+  bool parseBRecord(const char* line, size_t len, IgcFix& fix);
+
+  // Call onFix for every B record in the IGC file at path, in file order.  Returns false if the
+  // file could not be opened.
+  bool forEachFix(const String& path, void (*onFix)(const IgcFix& fix, void* context),
+                  void* context);
+}  // namespace igc_fix
@@ -7,9 +7,13 @@
 #include <time.h>
 
 #include "instruments/gps.h"
+#include "logbook/logbook_store.h"
+#include "logbook/track_preview.h"
 #include "profiles/profile_store.h"
+#include "storage/dir_cache.h"
 #include "system/version_info.h"
 #include "ui/settings/settings.h"
+#include "utils/lock_guard.h"
 
 namespace {
   constexpr const char* LOGBOOK_DIR = "/logbook";
@@ -146,6 +150,7 @@ void LogbookEntryFile::reset() {
 }
 
 bool LogbookEntryFile::deleteFiles(const String& logbookPath, const String& trackPath) {
+  LockGuard lock(LogbookStore::fileMutex());
   bool success = true;
 
   if (!trackPath.isEmpty()) {
@@ -153,12 +158,14 @@ bool LogbookEntryFile::deleteFiles(const String& logbookPath, const String& trac
     if (SD_MMC.exists(absoluteTrackPath)) {
       success = SD_MMC.remove(absoluteTrackPath) && success;
     }
+    success = track_preview::removeSidecar(absoluteTrackPath) && success;
   }
 
   if (!logbookPath.isEmpty()) {
     const String absoluteLogbookPath = absolutePath(logbookPath);
     if (SD_MMC.exists(absoluteLogbookPath)) {
       success = SD_MMC.remove(absoluteLogbookPath) && success;
+      dir_cache::noteChanged(absoluteLogbookPath);
     }
   }
 
@@ -196,7 +203,10 @@ bool LogbookEntryFile::ensureLogbookDirectory() const {
 bool LogbookEntryFile::renameToSyncedTimestampIfNeeded() {
   const String newPath = pathForStem(timestampFileStem());
   if (newPath == path_) return true;
+  LockGuard lock(LogbookStore::fileMutex());
   if (!SD_MMC.rename(path_, newPath)) return false;
+  dir_cache::noteChanged(path_);
+  dir_cache::noteChanged(newPath);
   path_ = newPath;
   return true;
 }
@@ -268,6 +278,7 @@ bool LogbookEntryFile::writeJson(const FlightStats& stats, bool finalEntry,
            stats.duration > 0 ? stats.distanceAlongPath / stats.duration : 0);
   addFloat(metrics, "straight_line_distance_m", stats.distanceStraightLine);
   addFloat(metrics, "path_distance_m", stats.distanceAlongPath);
+  LogbookStore::writeXcScore(metrics, stats.xc);
   addFloat(metrics, "max_accel_g", stats.accel_max);
   addFloat(metrics, "min_accel_g", stats.accel_min);
   addFloat(metrics, "max_temperature_c", stats.temperature_max);
@@ -317,6 +328,8 @@ bool LogbookEntryFile::writeJson(const FlightStats& stats, bool finalEntry,
   notes["pilot_notes"] = "";
   notes["tags"].to<JsonArray>();
 
+  // The web task may be reading this entry for the logbook list
+  LockGuard lock(LogbookStore::fileMutex());
   File file = SD_MMC.open(tmpPath, "w", true);
   if (!file) return false;
 
@@ -325,5 +338,7 @@ bool LogbookEntryFile::writeJson(const FlightStats& stats, bool finalEntry,
   file.close();
 
   SD_MMC.remove(path_);
-  return SD_MMC.rename(tmpPath, path_);
+  const bool renamed = SD_MMC.rename(tmpPath, path_);
+  dir_cache::noteChanged(path_);
+  return renamed;
 }
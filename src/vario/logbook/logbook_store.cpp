@@ -4,19 +4,21 @@
 #include <SD_MMC.h>
 
 #include "logbook/logbook_entry.h"
+#include "storage/dir_cache.h"
+#include "storage/preallocated_file.h"
+#include "utils/lock_guard.h"
 
 namespace {
   constexpr const char* LOGBOOK_DIR = "/logbook";
   constexpr size_t LEAF_LOG_MAX_IGC_BYTES = 5 * 1024 * 1024;
 
-  bool getNextLogbookPath(File& dir, String& path) {
-    while (true) {
-      String next = dir.getNextFileName();
-      if (next.isEmpty()) return false;
-
-      path = LogbookStore::normalizePath(next);
-      if (LogbookStore::isLogbookJsonPath(path)) return true;
-    }
+  // Visits the path of every entry, from the cached listing; false if the logbook can't be listed
+  bool forEachLogbookPath(const std::function<void(const String& path)>& visit) {
+    return dir_cache::forEach(LOGBOOK_DIR, [&visit](const dir_cache::Entry& entry) {
+      if (entry.directory) return;
+      const String path = String(LOGBOOK_DIR) + "/" + entry.name;
+      if (LogbookStore::isLogbookJsonPath(path)) visit(path);
+    });
   }
 
   bool isIgcTrack(JsonObjectConst track, const String& path) {
@@ -45,26 +47,22 @@ namespace {
     const String backupPath = path + ".bak";
     if (!SD_MMC.exists(path) && SD_MMC.exists(backupPath)) {
       SD_MMC.rename(backupPath, path);
+      dir_cache::noteChanged(path);
     }
     if (SD_MMC.exists(path) && SD_MMC.exists(backupPath)) SD_MMC.remove(backupPath);
     if (SD_MMC.exists(tempPath)) SD_MMC.remove(tempPath);
   }
 
-  bool writeLeafLogResult(const String& path, const char* key, const String& value) {
-    if (value.isEmpty()) return false;
-    const String normalizedPath = LogbookStore::normalizePath(path);
+  bool readEntryDocument(const String& normalizedPath, JsonDocument& doc) {
     File source = SD_MMC.open(normalizedPath, "r");
     if (!source) return false;
 
-    JsonDocument doc;
     const DeserializationError error = deserializeJson(doc, source);
     source.close();
-    if (error || !doc.is<JsonObject>()) return false;
-
-    JsonObject leafLog = doc["leaf_log"].to<JsonObject>();
-    leafLog.clear();
-    leafLog[key] = value;
+    return !error && doc.is<JsonObject>();
+  }
 
+  bool replaceEntryDocument(const String& normalizedPath, const JsonDocument& doc) {
     const String tempPath = normalizedPath + ".tmp";
     const String backupPath = normalizedPath + ".bak";
     if (SD_MMC.exists(tempPath)) SD_MMC.remove(tempPath);
@@ -90,38 +88,48 @@ namespace {
       return false;
     }
     SD_MMC.remove(backupPath);
+    dir_cache::noteChanged(normalizedPath);
     return true;
   }
+
+  bool writeLeafLogResult(const String& path, const char* key, const String& value) {
+    if (value.isEmpty()) return false;
+    const String normalizedPath = LogbookStore::normalizePath(path);
+    LockGuard lock(LogbookStore::fileMutex());
+
+    JsonDocument doc;
+    if (!readEntryDocument(normalizedPath, doc)) return false;
+
+    JsonObject leafLog = doc["leaf_log"].to<JsonObject>();
+    leafLog.clear();
+    leafLog[key] = value;
+    return replaceEntryDocument(normalizedPath, doc);
+  }
 }  // namespace
 
 uint16_t LogbookStore::count() {
-  File dir = SD_MMC.open(LOGBOOK_DIR);
-  if (!dir) return 0;
-
   uint16_t entries = 0;
-  String path;
-  while (getNextLogbookPath(dir, path)) {
-    entries++;
-  }
+  forEachLogbookPath([&entries](const String&) { entries++; });
   return entries;
 }
 
-bool LogbookStore::newestEntryPath(String& path) {
-  File dir = SD_MMC.open(LOGBOOK_DIR);
-  if (!dir) return false;
+bool LogbookStore::entryPaths(std::vector<String>& paths) {
+  paths.clear();
+  return forEachLogbookPath([&paths](const String& path) { paths.push_back(path); });
+}
 
+bool LogbookStore::newestEntryPath(String& path) {
   bool found = false;
   String bestPath;
   String bestKey;
-  String candidatePath;
-  while (getNextLogbookPath(dir, candidatePath)) {
+  forEachLogbookPath([&](const String& candidatePath) {
     String candidateKey = sortKeyForPath(candidatePath);
     if (!found || candidateKey > bestKey) {
       found = true;
       bestPath = candidatePath;
       bestKey = candidateKey;
     }
-  }
+  });
 
   if (!found) return false;
   path = bestPath;
@@ -154,15 +162,11 @@ bool LogbookStore::entryPositionNewestFirst(const String& currentPath, uint16_t&
 
 bool LogbookStore::navigationForPath(const String& currentPath, LogbookNavigation& navigation) {
   navigation = LogbookNavigation();
-  File dir = SD_MMC.open(LOGBOOK_DIR);
-  if (!dir) return false;
-
   const String currentKey = sortKeyForPath(currentPath);
   uint16_t newerEntries = 0;
   String previousKey;
   String nextKey;
-  String candidatePath;
-  while (getNextLogbookPath(dir, candidatePath)) {
+  const bool listed = forEachLogbookPath([&](const String& candidatePath) {
     const String candidateKey = sortKeyForPath(candidatePath);
     navigation.total++;
     if (candidateKey == currentKey) {
@@ -179,9 +183,9 @@ bool LogbookStore::navigationForPath(const String& currentPath, LogbookNavigatio
         navigation.previousPath = candidatePath;
       }
     }
-  }
+  });
 
-  if (!navigation.found) return false;
+  if (!listed || !navigation.found) return false;
   navigation.position = newerEntries + 1;
   return true;
 }
@@ -189,15 +193,18 @@ bool LogbookStore::navigationForPath(const String& currentPath, LogbookNavigatio
 bool LogbookStore::readSummary(const String& path, LogbookEntrySummary& summary) {
   summary = LogbookEntrySummary();
   const String normalizedPath = normalizePath(path);
-  recoverAtomicResult(normalizedPath);
+  JsonDocument doc;
+  {
+    LockGuard lock(fileMutex());
+    recoverAtomicResult(normalizedPath);
 
-  File file = SD_MMC.open(normalizedPath, "r");
-  if (!file) return false;
+    File file = SD_MMC.open(normalizedPath, "r");
+    if (!file) return false;
 
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, file);
-  file.close();
-  if (error) return false;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) return false;
+  }
 
   summary.valid = true;
   summary.path = normalizedPath;
@@ -239,6 +246,16 @@ bool LogbookStore::readSummary(const String& path, LogbookEntrySummary& summary)
   summary.maxWindDirectionFromDeg = maxWind["direction_from_deg"] | 0.0f;
   summary.pathDistanceM = metrics["path_distance_m"] | 0.0f;
   summary.straightLineDistanceM = metrics["straight_line_distance_m"] | 0.0f;
+  JsonObject xc = metrics["xc"];
+  const String xcType = xc["best_type"] | "";
+  for (XcScore::Type type : {XcScore::Type::FreeFlight, XcScore::Type::FlatTriangle,
+                             XcScore::Type::FaiTriangle}) {
+    if (xcType == XcScore::typeName(type)) summary.xcType = type;
+  }
+  summary.xcValid = summary.xcType != XcScore::Type::None;
+  summary.xcFinished = String(xc["source"] | "") == "tracklog";
+  summary.xcDistanceM = xc["best_distance_m"] | 0.0f;
+  summary.xcScore = xc["best_score"] | 0.0f;
   summary.maxAccelG = metrics["max_accel_g"] | 1.0f;
   summary.minAccelG = metrics["min_accel_g"] | 1.0f;
   summary.maxTemperatureC = metrics["max_temperature_c"] | 0.0f;
@@ -266,14 +283,17 @@ bool LogbookStore::readSummary(const String& path, LogbookEntrySummary& summary)
 bool LogbookStore::classifyForLeafLog(const String& path, LeafLogCandidate& candidate) {
   candidate = LeafLogCandidate();
   candidate.logbookPath = normalizePath(path);
-  recoverAtomicResult(candidate.logbookPath);
-
-  File file = SD_MMC.open(candidate.logbookPath, "r");
-  if (!file) return false;
   JsonDocument doc;
-  const DeserializationError error = deserializeJson(doc, file);
-  file.close();
-  if (error || !doc.is<JsonObject>()) return false;
+  {
+    LockGuard lock(fileMutex());
+    recoverAtomicResult(candidate.logbookPath);
+
+    File file = SD_MMC.open(candidate.logbookPath, "r");
+    if (!file) return false;
+    const DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error || !doc.is<JsonObject>()) return false;
+  }
 
   JsonObjectConst root = doc.as<JsonObjectConst>();
   JsonObjectConst leafLog = root["leaf_log"];
@@ -311,6 +331,9 @@ bool LogbookStore::classifyForLeafLog(const String& path, LeafLogCandidate& cand
     return true;
   }
   candidate.trackFilename = filenameFromPath(candidate.trackPath);
+  // Still being logged, so not ready to upload (and its size on the card may be its reservation)
+  uint32_t written;
+  if (PreallocatedFile::writtenLength(candidate.trackPath, written)) return true;
   File trackFile = SD_MMC.open(candidate.trackPath, "r");
   if (!trackFile) {
     candidate.disposition = LeafLogCandidate::Disposition::Rejected;
@@ -339,6 +362,42 @@ bool LogbookStore::recordLeafLogRejection(const String& path, const String& reas
   return writeLeafLogResult(path, "rejected", reason);
 }
 
+bool LogbookStore::recordXcScore(const String& path, const XcScore& score) {
+  const String normalizedPath = normalizePath(path);
+  LockGuard lock(fileMutex());
+
+  JsonDocument doc;
+  if (!readEntryDocument(normalizedPath, doc)) return false;
+  writeXcScore(doc["metrics"].to<JsonObject>(), score);
+  return replaceEntryDocument(normalizedPath, doc);
+}
+
+void LogbookStore::writeXcScore(JsonObject metrics, const XcScore& score) {
+  metrics.remove("xc");
+  if (!score.valid()) return;
+
+  JsonObject xc = metrics["xc"].to<JsonObject>();
+  xc["source"] = score.finished ? "tracklog" : "in_flight";
+  xc["best_type"] = XcScore::typeName(score.bestType);
+  xc["best_score"] = score.bestScore;
+  xc["best_distance_m"] = score.bestDistanceM;
+  xc["free_distance_m"] = score.freeDistanceM;
+  xc["free_score"] = score.freeScore;
+  if (score.triangleType != XcScore::Type::None) {
+    xc["triangle_type"] = XcScore::typeName(score.triangleType);
+    xc["triangle_perimeter_m"] = score.trianglePerimeterM;
+    xc["closing_distance_m"] = score.closingDistanceM;
+    xc["triangle_score"] = score.triangleScore;
+  } else {
+    xc["triangle_type"] = nullptr;
+  }
+}
+
+SemaphoreHandle_t LogbookStore::fileMutex() {
+  static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+  return mutex;
+}
+
 const char* LogbookStore::leafLogStatusName(LeafLogFlightStatus status) {
   switch (status) {
     case LeafLogFlightStatus::NotUploaded:
@@ -371,7 +430,9 @@ bool LogbookStore::deleteEntry(const String& path) {
 
   const String normalizedPath = normalizePath(path);
   if (normalizedPath.isEmpty() || !SD_MMC.exists(normalizedPath)) return false;
-  return SD_MMC.remove(normalizedPath);
+  const bool removed = SD_MMC.remove(normalizedPath);
+  dir_cache::noteChanged(normalizedPath);
+  return removed;
 }
 
 bool LogbookStore::isLogbookJsonPath(const String& path) {
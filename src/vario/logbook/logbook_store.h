@@ -1,6 +1,12 @@
 #pragma once
 
+#include <ArduinoJson.h>
+
+#include <vector>
+
 #include "Arduino.h"
+#include "FreeRTOS.h"
+#include "logbook/xc_score.h"
 
 enum class LeafLogFlightStatus : uint8_t {
   NotApplicable,
@@ -45,6 +51,11 @@ struct LogbookEntrySummary {
   float maxWindDirectionFromDeg = 0;
   float pathDistanceM = 0;
   float straightLineDistanceM = 0;
+  bool xcValid = false;
+  bool xcFinished = false;
+  XcScore::Type xcType = XcScore::Type::None;
+  float xcDistanceM = 0;
+  float xcScore = 0;
   float maxAccelG = 1;
   float minAccelG = 1;
   float maxTemperatureC = 0;
@@ -70,6 +81,8 @@ class LogbookStore {
   static constexpr const char* directoryPath() { return "/logbook"; }
 
   static uint16_t count();
+  // Every entry's path, in directory order; false if the logbook can't be listed
+  static bool entryPaths(std::vector<String>& paths);
   static bool newestEntryPath(String& path);
   static bool previousEntryPath(const String& currentPath, String& path);
   static bool nextEntryPath(const String& currentPath, String& path);
@@ -80,6 +93,11 @@ class LogbookStore {
   static bool classifyForLeafLog(const String& path, LeafLogCandidate& candidate);
   static bool recordLeafLogFlightId(const String& path, const String& flightId);
   static bool recordLeafLogRejection(const String& path, const String& reason);
+  // Replace metrics.xc of an existing entry (the post-flight score from the tracklog)
+  static bool recordXcScore(const String& path, const XcScore& score);
+  static void writeXcScore(JsonObject metrics, const XcScore& score);
+  // Held while an existing entry is rewritten or deleted, which can happen from background tasks
+  static SemaphoreHandle_t fileMutex();
   static const char* leafLogStatusName(LeafLogFlightStatus status);
   static const char* leafLogRejectionLabel(const String& reason);
   static bool deleteEntry(const String& path);
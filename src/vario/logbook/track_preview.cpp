@@ -0,0 +1,244 @@
+#include "logbook/track_preview.h"
+
+#include <SD_MMC.h>
+#include <math.h>
+#include <algorithm>
+#include <new>
+
+#include "logbook/igc_fix.h"
+
+namespace {
+  constexpr const char* SIDECAR_SUFFIX = ".preview.json";
+  constexpr int32_t COORDINATE_SCALE = igc_fix::COORDINATE_SCALE;
+
+  struct Segment {
+    uint16_t first;
+    uint16_t last;
+    float parentImportance;
+  };
+}  // namespace
+
+void TrackPreviewBuilder::reset() {
+  count_ = 0;
+  stride_ = 1;
+  sinceLastKept_ = 0;
+  hasLast_ = false;
+}
+
+void TrackPreviewBuilder::addFix(float latDeg, float lonDeg, float altitudeM) {
+  if (!isfinite(latDeg) || !isfinite(lonDeg)) return;
+  const int16_t altitude =
+      isfinite(altitudeM) ? static_cast<int16_t>(constrain(lroundf(altitudeM), -32768L, 32767L))
+                          : 0;
+  addFixE5(static_cast<int32_t>(lroundf(latDeg * COORDINATE_SCALE)),
+           static_cast<int32_t>(lroundf(lonDeg * COORDINATE_SCALE)), altitude);
+}
+
+void TrackPreviewBuilder::addFixE5(int32_t latE5, int32_t lonE5, int16_t altitudeM) {
+  if (count_ > 0 && ++sinceLastKept_ < stride_) {
+    hasLast_ = true;
+    lastLat_ = latE5;
+    lastLon_ = lonE5;
+    lastAlt_ = altitudeM;
+    return;
+  }
+
+  sinceLastKept_ = 0;
+  hasLast_ = false;
+  if (count_ == MAX_SAMPLES) compact();
+  lat_[count_] = latE5;
+  lon_[count_] = lonE5;
+  alt_[count_] = altitudeM;
+  count_++;
+}
+
+void TrackPreviewBuilder::compact() {
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < count_; i += 2) {
+    lat_[kept] = lat_[i];
+    lon_[kept] = lon_[i];
+    alt_[kept] = alt_[i];
+    kept++;
+  }
+  count_ = kept;
+  stride_ *= 2;
+}
+
+bool TrackPreviewBuilder::rankSamples(uint16_t n, float* importance) const {
+  Segment* stack = new (std::nothrow) Segment[n];
+  if (!stack) return false;
+
+  // Flat-earth projection around the first fix is plenty for ranking points of a single flight
+  const float lonScale = cosf(latAt(0) / static_cast<float>(COORDINATE_SCALE) * DEG_TO_RAD);
+
+  for (uint16_t i = 0; i < n; i++) importance[i] = 0;
+  importance[0] = INFINITY;
+  importance[n - 1] = INFINITY;
+
+  uint16_t depth = 0;
+  stack[depth++] = {0, static_cast<uint16_t>(n - 1), INFINITY};
+  while (depth > 0) {
+    const Segment segment = stack[--depth];
+    if (segment.last - segment.first < 2) continue;
+
+    const float ax = lonAt(segment.first) * lonScale;
+    const float ay = latAt(segment.first);
+    const float dx = lonAt(segment.last) * lonScale - ax;
+    const float dy = latAt(segment.last) - ay;
+    const float lengthSquared = dx * dx + dy * dy;
+
+    float maxDistance = -1;
+    uint16_t maxIndex = segment.first + 1;
+    for (uint16_t i = segment.first + 1; i < segment.last; i++) {
+      const float px = lonAt(i) * lonScale - ax;
+      const float py = latAt(i) - ay;
+      float distance;
+      if (lengthSquared <= 0) {
+        distance = px * px + py * py;
+      } else {
+        const float t = constrain((px * dx + py * dy) / lengthSquared, 0.0f, 1.0f);
+        const float ex = px - t * dx;
+        const float ey = py - t * dy;
+        distance = ex * ex + ey * ey;
+      }
+      if (distance > maxDistance) {
+        maxDistance = distance;
+        maxIndex = i;
+      }
+    }
+
+    const float rank = min(maxDistance, segment.parentImportance);
+    importance[maxIndex] = rank;
+    stack[depth++] = {segment.first, maxIndex, rank};
+    stack[depth++] = {maxIndex, segment.last, rank};
+  }
+
+  delete[] stack;
+  return true;
+}
+
+bool TrackPreviewBuilder::writeSidecar(const String& path) const {
+  const uint16_t n = sampleCount();
+  if (n < 2) return false;
+
+  float* importance = new (std::nothrow) float[n];
+  if (!importance) return false;
+  if (!rankSamples(n, importance)) {
+    delete[] importance;
+    return false;
+  }
+
+  // Keep the MAX_POINTS most significant samples.  Ranks are clamped to their parent's, so the
+  // kept set is always a valid Douglas-Peucker simplification at some tolerance.
+  float threshold = 0;
+  uint16_t tiesAllowed = n;
+  if (n > MAX_POINTS) {
+    float* sorted = new (std::nothrow) float[n];
+    if (!sorted) {
+      delete[] importance;
+      return false;
+    }
+    std::copy(importance, importance + n, sorted);
+    std::nth_element(sorted, sorted + (MAX_POINTS - 1), sorted + n, std::greater<float>());
+    threshold = sorted[MAX_POINTS - 1];
+    delete[] sorted;
+
+    uint16_t above = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      if (importance[i] > threshold) above++;
+    }
+    tiesAllowed = MAX_POINTS - above;
+  }
+
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    if (importance[i] > threshold) {
+      kept++;
+    } else if (importance[i] == threshold && tiesAllowed > 0) {
+      tiesAllowed--;
+      kept++;
+    } else {
+      importance[i] = -1;  // dropped
+    }
+  }
+
+  const String tmpPath = path + ".tmp";
+  File file = SD_MMC.open(tmpPath, "w", true);
+  if (!file) {
+    delete[] importance;
+    return false;
+  }
+
+  char buf[48];
+  snprintf(buf, sizeof(buf), "{\"v\":1,\"scale\":%ld,\"n\":%u,\"p\":[",
+           static_cast<long>(COORDINATE_SCALE), kept);
+  file.print(buf);
+
+  bool first = true;
+  int32_t prevLat = 0;
+  int32_t prevLon = 0;
+  int32_t prevAlt = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    if (importance[i] < 0) continue;
+    const int32_t lat = latAt(i);
+    const int32_t lon = lonAt(i);
+    const int32_t alt = altAt(i);
+    snprintf(buf, sizeof(buf), "%s%ld,%ld,%ld", first ? "" : ",",
+             static_cast<long>(lat - prevLat), static_cast<long>(lon - prevLon),
+             static_cast<long>(alt - prevAlt));
+    file.print(buf);
+    first = false;
+    prevLat = lat;
+    prevLon = lon;
+    prevAlt = alt;
+  }
+  file.print("]}");
+  file.close();
+  delete[] importance;
+
+  SD_MMC.remove(path);
+  return SD_MMC.rename(tmpPath, path);
+}
+
+namespace track_preview {
+  String sidecarPathFor(const String& trackPath) {
+    if (trackPath.isEmpty()) return "";
+    String path = trackPath[0] == '/' ? trackPath : "/" + trackPath;
+    const int dot = path.lastIndexOf('.');
+    const int slash = path.lastIndexOf('/');
+    if (dot > slash) path = path.substring(0, dot);
+    return path + SIDECAR_SUFFIX;
+  }
+
+  bool ensureSidecar(const String& trackPath) {
+    const String sidecarPath = sidecarPathFor(trackPath);
+    if (sidecarPath.isEmpty()) return false;
+    if (SD_MMC.exists(sidecarPath)) return true;
+
+    TrackPreviewBuilder* builder = new (std::nothrow) TrackPreviewBuilder();
+    if (!builder) return false;
+    builder->reset();
+
+    const bool read = igc_fix::forEachFix(
+        trackPath,
+        [](const IgcFix& fix, void* context) {
+          static_cast<TrackPreviewBuilder*>(context)->addFixE5(fix.latE5, fix.lonE5,
+                                                               fix.altitudeM);
+        },
+        builder);
+    if (!read) {
+      delete builder;
+      return false;
+    }
+
+    const bool written = builder->writeSidecar(sidecarPath);
+    delete builder;
+    return written;
+  }
+
+  bool removeSidecar(const String& trackPath) {
+    const String sidecarPath = sidecarPathFor(trackPath);
+    if (sidecarPath.isEmpty() || !SD_MMC.exists(sidecarPath)) return true;
+    return SD_MMC.remove(sidecarPath);
+  }
+}  // namespace track_preview
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Arduino.h"
+
+// A track preview is a small, decimated copy of a flight's tracklog that the web app can draw
+// without downloading and parsing the whole IGC file.  It is stored as a JSON sidecar next to the
+// track (/tracks/<name>.preview.json) and looks like:
+//
+//   {"v":1,"scale":100000,"n":3,"p":[lat0,lon0,alt0,dLat1,dLon1,dAlt1,dLat2,dLon2,dAlt2]}
+//
+// The first point is absolute (degrees * scale, altitude in m) and every following point is the
+// delta from the one before it, which keeps the numbers short for the slow softAP link.
+
+// Collects fixes with bounded memory and reduces them to at most MAX_POINTS with
+// Douglas-Peucker when the preview is written.
+class TrackPreviewBuilder {
+ public:
+  // Fixes retained while collecting.  When full, every other sample is dropped and the sampling
+  // stride doubles, so a flight of any length fits.
+  static constexpr uint16_t MAX_SAMPLES = 512;
+  // Points in a finished preview.
+  static constexpr uint16_t MAX_POINTS = 300;
+
+  void reset();
+  void addFix(float latDeg, float lonDeg, float altitudeM);
+  void addFixE5(int32_t latE5, int32_t lonE5, int16_t altitudeM);
+
+  // Decimate the collected fixes and write them to path.  Returns false when there are fewer than
+  // two fixes or the file could not be written.
+  bool writeSidecar(const String& path) const;
+
+  uint16_t sampleCount() const { return count_ + (hasLast_ ? 1 : 0); }
+
+ private:
+  void compact();
+  // Fill `importance` with each sample's Douglas-Peucker deviation (squared, in projected units),
+  // clamped so a point is never more important than the segment it was split from.
+  bool rankSamples(uint16_t n, float* importance) const;
+
+  // Sample i of sampleCount(), with the trailing fix after the stored samples
+  int32_t latAt(uint16_t i) const { return i < count_ ? lat_[i] : lastLat_; }
+  int32_t lonAt(uint16_t i) const { return i < count_ ? lon_[i] : lastLon_; }
+  int16_t altAt(uint16_t i) const { return i < count_ ? alt_[i] : lastAlt_; }
+
+  int32_t lat_[MAX_SAMPLES];
+  int32_t lon_[MAX_SAMPLES];
+  int16_t alt_[MAX_SAMPLES];
+  uint16_t count_ = 0;
+  uint16_t stride_ = 1;
+  uint16_t sinceLastKept_ = 0;
+
+  // Most recent fix that fell between stride samples, so the preview always ends where the
+  // flight did.
+  bool hasLast_ = false;
+  int32_t lastLat_ = 0;
+  int32_t lastLon_ = 0;
+  int16_t lastAlt_ = 0;
+};
+
+namespace track_preview {
+  // "/tracks/2024-12-10-XLF-000-01.igc" -> "/tracks/2024-12-10-XLF-000-01.preview.json"
+  String sidecarPathFor(const String& trackPath);
+
+  // Build the sidecar from an existing IGC file (flights recorded before previews existed, or
+  // whose sidecar was lost).  Returns true if a sidecar exists afterwards.
+  bool ensureSidecar(const String& trackPath);
+
+  bool removeSidecar(const String& trackPath);
+}  // namespace track_preview
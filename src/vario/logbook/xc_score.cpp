@@ -0,0 +1,444 @@
+#include "logbook/xc_score.h"
+
+#include <math.h>
+#include <string.h>
+#include <new>
+
+namespace {
+  constexpr double EARTH_RADIUS_M = 6371000.0;  // FAI sphere
+  constexpr float METERS_PER_E5 = EARTH_RADIUS_M * PI / 180.0 / 100000.0;
+
+  constexpr float MAX_CLOSING_FRACTION = 0.2f;
+  constexpr float FAI_MIN_LEG_FRACTION = 0.28f;
+
+  // Value of a triangle with the given legs and closing distance, or a negative number if it does
+  // not close.  `type` is set to the best triangle type it qualifies for.
+  float triangleValue(float ab, float bc, float ca, float closing, XcScore::Type& type) {
+    const float perimeter = ab + bc + ca;
+    if (perimeter <= 0 || closing > MAX_CLOSING_FRACTION * perimeter) return -1;
+    const float minLeg = min(ab, min(bc, ca));
+    type = minLeg >= FAI_MIN_LEG_FRACTION * perimeter ? XcScore::Type::FaiTriangle
+                                                       : XcScore::Type::FlatTriangle;
+    return (perimeter - closing) * XcScore::multiplier(type);
+  }
+
+  double greatCircleM(int32_t lat1E5, int32_t lon1E5, int32_t lat2E5, int32_t lon2E5) {
+    constexpr double E5_TO_RAD = PI / 180.0 / 100000.0;
+    const double lat1 = lat1E5 * E5_TO_RAD;
+    const double lat2 = lat2E5 * E5_TO_RAD;
+    const double sinDLat = sin((lat2 - lat1) / 2);
+    const double sinDLon = sin((lon2E5 - lon1E5) * E5_TO_RAD / 2);
+    const double h = sinDLat * sinDLat + cos(lat1) * cos(lat2) * sinDLon * sinDLon;
+    return 2 * EARTH_RADIUS_M * asin(sqrt(min(h, 1.0)));
+  }
+}  // namespace
+
+const char* XcScore::typeName(Type type) {
+  switch (type) {
+    case Type::FreeFlight:
+      return "free_flight";
+    case Type::FlatTriangle:
+      return "flat_triangle";
+    case Type::FaiTriangle:
+      return "fai_triangle";
+    case Type::None:
+    default:
+      return "none";
+  }
+}
+
+float XcScore::multiplier(Type type) {
+  switch (type) {
+    case Type::FreeFlight:
+      return 1.0f;
+    case Type::FlatTriangle:
+      return 1.2f;
+    case Type::FaiTriangle:
+      return 1.4f;
+    case Type::None:
+    default:
+      return 0;
+  }
+}
+
+bool XcScorer::begin(uint16_t capacity, uint32_t expectedFixes) {
+  end();
+  if (capacity < 3) return false;
+  if (expectedFixes > capacity) stride_ = (expectedFixes + capacity - 2) / (capacity - 1);
+
+  candidates_ = new (std::nothrow) Candidate[capacity];
+  snapshot_ = new (std::nothrow) Candidate[capacity];
+  rows_ = new (std::nothrow) SolveRow[capacity];
+  if (!candidates_ || !snapshot_ || !rows_) {
+    end();
+    return false;
+  }
+  capacity_ = capacity;
+  return true;
+}
+
+void XcScorer::end() {
+  delete[] candidates_;
+  delete[] snapshot_;
+  delete[] rows_;
+  candidates_ = nullptr;
+  snapshot_ = nullptr;
+  rows_ = nullptr;
+  capacity_ = 0;
+  count_ = 0;
+  fixes_ = 0;
+  stride_ = 1;
+  changedSinceSnapshot_ = false;
+  hasPending_ = false;
+  solving_ = false;
+  snapshotCount_ = 0;
+  nextRow_ = 0;
+  evaluations_ = 0;
+  free_ = Route();
+  freeLength_ = 0;
+  triangle_ = Route();
+  triangleValue_ = 0;
+  triangleType_ = XcScore::Type::None;
+  result_ = XcScore();
+}
+
+void XcScorer::project(Candidate& candidate) const {
+  candidate.x = (candidate.lonE5 - originLonE5_) * metersPerLonUnit_;
+  candidate.y = (candidate.latE5 - originLatE5_) * METERS_PER_E5;
+}
+
+void XcScorer::addFix(int32_t latE5, int32_t lonE5) {
+  if (!active()) return;
+
+  if (fixes_ == 0) {
+    // A flat projection around launch is accurate to well under 1% over any paraglider flight
+    originLatE5_ = latE5;
+    originLonE5_ = lonE5;
+    metersPerLonUnit_ = METERS_PER_E5 * cosf(latE5 / 100000.0f * DEG_TO_RAD);
+  }
+
+  Candidate candidate = {latE5, lonE5, fixes_, 0, 0, INFINITY};
+  project(candidate);
+  if (fixes_++ % stride_ != 0) {
+    pending_ = candidate;
+    hasPending_ = true;
+    return;
+  }
+  admit(candidate);
+}
+
+void XcScorer::admit(const Candidate& candidate) {
+  hasPending_ = false;
+  if (count_ == capacity_) evictOne();
+  candidates_[count_++] = candidate;
+  if (count_ >= 2) updateDetour(count_ - 2);
+  changedSinceSnapshot_ = true;
+}
+
+void XcScorer::updateDetour(uint16_t index) {
+  if (index == 0 || index + 1 >= count_) {
+    candidates_[index].detour = INFINITY;  // The ends of the track are always kept
+    return;
+  }
+  const Candidate& previous = candidates_[index - 1];
+  const Candidate& current = candidates_[index];
+  const Candidate& next = candidates_[index + 1];
+  candidates_[index].detour =
+      distance(previous, current) + distance(current, next) - distance(previous, next);
+}
+
+void XcScorer::evictOne() {
+  uint16_t victim = 1;
+  for (uint16_t i = 2; i + 1 < count_; i++) {
+    if (candidates_[i].detour < candidates_[victim].detour) victim = i;
+  }
+  memmove(&candidates_[victim], &candidates_[victim + 1],
+          (count_ - victim - 1) * sizeof(Candidate));
+  count_--;
+  updateDetour(victim - 1);
+  updateDetour(victim);
+}
+
+bool XcScorer::update(uint32_t evaluationBudget) {
+  if (!active()) return false;
+  if (!solving_) {
+    if (!changedSinceSnapshot_ || count_ < 2) return false;
+    startSolve();
+  }
+  return runRows(evaluationBudget);
+}
+
+void XcScorer::solve() {
+  if (!active()) return;
+  if (hasPending_) admit(pending_);
+  if (count_ < 2) return;
+  startSolve();
+  runRows(UINT32_MAX);
+}
+
+void XcScorer::startSolve() {
+  memcpy(snapshot_, candidates_, count_ * sizeof(Candidate));
+  snapshotCount_ = count_;
+  for (uint16_t i = 0; i < snapshotCount_; i++) {
+    rows_[i].closing = INFINITY;
+    rows_[i].closingStart = 0;
+    rows_[i].closingEnd = i;
+  }
+  nextRow_ = 0;
+  rowStarted_ = false;
+  solving_ = true;
+  changedSinceSnapshot_ = false;
+}
+
+bool XcScorer::runRows(uint32_t evaluationBudget) {
+  // Free distance takes one row per candidate, then triangles one row per first vertex
+  const uint32_t totalRows = 2 * static_cast<uint32_t>(snapshotCount_);
+  sliceStart_ = evaluations_;
+  sliceBudget_ = evaluationBudget;
+  while (nextRow_ < totalRows) {
+    const bool rowDone = nextRow_ < snapshotCount_
+                             ? solveFreeRow(nextRow_)
+                             : solveTriangleRow(nextRow_ - snapshotCount_);
+    if (!rowDone) return false;
+    nextRow_++;
+    rowStarted_ = false;
+  }
+
+  finishSolve();
+  return true;
+}
+
+bool XcScorer::solveFreeRow(uint16_t j) {
+  SolveRow& row = rows_[j];
+  if (!rowStarted_) {
+    for (uint8_t legs = 0; legs < 4; legs++) {
+      row.free[legs] = -1;
+      row.freeFrom[legs] = j;
+    }
+    rowCursor_ = 0;
+    rowStarted_ = true;
+  }
+
+  const Candidate& end = snapshot_[j];
+  for (; rowCursor_ < j; rowCursor_++) {
+    if (sliceSpent()) return false;
+    const uint16_t i = rowCursor_;
+    const float leg = distance(snapshot_[i], end);
+    if (leg > row.free[0]) {
+      row.free[0] = leg;
+      row.freeFrom[0] = i;
+    }
+    for (uint8_t legs = 1; legs < 4; legs++) {
+      if (rows_[i].free[legs - 1] < 0) continue;
+      const float length = rows_[i].free[legs - 1] + leg;
+      if (length > row.free[legs]) {
+        row.free[legs] = length;
+        row.freeFrom[legs] = i;
+      }
+    }
+  }
+  return true;
+}
+
+bool XcScorer::solveTriangleRow(uint16_t a) {
+  const uint16_t n = snapshotCount_;
+  if (a + 2 >= n) return true;
+
+  const Candidate& vertexA = snapshot_[a];
+  if (!rowStarted_) {
+    rowCursor_ = a + 1;
+    rowPairsStarted_ = false;
+    rowStarted_ = true;
+  }
+
+  if (!rowPairsStarted_) {
+    for (; rowCursor_ < n; rowCursor_++) {
+      if (sliceSpent()) return false;
+      rows_[rowCursor_].fromA = distance(vertexA, snapshot_[rowCursor_]);
+    }
+
+    // Closing start s <= a and end e >= c: fold in s = a by taking, for every c, the nearest
+    // point to a at or after c.
+    float nearest = INFINITY;
+    uint16_t nearestIndex = n - 1;
+    for (uint16_t c = n - 1; c > a; c--) {
+      if (rows_[c].fromA < nearest) {
+        nearest = rows_[c].fromA;
+        nearestIndex = c;
+      }
+      if (nearest < rows_[c].closing) {
+        rows_[c].closing = nearest;
+        rows_[c].closingStart = a;
+        rows_[c].closingEnd = nearestIndex;
+      }
+    }
+    rowCursor_ = a + 2;
+    rowInner_ = a + 1;
+    rowPairsStarted_ = true;
+  }
+
+  const float bestMultiplier = XcScore::multiplier(XcScore::Type::FaiTriangle);
+  for (; rowCursor_ < n; rowCursor_++, rowInner_ = a + 1) {
+    const uint16_t c = rowCursor_;
+    const float closing = rows_[c].closing;
+    const float ca = rows_[c].fromA;
+    const Candidate& vertexC = snapshot_[c];
+    for (; rowInner_ < c; rowInner_++) {
+      if (sliceSpent()) return false;
+      const uint16_t b = rowInner_;
+      const float ab = rows_[b].fromA;
+      // bc <= ab + ca, so the perimeter is at most twice that: skip anything that can't close or
+      // can't beat the best triangle even as an FAI.
+      const float maxPerimeter = 2 * (ab + ca);
+      if (closing > MAX_CLOSING_FRACTION * maxPerimeter) continue;
+      if ((maxPerimeter - closing) * bestMultiplier <= triangleValue_) continue;
+
+      XcScore::Type type;
+      const float value = triangleValue(ab, distance(snapshot_[b], vertexC), ca, closing, type);
+      if (value <= triangleValue_) continue;
+      triangleValue_ = value;
+      triangleType_ = type;
+      triangle_.points[0] = vertexA;
+      triangle_.points[1] = snapshot_[b];
+      triangle_.points[2] = vertexC;
+      triangle_.points[3] = snapshot_[rows_[c].closingStart];
+      triangle_.points[4] = snapshot_[rows_[c].closingEnd];
+      triangle_.valid = true;
+    }
+  }
+  return true;
+}
+
+void XcScorer::finishSolve() {
+  solving_ = false;
+
+  float bestLength = -1;
+  uint16_t bestEnd = 0;
+  uint8_t bestLegs = 0;
+  for (uint16_t j = 0; j < snapshotCount_; j++) {
+    for (uint8_t legs = 0; legs < 4; legs++) {
+      if (rows_[j].free[legs] > bestLength) {
+        bestLength = rows_[j].free[legs];
+        bestEnd = j;
+        bestLegs = legs;
+      }
+    }
+  }
+
+  if (bestLength > freeLength_) {
+    // Walk back from the finish; shorter routes repeat the start so there are always five points
+    uint16_t index = bestEnd;
+    int8_t slot = 4;
+    for (int8_t legs = bestLegs; legs >= 0; legs--) {
+      free_.points[slot--] = snapshot_[index];
+      index = rows_[index].freeFrom[legs];
+    }
+    while (slot >= 0) free_.points[slot--] = snapshot_[index];
+    free_.valid = true;
+    freeLength_ = bestLength;
+  }
+
+  publish();
+}
+
+void XcScorer::beginRefinement() {
+  if (solving_) runRows(UINT32_MAX);
+  refineSequence_ = 0;
+}
+
+void XcScorer::refineFix(int32_t latE5, int32_t lonE5) {
+  if (!active() || fixes_ == 0) return;
+  Candidate fix = {latE5, lonE5, refineSequence_++, 0, 0, 0};
+  project(fix);
+  if (free_.valid) refineFreeRoute(fix);
+  if (triangle_.valid) refineTriangleRoute(fix);
+}
+
+void XcScorer::finishRefinement() { publish(); }
+
+void XcScorer::refineFreeRoute(const Candidate& fix) {
+  Candidate* points = free_.points;
+  for (uint8_t k = 0; k < 5; k++) {
+    if (k > 0 && fix.sequence < points[k - 1].sequence) continue;
+    if (k < 4 && fix.sequence > points[k + 1].sequence) continue;
+
+    float before = 0;
+    float after = 0;
+    if (k > 0) {
+      before -= distance(points[k - 1], points[k]);
+      after += distance(points[k - 1], fix);
+    }
+    if (k < 4) {
+      before -= distance(points[k], points[k + 1]);
+      after += distance(fix, points[k + 1]);
+    }
+    const float gain = after + before;
+    if (gain > 0) {
+      points[k] = fix;
+      freeLength_ += gain;
+    }
+  }
+}
+
+void XcScorer::refineTriangleRoute(const Candidate& fix) {
+  // Roles in track order: closing start <= A < B < C <= closing end
+  static constexpr uint8_t ORDER[5] = {3, 0, 1, 2, 4};
+
+  for (uint8_t position = 0; position < 5; position++) {
+    Candidate trial[5];
+    memcpy(trial, triangle_.points, sizeof(trial));
+    trial[ORDER[position]] = fix;
+
+    bool ordered = true;
+    for (uint8_t i = 1; i < 5 && ordered; i++) {
+      const uint32_t previous = trial[ORDER[i - 1]].sequence;
+      const uint32_t current = trial[ORDER[i]].sequence;
+      ordered = (i == 1 || i == 4) ? previous <= current : previous < current;
+    }
+    if (!ordered) continue;
+
+    XcScore::Type type;
+    const float value =
+        triangleValue(distance(trial[0], trial[1]), distance(trial[1], trial[2]),
+                      distance(trial[2], trial[0]), distance(trial[3], trial[4]), type);
+    if (value > triangleValue_) {
+      memcpy(triangle_.points, trial, sizeof(trial));
+      triangleValue_ = value;
+      triangleType_ = type;
+    }
+  }
+}
+
+void XcScorer::publish() {
+  result_ = XcScore();
+
+  auto legM = [](const Candidate& a, const Candidate& b) {
+    return static_cast<float>(greatCircleM(a.latE5, a.lonE5, b.latE5, b.lonE5));
+  };
+
+  if (free_.valid) {
+    for (uint8_t i = 0; i < 4; i++) {
+      result_.freeDistanceM += legM(free_.points[i], free_.points[i + 1]);
+    }
+    result_.freeScore =
+        result_.freeDistanceM / 1000 * XcScore::multiplier(XcScore::Type::FreeFlight);
+    result_.bestType = XcScore::Type::FreeFlight;
+    result_.bestDistanceM = result_.freeDistanceM;
+    result_.bestScore = result_.freeScore;
+  }
+
+  if (triangle_.valid) {
+    const Candidate* points = triangle_.points;
+    result_.triangleType = triangleType_;
+    result_.trianglePerimeterM = legM(points[0], points[1]) + legM(points[1], points[2]) +
+                                 legM(points[2], points[0]);
+    result_.closingDistanceM = legM(points[3], points[4]);
+    const float scoredM = max(0.0f, result_.trianglePerimeterM - result_.closingDistanceM);
+    result_.triangleScore = scoredM / 1000 * XcScore::multiplier(triangleType_);
+    if (result_.triangleScore > result_.bestScore) {
+      result_.bestType = triangleType_;
+      result_.bestDistanceM = scoredM;
+      result_.bestScore = result_.triangleScore;
+    }
+  }
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Cross-country scoring in the style of XContest / OLC:
+//   - free flight: start, up to three turnpoints and finish anywhere on the track, 1.0 point/km
+//   - flat triangle: three turnpoints, closed to within 20% of the perimeter, 1.2 points/km
+//   - FAI triangle: as flat, but every leg is at least 28% of the perimeter, 1.4 points/km
+// A triangle scores its perimeter minus the closing distance (the gap between the closest pair
+// of track points before the first and after the last turnpoint).
+
+struct XcScore {
+  enum class Type : uint8_t { None, FreeFlight, FlatTriangle, FaiTriangle };
+
+  static const char* typeName(Type type);  // "free_flight", "flat_triangle", "fai_triangle"
+  static float multiplier(Type type);
+
+  bool valid() const { return bestType != Type::None; }
+
+  float freeDistanceM = 0;
+  float freeScore = 0;
+
+  Type triangleType = Type::None;
+  float trianglePerimeterM = 0;
+  float closingDistanceM = 0;
+  float triangleScore = 0;
+
+  Type bestType = Type::None;
+  float bestDistanceM = 0;  // Distance that was scored (triangle: perimeter - closing)
+  float bestScore = 0;
+
+  // False for the in-flight estimate; true once the finished tracklog has been scored.
+  bool finished = false;
+};
+
+// Scores a track from a bounded set of candidate turnpoints.
+//
+// Fixes are fed in flight order.  Once the set is full, each new fix evicts the interior
+// candidate whose removal shortens the candidate path the least, so memory stays fixed while the
+// points that matter for distance (the far corners of the flight) survive.
+//
+// Solving is O(n^3) in the candidate count, so in flight it runs on a snapshot of the candidates
+// a bounded slice at a time (update()), and the result only ever improves: every turnpoint that
+// was scored was really flown through, even if it has since been evicted.  When the flight is
+// over, a larger set is solved to completion and then refined against every fix of the
+// tracklog (beginRefinement() / refineFix() / finishRefinement()).
+class XcScorer {
+ public:
+  static constexpr uint16_t IN_FLIGHT_CANDIDATES = 64;
+  static constexpr uint16_t FINAL_CANDIDATES = 192;
+
+  XcScorer() = default;
+  ~XcScorer() { end(); }
+  XcScorer(const XcScorer&) = delete;
+  XcScorer& operator=(const XcScorer&) = delete;
+
+  // Allocate room for `capacity` candidates and forget any previous track.  Returns false if
+  // memory is not available.  When the length of the track is known up front (scoring a finished
+  // tracklog), pass it as `expectedFixes` and candidates are sampled evenly along the track
+  // instead, which keeps the dense areas (thermals, launch) that triangle closing depends on.
+  bool begin(uint16_t capacity, uint32_t expectedFixes = 0);
+  void end();
+  bool active() const { return capacity_ > 0; }
+
+  void addFix(int32_t latE5, int32_t lonE5);
+
+  // Do at most `evaluationBudget` distance evaluations of solving work, starting a new solve on
+  // the current candidates if none is in progress; a slice can end partway through a row.
+  // Returns true when a solve finished and result() may have changed.
+  bool update(uint32_t evaluationBudget);
+
+  // Run a complete solve on the current candidates.
+  void solve();
+
+  // Feed every fix of the track again, in order, to move the scored turnpoints onto the exact
+  // fixes that maximize the score.  Each pass can only improve the result.
+  void beginRefinement();
+  void refineFix(int32_t latE5, int32_t lonE5);
+  void finishRefinement();
+
+  const XcScore& result() const { return result_; }
+  uint16_t candidateCount() const { return count_; }
+  uint32_t fixCount() const { return fixes_; }
+  // Distance evaluations done so far (for measuring the cost of a solve)
+  uint32_t evaluations() const { return evaluations_; }
+
+ private:
+  struct Candidate {
+    int32_t latE5;
+    int32_t lonE5;
+    uint32_t sequence;  // Index of the fix in the track
+    float x;            // Local projection, m
+    float y;
+    float detour;  // Path length lost if this candidate is evicted
+  };
+
+  // Working state for one solve, per snapshot index
+  struct SolveRow {
+    float free[4];  // Longest path ending here with 1..4 legs
+    uint16_t freeFrom[4];
+    float closing;  // Best closing distance so far for a triangle whose last vertex is here
+    uint16_t closingStart;
+    uint16_t closingEnd;
+    float fromA;  // Distance from the current first vertex
+  };
+
+  // A scored route as track points, so it survives the candidates it was found among
+  struct Route {
+    Candidate points[5];  // Free: start, 3 turnpoints, finish.  Triangle: A, B, C, close start/end
+    bool valid = false;
+  };
+
+  void project(Candidate& candidate) const;
+  float distance(const Candidate& a, const Candidate& b) {
+    evaluations_++;
+    return hypotf(a.x - b.x, a.y - b.y);
+  }
+  void admit(const Candidate& candidate);
+  void updateDetour(uint16_t index);
+  void evictOne();
+
+  void startSolve();
+  bool runRows(uint32_t evaluationBudget);
+  // Each returns false if the slice's budget ran out partway; the next slice resumes the row
+  bool solveFreeRow(uint16_t j);
+  bool solveTriangleRow(uint16_t a);
+  bool sliceSpent() const { return evaluations_ - sliceStart_ >= sliceBudget_; }
+  void finishSolve();
+  void refineFreeRoute(const Candidate& fix);
+  void refineTriangleRoute(const Candidate& fix);
+  void publish();
+
+  Candidate* candidates_ = nullptr;
+  Candidate* snapshot_ = nullptr;
+  SolveRow* rows_ = nullptr;
+  uint16_t capacity_ = 0;
+  uint16_t count_ = 0;
+  uint32_t fixes_ = 0;
+  uint32_t stride_ = 1;
+  bool changedSinceSnapshot_ = false;
+
+  // Latest fix skipped by the stride, admitted before solving so the track's end is included
+  bool hasPending_ = false;
+  Candidate pending_;
+
+  // Projection origin (first fix)
+  int32_t originLatE5_ = 0;
+  int32_t originLonE5_ = 0;
+  float metersPerLonUnit_ = 0;
+
+  bool solving_ = false;
+  uint16_t snapshotCount_ = 0;
+  uint32_t nextRow_ = 0;
+  // Where the current row stopped, so a slice can end between any two evaluations
+  bool rowStarted_ = false;
+  bool rowPairsStarted_ = false;  // Triangle row: distances from A done, now pairs (B, C)
+  uint16_t rowCursor_ = 0;        // Free row: next start; triangle row: next from-A point or C
+  uint16_t rowInner_ = 0;         // Triangle row: next B
+  uint32_t sliceStart_ = 0;
+  uint32_t sliceBudget_ = 0;
+  uint32_t evaluations_ = 0;
+
+  // Best routes found (in projected metres) and their published great-circle score
+  Route free_;
+  float freeLength_ = 0;
+  Route triangle_;
+  float triangleValue_ = 0;  // Projected score
+  XcScore::Type triangleType_ = XcScore::Type::None;
+  XcScore result_;
+
+  uint32_t refineSequence_ = 0;
+};
@@ -0,0 +1,120 @@
+#include "logbook/xc_score_task.h"
+
+#include <new>
+
+#include "FreeRTOS.h"
+#include "diagnostics/heap_monitor.h"
+#include "logbook/igc_fix.h"
+#include "logbook/logbook_store.h"
+
+namespace {
+  constexpr uint32_t TASK_STACK_BYTES = 6144;
+  constexpr UBaseType_t TASK_PRIORITY = 1;  // Below everything the pilot is looking at
+  constexpr uint8_t REFINEMENT_PASSES = 2;
+
+  struct Job {
+    String logbookPath;
+    String trackPath;
+    XcScorer* inFlight;
+  };
+
+  volatile bool running_ = false;
+  volatile uint32_t completed_ = 0;
+
+  void scoreTask(void* parameter) {
+    Job* job = static_cast<Job*>(parameter);
+
+    XcScore score;
+    bool scored;
+    if (!job->trackPath.isEmpty()) {
+      // The tracklog is scored with more candidates; free the in-flight ones first
+      delete job->inFlight;
+      job->inFlight = nullptr;
+      scored = xc_score_task::scoreTrackFile(job->trackPath, score);
+    } else {
+      job->inFlight->solve();
+      score = job->inFlight->result();
+      scored = score.valid();
+    }
+    if (scored && LogbookStore::recordXcScore(job->logbookPath, score)) {
+      completed_ = completed_ + 1;
+    } else {
+      Serial.println("XC score: could not score " + job->logbookPath);
+    }
+    delete job->inFlight;
+    delete job;
+
+    heap_monitor::checkpoint("xc-score-task-done");
+    running_ = false;
+    vTaskDelete(NULL);
+  }
+}  // namespace
+
+namespace xc_score_task {
+  bool start(const String& logbookPath, const String& trackPath, XcScorer* inFlight) {
+    if (running_ || logbookPath.isEmpty() || (trackPath.isEmpty() && inFlight == nullptr)) {
+      delete inFlight;
+      return false;
+    }
+
+    Job* job = new (std::nothrow) Job{logbookPath, trackPath, inFlight};
+    if (!job) {
+      delete inFlight;
+      return false;
+    }
+
+    running_ = true;
+    TaskHandle_t handle = NULL;
+    if (xTaskCreate(scoreTask, "XcScore", TASK_STACK_BYTES, job, TASK_PRIORITY, &handle) !=
+        pdPASS) {
+      running_ = false;
+      delete job->inFlight;
+      delete job;
+      return false;
+    }
+    heap_monitor::checkpoint("xc-score-task");
+    return true;
+  }
+
+  bool running() { return running_; }
+
+  uint32_t completedCount() { return completed_; }
+
+  bool scoreTrackFile(const String& trackPath, XcScore& score) {
+    // Count the fixes first so candidates can be spread evenly over the whole flight
+    uint32_t fixCount = 0;
+    if (!igc_fix::forEachFix(
+            trackPath,
+            [](const IgcFix&, void* context) { (*static_cast<uint32_t*>(context))++; },
+            &fixCount) ||
+        fixCount < 2) {
+      return false;
+    }
+
+    XcScorer scorer;
+    if (!scorer.begin(XcScorer::FINAL_CANDIDATES, fixCount)) return false;
+
+    igc_fix::forEachFix(
+        trackPath,
+        [](const IgcFix& fix, void* context) {
+          static_cast<XcScorer*>(context)->addFix(fix.latE5, fix.lonE5);
+        },
+        &scorer);
+    scorer.solve();
+
+    for (uint8_t pass = 0; pass < REFINEMENT_PASSES; pass++) {
+      scorer.beginRefinement();
+      igc_fix::forEachFix(
+          trackPath,
+          [](const IgcFix& fix, void* context) {
+            static_cast<XcScorer*>(context)->refineFix(fix.latE5, fix.lonE5);
+          },
+          &scorer);
+      scorer.finishRefinement();
+    }
+
+    score = scorer.result();
+    score.finished = true;
+    return score.valid();
+  }
+}  // namespace xc_score_task
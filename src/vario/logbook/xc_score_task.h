@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Arduino.h"
+#include "logbook/xc_score.h"
+
+// Scores a finished flight in a low-priority background task and stores the result in the flight's
+// logbook entry (replacing the in-flight estimate written at landing).  The flight is scored from
+// its IGC tracklog when it has one, and otherwise by finishing the in-flight scorer's solve.
+namespace xc_score_task {
+  // trackPath is empty if the flight has no IGC tracklog.  Takes ownership of inFlight (which may
+  // be null) whether or not the task starts.  Returns false if the task could not be started
+  // (another flight is still being scored, nothing to score, or no memory); the entry then keeps
+  // its in-flight score.
+  bool start(const String& logbookPath, const String& trackPath, XcScorer* inFlight);
+
+  bool running();
+
+  // Increments each time an entry has been updated, so open pages know to re-read it
+  uint32_t completedCount();
+
+  // Score an IGC file synchronously (what the task runs)
+  bool scoreTrackFile(const String& trackPath, XcScore& score);
+}  // namespace xc_score_task
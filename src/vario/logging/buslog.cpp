@@ -5,6 +5,7 @@
 
 #include "instruments/gps.h"
 #include "storage/sd_card.h"
+#include "storage/sd_latency.h"
 #include "system/version_info.h"
 #include "ui/settings/settings.h"
 #include "utils/string_utils.h"
@@ -14,6 +15,10 @@ BusLogger busLog;
 namespace {
   constexpr char* BUSLOG_PATH = "/buslogs";
   constexpr char* BUSLOG_EXTENSION = ".log";
+
+  // A bus log with every sensor running is several megabytes an hour; longer logs grow as they are
+  // written
+  constexpr uint32_t BUSLOG_RESERVE_BYTES = 16 * 1024 * 1024;
 }  // namespace
 
 String BusLogger::desiredFileName() const {
@@ -49,7 +54,7 @@ bool BusLogger::startLog() {
     } while (SD_MMC.exists(fileName));
   }
 
-  file_ = SD_MMC.open(fileName, "w", true);
+  file_ = logFile_.open(fileName, BUSLOG_RESERVE_BYTES);
   if (!file_) {
     Serial.println("BusLogger::startLog failed: couldn't open" + fileName);
     return false;
@@ -58,7 +63,7 @@ bool BusLogger::startLog() {
   bus_->unsubscribe(*this);  // Make sure we don't double-subscribe
   if (!bus_->subscribe(*this)) {
     Serial.println("BusLogger::startLog failed: subscribe to bus");
-    file_.close();
+    logFile_.close();
     return false;
   }
 
@@ -71,35 +76,41 @@ bool BusLogger::startLog() {
 
 void BusLogger::on_receive(const AmbientUpdate& msg) {
   if (!file_) return;
+  sd_latency::Timer timer(sd_latency::Op::Write);
   file_.printf("A%d,%f,%f\n", millis() - tStart_, msg.temperature, msg.relativeHumidity);
 }
 
 void BusLogger::on_receive(const CommentMessage& msg) {
   if (!file_) return;
+  sd_latency::Timer timer(sd_latency::Op::Write);
   file_.printf("#%d,%s\n", millis() - tStart_, msg.message);
 }
 
 void BusLogger::on_receive(const GpsMessage& msg) {
   if (!file_) return;
+  sd_latency::Timer timer(sd_latency::Op::Write);
   file_.printf("G%d,%s\n", millis() - tStart_, msg.nmea.c_str());
 }
 
 void BusLogger::on_receive(const MotionUpdate& msg) {
   if (!file_) return;
+  sd_latency::Timer timer(sd_latency::Op::Write);
   file_.printf("M%d,%s,%g,%g,%g,%s,%g,%g,%g\n", msg.t - tStart_, msg.hasAcceleration ? "A" : "a",
                msg.ax, msg.ay, msg.az, msg.hasOrientation ? "Q" : "q", msg.qx, msg.qy, msg.qz);
 }
 
 void BusLogger::on_receive(const PressureUpdate& msg) {
   if (!file_) return;
-  file_.printf("P%d,%d\n", msg.t - tStart_, msg.pressure);
+  {
+    sd_latency::Timer timer(sd_latency::Op::Write);
+    file_.printf("P%d,%d\n", msg.t - tStart_, msg.pressure);
+  }
+  logFile_.checkpoint();
 }
 
 void BusLogger::endLog() {
   if (bus_) {
     bus_->unsubscribe(*this);
   }
-  if (file_) {
-    file_.close();
-  }
+  logFile_.close();
 }
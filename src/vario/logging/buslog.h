@@ -4,6 +4,7 @@
 
 #include "dispatch/message_types.h"
 #include "logbook/flight.h"
+#include "storage/preallocated_file.h"
 
 // Logger that records messages sent to the message bus
 class BusLogger : public etl::message_router<BusLogger, AmbientUpdate, CommentMessage, GpsMessage,
@@ -26,6 +27,7 @@ class BusLogger : public etl::message_router<BusLogger, AmbientUpdate, CommentMe
   String desiredFileName() const;
 
   File file_;
+  PreallocatedFile logFile_;
   unsigned long tStart_;
   etl::imessage_bus* bus_ = nullptr;
 };
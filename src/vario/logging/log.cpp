@@ -4,6 +4,8 @@
 
 #include <Arduino.h>
 
+#include <new>
+
 #include "comms/fanet_radio.h"
 #include "instruments/ambient.h"
 #include "instruments/baro.h"
@@ -11,7 +13,10 @@
 #include "instruments/imu.h"
 #include "logbook/flight.h"
 #include "logbook/igc.h"
+#include "logbook/igc_fix.h"
 #include "logbook/logbook_entry.h"
+#include "logbook/xc_score.h"
+#include "logbook/xc_score_task.h"
 #include "navigation/gpx.h"
 #include "navigation/thermal_tracker.h"
 #include "power.h"
@@ -43,7 +48,24 @@ LogbookEntryFile logbookEntry;
 // Alert page to warn if auto-stop is about to occur
 PageAlertTimerAutoStop pageAlertTimerAutoStop;
 
+// In-flight XC score estimate; handed to the XC score task when the flight ends
+XcScorer* xcScorer = nullptr;
+
 namespace {
+  // Distance evaluations of XC solving per log tick (~1 ms on the ESP32-S3; see
+  // sim/bench/xc_score_bench.cpp)
+  constexpr uint32_t XC_EVALUATIONS_PER_TICK = 2000;
+
+  void updateXcScore() {
+    if (xcScorer == nullptr) return;
+    GPSPositionSnapshot fix;
+    if (gps.hasUsableFix() && gps.lastValidFix(fix)) {
+      xcScorer->addFix(static_cast<int32_t>(lround(fix.latitude * igc_fix::COORDINATE_SCALE)),
+                       static_cast<int32_t>(lround(fix.longitude * igc_fix::COORDINATE_SCALE)));
+    }
+    if (xcScorer->update(XC_EVALUATIONS_PER_TICK)) logbook.xc = xcScorer->result();
+  }
+
   void captureFirstGpsFixForLogbook() {
     GPSPositionSnapshot fix;
     if (!gps.lastValidFix(fix)) return;
@@ -138,13 +160,26 @@ void log_update() {
       captureFirstGpsFixForLogbook();
     }
 
-    // Generate a tracklog record.
-    if (trackLogEnabledForFlight && gps.hasUsableFix()) flight->log(logbook.duration);
+    // Tracklog records are written by log_updateTrack, once per GPS fix
     log_captureValues();      // TODO:  Update this to an "Update Flight Stats" or something
     log_checkMinMaxValues();  // TODO:  Probably rename this to be "bound Flight Stats"
+    updateXcScore();
   }
 }
 
+void log_updateTrack() {
+  // GPS time of the fix last recorded in the tracklog
+  static uint32_t lastTrackFixTime = 0;
+
+  if (!flight || !trackLogEnabledForFlight || !flight->started()) return;
+  if (!gps.hasUsableFix()) return;
+
+  const uint32_t fixTime = gps.time.value();
+  if (fixTime == lastTrackFixTime) return;
+  lastTrackFixTime = fixTime;
+  flight->log(logbook.duration);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Auto Start & Stop check functions.
 
@@ -297,6 +332,13 @@ void flightTimer_start() {
   logbook.temperature_max = logbook.temperature_min = logbook.temperature;
   logbookEntry.begin(logbook);
   trackLogEnabledForFlight = settings.log_saveTrack;
+  delete xcScorer;
+  xcScorer = new (std::nothrow) XcScorer();
+  if (xcScorer == nullptr || !xcScorer->begin(XcScorer::IN_FLIGHT_CANDIDATES)) {
+    Serial.println("XC score: no memory for in-flight scoring");
+    delete xcScorer;
+    xcScorer = nullptr;
+  }
 
   // Start the Fanet radio
   fanetRadio.begin(settings.fanet_region);
@@ -322,7 +364,14 @@ void flightTimer_stop(bool showSummary) {
   // Close the tracklog before finalizing the logbook reference to it.
   if (flight->started()) flight->end(logbook, false);
 
+  // Best XC score of the solves finished in flight for now; the rest of the scoring is left to a
+  // background task, as a complete solve here would hold up the loop
+  if (xcScorer) logbook.xc = xcScorer->result();
+
   logbookEntry.finalize(logbook, trackFormat, trackPath);
+  xc_score_task::start(logbookEntry.path(), trackFormat == "igc" ? trackPath : String(),
+                       xcScorer);
+  xcScorer = nullptr;
   if (showSummary) {
     static PageFlightSummary dialog;
     dialog.show(logbook, logbookEntry.path(), trackPath);
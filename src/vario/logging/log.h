@@ -21,6 +21,9 @@ struct Waypoint;
 
 // Main Log functions
 void log_update(void);  // Update function to run every second
+// Write a tracklog record if there is a GPS fix that has not been recorded yet.  Runs more often
+// than the GPS rate, so that at 5 or 10Hz every fix is recorded.
+void log_updateTrack(void);
 
 // Flight Timer Auto Start/Stop check functions
 bool flightTimer_autoStart(void);
@@ -18,6 +18,7 @@
 #include "navigation/gpx_parser.h"
 #include "navigation/route_store.h"
 #include "navigation/user_waypoints.h"
+#include "storage/dir_cache.h"
 #include "storage/files.h"
 #include "storage/sd_card.h"
 #include "ui/audio/sound_effects.h"
@@ -84,7 +85,9 @@ namespace {
     }
 
     SD_MMC.remove(route_store::activeRoutePath());
-    if (!SD_MMC.rename(tempPath, route_store::activeRoutePath())) {
+    const bool renamed = SD_MMC.rename(tempPath, route_store::activeRoutePath());
+    dir_cache::noteChanged(route_store::activeRoutePath());
+    if (!renamed) {
       SD_MMC.remove(tempPath);
       return false;
     }
@@ -796,7 +799,9 @@ bool Navigator::savePersistedState() {
 
 bool Navigator::clearPersistedState() {
   if (!sdcard.isMounted() || !SD_MMC.exists(route_store::activeRoutePath())) return true;
-  return SD_MMC.remove(route_store::activeRoutePath());
+  const bool removed = SD_MMC.remove(route_store::activeRoutePath());
+  dir_cache::noteChanged(route_store::activeRoutePath());
+  return removed;
 }
 
 bool Navigator::loadPersistedState() { return loadPersistedState(true); }
@@ -888,7 +893,7 @@ bool Navigator::restartLastRoute() {
   return activateRoute(lastRouteIndex_, RouteIndex(1));
 }
 
-bool gpx_readFile(fs::FS& fs, String fileName) {
+bool gpx_readFile(fs::FS& fs, String fileName, Navigator& result) {
   heap_monitor::checkpoint("gpx-read-start");
   FileReader file_reader(fs, fileName);
   if (file_reader.error() != "") {
@@ -898,55 +903,55 @@ bool gpx_readFile(fs::FS& fs, String fileName) {
     return false;
   }
 
-  navigator.clear();
+  result.clear();
   heap_monitor::checkpoint("gpx-parse-start");
 
   GPXParser parser(&file_reader);
-  bool success = parser.parse(&navigator);
+  bool success = parser.parse(&result);
   if (success) {
     Serial.println("gpx_readFile was successful:");
     Serial.print("  ");
-    Serial.print(navigator.totalWaypoints);
+    Serial.print(result.totalWaypoints);
     Serial.println(" waypoints");
-    for (uint8_t wp = 1; wp <= navigator.totalWaypoints; wp++) {
+    for (uint8_t wp = 1; wp <= result.totalWaypoints; wp++) {
       Serial.print("    ");
-      Serial.print(navigator.waypoint(WaypointID(wp)).name);
+      Serial.print(result.waypoint(WaypointID(wp)).name);
       Serial.print(" @ ");
-      Serial.print(navigator.waypoint(WaypointID(wp)).latitude());
+      Serial.print(result.waypoint(WaypointID(wp)).latitude());
       Serial.print(", ");
-      Serial.print(navigator.waypoint(WaypointID(wp)).longitude());
+      Serial.print(result.waypoint(WaypointID(wp)).longitude());
       Serial.print(", ");
-      Serial.print(navigator.waypoint(WaypointID(wp)).ele);
+      Serial.print(result.waypoint(WaypointID(wp)).ele);
       Serial.println("m");
     }
     Serial.print("  ");
-    Serial.print(navigator.totalRoutes);
+    Serial.print(result.totalRoutes);
     Serial.println(" routes");
-    for (uint8_t r = 1; r <= navigator.totalRoutes; r++) {
+    for (uint8_t r = 1; r <= result.totalRoutes; r++) {
       Serial.print("    ");
-      Serial.print(navigator.routes[r].name);
+      Serial.print(result.routes[r].name);
       Serial.print(" (");
-      Serial.print(navigator.routes[r].totalPoints);
+      Serial.print(result.routes[r].totalPoints);
       Serial.println(" points)");
-      for (uint8_t wp = 1; wp <= navigator.routes[r].totalPoints; wp++) {
+      for (uint8_t wp = 1; wp <= result.routes[r].totalPoints; wp++) {
         Serial.print("      ");
-        Serial.print(navigator.routePoint(RouteID(r), RouteIndex(wp)).name);
+        Serial.print(result.routePoint(RouteID(r), RouteIndex(wp)).name);
         Serial.print(" @ ");
-        Serial.print(navigator.routePoint(RouteID(r), RouteIndex(wp)).latitude());
+        Serial.print(result.routePoint(RouteID(r), RouteIndex(wp)).latitude());
         Serial.print(", ");
-        Serial.print(navigator.routePoint(RouteID(r), RouteIndex(wp)).longitude());
+        Serial.print(result.routePoint(RouteID(r), RouteIndex(wp)).longitude());
         Serial.print(", ");
-        Serial.print(navigator.routePoint(RouteID(r), RouteIndex(wp)).ele);
+        Serial.print(result.routePoint(RouteID(r), RouteIndex(wp)).ele);
         Serial.println("m");
       }
     }
     Serial.print("Navigator loaded ");
-    Serial.print(navigator.totalWaypoints);
+    Serial.print(result.totalWaypoints);
     Serial.print(" waypoints and ");
-    Serial.print(navigator.totalRoutes);
+    Serial.print(result.totalRoutes);
     Serial.println(" routes");
-    navigator.setLoadedGpxFilename(fileName);
-    navigator.savePersistedState();
+    result.setLoadedGpxFilename(fileName);
+    result.savePersistedState();
     heap_monitor::checkpoint("gpx-read-end");
     return true;
   } else {
@@ -958,28 +963,28 @@ bool gpx_readFile(fs::FS& fs, String fileName) {
     Serial.print(parser.col());
     Serial.print(": ");
     Serial.println(parser.error());
-    navigator.clear();
+    result.clear();
     heap_monitor::checkpoint("gpx-read-fail");
     return false;
   }
 }
 
-bool nav_readFile(fs::FS& fs, String fileName) {
+bool nav_readFile(fs::FS& fs, String fileName, Navigator& result) {
   heap_monitor::checkpoint("nav-read-start");
   const String ext = lowerExtension(fileName);
   if (ext == "gpx") {
-    return gpx_readFile(fs, fileName);
+    return gpx_readFile(fs, fileName, result);
   }
 
-  navigator.clear();
+  result.clear();
 
   bool success = false;
   if (ext == "cup") {
     heap_monitor::checkpoint("cup-parse-start");
-    success = parseCupFile(fs, fileName, &navigator);
+    success = parseCupFile(fs, fileName, &result);
   } else if (ext == "wpt" || ext == "wyp") {
     heap_monitor::checkpoint("wpt-parse-start");
-    success = parseWptFile(fs, fileName, &navigator);
+    success = parseWptFile(fs, fileName, &result);
   } else {
     Serial.print("Unsupported nav file type: ");
     Serial.println(fileName);
@@ -989,20 +994,20 @@ bool nav_readFile(fs::FS& fs, String fileName) {
 
   if (success) {
     Serial.print("Navigator loaded ");
-    Serial.print(navigator.totalWaypoints);
+    Serial.print(result.totalWaypoints);
     Serial.print(" waypoints and ");
-    Serial.print(navigator.totalRoutes);
+    Serial.print(result.totalRoutes);
     Serial.print(" routes from ");
     Serial.println(fileName);
-    navigator.setLoadedNavFilename(fileName);
-    navigator.savePersistedState();
+    result.setLoadedNavFilename(fileName);
+    result.savePersistedState();
     heap_monitor::checkpoint("nav-read-end");
     return true;
   }
 
   Serial.print("nav_readFile error parsing ");
   Serial.println(fileName);
-  navigator.clear();
+  result.clear();
   heap_monitor::checkpoint("nav-read-fail");
   return false;
 }
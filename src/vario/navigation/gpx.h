@@ -255,5 +255,6 @@ class Navigator {
 };
 extern Navigator navigator;
 
-bool gpx_readFile(fs::FS& fs, String fileName);
-bool nav_readFile(fs::FS& fs, String fileName);
+// Load a waypoint file into result, replacing whatever it held
+bool gpx_readFile(fs::FS& fs, String fileName, Navigator& result = navigator);
+bool nav_readFile(fs::FS& fs, String fileName, Navigator& result = navigator);
@@ -8,6 +8,7 @@
 
 #include "diagnostics/heap_monitor.h"
 #include "navigation/gpx.h"
+#include "storage/dir_cache.h"
 
 namespace route_store {
   namespace {
@@ -372,9 +373,11 @@ namespace route_store {
       if (!SD_MMC.rename(ROUTE_TEMP_FILE, path)) {
         if (hadExisting) SD_MMC.rename(ROUTE_BACKUP_FILE, path);
         SD_MMC.remove(ROUTE_TEMP_FILE);
+        dir_cache::noteChanged(path);
         return false;
       }
       if (hadExisting) SD_MMC.remove(ROUTE_BACKUP_FILE);
+      dir_cache::noteChanged(path);
       return true;
     }
 
@@ -386,8 +389,9 @@ namespace route_store {
       return writeJsonFile(activeRoutePath(), doc);
     }
 
-    bool loadNormalizedRoute(JsonDocument& doc, const String& path, bool activate) {
-      navigator.clear();
+    bool loadNormalizedRoute(Navigator& target, JsonDocument& doc, const String& path,
+                             bool activate) {
+      target.clear();
 
       const char* schema = doc["schema"] | "";
       if (strcmp(schema, "leaf.route") != 0) return false;
@@ -409,8 +413,8 @@ namespace route_store {
       JsonObjectConst start = doc["start"].as<JsonObjectConst>();
       route.startType = startTypeFromName(start["type"] | "none");
 
-      navigator.routes[1] = route;
-      navigator.totalRoutes = 1;
+      target.routes[1] = route;
+      target.totalRoutes = 1;
 
       for (JsonObjectConst point : points) {
         Waypoint waypoint;
@@ -419,25 +423,25 @@ namespace route_store {
         waypoint.setLongitude(point["lon"] | 0.0);
         waypoint.ele = point["alt_m"] | 0.0;
 
-        WaypointID waypointIndex = navigator.addWaypoint(waypoint)
-                                       ? WaypointID(navigator.totalWaypoints)
+        WaypointID waypointIndex = target.addWaypoint(waypoint)
+                                       ? WaypointID(target.totalWaypoints)
                                        : WaypointID::None;
         if (!waypointIndex) return false;
 
         const uint16_t radiusM = point["radius_m"] | defaultWaypointRadius;
         const RoutePointRole role = roleFromName(point["role"] | "normal");
-        if (!navigator.addRoutePoint(&navigator.routes[1], waypointIndex, radiusM, role))
+        if (!target.addRoutePoint(&target.routes[1], waypointIndex, radiusM, role))
           return false;
       }
 
-      navigator.setLoadedSavedRouteFilename(path);
-      if (activate) navigator.activateRoute(RouteID(1));
+      target.setLoadedSavedRouteFilename(path);
+      if (activate) target.activateRoute(RouteID(1));
       return true;
     }
   }  // namespace
 
   bool importRouteText(const String& name, const String& data, bool activate,
-                       ImportResult& result) {
+                       ImportResult& result, Navigator& target) {
     heap_monitor::checkpoint("route-import-text");
     result = ImportResult();
 
@@ -461,7 +465,7 @@ namespace route_store {
     result.ok = true;
 
     if (activate) {
-      if (!saveActiveRoutePointer(path) || !loadNormalizedRoute(routeDoc, path, true)) {
+      if (!saveActiveRoutePointer(path) || !loadNormalizedRoute(target, routeDoc, path, true)) {
         result.error = routeError("Route was saved but could not be activated.");
         heap_monitor::checkpoint("route-import-act-fail");
         return false;
@@ -473,7 +477,8 @@ namespace route_store {
     return true;
   }
 
-  bool saveRouteJson(JsonDocument& routeDoc, bool activate, ImportResult& result) {
+  bool saveRouteJson(JsonDocument& routeDoc, bool activate, ImportResult& result,
+                     Navigator& target) {
     heap_monitor::checkpoint("route-save-json");
     result = ImportResult();
 
@@ -506,7 +511,7 @@ namespace route_store {
     result.ok = true;
 
     if (activate) {
-      if (!saveActiveRoutePointer(path) || !loadNormalizedRoute(routeDoc, path, true)) {
+      if (!saveActiveRoutePointer(path) || !loadNormalizedRoute(target, routeDoc, path, true)) {
         result.error = routeError("Route was saved but could not be activated.");
         heap_monitor::checkpoint("route-save-act-fail");
         return false;
@@ -537,7 +542,7 @@ namespace route_store {
       return false;
     }
 
-    const bool loaded = loadNormalizedRoute(doc, path, activate);
+    const bool loaded = loadNormalizedRoute(navigator, doc, path, activate);
     heap_monitor::checkpoint(loaded ? "route-load-done" : "route-load-fail");
     return loaded;
   }
@@ -562,7 +567,9 @@ namespace route_store {
 
   bool clearActiveRoute() {
     if (!SD_MMC.exists(activeRoutePath())) return true;
-    return SD_MMC.remove(activeRoutePath());
+    const bool removed = SD_MMC.remove(activeRoutePath());
+    dir_cache::noteChanged(activeRoutePath());
+    return removed;
   }
 
 }  // namespace route_store
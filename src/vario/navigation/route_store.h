@@ -3,6 +3,8 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include "navigation/gpx.h"
+
 namespace route_store {
 
   struct ImportResult {
@@ -16,8 +18,11 @@ namespace route_store {
   constexpr const char* directoryPath() { return "/routes"; }
   constexpr const char* activeRoutePath() { return "/routes/active.json"; }
 
-  bool importRouteText(const String& name, const String& data, bool activate, ImportResult& result);
-  bool saveRouteJson(JsonDocument& routeDoc, bool activate, ImportResult& result);
+  // Save a route; if activate, also load it into target and navigate along it
+  bool importRouteText(const String& name, const String& data, bool activate, ImportResult& result,
+                       Navigator& target = navigator);
+  bool saveRouteJson(JsonDocument& routeDoc, bool activate, ImportResult& result,
+                     Navigator& target = navigator);
   bool loadRouteFile(const String& path, bool activate);
   bool loadActiveRoute();
   bool clearActiveRoute();
@@ -6,6 +6,7 @@
 
 #include "diagnostics/heap_monitor.h"
 #include "instruments/gps.h"
+#include "storage/dir_cache.h"
 #include "storage/sd_card.h"
 
 namespace user_waypoints {
@@ -120,7 +121,9 @@ namespace user_waypoints {
         error = "Unable to replace user waypoints.";
         return false;
       }
-      if (!SD_MMC.rename(TEMP_FILE, filePath())) {
+      const bool renamed = SD_MMC.rename(TEMP_FILE, filePath());
+      dir_cache::noteChanged(filePath());
+      if (!renamed) {
         SD_MMC.remove(TEMP_FILE);
         error = "Unable to save user waypoints.";
         return false;
@@ -137,20 +140,20 @@ namespace user_waypoints {
       return waypoint;
     }
 
-    WaypointID appendNavigatorWaypoint(JsonObjectConst point) {
+    WaypointID appendNavigatorWaypoint(Navigator& target, JsonObjectConst point) {
       if (!validPoint(point)) return WaypointID::None;
       Waypoint waypoint = waypointFromJson(point);
 
-      for (uint8_t i = 1; i <= navigator.totalWaypoints; i++) {
-        if (navigator.waypoints[i].latE7 == waypoint.latE7 &&
-            navigator.waypoints[i].lonE7 == waypoint.lonE7) {
-          navigator.waypoints[i] = waypoint;
+      for (uint8_t i = 1; i <= target.totalWaypoints; i++) {
+        if (target.waypoints[i].latE7 == waypoint.latE7 &&
+            target.waypoints[i].lonE7 == waypoint.lonE7) {
+          target.waypoints[i] = waypoint;
           return WaypointID(i);
         }
       }
 
-      if (!navigator.addWaypoint(waypoint)) return WaypointID::None;
-      return WaypointID(navigator.totalWaypoints);
+      if (!target.addWaypoint(waypoint)) return WaypointID::None;
+      return WaypointID(target.totalWaypoints);
     }
   }  // namespace
 
@@ -202,14 +205,14 @@ namespace user_waypoints {
     return true;
   }
 
-  bool loadIntoNavigator() {
+  bool loadIntoNavigator(Navigator& target) {
     heap_monitor::checkpoint("user-wpt-load-nav");
     if (!sdcard.isMounted() || !SD_MMC.exists(filePath())) return false;
     JsonDocument doc;
     String error;
     if (!loadDocument(doc, error)) return false;
     for (JsonObjectConst point : doc["points"].as<JsonArrayConst>()) {
-      appendNavigatorWaypoint(point);
+      appendNavigatorWaypoint(target, point);
     }
     return true;
   }
@@ -235,7 +238,7 @@ namespace user_waypoints {
     navigator.clear();
     for (JsonObjectConst point : doc["points"].as<JsonArrayConst>()) {
       if (!validPoint(point)) continue;
-      if (!appendNavigatorWaypoint(point)) {
+      if (!appendNavigatorWaypoint(navigator, point)) {
         navigator.clear();
         return false;
       }
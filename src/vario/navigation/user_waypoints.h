@@ -11,7 +11,8 @@ namespace user_waypoints {
 
   bool appendCurrentPosition(Waypoint& savedWaypoint, String& error);
   bool hasSavedPoints();
-  bool loadIntoNavigator();
+  // Add the saved points to target's waypoints
+  bool loadIntoNavigator(Navigator& target = navigator);
   bool loadAsNavigatorSource(bool persist = true);
   bool renameFromJson(JsonDocument& input, String& error);
   bool deleteById(const char* id, String& error);
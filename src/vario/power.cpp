@@ -21,6 +21,7 @@
 #include "power.h"
 #include "storage/sd_card.h"
 #include "system/usb_state.h"
+#include "taskman.h"
 #include "ui/audio/sound_effects.h"
 #include "ui/audio/speaker.h"
 #include "ui/display/display.h"
@@ -256,6 +257,8 @@ void Power::shutdown() { shutdown(false); }
 
 void Power::shutdown(bool deadBattery) {
   Serial.println("power_shutdown");
+  // Keep the realtime tasks off the sensors while they are put to sleep
+  RealtimeLockGuard realtimeLock;
 
   switch (display.getPage()) {
     case MainPage::Debug:
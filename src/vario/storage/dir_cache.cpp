@@ -0,0 +1,170 @@
+#include "storage/dir_cache.h"
+
+#include <SD_MMC.h>
+
+#include <string>
+#include <vector>
+
+#include "storage/sd_card.h"
+#include "storage/sd_latency.h"
+#include "utils/lock_guard.h"
+
+namespace dir_cache {
+  namespace {
+    struct Record {
+      uint32_t nameOffset;
+      uint16_t nameLength;
+      bool directory;
+      uint32_t size;
+      time_t modified;
+    };
+
+    // Names live in one buffer per directory rather than a String per entry: a logbook of a few
+    // thousand flights is then one allocation (which the allocator can place in PSRAM) instead of
+    // thousands of small ones from internal RAM.
+    struct Listing {
+      const char* path;
+      bool listed = false;
+      uint32_t mountGeneration = 0;
+      std::vector<Record> records;
+      std::string names;
+    };
+
+    Listing listings[] = {{"/logbook"}, {"/waypoints"}, {"/routes"}};
+
+    SemaphoreHandle_t mutex() {
+      static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+      return mutex;
+    }
+
+    Listing* listingFor(const char* directory) {
+      for (Listing& listing : listings) {
+        if (strcmp(listing.path, directory) == 0) return &listing;
+      }
+      return nullptr;
+    }
+
+    bool interruptedWrite(const char* name) {
+      const size_t length = strlen(name);
+      return length >= 4 &&
+             (strcmp(name + length - 4, ".tmp") == 0 || strcmp(name + length - 4, ".bak") == 0);
+    }
+
+    const char* nameOnly(const char* path) {
+      const char* slash = strrchr(path, '/');
+      return slash ? slash + 1 : path;
+    }
+
+    void clear(Listing& listing) {
+      listing.listed = false;
+      listing.records.clear();
+      listing.records.shrink_to_fit();
+      listing.names.clear();
+      listing.names.shrink_to_fit();
+    }
+
+    void append(Listing& listing, const char* name, File& file) {
+      Record record;
+      record.nameOffset = listing.names.size();
+      record.nameLength = strlen(name);
+      record.directory = file.isDirectory();
+      record.size = record.directory ? 0 : file.size();
+      record.modified = file.getLastWrite();
+      listing.names.append(name, record.nameLength);
+      listing.names.push_back('\0');
+      listing.records.push_back(record);
+    }
+
+    void erase(Listing& listing, size_t index) {
+      const Record removed = listing.records[index];
+      listing.names.erase(removed.nameOffset, removed.nameLength + 1);
+      listing.records.erase(listing.records.begin() + index);
+      for (Record& record : listing.records) {
+        if (record.nameOffset > removed.nameOffset) record.nameOffset -= removed.nameLength + 1;
+      }
+    }
+
+    bool current(const Listing& listing) {
+      return listing.listed && listing.mountGeneration == sdcard.mountGeneration();
+    }
+
+    bool list(Listing& listing) {
+      clear(listing);
+      const uint32_t mountGeneration = sdcard.mountGeneration();
+      File dir;
+      {
+        sd_latency::Timer timer(sd_latency::Op::Open);
+        dir = SD_MMC.open(listing.path);
+      }
+      if (!dir || !dir.isDirectory()) return false;
+
+      while (true) {
+        const uint32_t readStartUs = micros();
+        File file = dir.openNextFile();
+        sd_latency::record(sd_latency::Op::DirectoryRead, micros() - readStartUs);
+        if (!file) break;
+        const char* name = nameOnly(file.name());
+        if (!interruptedWrite(name)) append(listing, name, file);
+        file.close();
+      }
+      dir.close();
+
+      listing.listed = true;
+      listing.mountGeneration = mountGeneration;
+      return true;
+    }
+  }  // namespace
+
+  bool forEach(const char* directory, const std::function<void(const Entry&)>& visit) {
+    Listing* listing = listingFor(directory);
+    if (listing == nullptr) return false;
+
+    LockGuard lock(mutex());
+    if (!sdcard.firmwareCanAccessFilesystem()) {
+      clear(*listing);
+      return false;
+    }
+    if (!current(*listing) && !list(*listing)) return false;
+
+    for (const Record& record : listing->records) {
+      visit(Entry{listing->names.c_str() + record.nameOffset, record.size, record.modified,
+                  record.directory});
+    }
+    return true;
+  }
+
+  void noteChanged(const String& path) {
+    const int slash = path.lastIndexOf('/');
+    if (slash <= 0) return;
+    Listing* listing = listingFor(path.substring(0, slash).c_str());
+    if (listing == nullptr) return;
+    const char* name = path.c_str() + slash + 1;
+    if (interruptedWrite(name)) return;
+
+    LockGuard lock(mutex());
+    // Not listed since the last mount: the next reader lists it afresh anyway
+    if (!current(*listing)) return;
+
+    size_t index = 0;
+    while (index < listing->records.size() &&
+           strcmp(listing->names.c_str() + listing->records[index].nameOffset, name) != 0) {
+      index++;
+    }
+    const bool found = index < listing->records.size();
+
+    File file = SD_MMC.exists(path) ? SD_MMC.open(path) : File();
+    if (!file) {
+      if (found) erase(*listing, index);
+      return;
+    }
+    if (found) {
+      Record& record = listing->records[index];
+      record.directory = file.isDirectory();
+      record.size = record.directory ? 0 : file.size();
+      record.modified = file.getLastWrite();
+    } else {
+      append(*listing, name, file);
+    }
+    file.close();
+  }
+}  // namespace dir_cache
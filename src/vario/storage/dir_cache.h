@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+
+#include "Arduino.h"
+
+// Listings of the SD card directories that menus, stores and the web app browse, held in RAM.
+//
+// Listing a FAT directory means reading every entry from the card, and several of these lists are
+// read more than once per user action (the logbook's position and next/previous lookups, say).
+// Each watched directory is instead listed once, on first use after the card is mounted, and then
+// kept current by noteChanged() as the firmware writes to it.  Anything that can change the card
+// behind the firmware's back -- a card swap, a format, handing it to a USB host -- ends in a
+// remount, which discards every listing (see SDCard::mountGeneration).
+//
+// Interrupted writes (*.tmp, *.bak) are left out, as no reader wants them.
+namespace dir_cache {
+  struct Entry {
+    const char* name;  // Without the directory; only valid during the visit
+    uint32_t size;
+    time_t modified;
+    bool directory;
+  };
+
+  // Call visit for each entry of a watched directory, in directory order.  Returns false without
+  // calling it if the directory is not watched, cannot be listed, or the card is not available to
+  // the firmware.  The cache is locked during the visits, so visit must not call into dir_cache
+  // (and should not do slow SD work of its own).
+  bool forEach(const char* directory, const std::function<void(const Entry&)>& visit);
+
+  // Bring a listing up to date after the firmware created, rewrote, renamed or removed path.  Call
+  // it for each name a rename touched.  Paths outside watched directories are ignored.
+  void noteChanged(const String& path);
+}  // namespace dir_cache
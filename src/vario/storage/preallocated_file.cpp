@@ -0,0 +1,372 @@
+#include "storage/preallocated_file.h"
+
+#include <Preferences.h>
+#include <SD_MMC.h>
+
+#include <atomic>
+
+#include "storage/sd_card.h"
+#include "storage/sd_latency.h"
+#include "utils/lock_guard.h"
+
+namespace {
+  constexpr const char* NAMESPACE = "preallocated";
+  constexpr const char* OPEN_KEY = "open";
+
+  // Eight 512-byte sectors: the stdio buffer in front of the file, so it reaches the card in whole
+  // sectors at sector-aligned offsets
+  constexpr size_t WRITE_BUFFER_BYTES = 4096;
+  constexpr uint32_t SECTOR_BYTES = 512;
+
+  // At most this much of a file is lost to a reset or power loss
+  constexpr uint32_t CHECKPOINT_INTERVAL_MS = 30000;
+
+  // The files open at once: the track log and the bus log, with room to spare
+  constexpr size_t MAX_OPEN_FILES = 4;
+
+  // Spare extents, one for each of the track and bus logs
+  constexpr const char* SPARE_DIRECTORY = "/.reserved";
+  constexpr uint8_t MAX_SPARES = 2;
+  // An extent is a whole number of sectors, the last of which holds its Mark
+  constexpr uint32_t MIN_SPARE_BYTES = WRITE_BUFFER_BYTES;
+
+  constexpr uint32_t SPARE_TASK_STACK_BYTES = 4096;
+  constexpr UBaseType_t SPARE_TASK_PRIORITY = 1;  // Below everything the pilot is looking at
+  // The service core: core 1 belongs to the realtime loop
+  constexpr BaseType_t SPARE_TASK_CORE = 0;
+  constexpr uint32_t SPARE_WAIT_MS = 1000;
+
+  constexpr uint32_t MARK_MAGIC = 0x6b72616d;  // "mark"
+
+  // An empty path is a free slot
+  struct OpenFile {
+    char path[64];
+    uint32_t reservedBytes;
+    uint32_t nonce;  // Tells this file's Mark from one left in the extent by an earlier file
+  };
+
+  struct OpenFiles {
+    OpenFile files[MAX_OPEN_FILES];
+  };
+
+  // How far a file has been written, at the start of its extent's last sector
+  struct Mark {
+    uint32_t magic;
+    uint32_t nonce;
+    uint32_t length;
+  };
+
+  // PreallocatedFiles open now; spares are only reserved while there are none
+  std::atomic<uint8_t> openFiles{0};
+
+  // How far each open file has reached the card, for writtenLength(); an empty path is a free slot
+  struct Written {
+    char path[64];
+    uint32_t length;
+  };
+  Written written[MAX_OPEN_FILES] = {};
+  portMUX_TYPE writtenLock = portMUX_INITIALIZER_UNLOCKED;
+
+  // Record that path has reached the card up to length
+  void publishWritten(const String& path, uint32_t length) {
+    if (path.length() >= sizeof(Written::path)) return;
+    taskENTER_CRITICAL(&writtenLock);
+    Written* slot = nullptr;
+    for (Written& file : written) {
+      if (path == file.path) {
+        slot = &file;
+        break;
+      }
+      if (slot == nullptr && file.path[0] == '\0') slot = &file;
+    }
+    if (slot != nullptr) {
+      strncpy(slot->path, path.c_str(), sizeof(slot->path) - 1);
+      slot->length = length;
+    }
+    taskEXIT_CRITICAL(&writtenLock);
+  }
+
+  void forgetWritten(const String& path) {
+    taskENTER_CRITICAL(&writtenLock);
+    for (Written& file : written) {
+      if (file.path[0] != '\0' && path == file.path) memset(&file, 0, sizeof(file));
+    }
+    taskEXIT_CRITICAL(&writtenLock);
+  }
+
+  SemaphoreHandle_t mutex() {
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    return mutex;
+  }
+
+  void load(OpenFiles& open) {
+    memset(&open, 0, sizeof(open));
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, true)) return;
+    if (prefs.getBytesLength(OPEN_KEY) == sizeof(open)) {
+      prefs.getBytes(OPEN_KEY, &open, sizeof(open));
+    }
+    prefs.end();
+  }
+
+  bool store(const OpenFiles& open) {
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, false)) return false;
+    const bool stored = prefs.putBytes(OPEN_KEY, &open, sizeof(open)) == sizeof(open);
+    prefs.end();
+    return stored;
+  }
+
+  // Record that path is open in an extent of reservedBytes
+  bool record(const String& path, uint32_t reservedBytes, uint32_t nonce) {
+    LockGuard lock(mutex());
+    OpenFiles open;
+    load(open);
+    OpenFile* slot = nullptr;
+    for (OpenFile& file : open.files) {
+      if (path == file.path) {
+        slot = &file;
+        break;
+      }
+      if (slot == nullptr && file.path[0] == '\0') slot = &file;
+    }
+    if (slot == nullptr) return false;
+    strncpy(slot->path, path.c_str(), sizeof(slot->path) - 1);
+    slot->reservedBytes = reservedBytes;
+    slot->nonce = nonce;
+    return store(open);
+  }
+
+  void forget(const String& path) {
+    LockGuard lock(mutex());
+    OpenFiles open;
+    load(open);
+    for (OpenFile& file : open.files) {
+      if (path == file.path) {
+        memset(&file, 0, sizeof(file));
+        store(open);
+        return;
+      }
+    }
+  }
+
+  String sparePath(uint8_t index) { return String(SPARE_DIRECTORY) + "/spare" + index; }
+
+  // Size of the spare at path; 0 if there is none, or one whose reservation never finished
+  uint32_t spareBytes(const String& path) {
+    if (!SD_MMC.exists(path)) return 0;
+    File file = SD_MMC.open(path);
+    if (!file) return 0;
+    const uint32_t size = file.size();
+    file.close();
+    return size >= MIN_SPARE_BYTES ? size : 0;
+  }
+
+  // Rename the spare best fitting wantedBytes to path.  Returns its size, 0 if there was none.
+  uint32_t takeSpare(const String& path, uint32_t wantedBytes) {
+    int8_t best = -1;
+    uint32_t bestBytes = 0;
+    for (uint8_t i = 0; i < MAX_SPARES; i++) {
+      const uint32_t bytes = spareBytes(sparePath(i));
+      if (bytes == 0) continue;
+      // The smallest that fits, or failing that the largest
+      const bool better = bytes >= wantedBytes ? bestBytes < wantedBytes || bytes < bestBytes
+                                               : bestBytes < wantedBytes && bytes > bestBytes;
+      if (best < 0 || better) {
+        best = i;
+        bestBytes = bytes;
+      }
+    }
+    if (best < 0 || !SD_MMC.rename(sparePath(best), path)) return 0;
+    return bestBytes;
+  }
+
+  // Fill the first free spare slot with an extent of bytes
+  void reserveSpare(uint32_t bytes) {
+    for (uint8_t i = 0; i < MAX_SPARES; i++) {
+      const String path = sparePath(i);
+      if (spareBytes(path) > 0) continue;
+      // Left behind by a reservation that never finished
+      if (SD_MMC.exists(path)) SD_MMC.remove(path);
+      if (!SD_MMC.exists(SPARE_DIRECTORY) && !SD_MMC.mkdir(SPARE_DIRECTORY)) return;
+
+      const uint32_t startMs = millis();
+      if (sdcard.createContiguousFile(path.c_str(), bytes)) {
+        Serial.printf("Reserved %lu KB for the next log in %lu ms\n",
+                      static_cast<unsigned long>(bytes / 1024),
+                      static_cast<unsigned long>(millis() - startMs));
+      }
+      return;
+    }
+  }
+
+  QueueHandle_t spareRequests() {
+    static QueueHandle_t queue = xQueueCreate(MAX_SPARES, sizeof(uint32_t));
+    return queue;
+  }
+
+  void spareTask(void*) {
+    uint32_t bytes;
+    while (true) {
+      if (xQueueReceive(spareRequests(), &bytes, portMAX_DELAY) != pdTRUE) continue;
+      // Searching for a free run holds the card for as long as it takes, which no log being written
+      // should have to wait for
+      while (openFiles.load() > 0) vTaskDelay(pdMS_TO_TICKS(SPARE_WAIT_MS));
+      // Held so the card isn't handed to a USB host mid-reservation; with the card unmounted or
+      // with the host, the request lapses and the next open() asks again
+      if (!sdcard.beginFirmwareIo()) continue;
+      reserveSpare(bytes);
+      sdcard.endFirmwareIo();
+    }
+  }
+
+  // Have a spare of about bytes reserved in the background
+  void requestSpare(uint32_t bytes) {
+    bytes -= bytes % SECTOR_BYTES;
+    if (bytes < MIN_SPARE_BYTES) return;
+    static TaskHandle_t task = NULL;
+    if (task == NULL &&
+        xTaskCreatePinnedToCore(spareTask, "LogReserve", SPARE_TASK_STACK_BYTES, NULL,
+                                SPARE_TASK_PRIORITY, &task, SPARE_TASK_CORE) != pdPASS) {
+      task = NULL;
+      return;
+    }
+    xQueueSend(spareRequests(), &bytes, 0);
+  }
+}  // namespace
+
+File PreallocatedFile::open(const String& path, uint32_t reserveBytes) {
+  close();
+  sd_latency::Timer timer(sd_latency::Op::Open);
+  path_ = path;
+  reserved_ = false;
+  reservedBytes_ = 0;
+
+  // Before the spare is renamed into place, so no reader sees the reservation as the file's length
+  publishWritten(path, 0);
+  const uint32_t spareBytes =
+      path.length() < sizeof(OpenFile::path) ? takeSpare(path, reserveBytes) : 0;
+  if (spareBytes > 0) {
+    nonce_ = esp_random();
+    // Recorded before anything is written, so from here on an interrupted file is cut back
+    if (record(path, spareBytes, nonce_)) file_ = SD_MMC.open(path, "r+");
+    if (file_) {
+      reserved_ = true;
+      reservedBytes_ = spareBytes;
+    } else {
+      SD_MMC.remove(path);
+      forget(path);
+    }
+  }
+  if (!reserved_) file_ = SD_MMC.open(path, "w", true);
+  if (reserveBytes > 0) requestSpare(reserveBytes);
+  if (!file_) {
+    forgetWritten(path);
+    path_ = "";
+    return file_;
+  }
+
+  openFiles++;
+  file_.setBufferSize(WRITE_BUFFER_BYTES);
+  // Whatever an earlier file left in the extent's last sector no longer applies
+  if (reserved_) markWritten();
+  lastCheckpointMs_ = millis();
+  return file_;
+}
+
+void PreallocatedFile::checkpoint() {
+  if (!file_ || millis() - lastCheckpointMs_ < CHECKPOINT_INTERVAL_MS) return;
+  lastCheckpointMs_ = millis();
+
+  // Synced to the card first, so the mark never runs ahead of the data
+  {
+    sd_latency::Timer timer(sd_latency::Op::Flush);
+    file_.flush();
+  }
+  if (reserved_) markWritten();
+  publishWritten(path_, file_.position());
+}
+
+void PreallocatedFile::markWritten() {
+  const uint32_t position = file_.position();
+  const uint32_t markOffset = reservedBytes_ - SECTOR_BYTES;
+  // Once the data reaches the last sector, the whole extent is data
+  if (position > markOffset) return;
+
+  uint8_t sector[SECTOR_BYTES] = {};
+  const Mark mark = {MARK_MAGIC, nonce_, position};
+  memcpy(sector, &mark, sizeof(mark));
+  file_.seek(markOffset);
+  file_.write(sector, sizeof(sector));
+  file_.seek(position);
+}
+
+void PreallocatedFile::close() {
+  if (!file_) return;
+  sd_latency::Timer timer(sd_latency::Op::Close);
+  const uint32_t written = file_.position();
+  if (reserved_) {
+    // So that if the card can't be cut back now (it was pulled, say), recovery can finish the job
+    file_.flush();
+    markWritten();
+  }
+  file_.close();
+  openFiles--;
+  publishWritten(path_, written);
+
+  if (reserved_ && (written >= reservedBytes_ || sdcard.truncateFile(path_.c_str(), written))) {
+    forget(path_);
+  }
+  forgetWritten(path_);
+  reserved_ = false;
+  reservedBytes_ = 0;
+  path_ = "";
+}
+
+bool PreallocatedFile::writtenLength(const String& path, uint32_t& length) {
+  bool found = false;
+  taskENTER_CRITICAL(&writtenLock);
+  for (const Written& file : written) {
+    if (file.path[0] != '\0' && path == file.path) {
+      length = file.length;
+      found = true;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL(&writtenLock);
+  return found;
+}
+
+void PreallocatedFile::recoverInterrupted() {
+  LockGuard lock(mutex());
+  OpenFiles open;
+  load(open);
+
+  bool changed = false;
+  for (OpenFile& file : open.files) {
+    if (file.path[0] == '\0') continue;
+
+    bool recovered = true;
+    File existing = SD_MMC.exists(file.path) ? SD_MMC.open(file.path) : File();
+    if (existing) {
+      const size_t size = existing.size();
+      Mark mark = {};
+      const bool marked = size == file.reservedBytes && size >= MIN_SPARE_BYTES &&
+                          existing.seek(size - SECTOR_BYTES) &&
+                          existing.read((uint8_t*)&mark, sizeof(mark)) == sizeof(mark) &&
+                          mark.magic == MARK_MAGIC && mark.nonce == file.nonce;
+      existing.close();
+      // Without a mark the file grew past its extent or its data reached the mark: it is all data
+      if (marked && size > mark.length) {
+        Serial.printf("Cutting interrupted %s back to %lu bytes\n", file.path,
+                      static_cast<unsigned long>(mark.length));
+        recovered = sdcard.truncateFile(file.path, mark.length);
+      }
+    }
+    if (recovered) {
+      memset(&file, 0, sizeof(file));
+      changed = true;
+    }
+  }
+  if (changed) store(open);
+}
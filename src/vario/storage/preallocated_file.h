@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Arduino.h"
+#include "FS.h"
+
+// A log file written into space reserved for it ahead of time.
+//
+// A FAT file that grows a few bytes at a time gets a cluster allocated whenever it crosses into a
+// new one, and finding a free cluster on a full or fragmented card is where the long SD stalls in
+// flight come from.  A PreallocatedFile is written into one contiguous extent instead, so appends
+// only ever write data; it is written from offset 0 through a buffer of whole sectors, so the card
+// sees aligned sector writes; and closing it gives back the part of the extent not used.  A file
+// that outgrows its extent carries on growing as an ordinary file would.
+//
+// Searching the card for a free run as long as a whole flight's log can take seconds on a
+// fragmented card, so it is never done when a file is opened.  Extents are reserved as spare files
+// in /.reserved by a background task, only while no PreallocatedFile is open (on the ground, after
+// the previous log closed), and open() just renames one into place.  With no spare on the card --
+// the first log on a new card, or one with no free run long enough -- the file is an ordinary one.
+//
+// Until it is closed the file's size on the card is the whole extent, so how far it has been
+// written is kept in the extent's last sector at each checkpoint(); only opening and closing touch
+// NVS.  After a reset or power loss, recoverInterrupted() cuts the file back to its last checkpoint
+// the next time the card is mounted.  Readers on other tasks ask writtenLength() instead.
+class PreallocatedFile {
+ public:
+  // Create path, which must not exist, in a spare extent if there is one, and open it for writing;
+  // then ask for a spare of reserveBytes (none if 0) to be reserved for the next file.  Returns the
+  // open file, which is what the writer writes to.
+  File open(const String& path, uint32_t reserveBytes);
+
+  // Make what has been written so far survive a reset or power loss.  Cheap between checkpoints,
+  // so writers can call it after every write.
+  void checkpoint();
+
+  // Close the file, releasing any reservation beyond what was written
+  void close();
+
+  // Cut back any file left open by a reset or power loss; called once the card is mounted
+  static void recoverInterrupted();
+
+  // How much of the file open at path has reached the card, as of its last checkpoint, for readers
+  // on other tasks: until it is closed, its size on the card may be the whole reservation.  False
+  // if no PreallocatedFile is open at path, in which case its size is its length.
+  static bool writtenLength(const String& path, uint32_t& length);
+
+ private:
+  // Record in the extent's last sector that the file has been written up to the current position
+  void markWritten();
+
+  File file_;
+  String path_;
+  bool reserved_ = false;
+  uint32_t reservedBytes_ = 0;
+  uint32_t nonce_ = 0;
+  uint32_t lastCheckpointMs_ = 0;
+};
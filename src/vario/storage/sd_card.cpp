@@ -8,6 +8,7 @@
 #include <esp_vfs_fat.h>
 #include <ff.h>
 #include <sdmmc_cmd.h>
+#include <unistd.h>
 #include <new>
 #include "FirmwareMSC.h"
 #include "USB.h"
@@ -19,7 +20,10 @@
 #include "hardware/io_pins.h"
 #include "instruments/gps.h"
 #include "logging/log.h"
+#include "storage/preallocated_file.h"
+#include "storage/sd_latency.h"
 #include "system/usb_state.h"
+#include "ui/audio/vario_tones.h"
 #include "ui/settings/settings.h"
 
 #define DEBUG_SDCARD true
@@ -107,9 +111,11 @@ void SDCard::update() {
 
 namespace {
   constexpr const char* STANDARD_DIRECTORIES[] = {"/waypoints", "/routes", "/logbook", "/tracks",
-                                                  "/firmware"};
+                                                  "/firmware", "/sounds"};
   constexpr uint32_t SD_SECTOR_SIZE = 512;
   constexpr uint32_t MSC_BUFFER_SIZE = 4096;
+  // Long enough for a background reservation on a fragmented card to finish
+  constexpr uint32_t FIRMWARE_IO_TIMEOUT_MS = 10000;
 
   bool ensureDirectory(const char* path) {
     if (SD_MMC.exists(path)) return true;
@@ -202,11 +208,15 @@ bool SDCard::mount() {
     if (DEBUG_SDCARD) Serial.println("SDcard Mount Success");
     success = true;
     mounted_ = true;
+    mountGeneration_.fetch_add(1, std::memory_order_acq_rel);
     setLabel();
     ensureStandardDirectories();
+    PreallocatedFile::recoverInterrupted();
+    sd_latency::runMountBenchmark();
     heap_monitor::setSdLoggingEnabled(true);
     heap_monitor::checkpoint("sd-mounted");
     boot_diagnostics::writeReportsToSd();
+    vario_tones::loadFromSd();
     if (bootUpdateRequested) sd_firmware_update::handleBootUpdate();
 
 #ifndef DISABLE_MASS_STORAGE
@@ -276,6 +286,19 @@ bool SDCard::presentMassStorage() {
   ownership_.store(SDCardOwnership::TransitioningToHost, std::memory_order_release);
   heap_monitor::setSdLoggingEnabled(false);
 
+  // No new firmware I/O starts now; let what is under way finish before the card is unmounted
+  const uint32_t startedMs = millis();
+  while (activeFirmwareIo_.load(std::memory_order_acquire) != 0) {
+    if (millis() - startedMs >= FIRMWARE_IO_TIMEOUT_MS) {
+      Serial.printf("Mass Storage Failed: %u firmware SD operations still active\n",
+                    activeFirmwareIo_.load(std::memory_order_acquire));
+      ownership_.store(SDCardOwnership::FirmwareReserved, std::memory_order_release);
+      heap_monitor::setSdLoggingEnabled(true);
+      return false;
+    }
+    delay(1);
+  }
+
   mscBuffer_ = static_cast<uint8_t*>(
       heap_caps_malloc(MSC_BUFFER_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL));
   if (!mscBuffer_) {
@@ -404,6 +427,18 @@ bool SDCard::beginHostIo() {
 
 void SDCard::endHostIo() { activeHostIo_.fetch_sub(1, std::memory_order_acq_rel); }
 
+bool SDCard::beginFirmwareIo() {
+  if (!firmwareCanAccessFilesystem()) return false;
+
+  activeFirmwareIo_.fetch_add(1, std::memory_order_acq_rel);
+  if (firmwareCanAccessFilesystem()) return true;
+
+  activeFirmwareIo_.fetch_sub(1, std::memory_order_acq_rel);
+  return false;
+}
+
+void SDCard::endFirmwareIo() { activeFirmwareIo_.fetch_sub(1, std::memory_order_acq_rel); }
+
 int32_t SDCard::readHostSectors(uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
   if (!rawHostInitialized_ || !mscBuffer_ || offset % SD_SECTOR_SIZE != 0 || bufsize == 0 ||
       bufsize % SD_SECTOR_SIZE != 0 || bufsize > MSC_BUFFER_SIZE) {
@@ -624,3 +659,25 @@ bool SDCard::setLabel() {
   if (DEBUG_SDCARD) Serial.println("SDcard Label Success");
   return true;
 }
+
+bool SDCard::createContiguousFile(const char* path, uint32_t size) {
+  if (!firmwareCanAccessFilesystem() || SD_MMC.exists(path)) return false;
+  const String fullPath = String(SD_CARD_MOUNT_POINT) + path;
+  const esp_err_t result =
+      esp_vfs_fat_create_contiguous_file(SD_CARD_MOUNT_POINT, fullPath.c_str(), size, true);
+  if (result != ESP_OK) {
+    if (DEBUG_SDCARD) {
+      Serial.printf("SDcard Contiguous File Failed: %s (%s)\n", path, esp_err_to_name(result));
+    }
+    // A failed reservation may still have created the file
+    SD_MMC.remove(path);
+    return false;
+  }
+  return true;
+}
+
+bool SDCard::truncateFile(const char* path, uint32_t length) {
+  if (!firmwareCanAccessFilesystem()) return false;
+  const String fullPath = String(SD_CARD_MOUNT_POINT) + path;
+  return truncate(fullPath.c_str(), length) == 0;
+}
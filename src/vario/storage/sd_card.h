@@ -35,6 +35,12 @@ class SDCard {
   bool setLabel();
   bool isMounted() { return mounted_; }
 
+  // Create path with size bytes allocated to it in one contiguous run of clusters, so writing
+  // within them never allocates.  False if the file exists or the card has no free run that long.
+  bool createContiguousFile(const char* path, uint32_t size);
+  // Cut path back to length bytes, freeing its clusters beyond that
+  bool truncateFile(const char* path, uint32_t length);
+
   bool setupMassStorage(bool mediaPresent = true);
   bool reserveForFirmwareUpload();
   bool presentMassStorage();
@@ -52,6 +58,16 @@ class SDCard {
   }
   bool firmwareCanAccessFilesystem() const { return mounted_ && firmwareOwnsMassStorage(); }
 
+  // Held by firmware tasks other than the main loop around their SD work, so the card is not
+  // handed to a USB host under them.  False, with nothing to end, if the firmware can't use it.
+  bool beginFirmwareIo();
+  void endFirmwareIo();
+
+  // Counts successful mounts.  Between two mounts the card may have been swapped, formatted or
+  // handed to a USB host, so anything cached about its contents is only good while this is
+  // unchanged.
+  uint32_t mountGeneration() const { return mountGeneration_.load(std::memory_order_acquire); }
+
   // Used only by the USB MSC callbacks to keep a host request alive across an ownership change.
   bool beginHostIo();
   void endHostIo();
@@ -63,11 +79,13 @@ class SDCard {
   // Whether the SD card is currently mounted (used to compare against the SD_DETECT
   // pin so we can tell if a card has been inserted or removed)
   bool mounted_ = false;
+  std::atomic<uint32_t> mountGeneration_{0};
 
   FirmwareMSC* firmwareMSC_ = nullptr;
   USBMSC* msc_ = nullptr;
   std::atomic<SDCardOwnership> ownership_{SDCardOwnership::FirmwareReserved};
   std::atomic<uint16_t> activeHostIo_{0};
+  std::atomic<uint16_t> activeFirmwareIo_{0};
   std::atomic<bool> explicitEject_{false};
   bool reserveMassStorageOnMount_ = false;
   bool mscStarted_ = false;
@@ -0,0 +1,204 @@
+#include "storage/sd_latency.h"
+
+#include <SD_MMC.h>
+
+#include "diagnostics/diagnostic_logs.h"
+#include "storage/sd_card.h"
+
+namespace sd_latency {
+  namespace {
+    constexpr const char* BENCHMARK_PATH = "/diagnostics/sd_benchmark.tmp";
+
+    // The track and bus logs reach the card in 4 KB runs of whole sectors (see PreallocatedFile)
+    constexpr size_t BENCHMARK_WRITE_BYTES = 4096;
+    constexpr uint8_t BENCHMARK_WRITES = 32;
+    // It runs on the service task as the card is mounted; a card whose writes can't finish in this
+    // long is too slow anyway.  Reserving the file beforehand is not counted.
+    constexpr uint32_t BENCHMARK_LIMIT_US = 500000;
+
+    // The bus log, the heaviest writer, needs about 3 KB/s; this leaves room for everything else
+    constexpr uint32_t MIN_BYTES_PER_SECOND = 32 * 1024;
+
+    // Logs are written from the service core, which a write this long holds up for ten blocks
+    constexpr uint32_t SLOW_WRITE_US = 100000;
+
+    // Guards everything below
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    Histogram histograms[OP_COUNT] = {};
+    Benchmark benchmark = {};
+
+    uint8_t bucketFor(uint32_t elapsedUs) {
+      uint8_t bucket = 0;
+      uint32_t bound = FIRST_BUCKET_US;
+      while (bucket < BUCKET_COUNT - 1 && elapsedUs >= bound) {
+        bucket++;
+        bound <<= 1;
+      }
+      return bucket;
+    }
+
+    void add(Histogram& histogram, uint32_t elapsedUs) {
+      histogram.count++;
+      histogram.totalUs += elapsedUs;
+      if (elapsedUs > histogram.maxUs) histogram.maxUs = elapsedUs;
+      histogram.buckets[bucketFor(elapsedUs)]++;
+    }
+
+    uint32_t meanUs(const Histogram& histogram) {
+      if (histogram.count == 0) return 0;
+      return (uint32_t)(histogram.totalUs / histogram.count);
+    }
+
+    void writeHeader(File& file) {
+      file.print("op,count,mean_us,p50_us,p99_us,max_us,bytes_per_second,slow");
+      for (uint8_t i = 0; i < BUCKET_COUNT - 1; i++) {
+        file.printf(",lt_%luus", static_cast<unsigned long>(FIRST_BUCKET_US << i));
+      }
+      file.printf(",ge_%luus\n", static_cast<unsigned long>(LAST_BUCKET_US));
+    }
+
+    // bytesPerSecond and slow are left empty for the ops and filled in for the benchmark
+    void writeRow(File& file, const char* op, const Histogram& histogram,
+                  const String& bytesPerSecond = String(), const String& slow = String()) {
+      file.printf("%s,%lu,%lu,%lu,%lu,%lu,%s,%s", op, static_cast<unsigned long>(histogram.count),
+                  static_cast<unsigned long>(meanUs(histogram)),
+                  static_cast<unsigned long>(percentileUs(histogram, 50)),
+                  static_cast<unsigned long>(percentileUs(histogram, 99)),
+                  static_cast<unsigned long>(histogram.maxUs), bytesPerSecond.c_str(),
+                  slow.c_str());
+      for (uint32_t count : histogram.buckets) {
+        file.printf(",%lu", static_cast<unsigned long>(count));
+      }
+      file.println();
+    }
+  }  // namespace
+
+  const char* name(Op op) {
+    switch (op) {
+      case Op::Open:
+        return "open";
+      case Op::Write:
+        return "write";
+      case Op::Flush:
+        return "flush";
+      case Op::Close:
+        return "close";
+      case Op::DirectoryRead:
+        return "dir_read";
+    }
+    return "unknown";
+  }
+
+  void record(Op op, uint32_t elapsedUs) {
+    if ((uint8_t)op >= OP_COUNT) return;
+    portENTER_CRITICAL(&lock);
+    add(histograms[(uint8_t)op], elapsedUs);
+    portEXIT_CRITICAL(&lock);
+  }
+
+  Histogram histogram(Op op) {
+    Histogram copy = {};
+    if ((uint8_t)op >= OP_COUNT) return copy;
+    portENTER_CRITICAL(&lock);
+    copy = histograms[(uint8_t)op];
+    portEXIT_CRITICAL(&lock);
+    return copy;
+  }
+
+  uint32_t percentileUs(const Histogram& histogram, uint8_t percent) {
+    if (histogram.count == 0) return 0;
+    const uint64_t target = ((uint64_t)histogram.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < BUCKET_COUNT - 1; i++) {
+      seen += histogram.buckets[i];
+      if (seen >= target) return min((uint32_t)(FIRST_BUCKET_US << i), histogram.maxUs);
+    }
+    return histogram.maxUs;
+  }
+
+  void runMountBenchmark() {
+    Benchmark result = {};
+    // Whatever was learned about the card mounted before no longer applies
+    portENTER_CRITICAL(&lock);
+    benchmark = result;
+    portEXIT_CRITICAL(&lock);
+    if (!diagnostic_logs::ensureDirectory()) return;
+    uint8_t* block = (uint8_t*)malloc(BENCHMARK_WRITE_BYTES);
+    if (block == nullptr) return;
+    memset(block, 0x55, BENCHMARK_WRITE_BYTES);
+
+    // Written into space reserved for it, as the logs are, so it times the writes and not finding
+    // clusters for them; a card with no free run that long gets an ordinary file
+    if (SD_MMC.exists(BENCHMARK_PATH)) SD_MMC.remove(BENCHMARK_PATH);
+    const bool reserved =
+        sdcard.createContiguousFile(BENCHMARK_PATH, BENCHMARK_WRITE_BYTES * BENCHMARK_WRITES);
+    File file =
+        reserved ? SD_MMC.open(BENCHMARK_PATH, "r+") : SD_MMC.open(BENCHMARK_PATH, "w", true);
+    if (!file) {
+      free(block);
+      return;
+    }
+    const uint32_t writesStartUs = micros();
+    size_t written = 0;
+    bool timedOut = false;
+    for (uint8_t i = 0; i < BENCHMARK_WRITES; i++) {
+      if (micros() - writesStartUs > BENCHMARK_LIMIT_US) {
+        timedOut = true;
+        break;
+      }
+      const uint32_t writeStartUs = micros();
+      const size_t wrote = file.write(block, BENCHMARK_WRITE_BYTES);
+      add(result.writes, micros() - writeStartUs);
+      written += wrote;
+      if (wrote != BENCHMARK_WRITE_BYTES) break;
+    }
+    // Closing is when the last of it reaches the card
+    file.close();
+    const uint32_t elapsedUs = max(micros() - writesStartUs, (uint32_t)1);
+    SD_MMC.remove(BENCHMARK_PATH);
+    free(block);
+
+    result.ran = written == BENCHMARK_WRITE_BYTES * BENCHMARK_WRITES || timedOut;
+    result.bytesPerSecond = (uint32_t)((uint64_t)written * 1000000 / elapsedUs);
+    result.slow = !result.ran || timedOut || result.bytesPerSecond < MIN_BYTES_PER_SECOND ||
+                  result.writes.maxUs > SLOW_WRITE_US;
+    portENTER_CRITICAL(&lock);
+    benchmark = result;
+    portEXIT_CRITICAL(&lock);
+
+    Serial.printf("SD benchmark: %lu KB/s, worst write %lu us%s\n",
+                  static_cast<unsigned long>(result.bytesPerSecond / 1024),
+                  static_cast<unsigned long>(result.writes.maxUs),
+                  result.slow ? " -- too slow for logging" : "");
+    if (result.slow) {
+      diagnostic_logs::appendSystemEvent("sd_card", "slow_card", String(), "bytes_per_second",
+                                         (int32_t)result.bytesPerSecond, true);
+    }
+    writeReport();
+  }
+
+  Benchmark mountBenchmark() {
+    portENTER_CRITICAL(&lock);
+    const Benchmark copy = benchmark;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+  }
+
+  bool writeReport() {
+    if (!diagnostic_logs::ensureDirectory()) return false;
+    File file = SD_MMC.open(diagnostic_logs::SD_LATENCY_PATH, "w", true);
+    if (!file) return false;
+
+    writeHeader(file);
+    for (uint8_t i = 0; i < OP_COUNT; i++) {
+      writeRow(file, name((Op)i), histogram((Op)i));
+    }
+    const Benchmark bench = mountBenchmark();
+    if (bench.ran || bench.writes.count > 0) {
+      writeRow(file, "mount_benchmark_write", bench.writes, String(bench.bytesPerSecond),
+               bench.slow ? "1" : "0");
+    }
+    file.close();
+    return true;
+  }
+}  // namespace sd_latency
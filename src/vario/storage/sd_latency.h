@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+
+// How long the SD card takes over the operations the firmware's logging and browsing depend on, so
+// that a card too slow for the vario can be told apart from a firmware problem.
+//
+// Every timed open, write, flush, close and directory read lands in a histogram for its operation,
+// in power-of-two buckets of microseconds.  Each time a card is mounted a quick benchmark also
+// writes to it the way the track and bus logs do, into space reserved for it, and flags it if it
+// cannot keep up or its writes cannot finish within half a second.  Both are shown on the second
+// debug page and written to /diagnostics/sd_latency.csv; a slow card is also named on the startup
+// splash.
+//
+// Recorded from any task; cheap enough to time every write.
+namespace sd_latency {
+  enum class Op : uint8_t { Open, Write, Flush, Close, DirectoryRead };
+  constexpr uint8_t OP_COUNT = 5;
+
+  // Bucket 0 holds latencies under FIRST_BUCKET_US, each later bucket up to twice the bound of the
+  // one before, and the last everything from LAST_BUCKET_US up (about half a second)
+  constexpr uint8_t BUCKET_COUNT = 15;
+  constexpr uint32_t FIRST_BUCKET_US = 64;
+  constexpr uint32_t LAST_BUCKET_US = FIRST_BUCKET_US << (BUCKET_COUNT - 2);
+
+  struct Histogram {
+    uint32_t count;
+    uint64_t totalUs;
+    uint32_t maxUs;
+    uint32_t buckets[BUCKET_COUNT];
+  };
+
+  struct Benchmark {
+    bool ran;
+    bool slow;  // Too slow to sustain logging: see MIN_BYTES_PER_SECOND, SLOW_WRITE_US and
+                // BENCHMARK_LIMIT_US
+    uint32_t bytesPerSecond;
+    Histogram writes;
+  };
+
+  // Short lowercase name, also used in the report
+  const char* name(Op op);
+
+  void record(Op op, uint32_t elapsedUs);
+
+  // A copy of op's histogram so far
+  Histogram histogram(Op op);
+
+  // Upper bound of the bucket holding the percent-th percentile latency; for the last bucket, and
+  // whenever it is lower, the longest latency seen
+  uint32_t percentileUs(const Histogram& histogram, uint8_t percent);
+
+  // Times the rest of the scope as one op
+  class Timer {
+   public:
+    explicit Timer(Op op) : op_(op), startUs_(micros()) {}
+    ~Timer() { record(op_, micros() - startUs_); }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+   private:
+    Op op_;
+    uint32_t startUs_;
+  };
+
+  // Benchmark the card just mounted and write the report; called by SDCard::mount
+  void runMountBenchmark();
+
+  // The benchmark of the card mounted last
+  Benchmark mountBenchmark();
+
+  // Write the histograms and benchmark to /diagnostics/sd_latency.csv, replacing what was there
+  bool writeReport();
+}  // namespace sd_latency
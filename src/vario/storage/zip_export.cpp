@@ -0,0 +1,282 @@
+#include "storage/zip_export.h"
+
+#include <time.h>
+#include <new>
+
+#include "storage/preallocated_file.h"
+
+namespace {
+  constexpr size_t COPY_BUFFER_BYTES = 4096;
+
+  constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+  constexpr uint32_t DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+  constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+  constexpr uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+
+  constexpr size_t LOCAL_HEADER_BYTES = 30;
+  constexpr size_t DATA_DESCRIPTOR_BYTES = 16;
+  constexpr size_t CENTRAL_HEADER_BYTES = 46;
+  constexpr size_t END_OF_CENTRAL_DIRECTORY_BYTES = 22;
+
+  constexpr uint16_t ZIP_VERSION = 20;  // 2.0: data descriptors
+  // Bit 3: sizes and CRC follow the data; bit 11: names are UTF-8
+  constexpr uint16_t ZIP_FLAGS = 0x0808;
+  constexpr uint16_t METHOD_STORED = 0;
+
+  constexpr time_t DOS_EPOCH = 315532800;  // 1980-01-01, the earliest time a zip can hold
+  constexpr uint32_t DOS_EPOCH_DATE_TIME = ((0 << 9) | (1 << 5) | 1) << 16;
+
+  struct CrcTable {
+    uint32_t entries[256];
+    constexpr CrcTable() : entries() {
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (uint8_t bit = 0; bit < 8; bit++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        entries[i] = c;
+      }
+    }
+  };
+  constexpr CrcTable CRC_TABLE;
+
+  // What the central directory needs to remember about each entry once its data has been sent
+  struct WrittenEntry {
+    uint32_t crc;
+    uint32_t size;
+  };
+
+  class HeaderBuffer {
+   public:
+    void put16(uint16_t value) {
+      bytes_[length_++] = value & 0xFF;
+      bytes_[length_++] = value >> 8;
+    }
+    void put32(uint32_t value) {
+      put16(value & 0xFFFF);
+      put16(value >> 16);
+    }
+    bool writeTo(Print& out) const { return out.write(bytes_, length_) == length_; }
+
+   private:
+    uint8_t bytes_[CENTRAL_HEADER_BYTES];
+    size_t length_ = 0;
+  };
+
+  bool endsWith(const char* name, const char* suffix) {
+    const size_t nameLength = strlen(name);
+    const size_t suffixLength = strlen(suffix);
+    return nameLength >= suffixLength &&
+           strcasecmp(name + nameLength - suffixLength, suffix) == 0;
+  }
+
+  // The bare file name; name() is the full path on some cores
+  const char* baseName(const File& file) {
+    const char* name = file.name();
+    const char* slash = strrchr(name, '/');
+    return slash ? slash + 1 : name;
+  }
+
+  bool included(const zip_export::Source& source, const File& file) {
+    if (file.isDirectory()) return false;
+    const char* name = baseName(file);
+    if (name[0] == '\0' || name[0] == '.' || endsWith(name, ".tmp") || endsWith(name, ".bak") ||
+        endsWith(name, ".preview.json")) {
+      return false;
+    }
+    // A log still being written grows between plan() and write(), and until it is closed its size
+    // on the card is its whole reservation
+    uint32_t written;
+    return !PreallocatedFile::writtenLength(String(source.directory) + "/" + name, written);
+  }
+
+  // "/tracks" -> "tracks"
+  const char* archiveDirectory(const zip_export::Source& source) {
+    const char* directory = source.directory;
+    while (*directory == '/') directory++;
+    return directory;
+  }
+
+  size_t entryNameLength(const zip_export::Source& source, const File& file) {
+    return strlen(archiveDirectory(source)) + 1 + strlen(baseName(file));
+  }
+
+  bool writeEntryName(Print& out, const zip_export::Source& source, const File& file) {
+    const char* directory = archiveDirectory(source);
+    const char* name = baseName(file);
+    return out.write(reinterpret_cast<const uint8_t*>(directory), strlen(directory)) ==
+               strlen(directory) &&
+           out.write('/') == 1 &&
+           out.write(reinterpret_cast<const uint8_t*>(name), strlen(name)) == strlen(name);
+  }
+
+  uint32_t dosDateTime(File& file) {
+    const time_t modified = file.getLastWrite();
+    if (modified < DOS_EPOCH) return DOS_EPOCH_DATE_TIME;
+    tm cal;
+    localtime_r(&modified, &cal);
+    const uint16_t date = ((cal.tm_year - 80) << 9) | ((cal.tm_mon + 1) << 5) | cal.tm_mday;
+    const uint16_t time = (cal.tm_hour << 11) | (cal.tm_min << 5) | (cal.tm_sec / 2);
+    return (static_cast<uint32_t>(date) << 16) | time;
+  }
+
+  // Calls visit(source, file) for every included file, in directory order
+  template <typename Visit>
+  bool forEachFile(fs::FS& fs, const zip_export::Source* sources, size_t sourceCount,
+                   Visit visit) {
+    for (size_t i = 0; i < sourceCount; i++) {
+      File dir = fs.open(sources[i].directory);
+      if (!dir || !dir.isDirectory()) continue;
+      for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        if (included(sources[i], file) && !visit(sources[i], file)) return false;
+      }
+    }
+    return true;
+  }
+
+  // The mutex, if any, is held only while each chunk is read: sending it can take as long as the
+  // client does, and the flight log's writers must not wait on that
+  bool copyFile(File& file, uint32_t size, SemaphoreHandle_t mutex, uint8_t* buffer, Print& out,
+                uint32_t& crc) {
+    crc = 0;
+    uint32_t remaining = size;
+    while (remaining > 0) {
+      const size_t want = remaining < COPY_BUFFER_BYTES ? remaining : COPY_BUFFER_BYTES;
+      if (mutex) xSemaphoreTake(mutex, portMAX_DELAY);
+      const int got = file.read(buffer, want);
+      if (mutex) xSemaphoreGive(mutex);
+      if (got <= 0) return false;
+      crc = zip_export::crc32(buffer, got, crc);
+      if (out.write(buffer, got) != static_cast<size_t>(got)) return false;
+      remaining -= got;
+    }
+    return true;
+  }
+}  // namespace
+
+namespace zip_export {
+  uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+      crc = CRC_TABLE.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+  }
+
+  bool plan(fs::FS& fs, const Source* sources, size_t sourceCount, Plan& plan) {
+    plan = Plan();
+    uint64_t bytes = END_OF_CENTRAL_DIRECTORY_BYTES;
+    uint32_t files = 0;
+    forEachFile(fs, sources, sourceCount, [&](const Source& source, File& file) {
+      const size_t nameLength = entryNameLength(source, file);
+      bytes += LOCAL_HEADER_BYTES + nameLength + file.size() + DATA_DESCRIPTOR_BYTES;
+      bytes += CENTRAL_HEADER_BYTES + nameLength;
+      files++;
+      return true;
+    });
+    if (files > UINT16_MAX || bytes > UINT32_MAX) return false;
+    plan.fileCount = files;
+    plan.archiveBytes = bytes;
+    return true;
+  }
+
+  bool write(fs::FS& fs, const Source* sources, size_t sourceCount, const Plan& plan,
+             Print& out) {
+    WrittenEntry* entries = new (std::nothrow) WrittenEntry[plan.fileCount ? plan.fileCount : 1];
+    uint8_t* buffer = new (std::nothrow) uint8_t[COPY_BUFFER_BYTES];
+    if (!entries || !buffer) {
+      delete[] entries;
+      delete[] buffer;
+      return false;
+    }
+
+    // Entries
+    uint32_t offset = 0;
+    uint16_t index = 0;
+    bool ok = forEachFile(fs, sources, sourceCount, [&](const Source& source, File& file) {
+      const uint32_t size = file.size();
+      const size_t nameLength = entryNameLength(source, file);
+      if (index >= plan.fileCount ||
+          static_cast<uint64_t>(offset) + LOCAL_HEADER_BYTES + nameLength + size +
+                  DATA_DESCRIPTOR_BYTES >
+              plan.archiveBytes) {
+        return false;
+      }
+
+      HeaderBuffer header;
+      header.put32(LOCAL_HEADER_SIGNATURE);
+      header.put16(ZIP_VERSION);
+      header.put16(ZIP_FLAGS);
+      header.put16(METHOD_STORED);
+      header.put32(dosDateTime(file));
+      header.put32(0);  // CRC and sizes are in the data descriptor
+      header.put32(0);
+      header.put32(0);
+      header.put16(nameLength);
+      header.put16(0);
+      if (!header.writeTo(out) || !writeEntryName(out, source, file)) return false;
+
+      uint32_t crc;
+      if (!copyFile(file, size, source.mutex, buffer, out, crc)) return false;
+
+      HeaderBuffer descriptor;
+      descriptor.put32(DATA_DESCRIPTOR_SIGNATURE);
+      descriptor.put32(crc);
+      descriptor.put32(size);
+      descriptor.put32(size);
+      if (!descriptor.writeTo(out)) return false;
+
+      entries[index++] = {crc, size};
+      offset += LOCAL_HEADER_BYTES + nameLength + size + DATA_DESCRIPTOR_BYTES;
+      return true;
+    });
+    delete[] buffer;
+    ok = ok && index == plan.fileCount;
+
+    // Central directory, from a second listing in the same order
+    const uint32_t centralDirectoryOffset = offset;
+    uint32_t entryOffset = 0;
+    uint16_t centralIndex = 0;
+    ok = ok && forEachFile(fs, sources, sourceCount, [&](const Source& source, File& file) {
+      if (centralIndex >= index) return false;
+      const WrittenEntry& entry = entries[centralIndex++];
+      const size_t nameLength = entryNameLength(source, file);
+
+      HeaderBuffer header;
+      header.put32(CENTRAL_HEADER_SIGNATURE);
+      header.put16(ZIP_VERSION);
+      header.put16(ZIP_VERSION);
+      header.put16(ZIP_FLAGS);
+      header.put16(METHOD_STORED);
+      header.put32(dosDateTime(file));
+      header.put32(entry.crc);
+      header.put32(entry.size);
+      header.put32(entry.size);
+      header.put16(nameLength);
+      header.put16(0);  // Extra field
+      header.put16(0);  // Comment
+      header.put16(0);  // Disk
+      header.put16(0);  // Internal attributes
+      header.put32(0);  // External attributes
+      header.put32(entryOffset);
+      if (!header.writeTo(out) || !writeEntryName(out, source, file)) return false;
+
+      entryOffset += LOCAL_HEADER_BYTES + nameLength + entry.size + DATA_DESCRIPTOR_BYTES;
+      offset += CENTRAL_HEADER_BYTES + nameLength;
+      return true;
+    });
+    delete[] entries;
+    ok = ok && centralIndex == index;
+    if (!ok) return false;
+
+    HeaderBuffer end;
+    end.put32(END_OF_CENTRAL_DIRECTORY_SIGNATURE);
+    end.put16(0);
+    end.put16(0);
+    end.put16(index);
+    end.put16(index);
+    end.put32(offset - centralDirectoryOffset);
+    end.put32(centralDirectoryOffset);
+    end.put16(0);
+    if (!end.writeTo(out)) return false;
+    return offset + END_OF_CENTRAL_DIRECTORY_BYTES == plan.archiveBytes;
+  }
+}  // namespace zip_export
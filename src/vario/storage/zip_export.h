@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Arduino.h"
+#include "FS.h"
+#include "FreeRTOS.h"
+
+// Streams the files of a few SD card directories to a client as one zip archive, built on the fly.
+//
+// Entries are stored uncompressed: IGC and JSON would deflate well, but deflating on the ESP32
+// costs more time than the radio saves, and stored entries let the archive's exact size be known
+// before any data is read, so the download gets a Content-Length and a progress bar.  The CRC of
+// each entry is computed as it is sent and written in a data descriptor after the file, so memory
+// use is one copy buffer plus 8 bytes per file (for the central directory at the end).
+//
+// Only regular files directly in each directory are included; dot files, interrupted writes
+// (*.tmp, *.bak), regenerable track preview sidecars and a track still being logged are skipped.
+namespace zip_export {
+  struct Source {
+    const char* directory;  // "/tracks"; entries are named "tracks/<file>"
+    // Held while each chunk of a file in this directory is read (not while it is sent), or NULL
+    SemaphoreHandle_t mutex;
+  };
+
+  struct Plan {
+    uint16_t fileCount = 0;
+    uint32_t archiveBytes = 0;
+  };
+
+  // Size the archive from the directory listings alone.  Returns false if the archive would be too
+  // large for a zip without Zip64 extensions.
+  bool plan(fs::FS& fs, const Source* sources, size_t sourceCount, Plan& plan);
+
+  // Write the archive planned by plan().  Returns false, having written a truncated archive, if
+  // the client stopped reading or the directories changed since plan() (the Content-Length sent
+  // from the plan would no longer be right, so the client must see a failed download).
+  bool write(fs::FS& fs, const Source* sources, size_t sourceCount, const Plan& plan, Print& out);
+
+  // Standard zip / gzip CRC-32; pass the previous result to continue a running CRC
+  uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+}  // namespace zip_export
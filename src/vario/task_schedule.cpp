@@ -0,0 +1,142 @@
+#include "task_schedule.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#include "diagnostics/cpu_utilization.h"
+
+namespace task_schedule {
+  namespace {
+    const Task* tasks_ = nullptr;
+    uint8_t count_ = 0;
+
+    // Set by the realtime loop as each block starts and cleared by the core that runs the task
+    std::atomic<uint32_t> due_{0};  // Bit n: tasks_[n] has yet to run
+    std::atomic<uint8_t> block_{0};
+    // micros() when the current block started, or 0 before the first block
+    std::atomic<uint32_t> blockStartUs_{0};
+    uint32_t coreTasks_[CORE_COUNT];  // Bit n: tasks_[n] runs on that core
+
+    // Each task's entries are only written by the core it runs on
+    Stats stats_[MAX_TASKS];
+    // Block start of each task's last scheduled run, or 0
+    uint32_t lastBlockStartUs_[MAX_TASKS];
+
+    // Run times come from the CPU cycle counter rather than micros(): it is finer, and in leafsim,
+    // where micros() is virtual and stands still while firmware code runs, it counts host time.
+    uint32_t elapsedUs(uint32_t startCycles) {
+      return (ESP.getCycleCount() - startCycles) / ESP.getCpuFreqMHz();
+    }
+
+    void record(uint8_t index, uint32_t runUs, uint32_t blockStartUs, uint32_t endUs) {
+      const Task& task = tasks_[index];
+      Stats& s = stats_[index];
+      s.runs++;
+      s.totalUs += runUs;
+      if (runUs > s.maxUs) s.maxUs = runUs;
+      const bool overBudget = runUs > task.budgetUs;
+      if (overBudget) s.overBudget++;
+
+      bool missed = false;
+      if (blockStartUs != 0) {
+        missed = endUs - blockStartUs > BLOCK_US;
+        if (missed) s.deadlineMisses++;
+
+        if (lastBlockStartUs_[index] != 0) {
+          const int32_t interval = blockStartUs - lastBlockStartUs_[index];
+          const int32_t deviation = interval - (int32_t)(task.period * BLOCK_US);
+          const uint32_t jitter = deviation < 0 ? -deviation : deviation;
+          s.totalJitterUs += jitter;
+          if (jitter > s.maxJitterUs) s.maxJitterUs = jitter;
+        }
+        lastBlockStartUs_[index] = blockStartUs;
+      }
+
+      cpu_utilization::recordTask(index, runUs, overBudget, missed);
+    }
+  }  // namespace
+
+  void init(const Task* tasks, uint8_t count) {
+    tasks_ = tasks;
+    count_ = count > MAX_TASKS ? MAX_TASKS : count;
+    memset(coreTasks_, 0, sizeof(coreTasks_));
+    for (uint8_t i = 0; i < count_; i++) coreTasks_[(uint8_t)tasks_[i].core] |= 1u << i;
+    block_.store(0, std::memory_order_relaxed);
+    blockStartUs_.store(0, std::memory_order_relaxed);
+    resetStats();
+    due_.store(count_ == MAX_TASKS ? UINT32_MAX : (1u << count_) - 1, std::memory_order_release);
+  }
+
+  void beginBlock(uint8_t block) {
+    uint32_t startUs = micros();
+    if (startUs == 0) startUs = 1;  // 0 means "no block yet"
+    block_.store(block, std::memory_order_relaxed);
+    blockStartUs_.store(startUs, std::memory_order_relaxed);
+    uint32_t due = 0;
+    for (uint8_t i = 0; i < count_; i++) {
+      if (runsIn(tasks_[i], block)) due |= 1u << i;
+    }
+    due_.fetch_or(due, std::memory_order_release);
+  }
+
+  void runDue(Core core) {
+    const uint32_t mine = coreTasks_[(uint8_t)core];
+    uint32_t due = due_.fetch_and(~mine, std::memory_order_acquire) & mine;
+    if (due == 0) return;
+    // A service core that fell behind runs everything still due once, against the latest block
+    const uint8_t block = block_.load(std::memory_order_relaxed);
+    const uint32_t blockStartUs = blockStartUs_.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; due != 0 && i < count_; i++) {
+      if (!(due & (1u << i))) continue;
+      due &= ~(1u << i);
+      const uint32_t startCycles = ESP.getCycleCount();
+      tasks_[i].run(block);
+      const uint32_t runUs = elapsedUs(startCycles);
+      record(i, runUs, blockStartUs, micros());
+    }
+  }
+
+  uint8_t taskCount() { return count_; }
+
+  const Task& task(uint8_t index) { return tasks_[index]; }
+
+  const Stats& stats(uint8_t index) { return stats_[index]; }
+
+  void resetStats() {
+    memset(stats_, 0, sizeof(stats_));
+    memset(lastBlockStartUs_, 0, sizeof(lastBlockStartUs_));
+  }
+
+  uint32_t averageUs(const Stats& stats) {
+    if (stats.runs == 0) return 0;
+    return (stats.totalUs + stats.runs / 2) / stats.runs;
+  }
+
+  const char* coreName(Core core) { return core == Core::Realtime ? "realtime" : "service"; }
+
+  void logBudgets() {
+    for (uint8_t c = 0; c < CORE_COUNT; c++) {
+      const Core core = (Core)c;
+      for (uint8_t block = 0; block < BLOCKS_PER_CYCLE; block++) {
+        uint32_t budgetUs = 0;
+        uint8_t heavy = 0;
+        for (uint8_t i = 0; i < count_; i++) {
+          if (tasks_[i].core != core || !runsIn(tasks_[i], block)) continue;
+          budgetUs += tasks_[i].budgetUs;
+          if (tasks_[i].budgetUs >= HEAVY_BUDGET_US) heavy++;
+        }
+        if (budgetUs <= BLOCK_US && heavy <= 1) continue;
+
+        Serial.printf("Task block %u is over-booked on the %s core: %luus budgeted", block,
+                      coreName(core), static_cast<unsigned long>(budgetUs));
+        for (uint8_t i = 0; i < count_; i++) {
+          if (tasks_[i].core == core && runsIn(tasks_[i], block)) {
+            Serial.printf(" %s=%u", tasks_[i].name, tasks_[i].budgetUs);
+          }
+        }
+        Serial.println();
+      }
+    }
+  }
+}  // namespace task_schedule
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+
+// Runs the main loop's tasks from a table instead of a hand-written switch.
+//
+// Work is done in 10ms blocks that repeat in a 1-second pattern of 100 blocks.  Each task declares
+// how often it runs (every `period` blocks), which block it starts in (`phase`) and how long it is
+// expected to take (`budgetUs`).  The scheduler times every run and keeps per-task statistics:
+// run time, runs over budget, runs that finished after their block ended (deadline misses), and
+// jitter in the interval between runs.  The statistics feed the CPU utilization log, the debug
+// page and leafsim.
+//
+// Each task also names the core it runs on.  The realtime loop (core 1) starts every block and runs
+// the sensor, filter, audio and button tasks; the service task (core 0) then runs the logging,
+// display, navigation and comms tasks that became due in the same block (see taskman.h).
+//
+// A schedule is checked when it is compiled (heavyTasksShareBlock) and again at boot (logBudgets),
+// so a new task cannot quietly land in the same block as another heavy one on its core.
+namespace task_schedule {
+  constexpr uint8_t BLOCKS_PER_CYCLE = 100;
+  constexpr uint32_t BLOCK_US = 10000;
+  // Tasks budgeted at least this long should each have their blocks to themselves
+  constexpr uint16_t HEAVY_BUDGET_US = 2000;
+  constexpr uint8_t MAX_TASKS = 32;
+
+  enum class Core : uint8_t { Realtime, Service };
+  constexpr uint8_t CORE_COUNT = 2;
+
+  struct Task {
+    const char* name;   // Also a CSV column prefix, so letters, digits and underscores only
+    Core core;
+    uint8_t period;     // Runs every `period` blocks; must divide BLOCKS_PER_CYCLE
+    uint8_t phase;      // First block it runs in, 0 to period - 1
+    uint16_t budgetUs;  // Expected worst-case run time
+    void (*run)(uint8_t block);
+  };
+
+  struct Stats {
+    uint32_t runs;
+    uint64_t totalUs;
+    uint32_t maxUs;
+    uint32_t overBudget;      // Runs that took longer than budgetUs
+    uint32_t deadlineMisses;  // Runs that finished after the end of their block
+    uint32_t maxJitterUs;     // Largest difference between the interval since the last run and
+                              // the period
+    uint64_t totalJitterUs;
+  };
+
+  constexpr bool runsIn(const Task& task, uint8_t block) {
+    return block % task.period == task.phase;
+  }
+
+  template <size_t N>
+  constexpr bool validSchedule(const Task (&tasks)[N]) {
+    if (N > MAX_TASKS) return false;
+    for (const Task& task : tasks) {
+      if (task.period == 0 || BLOCKS_PER_CYCLE % task.period != 0 || task.phase >= task.period ||
+          task.run == nullptr || (uint8_t)task.core >= CORE_COUNT) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Heavy tasks on different cores run side by side, so only tasks on the same core collide
+  template <size_t N>
+  constexpr bool heavyTasksShareBlock(const Task (&tasks)[N]) {
+    for (uint8_t block = 0; block < BLOCKS_PER_CYCLE; block++) {
+      uint8_t heavy[CORE_COUNT] = {};
+      for (const Task& task : tasks) {
+        if (task.budgetUs < HEAVY_BUDGET_US || !runsIn(task, block)) continue;
+        if (++heavy[(uint8_t)task.core] > 1) return true;
+      }
+    }
+    return false;
+  }
+
+  // Use this table, which must outlive the scheduler.  Every task is due once straight away, so
+  // they all run at startup before the first block.
+  void init(const Task* tasks, uint8_t count);
+
+  // Start a 10ms block: the tasks that run in it become due, on both cores
+  void beginBlock(uint8_t block);
+
+  // Run the tasks on this core that are due, in table order.  Call from that core only.
+  void runDue(Core core);
+
+  uint8_t taskCount();
+  const Task& task(uint8_t index);
+  const Stats& stats(uint8_t index);
+  void resetStats();
+
+  // Mean run time in microseconds, rounded
+  uint32_t averageUs(const Stats& stats);
+
+  const char* coreName(Core core);
+
+  // Print the budget of every block that is over-booked or has more than one heavy task on a core
+  void logBudgets();
+}  // namespace task_schedule
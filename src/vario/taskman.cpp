@@ -6,7 +6,6 @@
 #include "task.h"
 
 #include "comms/ble.h"
-#include "comms/factory_discovery.h"
 #include "comms/fanet_radio.h"
 #include "comms/leaf_log_sync.h"
 #include "diagnostics/cpu_utilization.h"
@@ -30,8 +29,10 @@
 #include "power.h"
 #include "storage/sd_card.h"
 #include "system/usb_state.h"
+#include "task_schedule.h"
 #include "ui/audio/speaker.h"
 #include "ui/display/display.h"
+#include "ui/input/button_dispatcher.h"
 #include "ui/input/buttons.h"
 #include "ui/settings/settings.h"
 #include "utils/magic_enum.h"
@@ -52,8 +53,6 @@
 // of data around, so, we do it on the stack.  Default is 8KB
 SET_LOOP_TASK_STACK_SIZE(12 * 1024);  // 12KB
 
-#define DEBUG_MAIN_LOOP false
-
 namespace {
   std::atomic<bool> timerISRsSetup{false};
 
@@ -61,7 +60,16 @@ namespace {
   const uint64_t TASK_TIMER_PERIOD_MS = 10;  // trigger the ISR every 10ms
   // Set by interrupt at the start of the next task time block
   std::atomic<bool> nextTaskTimerBlock{false};
-  void IRAM_ATTR onTaskTimer() { nextTaskTimerBlock.store(true, std::memory_order_release); }
+  // The Arduino loop task, which sleeps between blocks until the timer wakes it
+  TaskHandle_t loopTask = NULL;
+  void IRAM_ATTR onTaskTimer() {
+    nextTaskTimerBlock.store(true, std::memory_order_release);
+    if (loopTask) {
+      BaseType_t woken = pdFALSE;
+      xTaskNotifyFromISR(loopTask, 0, eIncrement, &woken);
+      portYIELD_FROM_ISR(woken);
+    }
+  }
 
   const uint32_t CHARGE_TIMER_FREQ = 1000;      // run at 1000Hz
   const uint64_t CHARGE_TIMER_PERIOD_MS = 500;  // trigger the ISR every 500ms
@@ -90,19 +98,218 @@ namespace {
   bool loggedFirstSdCardTask = false;
   bool loggedFirstSelfTestTask = false;
   bool loggedFirstDiagnosticNetwork = false;
-  bool loggedFirstFactoryDiscovery = false;
+
+  // Vario bar redraws between the twice-a-second display updates (10ms block 9 of 100ms blocks 3
+  // and 8) run in 10ms block 4, which is otherwise free.  That gives five slots per update, 50,
+  // 150, 250, 350 and 450ms after it; bit n of entry k marks slot n as used when k redraws are
+  // wanted, spaced as evenly as the slots allow.
+  constexpr uint8_t VARIO_LAYER_SLOTS[] = {0b00000, 0b00100, 0b01010, 0b01110, 0b11110};
+
+  bool varioLayerDue(uint8_t current100msBlock, int8_t varioBarHz) {
+    int8_t redraws = (varioBarHz - 2) / 2;  // per display update
+    if (redraws <= 0) return false;
+    if (redraws > 4) redraws = 4;
+    const uint8_t slot = (current100msBlock + 6) % 5;  // 0 in the block after a display update
+    return VARIO_LAYER_SLOTS[redraws] & (1 << slot);
+  }
 
   void checkpointOnce(bool& logged, const char* event) {
     if (logged) return;
     logged = true;
     heap_monitor::checkpoint(event);
   }
+
+  bool restoredNavAfterFirstDisplayUpdate = false;
+
+  // begin updating MS5611 every 50ms; the baro task then reads it in the same block
+  void runBaroAdc(uint8_t) { ms5611.update(); }
+
+  // Do MS5611 first, because the ADC prep & read cycle is time dependent (must have >9ms between
+  // prep & read).  If other tasks delay the start of the MS5611 prep step by >1ms, then next cycle
+  // when we read ADC, the MS5611 won't be ready.
+  void runBaro(uint8_t) {
+    ms5611.update();
+    checkpointOnce(loggedFirstBaroTask, "task-baro-first");
+  }
+
+  void runButtons(uint8_t) {
+    buttons.update();
+    checkpointOnce(loggedFirstButtonsTask, "task-buttons-first");
+  }
+
+  void runSpeaker(uint8_t) {
+    speaker.update();
+    checkpointOnce(loggedFirstSpeakerTask, "task-speaker-first");
+  }
+
+  void runWind(uint8_t) {
+    windEstimator.estimateWind();
+    checkpointOnce(loggedFirstWindTask, "task-wind-first");
+  }
+
+  void runImu(uint8_t) {
+    ICM20948::getInstance().update();
+    checkpointOnce(loggedFirstImuTask, "task-imu-first");
+  }
+
+  // Every half second; this avoids any aliasing issues if we keep trying to update GPS in the
+  // middle of an NMEA sentence string
+  void runGps(uint8_t) {
+    gps.update();
+    checkpointOnce(loggedFirstGpsTask, "task-gps-first");
+  }
+
+  void runThermalDetector(uint8_t) {
+    if (settings.labs_thermalCore || settings.labs_thermalTrack) thermalTracker.updateDetector();
+  }
+
+  void runThermalNavigation(uint8_t) {
+    if (settings.labs_thermalTrack) thermalTracker.updateNavigation();
+    if (settings.labs_thermalCore) thermalCore.update();
+  }
+
+  // check battery, check auto-turn-off, etc
+  void runPower(uint8_t) {
+    power.update();
+    checkpointOnce(loggedFirstPowerTask, "task-power-first");
+  }
+
+  // check auto-start, increment timers, update log file, etc
+  void runLog(uint8_t) {
+    log_update();
+    checkpointOnce(loggedFirstLogTask, "task-log-first");
+  }
+
+  // record each new GPS fix in the tracklog; twice as often as the fastest GPS rate, so none are
+  // missed
+  void runTrack(uint8_t) { log_updateTrack(); }
+
+  void runDisplay(uint8_t block) {
+    checkpointOnce(loggedFirstDisplayTask, "task-display-before");
+    display.update();
+    cpu_utilization::recordDisplayContext(block, static_cast<uint8_t>(display.lastRenderContext()));
+    checkpointOnce(loggedFirstDisplayAfterTask, "task-display-after");
+    if (!restoredNavAfterFirstDisplayUpdate) {
+      restoredNavAfterFirstDisplayUpdate = true;
+      if (sdcard.isMounted()) {
+        heap_monitor::checkpoint("task-nav-restore-start");
+        navigator.loadPersistedState(false);
+        heap_monitor::checkpoint("task-nav-restore-state");
+        user_waypoints::loadIntoNavigator();
+        heap_monitor::checkpoint("task-nav-restore-end");
+      }
+    }
+  }
+
+  void runVarioLayer(uint8_t block) {
+    if (!varioLayerDue(block / 10, settings.disp_varioBarHz)) return;
+    display.updateVarioLayer();
+    cpu_utilization::recordDisplayContext(block, static_cast<uint8_t>(display.lastRenderContext()));
+  }
+
+  // (1) trigger temp & humidity measurements, (2) process values and save
+  void runTempRh(uint8_t) {
+    aht20.update();
+    checkpointOnce(loggedFirstTempRhTask, "task-temp-rh-first");
+  }
+
+  // check if SD card state has changed and remount if needed
+  void runSdCard(uint8_t) {
+    sdcard.update();
+    checkpointOnce(loggedFirstSdCardTask, "task-sdcard-first");
+  }
+
+  void runCpuReport(uint8_t) { cpu_utilization::writePendingReport(); }
+
+  void runSelfTest(uint8_t) {
+    if (!selfTest.updateNeeded()) return;
+    selfTest.update();
+    checkpointOnce(loggedFirstSelfTestTask, "task-self-test-first");
+  }
+
+#ifdef MEMORY_PROFILING
+  void runMemoryStats(uint8_t) { printMemoryUsage(); }
+#endif
+
+  // The main loop's cadence.  Blocks are numbered 0-99 through each second (block 39 is the 10th
+  // 10ms block of the 4th 100ms block); a task runs in the blocks where block % period == phase,
+  // in table order.  Budgets are what each task took in the CPU utilization captures, with room to
+  // spare; a task budgeted at HEAVY_BUDGET_US or more needs blocks no other heavy task on its core
+  // uses.
+  //
+  // Realtime tasks sample the sensors, run their filters and feed the speaker and button queues,
+  // and never wait on the SD card, the LCD or the radio.  Everything else is a service task.
+  using task_schedule::Core;
+  constexpr task_schedule::Task SCHEDULE[] = {
+      // name, core, period (blocks), phase, budget (us), run
+      {"baro_adc", Core::Realtime, 5, 0, 300, runBaroAdc},
+      {"baro", Core::Realtime, 1, 0, 500, runBaro},
+      {"buttons", Core::Realtime, 1, 0, 200, runButtons},
+      {"speaker", Core::Realtime, 1, 0, 100, runSpeaker},
+      {"imu", Core::Realtime, 5, 2, 3000, runImu},
+      {"temp_rh", Core::Realtime, 50, 49, 500, runTempRh},
+      {"wind", Core::Service, 10, 2, 800, runWind},
+      {"gps", Core::Service, 50, 9, 1200, runGps},
+      {"thermal_detect", Core::Service, 100, 19, 800, runThermalDetector},
+      {"thermal_nav", Core::Service, 50, 19, 500, runThermalNavigation},
+      {"power", Core::Service, 100, 79, 1000, runPower},
+      {"log", Core::Service, 100, 29, 1500, runLog},
+      {"track", Core::Service, 5, 1, 1000, runTrack},
+      {"display", Core::Service, 50, 39, 6000, runDisplay},
+      {"vario_layer", Core::Service, 10, 4, 1500, runVarioLayer},
+      {"sd_card", Core::Service, 100, 79, 1000, runSdCard},
+      {"cpu_report", Core::Service, 100, 3, 8000, runCpuReport},
+      {"self_test", Core::Service, 1, 0, 200, runSelfTest},
+#ifdef MEMORY_PROFILING
+      {"memory_stats", Core::Service, 100, 99, 3000, runMemoryStats},
+#endif
+  };
+  static_assert(task_schedule::validSchedule(SCHEDULE),
+                "Every task needs a core, a period dividing 100 blocks, a phase below its period "
+                "and a run function, and there can be at most task_schedule::MAX_TASKS of them");
+  static_assert(!task_schedule::heavyTasksShareBlock(SCHEDULE),
+                "Two heavy tasks run in the same 10ms block on one core; give one of them another "
+                "phase");
+
+  // As big as the loop task's: the display and logbook keep large buffers on the stack
+  constexpr uint32_t SERVICE_TASK_STACK_BYTES = 12 * 1024;
+  // Above the display send (3) and web server (2) tasks that share its core, so the next block's
+  // tasks are not held up by a frame still being sent or a download
+  constexpr UBaseType_t SERVICE_TASK_PRIORITY = 5;
+  constexpr BaseType_t SERVICE_TASK_CORE = 0;
+
+  TaskHandle_t serviceTask = NULL;
+
+  void serviceTaskMain(void*) {
+    Serial.printf("Service tasks running on core %d\n", xPortGetCoreID());
+    for (;;) {
+      // Woken by the realtime loop at the start of every block
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      if (power.info().onState != PowerState::On) continue;  // The loop handles charging alone
+
+      MainLoopLockGuard mainLoopLock;
+      // Display, power and self-test changes requested by web handlers
+      webserver_main_loop();
+      buttonDispatcher.dispatchPending();
+      task_schedule::runDue(Core::Service);
+      // NMEA sentences the UART driver assembled since the last block
+      lc86g.publishPending();
+      diagnostic_network.update();
+      checkpointOnce(loggedFirstDiagnosticNetwork, "task-diag-net-first");
+    }
+  }
 }  // namespace
 
+SemaphoreHandle_t MainLoopLockGuard::mutex = NULL;
+SemaphoreHandle_t RealtimeLockGuard::mutex = NULL;
+
 /////////////////////////////////////////////////
 //             SETUP              ///////////////
 /////////////////////////////////////////////////
 void TaskManager::init() {
+  MainLoopLockGuard::mutex = xSemaphoreCreateMutex();
+  RealtimeLockGuard::mutex = xSemaphoreCreateMutex();
+
 #ifdef DEBUG_WIFI
   // Start WiFi
   WiFi.begin();
@@ -125,8 +332,12 @@ void TaskManager::init() {
 #endif
   heap_monitor::checkpoint("taskman-power-end");
 
+  task_schedule::init(SCHEDULE, sizeof(SCHEDULE) / sizeof(SCHEDULE[0]));
+  task_schedule::logBudgets();
+
   if (!timerISRsSetup.exchange(false, std::memory_order_acq_rel)) {
     heap_monitor::checkpoint("taskman-timers-start");
+    loopTask = xTaskGetCurrentTaskHandle();
     // Start Main System Timer for Interrupt Events (this will tell Main Loop to set tasks every
     // interrupt cycle)
     taskTimer_ = timerBegin(TASK_TIMER_FREQ);
@@ -147,6 +358,18 @@ void TaskManager::init() {
     fatalError("Attempted to set up singleton task timers when they were already set up");
   }
 
+  // Logging, display, navigation and comms run on the other core, a block at a time
+  if (!serviceTask) {
+    if (xTaskCreatePinnedToCore(serviceTaskMain, "Service", SERVICE_TASK_STACK_BYTES, NULL,
+                                SERVICE_TASK_PRIORITY, &serviceTask, SERVICE_TASK_CORE) != pdPASS) {
+      fatalError("Could not start the service task");
+    }
+    heap_monitor::registerTask("service", serviceTask);
+  }
+
+  // Serve the web app and factory discovery from their own task, off this loop
+  webserver_start_task();
+
   // All done!
   Serial.println("Finished Setup");
 }
@@ -155,15 +378,21 @@ void TaskManager::init() {
 // Main Loop for Processing Tasks ///////////////
 /////////////////////////////////////////////////
 /*
-The main loop prioritizes processesing any data in the serial buffer so as not to miss any NMEA GPS
-characters. When the serial buffer is empty, the main loop will move on to processing any other
-remaining tasks.
-
-The gps serial port is considered 'quiet' if we received the last character of the last NMEA
-sentence.  We shouldn't expect more sentences for awhile (~1 second GPS updates) If the serial port
-is quiet, and all tasks are done, then the processor will go to sleep for the remainder of the 10ms
-time block. Every 10ms, driven by an interrupt timer, the system will wake up, set flags for which
-tasks are needed, and then return to running the main loop.
+The work is split between the two cores.  The main loop (this Arduino loop task, on core 1) is the
+realtime side: every 10ms, driven by an interrupt timer, it starts a block and runs the sensor,
+filter, audio and button tasks due in it, then wakes the service task on core 0.  The service task
+runs the logging, display, navigation and comms tasks due in the same block, dispatches the button
+events the realtime side queued, and publishes the NMEA sentences the GPS UART driver assembled
+since the last block.  Between blocks the main loop sleeps until the timer interrupt wakes it, so
+core 1 idles rather than polling the timer flag or the serial port.
+
+Nothing on the realtime side waits for the service side: button events and speaker commands cross
+in bounded lock-free queues, the barometer, IMU and ambient readings are published whole through
+seqlocks (utils/seqlock.h), and if the service side falls behind, its tasks run late rather than
+delaying the next block's sensor reads.
+
+While the device is charging the main loop does everything itself, every 500ms, and may sleep in
+between.
 
 TODO: In addition to the timer-driven interrupt, we may consider also setting wake-up interrupts for
 the pushbuttons, the GPS 1PPS signal, and perhaps others.
@@ -173,13 +402,6 @@ void TaskManager::update() {
   // when re-entering PowerState::On, be sure to start from tasks #1, so baro ADC can be re-prepped
   // before reading
 
-  if (sdcard.firmwareOwnsMassStorage() &&
-      (WiFi.status() == WL_CONNECTED || webserver_user_app_active())) {
-    webserver_setup();
-    webserver_loop();
-    factoryDiscovery.update();
-  }
-
   if (millis() - lastMemoryHeartbeatMs >= MEMORY_HEARTBEAT_MS) {
     lastMemoryHeartbeatMs = millis();
     heap_monitor::checkpoint("main-heartbeat");
@@ -197,6 +419,9 @@ void TaskManager::update() {
 
 void TaskManager::updateWhileCharging() {
   if (nextChargeTimerBlock.exchange(false, std::memory_order_acq_rel)) {
+    MainLoopLockGuard mainLoopLock;
+    // Display, power and self-test changes requested by web handlers
+    webserver_main_loop();
     leafLogSync.update();
     if (leafLogSync.takePowerOnReady()) {
       display.clear();
@@ -225,6 +450,7 @@ void TaskManager::updateWhileCharging() {
 
     // Check Buttons
     buttons.update();  // check Button for any presses (user can turn ON from charging state)
+    buttonDispatcher.dispatchPending();
 
     // Prep to end this cycle and sleep
     if (buttons.inspectPins() == Button::NONE && diagnostic_network.canSleepWhileCharging() &&
@@ -276,242 +502,35 @@ void TaskManager::updateWhileCharging() {
 }
 
 void TaskManager::updateWhileOn() {
-  bool startedTaskBlock = false;
-  bool recordCpuUtilization = false;
-  uint32_t taskBlockStartUs = 0;
-  uint8_t taskBlockIndex = 0;
-  uint8_t taskBlockButtonMask = 0;
-  uint8_t taskBlockDisplayContext = 0;
-
-  // Check flag set by timer interrupt
-  if (nextTaskTimerBlock.exchange(false, std::memory_order_acq_rel)) {
-    startedTaskBlock = true;
-    recordCpuUtilization = cpu_utilization::enabled();
-    taskBlockStartUs = static_cast<uint32_t>(micros());
-    if (recordCpuUtilization) {
-      taskBlockButtonMask = cpu_utilization::buttonPinMask(buttons.inspectPins());
-      display.clearLastRenderContext();
-    }
-    // We only do this once every 10ms
-    setNecessaryTasksForBlock();
-    taskBlockIndex = current100msBlock * 10 + current10msBlock;
+  // Check flag set by timer interrupt, sleeping until it is set.  The wait times out after a block
+  // in case the notification was taken by an earlier wait that found the flag already set.
+  if (!nextTaskTimerBlock.exchange(false, std::memory_order_acq_rel)) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TASK_TIMER_PERIOD_MS));
+    if (!nextTaskTimerBlock.exchange(false, std::memory_order_acq_rel)) return;
   }
 
-  doNecessaryTasks();
-
-  if (startedTaskBlock && recordCpuUtilization) {
-    taskBlockButtonMask |= cpu_utilization::buttonPinMask(buttons.inspectPins());
-    taskBlockDisplayContext = static_cast<uint8_t>(display.lastRenderContext());
-    cpu_utilization::recordBlock(taskBlockIndex, taskBlockStartUs, static_cast<uint32_t>(micros()),
-                                 taskBlockButtonMask, taskBlockDisplayContext);
-  }
-
-  // GPS Serial Buffer Read
-  // stop reading if no more data is available, OR, if our 10ms time block is up (because main timer
-  // interrupt fired and set setTasks to true)
-  bool gpsHasData = true;
-  while (gpsHasData && !nextTaskTimerBlock.load(std::memory_order_acquire)) {
-    gpsHasData = lc86g.readLine();
-  }
-}
-
-void TaskManager::setNecessaryTasksForBlock() {
-  // increment time counters
-  if (++current10msBlock >= 10) {
-    current10msBlock = 0;  // every 10 periods of 10ms, go back to 0 (100ms total)
-    if (++current100msBlock >= 10) {
-      current100msBlock = 0;  // every 10 periods of 100ms, go back to 0 (1sec total)
-    }
-  }
-
-  // tasks to complete every 10ms
-  performTask.buttons = true;
-  performTask.baro = true;
-  performTask.speakerTimer = true;
-  if (selfTest.updateNeeded())
-    performTask.selfTest = true;
-  else
-    (performTask.selfTest = false);
-
-  // set additional tasks to complete, broken down into 10ms block cycles.  (embedded if()
-  // statements allow for tasks every second, spaced out on different 100ms blocks)
-  switch (current10msBlock) {
-    case 0:
-      ms5611.update();  // begin updating MS5611 every 50ms on the 0th and 5th blocks
-      break;
-    case 1:
-      break;
-    case 2:
-      performTask.imu = true;           // update accel every 50ms during the 2nd & 7th blocks
-      performTask.estimateWind = true;  // estimate wind speed and direction
-      break;
-    case 3:
-      if (current100msBlock == 0) performTask.cpuUtilization = true;
-      break;
-    case 4:
-      break;
-    case 5:
-      ms5611.update();  // begin updating MS5611 every 50ms on the 0th and 5th blocks
-      break;
-    case 6:
-      break;
-    case 7:
-      performTask.imu = true;  // update accel every 50ms during the 2nd & 7th blocks
-      break;
-    case 8:
-      break;
-    case 9:
-
-      // Tasks every second complete here in the 9th 10ms block.  Pick a unique 100ms block for each
-      // task to space things out
-
-      if (current100msBlock == 0 || current100msBlock == 5)
-        performTask.gps =
-            true;  // gps update every half second (this avoids any aliasing issues if we
-                   // keep trying to update GPS in the middle of an NMEA sentence string)
-      if (current100msBlock == 1) {
-        performTask.thermalDetector = true;    // every second: thermal detector
-        performTask.thermalNavigation = true;  // every half second: thermal nav/display cache
-      }
-      if (current100msBlock == 2) performTask.log = true;  // every second: logging
-      if (current100msBlock == 3 || current100msBlock == 8)
-        performTask.display = 1;  // Update LCD every half-second on the 3rd and 8th 100ms blocks
-      if (current100msBlock == 4)
-        performTask.tempRH = true;  // trigger the start of a new temp & humidity measurement
-      // 5 - gps
-      if (current100msBlock == 6)
-        performTask.thermalNavigation = true;  // every half second: thermal nav/display cache
-      if (current100msBlock == 7) {
-        performTask.power = true;   // every second: power checks
-        performTask.sdCard = true;  // check if SD card state has changed and remount if needed
-      }
-// 8 - LCD
-#ifdef MEMORY_PROFILING
-      if (current100msBlock == 9) {
-        performTask.memoryStats = 1;
-      }
-#endif
-      if (current100msBlock == 9)
-        performTask.tempRH = true;  // read and process temp & humidity measurement
-      break;
+  const bool recordCpuUtilization = cpu_utilization::enabled();
+  const uint32_t taskBlockStartUs = static_cast<uint32_t>(micros());
+  uint8_t taskBlockButtonMask = 0;
+  if (recordCpuUtilization) {
+    taskBlockButtonMask = cpu_utilization::buttonPinMask(buttons.inspectPins());
   }
-}
 
-// execute necessary tasks while we're awake and have things to do
-void TaskManager::doNecessaryTasks(void) {
-  // just for capturing start time of taskmanager loop
-  if (performTask.buttons && DEBUG_MAIN_LOOP) {
-    tNecessaryTasksStart = micros();
-    performedNecessaryTasks = true;
-  }
+  {
+    // Held off while the service core powers the sensors down
+    RealtimeLockGuard realtimeLock;
+    if (power.info().onState != PowerState::On) return;
 
-  // Do MS5611 first, because the ADC prep & read cycle is time dependent (must have >9ms between
-  // prep & read).  If other tasks delay the start of the MS5611 prep step by >1ms, then next cycle
-  // when we read ADC, the MS5611 won't be ready.
-  if (performTask.baro) {
-    ms5611.update();
-    checkpointOnce(loggedFirstBaroTask, "task-baro-first");
-    performTask.baro = false;
-  }
-  if (performTask.buttons) {
-    buttons.update();
-    checkpointOnce(loggedFirstButtonsTask, "task-buttons-first");
-    performTask.buttons = false;
-  }
-  if (performTask.speakerTimer) {
-    speaker.update();
-    checkpointOnce(loggedFirstSpeakerTask, "task-speaker-first");
-    performTask.speakerTimer = false;
-  }
-  if (performTask.estimateWind) {
-    windEstimator.estimateWind();
-    checkpointOnce(loggedFirstWindTask, "task-wind-first");
-    performTask.estimateWind = false;
-  }
-  if (performTask.imu) {
-    ICM20948::getInstance().update();
-    checkpointOnce(loggedFirstImuTask, "task-imu-first");
-    performTask.imu = false;
-  }
-  if (performTask.gps) {
-    gps.update();
-    checkpointOnce(loggedFirstGpsTask, "task-gps-first");
-    performTask.gps = false;
-  }
-  if (performTask.thermalDetector) {
-    if (settings.labs_thermalCore || settings.labs_thermalTrack) thermalTracker.updateDetector();
-    performTask.thermalDetector = false;
-  }
-  if (performTask.thermalNavigation) {
-    if (settings.labs_thermalTrack) thermalTracker.updateNavigation();
-    if (settings.labs_thermalCore) thermalCore.update();
-    performTask.thermalNavigation = false;
-  }
-  if (performTask.power) {
-    power.update();
-    checkpointOnce(loggedFirstPowerTask, "task-power-first");
-    performTask.power = false;
-  }
-  if (performTask.log) {
-    log_update();
-    checkpointOnce(loggedFirstLogTask, "task-log-first");
-    performTask.log = false;
-  }
-  if (performTask.display) {
-    checkpointOnce(loggedFirstDisplayTask, "task-display-before");
-    display.update();
-    checkpointOnce(loggedFirstDisplayAfterTask, "task-display-after");
-    if (!restoredNavAfterFirstDisplayUpdate_) {
-      restoredNavAfterFirstDisplayUpdate_ = true;
-      if (sdcard.isMounted()) {
-        heap_monitor::checkpoint("task-nav-restore-start");
-        navigator.loadPersistedState(false);
-        heap_monitor::checkpoint("task-nav-restore-state");
-        user_waypoints::loadIntoNavigator();
-        heap_monitor::checkpoint("task-nav-restore-end");
-      }
-    }
-    performTask.display = false;
-  }
-  if (performTask.tempRH) {
-    aht20.update();
-    checkpointOnce(loggedFirstTempRhTask, "task-temp-rh-first");
-    performTask.tempRH = false;
-  }
-  if (performTask.sdCard) {
-    sdcard.update();
-    checkpointOnce(loggedFirstSdCardTask, "task-sdcard-first");
-    performTask.sdCard = false;
-  }
-  if (performTask.cpuUtilization) {
-    cpu_utilization::writePendingReport();
-    performTask.cpuUtilization = false;
-  }
-  if (performTask.selfTest) {
-    selfTest.update();
-    checkpointOnce(loggedFirstSelfTestTask, "task-self-test-first");
-    performTask.selfTest = false;
-  }
-#ifdef MEMORY_PROFILING
-  if (performTask.memoryStats) {
-    printMemoryUsage();
-    performTask.memoryStats = false;
+    // We only do this once every 10ms
+    if (++currentBlock_ >= task_schedule::BLOCKS_PER_CYCLE) currentBlock_ = 0;
+    task_schedule::beginBlock(currentBlock_);
+    task_schedule::runDue(task_schedule::Core::Realtime);
   }
-#endif
+  xTaskNotifyGive(serviceTask);
 
-  diagnostic_network.update();
-  checkpointOnce(loggedFirstDiagnosticNetwork, "task-diag-net-first");
-  factoryDiscovery.update();
-  checkpointOnce(loggedFirstFactoryDiscovery, "task-factory-disc-first");
-
-  if (performedNecessaryTasks && DEBUG_MAIN_LOOP) {
-    performedNecessaryTasks = false;
-    uint64_t dt = micros() - tNecessaryTasksStart;
-    Serial.print("10ms: ");
-    Serial.print((uint8_t)current10msBlock);
-    Serial.print(" 100ms: ");
-    Serial.print((uint8_t)current100msBlock);
-    Serial.print(" taskTime: ");
-    Serial.println(dt);
+  if (recordCpuUtilization) {
+    taskBlockButtonMask |= cpu_utilization::buttonPinMask(buttons.inspectPins());
+    cpu_utilization::recordBlock(currentBlock_, taskBlockStartUs, static_cast<uint32_t>(micros()),
+                                 taskBlockButtonMask);
   }
 }
@@ -4,28 +4,36 @@
 #include <cstdint>
 
 #include "dispatch/pollable.h"
+#include "utils/lock_guard.h"
 
-// List of tasks managed by TaskManager and whether they are necessary in a particular work block.
-// Default to tasks being needed, so they execute upon startup.
-struct ManagedTasks {
-  bool buttons = true;       // poll & process buttons
-  bool speakerTimer = true;  // adjust speaker notes
-  bool baro = true;     // (1) preprocess on-chip ADC pressure, (2) read pressure and preprocess
-                        // on-chip ADC temperature, (3) read temp and calulate true Alt, (4)
-                        // filter Alt, update climb, and store values etc
-  bool imu = true;      // read sensors and update values
-  bool gps = true;      // process any NMEA strings and update values
-  bool display = true;  // update display
-  bool thermalDetector = true;    // detect/save thermals from the latest GPS fix and pressure alt
-  bool thermalNavigation = true;  // update relative thermal locations for display/nav
-  bool power = true;              // check battery, check auto-turn-off, etc
-  bool log = true;                // check auto-start, increment timers, update log file, etc
-  bool tempRH = true;       // (1) trigger temp & humidity measurements, (2) process values and save
-  bool sdCard = true;       // check if SD card state has changed and attempt remount if needed
-  bool memoryStats = true;  // Prints memory usage reports
-  bool estimateWind = true;     // estimate wind speed and direction
-  bool selfTest = true;         // run self test tasks
-  bool cpuUtilization = false;  // write CPU utilization diagnostics
+/// @brief Held by the service task while it runs a block of tasks, and by the main loop while the
+/// device is charging.  Other FreeRTOS tasks (the web server) take it to read or change state the
+/// service tasks own -- the display, the navigator and its waypoint and route files, settings --
+/// so they never see it half-updated.  Hold it briefly: every millisecond it is held is taken from
+/// the 10ms task block.
+class MainLoopLockGuard : public LockGuard {
+  friend class TaskManager;
+
+ public:
+  MainLoopLockGuard() : LockGuard(mutex) {}
+  explicit MainLoopLockGuard(uint32_t timeoutMs, bool fatalOnTimeout = true)
+      : LockGuard(mutex, pdMS_TO_TICKS(timeoutMs), fatalOnTimeout) {}
+
+ private:
+  static SemaphoreHandle_t mutex;
+};
+
+/// @brief Held by the main loop while it runs a block of realtime tasks.  Service-core code that
+/// must keep those from running -- powering the sensors down -- takes it.  The realtime tasks never
+/// take MainLoopLockGuard, so they are never held up by the display or the SD card.
+class RealtimeLockGuard : public LockGuard {
+  friend class TaskManager;
+
+ public:
+  RealtimeLockGuard() : LockGuard(mutex) {}
+
+ private:
+  static SemaphoreHandle_t mutex;
 };
 
 // This is where the bulk of the task management work happens.  We are slowly moving away from this
@@ -39,28 +47,15 @@ class TaskManager : IPollable {
 
  private:
   void updateWhileOn();
-  void setNecessaryTasksForBlock();  // set necessary tasks for 10ms block
-  void doNecessaryTasks();
 
   void updateWhileCharging();
 
   bool goToSleep = false;
 
-  uint32_t tNecessaryTasksStart = 0;
-  bool performedNecessaryTasks = false;
-  bool restoredNavAfterFirstDisplayUpdate_ = false;
-
   // Opportunities to perform necessary work occur every 10ms with a repeating pattern every 1000ms.
-  // Tasks can be targeted to execute at certain combinations of 10ms and 100ms indices within the
-  // 1-second pattern.
-
-  // Varies between 0 and 9, then wraps back to 0 as the 100ms block increments
-  uint8_t current10msBlock = 0;
-
-  // Varies between 0 and 9, then wraps back to 0 as the 1-second pattern repeats
-  uint8_t current100msBlock = 0;
-
-  ManagedTasks performTask;
+  // Which tasks run in which block is set by the schedule in taskman.cpp (see task_schedule.h).
+  // Varies between 0 and 99, then wraps back to 0 as the 1-second pattern repeats
+  uint8_t currentBlock_ = 0;
 
   // Main system event/task timer
   hw_timer_t* taskTimer_ = nullptr;
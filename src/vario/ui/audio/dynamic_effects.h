@@ -1,5 +1,8 @@
 #pragma once
 
+// Length of one speaker sample: every note and rest lasts a whole number of these
+constexpr uint32_t NOTE_DURATION_MS = 40;
+
 constexpr uint8_t FX_NOTE_SAMPLE_COUNT = 2;  // number of samples to play per FX Note
 
 // each "beep beep" cycle is a "measure", made up of play-length followed by rest-length, then
@@ -2,23 +2,18 @@
 
 #include <Arduino.h>
 
-#include "hardware/Leaf_SPI.h"
 #include "hardware/configuration.h"
 #include "hardware/io_pins.h"
 #include "logging/log.h"
 #include "ui/audio/dynamic_effects.h"
 #include "ui/audio/notes.h"
 #include "ui/audio/sound_effects.h"
+#include "ui/audio/vario_tones.h"
 #include "ui/settings/settings.h"
 #include "utils/magic_enum.h"
 
 Speaker speaker;
 
-namespace {
-  constexpr unsigned long NOTE_DURATION_MS = 40;
-  constexpr unsigned long TIMING_TOLERANCE_MS = 2;
-}  // namespace
-
 void Speaker::init(void) {
   assertState("Speaker::init", State::Uninitialized);
 
@@ -30,24 +25,50 @@ void Speaker::init(void) {
   if (!SPEAKER_VOLA_IOEX) pinMode(SPEAKER_VOLA, OUTPUT);
   if (!SPEAKER_VOLB_IOEX) pinMode(SPEAKER_VOLB, OUTPUT);
 
-  tLastUpdate_ = NOTE_DURATION_MS * (millis() / NOTE_DURATION_MS);
   state_ = State::Active;
   setVolume(varioVolume_, true);
+
+  // The callback runs in the esp_timer task, which on core 0 preempts everything but the radio
+  // stacks, so the beeps keep time whatever the main loop on core 1 is busy with.
+  const esp_timer_create_args_t timerArgs = {
+      .callback = &Speaker::onTimer,
+      .arg = this,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "speaker",
+      .skip_unhandled_events = true,
+  };
+  if (esp_timer_create(&timerArgs, &timer_) != ESP_OK ||
+      esp_timer_start_periodic(timer_, NOTE_DURATION_MS * 1000ULL) != ESP_OK) {
+    fatalError("Could not start the speaker sequencer timer");
+  }
+}
+
+bool Speaker::post(const Command& command) {
+  bool posted;
+  if (command.type == Command::Type::VarioNote) {
+    posted = varioCommands_.push(command);
+  } else {
+    portENTER_CRITICAL(&commandsLock_);
+    posted = commands_.push(command);
+    portEXIT_CRITICAL(&commandsLock_);
+  }
+  if (posted) return true;
+  Serial.printf("Speaker command %u dropped; sequencer queue full\n", (uint8_t)command.type);
+  return false;
 }
 
 void Speaker::mute() {
   assertState("Speaker::mute", State::Uninitialized, State::Active);
-  playingSound_ = false;  // clear FX sound
-  updateVarioNote(0);     // clear vario note
-  if (state_ != State::Uninitialized) {
-    playTone(0);  // mute speaker pin
-  }
-  speakerMute_ = true;
+  mutePosted_ = true;
+  // Cancels any FX sound and the vario note, and silences the speaker
+  post({Command::Type::Mute, nullptr, note::NONE, 0, 0});
+  varioNoteCancelled_ = true;
 }
 
 void Speaker::unMute() {
   assertState("Speaker::unMute", State::Uninitialized, State::Active);
-  speakerMute_ = false;
+  mutePosted_ = false;
+  post({Command::Type::UnMute, nullptr, note::NONE, 0, 0});
 }
 
 void Speaker::setVolume(SoundChannel channel, SpeakerVolume volume) {
@@ -97,28 +118,24 @@ void Speaker::setVolume(SpeakerVolume volume, bool force) {
 void Speaker::playSound(sound_t sound) {
   assertState("Speaker::playSound", State::Uninitialized, State::Active);
   Serial.printf("%d playSound %d\n", millis(), sound);
-  soundPlaying_ = sound;
-  playingSound_ = true;
+  if (post({Command::Type::Sound, sound, note::NONE, 0, 0})) soundsQueued_++;
 }
 
 void Speaker::playNote(uint16_t note) {
   assertState("Speaker::playNote", State::Uninitialized, State::Active);
-  singleNote_[0] = note;
-  playSound(singleNote_);
+  // The sequencer copies the note into its own one-note sound, which may still be playing
+  if (post({Command::Type::Sound, nullptr, note, 0, 0})) soundsQueued_++;
 }
 
 void Speaker::updateVarioNote(int32_t verticalRate) {
   assertState("Speaker::updateVarioNote", State::Uninitialized, State::Active);
 
-  // don't play any beeps if Quiet Mode is turned on, and we haven't started a flight
-  if (settings.vario_quietMode && !flightTimer_isRunning()) {
-    varioNote_ = note::NONE;
-    return;
-  }
+  uint16_t newVarioNote = note::NONE;
+  uint16_t newVarioPlaySamples = varioPlayPosted_;
+  uint16_t newVarioRestSamples = varioRestPosted_;
 
-  uint16_t newVarioNote;
-  uint16_t newVarioPlaySamples;
-  uint16_t newVarioRestSamples;
+  // don't play any beeps if Quiet Mode is turned on, and we haven't started a flight
+  const bool quiet = settings.vario_quietMode && !flightTimer_isRunning();
 
   int sinkAlarm_cms;
   if (settings.vario_sinkAlarm_units) {
@@ -127,50 +144,27 @@ void Speaker::updateVarioNote(int32_t verticalRate) {
     sinkAlarm_cms = settings.vario_sinkAlarm * 100;  // convert m/s to cm/s
   }
 
-  if (verticalRate > settings.vario_climbStart) {
-    // first clamp to thresholds if climbRate is over the max
-    if (verticalRate >= CLIMB_MAX) {
-      newVarioNote = verticalRate * (CLIMB_NOTE_MAX - CLIMB_NOTE_MIN) / CLIMB_MAX + CLIMB_NOTE_MIN;
-      if (newVarioNote > CLIMB_NOTE_MAXMAX) newVarioNote = CLIMB_NOTE_MAXMAX;
-      newVarioPlaySamples = CLIMB_PLAY_SAMPLES_MIN;
-      newVarioRestSamples = 0;  // just hold a continuous tone, no rest in between
-    } else {
-      newVarioNote = verticalRate * (CLIMB_NOTE_MAX - CLIMB_NOTE_MIN) / CLIMB_MAX + CLIMB_NOTE_MIN;
-      newVarioPlaySamples =
-          CLIMB_PLAY_SAMPLES_MAX -
-          (verticalRate * (CLIMB_PLAY_SAMPLES_MAX - CLIMB_PLAY_SAMPLES_MIN) / CLIMB_MAX);
-      newVarioRestSamples =
-          CLIMB_REST_SAMPLES_MAX -
-          (verticalRate * (CLIMB_REST_SAMPLES_MAX - CLIMB_REST_SAMPLES_MIN) / CLIMB_MAX);
-    }
-
-    // if we trigger sink threshold
-  } else if (verticalRate < sinkAlarm_cms) {
-    // first clamp to thresholds if sinkRate is over the max
-    if (verticalRate <= SINK_MAX) {
-      newVarioNote = SINK_NOTE_MIN - verticalRate * (SINK_NOTE_MIN - SINK_NOTE_MAX) / SINK_MAX;
-      if (newVarioNote < SINK_NOTE_MAXMAX || newVarioNote > SINK_NOTE_MAX)
-        newVarioNote = SINK_NOTE_MAXMAX;  // the second condition (|| > SINK_NOTE_MAX) is to prevent
-                                          // uint16 wrap-around to a much higher number
-      newVarioPlaySamples = SINK_PLAY_SAMPLES_MAX;
-      newVarioRestSamples = 0;  // just hold a continuous tone, no pulses
-    } else {
-      newVarioNote = SINK_NOTE_MIN - verticalRate * (SINK_NOTE_MIN - SINK_NOTE_MAX) / SINK_MAX;
-      newVarioPlaySamples =
-          SINK_PLAY_SAMPLES_MIN +
-          (verticalRate * (SINK_PLAY_SAMPLES_MAX - SINK_PLAY_SAMPLES_MIN) / SINK_MAX);
-      newVarioRestSamples =
-          SINK_REST_SAMPLES_MIN +
-          (verticalRate * (SINK_REST_SAMPLES_MAX - SINK_REST_SAMPLES_MIN) / SINK_MAX);
+  // Settings decide whether to beep; the tone curve decides what the beep sounds like
+  if (!quiet && (verticalRate > settings.vario_climbStart || verticalRate < sinkAlarm_cms)) {
+    const vario_tones::Tone tone = vario_tones::lookup(verticalRate);
+    if (tone.hz != note::NONE) {
+      newVarioNote = tone.hz;
+      newVarioPlaySamples = tone.playSamples;
+      newVarioRestSamples = tone.restSamples;
     }
-
-  } else {
-    varioNote_ = note::NONE;
   }
 
-  varioNote_ = newVarioNote;
-  varioPlaySamples_ = newVarioPlaySamples;
-  varioRestSamples_ = newVarioRestSamples;
+  if (varioNoteCancelled_.exchange(false)) varioNotePosted_ = note::NONE;
+  if (newVarioNote == varioNotePosted_ && newVarioPlaySamples == varioPlayPosted_ &&
+      newVarioRestSamples == varioRestPosted_) {
+    return;  // Already playing
+  }
+  if (post({Command::Type::VarioNote, nullptr, newVarioNote, newVarioPlaySamples,
+            newVarioRestSamples})) {
+    varioNotePosted_ = newVarioNote;
+    varioPlayPosted_ = newVarioPlaySamples;
+    varioRestPosted_ = newVarioRestSamples;
+  }
 }
 
 bool Speaker::update() {
@@ -181,63 +175,80 @@ bool Speaker::update() {
     fatalError("Unsupported Speaker::update state %d (%u)", nameOf(state_).c_str(), state_);
   }
 
+  // Sounds played while muted wait for unMute, so don't keep anyone waiting for them
+  if (mutePosted_) return false;
+
+  return soundsQueued_ != soundsFinished_;
+}
+
+void Speaker::onTimer(void* arg) { static_cast<Speaker*>(arg)->tick(); }
+
+// One sequencer step, every NOTE_DURATION_MS, in the esp_timer task
+void Speaker::tick() {
+  // A vario note posted again after a mute is applied after the mute
+  Command command;
+  while (commands_.pop(command)) applyCommand(command);
+  while (varioCommands_.pop(command)) applyCommand(command);
+
   // If speaker is muted, ensure silence and don't play sound
   if (speakerMute_) {
     playTone(0);
-    return false;
+    return;
   }
 
-  if (!shouldUpdate()) {
-    return playingSound_;
+  if (playingSound_ && fxVolume_ == SpeakerVolume::Off) {
+    // Sounds aren't held back for when the system volume is turned on again
+    finishSound();
   }
 
-  if (playingSound_ && fxVolume_ != SpeakerVolume::Off) {
+  if (playingSound_) {
     // prioritize sound effects from UI & Button etc before we get to vario beeps
-    // but only play soundFX if system volume is on
-    return updateSound();
+    updateSound();
 
   } else if (varioNote_ != note::NONE && varioVolume_ != SpeakerVolume::Off) {
     // if there's a vario note to play, and the vario volume isn't zero
     updateVario();
-    return false;
 
   } else {
     // play silence
     playTone(0);
   }
-
-  return false;
 }
 
-bool Speaker::shouldUpdate() {
-  unsigned long tNow = millis();
-  // Nominally wait NOTE_DURATION_MS intervals between updates, but allow an update to happen up to
-  // TIMING_TOLERANCE_MS before its actual target time.  In diagrams below, NOTE_DURATION_MS
-  // intervals are |, tLastUpdate_ is x, tNow is y, and tLastUpdate_ should be updated to z.
-  // TIMING_TOLERANCE_MS is one character wide.
-  // x-------y-|---------|---------|---------| (no action)
-  // x--------y|---------z---------|---------|
-  // x---------y---------z---------|---------|
-  // x---------|y--------z---------|---------|
-  // x---------|-y-------z---------|---------|
-  // x---------|-------y-z---------|---------|
-  // x---------|--------y|---------z---------|
-  // x---------|---------y---------z---------|
-  // x---------|---------|y--------z---------|
-  // x---------|---------|-y-------z---------|
-
-  // n is the number of NOTE_DURATION_MS intervals that have elapsed, or almost elapsed, since
-  // tLastUpdate_
-  uint32_t n = (tNow + TIMING_TOLERANCE_MS - tLastUpdate_) / NOTE_DURATION_MS;
-  if (n == 0) {
-    // Nothing to do yet; we need to wait longer.
-    return false;
-  }
-  if (n >= 2) {
-    Serial.printf("Speaker::update skipped %d intervals\n", n - 1);
+void Speaker::applyCommand(const Command& command) {
+  switch (command.type) {
+    case Command::Type::Sound:
+      if (playingSound_) finishSound();  // Replaced
+      if (command.sound) {
+        soundPlaying_ = command.sound;
+      } else {
+        singleNote_[0] = command.note;
+        soundPlaying_ = singleNote_;
+      }
+      fxSampleCount_ = 0;
+      playingSound_ = true;
+      break;
+    case Command::Type::VarioNote:
+      varioNote_ = command.note;
+      varioPlaySamples_ = command.playSamples;
+      varioRestSamples_ = command.restSamples;
+      break;
+    case Command::Type::Mute:
+      if (playingSound_) finishSound();
+      varioNote_ = note::NONE;
+      playTone(0);
+      speakerMute_ = true;
+      break;
+    case Command::Type::UnMute:
+      speakerMute_ = false;
+      break;
   }
-  tLastUpdate_ += n * NOTE_DURATION_MS;
-  return true;
+}
+
+void Speaker::finishSound() {
+  playingSound_ = false;
+  fxNoteLast_ = note::NONE;
+  soundsFinished_++;
 }
 
 bool Speaker::updateSound() {
@@ -255,8 +266,7 @@ bool Speaker::updateSound() {
 
   } else {  // Else, we're at END_OF_TONE
     playTone(0);
-    playingSound_ = false;
-    fxNoteLast_ = note::NONE;
+    finishSound();
     return false;
   }
 }
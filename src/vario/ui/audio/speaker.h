@@ -1,11 +1,15 @@
 #pragma once
 
 #include <Arduino.h>
+#include <esp_timer.h>
+
+#include <atomic>
 
 #include "hardware/configuration.h"
 #include "ui/audio/dynamic_effects.h"
 #include "ui/audio/notes.h"
 #include "ui/audio/sound_effects.h"
+#include "utils/spsc_queue.h"
 #include "utils/state_assert_mixin.h"
 
 using sound_t = const note::note_t*;
@@ -15,9 +19,15 @@ enum class SpeakerVolume : uint8_t { Off = 0, Low = 1, Medium = 2, High = 3 };
 // Speaker preferentially plays a single FX sound (note sequence) by moving the sound pointer
 // forward until encountering the end-of-sound sentinel note value.  playSound and playNote both
 // immediately replace this single sound with the specified sound.  When no sound FX is playing,
-// Speaker plays vario notes corresponding to the climb rate provided via updateVarioNote.  The
-// hardware speaker is actuated by calling update at least once per NOTE_DURATION_MS (see
-// implementation).
+// Speaker plays vario notes corresponding to the climb rate provided via updateVarioNote.
+//
+// The notes are sequenced by a periodic esp_timer every NOTE_DURATION_MS (dynamic_effects.h), not
+// by the main loop, so a long display flush or SD write does not stretch a beep.  The public
+// methods only post commands to the sequencer through queues it drains without a lock; everything
+// the sequencer plays with is owned by the timer callback.  updateVarioNote is called by the
+// barometer, on the realtime loop or with it held off by RealtimeLockGuard, and has a queue of its
+// own.  Sounds and mute come from any task -- the UI, web handlers, the charging loop, fatalError --
+// and share a queue whose producers take turns under a spinlock.
 class Speaker : private StateAssertMixin<Speaker> {
  public:
   enum class State : uint8_t { Uninitialized, Active };
@@ -39,7 +49,7 @@ class Speaker : private StateAssertMixin<Speaker> {
   // Update the sound the vario plays according to climb/sink rate in cm/s
   void updateVarioNote(int32_t verticalRate);
 
-  // Call periodically to play sounds.  Returns true if there are notes left to play.
+  // Starts the sequencer on first call.  Returns true while a sound is still queued or playing.
   bool update();
 
   // Set the specified sound to be played
@@ -49,12 +59,42 @@ class Speaker : private StateAssertMixin<Speaker> {
   void playNote(note::note_t note);
 
  private:
-  State state_;
-
-  unsigned long tLastUpdate_;
+  struct Command {
+    enum class Type : uint8_t { Sound, VarioNote, Mute, UnMute };
+    Type type;
+    sound_t sound;  // Sound: the sound to play, or NULL to play `note` once
+    note::note_t note;
+    uint16_t playSamples;  // VarioNote
+    uint16_t restSamples;  // VarioNote
+  };
+
+  State state_ = State::Uninitialized;
+
+  esp_timer_handle_t timer_ = nullptr;
+
+  // Any task (sounds, mute) to sequencer; pushed only under commandsLock_, so the queue has one
+  // producer at a time
+  SpscQueue<Command, 16> commands_;
+  portMUX_TYPE commandsLock_ = portMUX_INITIALIZER_UNLOCKED;
+  // Realtime loop (vario notes) to sequencer
+  SpscQueue<Command, 8> varioCommands_;
+  std::atomic<SpeakerVolume> fxVolume_{SpeakerVolume::Low};
+  std::atomic<SpeakerVolume> varioVolume_{SpeakerVolume::Low};
+  // Sounds posted and sounds the sequencer has finished (played out, replaced or cancelled)
+  std::atomic<uint32_t> soundsQueued_{0};
+  std::atomic<uint32_t> soundsFinished_{0};
+
+  std::atomic<bool> mutePosted_{false};
+  // Set by mute(), which cancels the vario note, so updateVarioNote posts it again
+  std::atomic<bool> varioNoteCancelled_{false};
+
+  // Realtime loop's own view, to skip posting a vario note that is already playing
+  note::note_t varioNotePosted_ = note::NONE;
+  uint16_t varioPlayPosted_ = 0;
+  uint16_t varioRestPosted_ = 0;
+
+  // == Everything below is owned by the sequencer ==
 
-  SpeakerVolume fxVolume_ = SpeakerVolume::Low;
-  SpeakerVolume varioVolume_ = SpeakerVolume::Low;
   SpeakerVolume currentVolume_;
   bool speakerMute_ = false;  // use to mute sound for various charging & sleep states
 
@@ -101,11 +141,16 @@ class Speaker : private StateAssertMixin<Speaker> {
   void onUnexpectedState(const char* action, State actual) const;
   friend struct StateAssertMixin<Speaker>;
 
-  bool shouldUpdate();
+  bool post(const Command& command);
+
+  static void onTimer(void* arg);
+  void tick();
+  void applyCommand(const Command& command);
+  void finishSound();
   bool updateSound();
   void updateVario();
 
   void playTone(uint32_t freq);
 };
 
-extern Speaker speaker;
+extern Speaker speaker;
\ No newline at end of file
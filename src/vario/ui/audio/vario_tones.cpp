@@ -0,0 +1,287 @@
+#include "ui/audio/vario_tones.h"
+
+#include <SD_MMC.h>
+#include <math.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "storage/sd_card.h"
+#include "ui/audio/dynamic_effects.h"
+
+namespace vario_tones {
+  namespace {
+    constexpr const char* SOUNDS_DIR = "/sounds";
+    constexpr const char* TEMP_FILE = "/sounds/vario.tmp";
+    constexpr size_t TONES_MAX_BYTES = 4096;
+
+    constexpr size_t TABLE_SIZE = (TABLE_MAX_CMS - TABLE_MIN_CMS) / TABLE_STEP_CMS + 1;
+
+    constexpr int32_t CLIMB_LIMIT_CMS = 3000;
+    constexpr uint16_t HZ_MIN = 100;
+    constexpr uint16_t HZ_MAX = 5000;
+    constexpr uint16_t PERIOD_MS_MAX = 5000;
+
+    // Interpolation fraction: Q16 fixed point
+    constexpr int FRACTION_BITS = 16;
+
+    constexpr int32_t entryClimb(size_t index) {
+      return TABLE_MIN_CMS + (int32_t)index * TABLE_STEP_CMS;
+    }
+
+    uint8_t samples(uint32_t ms) {
+      const uint32_t count = (ms + NOTE_DURATION_MS / 2) / NOTE_DURATION_MS;
+      return count > UINT8_MAX ? UINT8_MAX : count;
+    }
+
+    Tone toneFor(uint16_t hz, uint16_t periodMs, uint16_t dutyPermille) {
+      if (hz == 0 || dutyPermille == 0) return {0, 0, 0};
+      const uint32_t onMs = (uint32_t)periodMs * dutyPermille / 1000;
+      Tone tone;
+      tone.hz = hz;
+      tone.playSamples = samples(onMs);
+      if (tone.playSamples == 0) tone.playSamples = 1;
+      tone.restSamples = dutyPermille >= 1000 ? 0 : samples(periodMs - onMs);
+      return tone;
+    }
+
+    int32_t interpolate(int32_t from, int32_t to, int32_t fraction) {
+      return from + (((to - from) * fraction + (1 << (FRACTION_BITS - 1))) >> FRACTION_BITS);
+    }
+
+    // The climb and sink tones Speaker played before tone curves, which computed them for every
+    // climb rate rather than every TABLE_STEP_CMS within the table's range
+    constexpr Tone builtInTone(int32_t climb) {
+      int32_t hz = 0;
+      Tone tone{};
+      if (climb >= 0) {
+        hz = climb * (CLIMB_NOTE_MAX - CLIMB_NOTE_MIN) / CLIMB_MAX + CLIMB_NOTE_MIN;
+        if (climb >= CLIMB_MAX) {
+          if (hz > CLIMB_NOTE_MAXMAX) hz = CLIMB_NOTE_MAXMAX;
+          tone.playSamples = CLIMB_PLAY_SAMPLES_MIN;
+          tone.restSamples = 0;  // just hold a continuous tone, no rest in between
+        } else {
+          tone.playSamples =
+              CLIMB_PLAY_SAMPLES_MAX -
+              (climb * (CLIMB_PLAY_SAMPLES_MAX - CLIMB_PLAY_SAMPLES_MIN) / CLIMB_MAX);
+          tone.restSamples =
+              CLIMB_REST_SAMPLES_MAX -
+              (climb * (CLIMB_REST_SAMPLES_MAX - CLIMB_REST_SAMPLES_MIN) / CLIMB_MAX);
+        }
+      } else {
+        hz = SINK_NOTE_MIN - climb * (SINK_NOTE_MIN - SINK_NOTE_MAX) / SINK_MAX;
+        if (climb <= SINK_MAX) {
+          if (hz < SINK_NOTE_MAXMAX) hz = SINK_NOTE_MAXMAX;
+          tone.playSamples = SINK_PLAY_SAMPLES_MAX;
+          tone.restSamples = 0;  // just hold a continuous tone, no pulses
+        } else {
+          tone.playSamples = SINK_PLAY_SAMPLES_MIN +
+                             (climb * (SINK_PLAY_SAMPLES_MAX - SINK_PLAY_SAMPLES_MIN) / SINK_MAX);
+          tone.restSamples = SINK_REST_SAMPLES_MIN +
+                             (climb * (SINK_REST_SAMPLES_MAX - SINK_REST_SAMPLES_MIN) / SINK_MAX);
+        }
+      }
+      tone.hz = hz;
+      return tone;
+    }
+
+    // Compiled from the built-in tones when constructed
+    struct ToneTable {
+      Tone entries[TABLE_SIZE];
+      constexpr ToneTable() : entries() {
+        for (size_t i = 0; i < TABLE_SIZE; i++) entries[i] = builtInTone(entryClimb(i));
+      }
+    };
+
+    // Compiled at build time, so the vario beeps before any SD card is mounted
+    constexpr ToneTable BUILT_IN;
+    // User curves are compiled into these in turn, so the one compiled into was last live two
+    // curves ago, even with the built-in table swapped in between
+    ToneTable userTables[2];
+    uint8_t lastUserTable = 1;
+    std::atomic<const ToneTable*> live{&BUILT_IN};
+    bool custom = false;
+
+    bool ensureDirectory() { return SD_MMC.exists(SOUNDS_DIR) || SD_MMC.mkdir(SOUNDS_DIR); }
+
+    bool writeCurve(const Curve& curve, String& error) {
+      JsonDocument doc;
+      doc["schema"] = "leaf.tones";
+      JsonArray points = doc["points"].to<JsonArray>();
+      for (uint8_t i = 0; i < curve.count; i++) {
+        const Point& p = curve.points[i];
+        JsonObject point = points.add<JsonObject>();
+        point["climb_cms"] = p.climbCms;
+        point["hz"] = p.hz;
+        point["period_ms"] = p.periodMs;
+        point["duty"] = p.dutyPermille / 10.0;
+      }
+
+      if (!ensureDirectory()) {
+        error = "Unable to create sounds folder.";
+        return false;
+      }
+      if (SD_MMC.exists(TEMP_FILE)) SD_MMC.remove(TEMP_FILE);
+      File file = SD_MMC.open(TEMP_FILE, "w", true);
+      if (!file) {
+        error = "Unable to write vario sound.";
+        return false;
+      }
+      const size_t written = serializeJson(doc, file);
+      file.close();
+      if (written == 0) {
+        SD_MMC.remove(TEMP_FILE);
+        error = "Unable to write vario sound.";
+        return false;
+      }
+      if (SD_MMC.exists(filePath()) && !SD_MMC.remove(filePath())) {
+        SD_MMC.remove(TEMP_FILE);
+        error = "Unable to replace vario sound.";
+        return false;
+      }
+      if (!SD_MMC.rename(TEMP_FILE, filePath())) {
+        SD_MMC.remove(TEMP_FILE);
+        error = "Unable to save vario sound.";
+        return false;
+      }
+      return true;
+    }
+  }  // namespace
+
+  Tone lookup(int32_t climbCms) {
+    const ToneTable& table = *live.load(std::memory_order_acquire);
+    if (climbCms <= TABLE_MIN_CMS) return table.entries[0];
+    if (climbCms >= TABLE_MAX_CMS) return table.entries[TABLE_SIZE - 1];
+    return table.entries[(climbCms - TABLE_MIN_CMS) / TABLE_STEP_CMS];
+  }
+
+  bool parse(JsonVariantConst json, Curve& curve, String& error) {
+    curve = Curve();
+    const char* schema = json["schema"] | "";
+    if (strcmp(schema, "leaf.tones") != 0) {
+      error = "Vario sound has an unsupported schema.";
+      return false;
+    }
+    JsonArrayConst points = json["points"].as<JsonArrayConst>();
+    if (points.isNull() || points.size() == 0) {
+      error = "Vario sound needs at least one point.";
+      return false;
+    }
+    if (points.size() > MAX_POINTS) {
+      error = "Vario sound has too many points.";
+      return false;
+    }
+
+    for (JsonObjectConst point : points) {
+      const double climb = point["climb_cms"] | NAN;
+      const double hz = point["hz"] | NAN;
+      const double period = point["period_ms"] | NAN;
+      const double duty = point["duty"] | NAN;
+      if (!(climb >= -CLIMB_LIMIT_CMS && climb <= CLIMB_LIMIT_CMS)) {
+        error = "Climb rates must be within +/-3000 cm/s.";
+        return false;
+      }
+      if (!(hz == 0 || (hz >= HZ_MIN && hz <= HZ_MAX))) {
+        error = "Pitch must be 0 (silent) or 100-5000 Hz.";
+        return false;
+      }
+      if (!(period >= NOTE_DURATION_MS && period <= PERIOD_MS_MAX)) {
+        error = "Period must be 40-5000 ms.";
+        return false;
+      }
+      if (!(duty >= 0 && duty <= 100)) {
+        error = "Duty must be 0-100%.";
+        return false;
+      }
+
+      Point& p = curve.points[curve.count];
+      p.climbCms = lround(climb);
+      p.hz = lround(hz);
+      p.periodMs = lround(period);
+      p.dutyPermille = lround(duty * 10);
+      if (curve.count > 0 && p.climbCms < curve.points[curve.count - 1].climbCms) {
+        error = "Points must be in order of climb rate.";
+        return false;
+      }
+      if (curve.count > 1 && p.climbCms == curve.points[curve.count - 2].climbCms) {
+        error = "At most two points may share a climb rate.";
+        return false;
+      }
+      curve.count++;
+    }
+    return true;
+  }
+
+  void use(const Curve& curve) {
+    if (curve.count == 0) {
+      useDefault();
+      return;
+    }
+
+    lastUserTable ^= 1;
+    ToneTable& table = userTables[lastUserTable];
+    uint8_t segment = 0;  // Last point at or below the entry's climb rate
+    for (size_t i = 0; i < TABLE_SIZE; i++) {
+      const int32_t climb = entryClimb(i);
+      while (segment + 1 < curve.count && curve.points[segment + 1].climbCms <= climb) segment++;
+      const Point& a = curve.points[segment];
+      if (segment + 1 >= curve.count || climb < a.climbCms) {
+        // Beyond the ends of the curve
+        table.entries[i] = toneFor(a.hz, a.periodMs, a.dutyPermille);
+        continue;
+      }
+      const Point& b = curve.points[segment + 1];
+      const int32_t fraction = ((climb - a.climbCms) << FRACTION_BITS) / (b.climbCms - a.climbCms);
+      table.entries[i] = toneFor(interpolate(a.hz, b.hz, fraction),
+                                 interpolate(a.periodMs, b.periodMs, fraction),
+                                 interpolate(a.dutyPermille, b.dutyPermille, fraction));
+    }
+    live.store(&table, std::memory_order_release);
+    custom = true;
+  }
+
+  void useDefault() {
+    live.store(&BUILT_IN, std::memory_order_release);
+    custom = false;
+  }
+
+  bool isCustom() { return custom; }
+
+  bool loadFromSd() {
+    useDefault();
+    if (!sdcard.isMounted() || !SD_MMC.exists(filePath())) return false;
+
+    File file = SD_MMC.open(filePath(), "r");
+    if (!file) return false;
+    if (file.size() > TONES_MAX_BYTES) {
+      file.close();
+      return false;
+    }
+    JsonDocument doc;
+    const DeserializationError parseError = deserializeJson(doc, file);
+    file.close();
+    if (parseError) return false;
+
+    Curve curve;
+    String error;
+    if (!parse(doc.as<JsonVariantConst>(), curve, error)) return false;
+    use(curve);
+    return true;
+  }
+
+  bool save(const Curve& curve, String& error) {
+    if (!sdcard.isMounted()) {
+      error = "SD card is not mounted.";
+      return false;
+    }
+    return writeCurve(curve, error);
+  }
+
+  bool remove(String& error) {
+    if (sdcard.isMounted() && SD_MMC.exists(filePath()) && !SD_MMC.remove(filePath())) {
+      error = "Unable to remove vario sound.";
+      return false;
+    }
+    return true;
+  }
+}  // namespace vario_tones
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Maps climb rate to the vario beep: pitch, and how many speaker samples (NOTE_DURATION_MS each)
+// to play and rest in each beep cycle.
+//
+// A curve is a short list of points (climb rate -> pitch, cycle period, duty) that pilots can
+// load from the SD card or set from the Web App, like the sound profiles of other varios.  Rather
+// than interpolating it on every vario update, the curve is compiled once into a dense table
+// indexed by climb rate, so Speaker::updateVarioNote only does a lookup.  Without a user curve,
+// the table is compiled from the built-in climb and sink tones (dynamic_effects.h).  Either way a
+// climb rate sounds like the TABLE_STEP_CMS step at or below it, and rates beyond the table like
+// its ends, so even the built-in tones differ slightly from computing them for every rate.
+//
+// Which climb and sink rates beep at all is still decided by the vario settings (climb start,
+// sink alarm, quiet mode); the curve only chooses what the beep sounds like.
+//
+// lookup() is called on the realtime core without a lock.  A new curve is compiled into a spare
+// table and swapped in with an atomic pointer store, so a lookup sees either the old table or the
+// new one whole.  Changing the curve is for one task at a time: the web handlers and the SD card
+// mount both hold the main loop lock to do it.
+namespace vario_tones {
+  constexpr int32_t TABLE_STEP_CMS = 4;
+  constexpr int32_t TABLE_MIN_CMS = -1280;  // Rates beyond the table use its end entries
+  constexpr int32_t TABLE_MAX_CMS = 1276;
+  constexpr size_t MAX_POINTS = 24;
+
+  constexpr const char* filePath() { return "/sounds/vario.json"; }
+
+  struct Tone {
+    uint16_t hz;          // 0 for silence
+    uint8_t playSamples;  // At least 1 unless silent
+    uint8_t restSamples;  // 0 for a continuous tone
+  };
+
+  struct Point {
+    int16_t climbCms;
+    uint16_t hz;
+    uint16_t periodMs;      // One beep plus the rest after it
+    uint16_t dutyPermille;  // Share of the period the beep sounds
+  };
+
+  // Points in order of climb rate.  Two points may share a climb rate to make a step.
+  struct Curve {
+    Point points[MAX_POINTS];
+    uint8_t count = 0;
+  };
+
+  // The beep for this climb rate in cm/s
+  Tone lookup(int32_t climbCms);
+
+  // Read a curve from {"schema":"leaf.tones","points":[{"climb_cms":..,"hz":..,"period_ms":..,
+  // "duty":..}, ...]} (duty in percent).  Returns false with a message for the pilot if the curve
+  // is not usable.
+  bool parse(JsonVariantConst json, Curve& curve, String& error);
+
+  // Compile the curve into the table
+  void use(const Curve& curve);
+
+  // Compile the built-in tones into the table
+  void useDefault();
+
+  // Whether the table came from a user curve
+  bool isCustom();
+
+  // Use the curve on the SD card, or the built-in tones if there is none or it is not usable
+  bool loadFromSd();
+
+  // Write the curve to the SD card; use() it to hear it now
+  bool save(const Curve& curve, String& error);
+
+  // Remove the curve from the SD card; useDefault() to go back to the built-in tones now
+  bool remove(String& error);
+}  // namespace vario_tones
@@ -8,6 +8,12 @@
 #include <Arduino.h>
 #include <U8g2lib.h>
 
+#include <atomic>
+#include <utility>
+#include <new>
+
+#include "diagnostics/cpu_utilization.h"
+#include "diagnostics/heap_monitor.h"
 #include "hardware/Leaf_SPI.h"
 #include "instruments/baro.h"
 #include "instruments/gps.h"
@@ -54,6 +60,229 @@ U8G2_ST75256_WO256X128_F_4W_HW_SPI u8g2(U8G2_R3,
                                         /* reset=*/LCD_RESET);
 #endif
 
+namespace {
+  // Partial flush.  Every page draws into u8g2's full frame buffer and finishes it with
+  // nextPage(), which hands the panel driver the buffer one tile row (8 pixel rows) at a time and
+  // then asks it to refresh.  This callback sits between u8g2 and the driver: it ignores the rows
+  // and, on the refresh, sends only the span of 8x8 tiles in each row that changed since it was
+  // last sent, so a frame where a few digits moved costs a few dozen bytes of SPI instead of the
+  // whole frame.
+  //
+  // Frames drawn by Display::update and updateVarioLayer are not sent by the main loop at all:
+  // the buffer is copied for the send task, which sends it a row at a time, locking the SPI bus
+  // only for each row so the FANET radio can get at the bus in between, while the main loop gets
+  // on with its next tasks and draws the next frame into u8g2's buffer.  The main loop never waits
+  // for the send task: a frame finished while the last is still going out is left for the send
+  // task to pick up next, replacing any it has not got to yet.  Any other frame (splash
+  // screens, fatal errors, clear()) is sent at once from the task that drew it, and the send task
+  // abandons whatever it was sending, since that is now older than what is on the panel.
+  u8x8_msg_cb panelCallback = nullptr;
+  uint8_t* sentTiles = nullptr;  // Panel RAM contents as last sent, in u8g2 buffer layout
+  uint32_t knownRows = 0;        // Rows whose sentTiles are known to match the panel
+  // sentTiles and knownRows are only touched with the SPI bus locked
+
+  constexpr uint32_t SEND_TASK_STACK_BYTES = 3 * 1024;
+  constexpr UBaseType_t SEND_TASK_PRIORITY = 3;  // Above the web server, which shares its core
+  constexpr BaseType_t SEND_TASK_CORE = 0;       // The main loop never yields core 1
+
+  TaskHandle_t sendTask = NULL;
+  SemaphoreHandle_t sendIdle = NULL;  // Held by the send task while it owns sendFrame
+  uint8_t* sendFrame = nullptr;       // Copy of the frame the send task is sending
+  uint32_t sendSequence = 0;          // frameSequence when sendFrame was queued
+
+  // The newest frame the send task has yet to pick up.  Guarded by queueLock.
+  portMUX_TYPE queueLock = portMUX_INITIALIZER_UNLOCKED;
+  uint8_t* queuedFrame = nullptr;
+  uint32_t queuedSequence = 0;
+  bool queuedVarioLayer = false;
+  bool frameQueued = false;
+  // Counts every frame queued or sent directly, so the send task can tell its frame was overtaken
+  std::atomic<uint32_t> frameSequence{0};
+  // Set by Display while it draws a frame the send task should send
+  bool deferFrames = false;
+  bool deferredVarioLayer = false;
+
+  // What the send task did with its last frame, reported by the main loop once it is done
+  struct FlushStats {
+    bool pending;
+    bool varioLayer;
+    uint32_t bytesSent;
+    uint32_t fullFrameBytes;
+    uint32_t spiLockUs;
+  };
+  FlushStats sendStats = {};
+
+  uint16_t frameBytes(const u8x8_t* u8x8) {
+    return u8x8->display_info->tile_width * u8x8->display_info->tile_height * 8;
+  }
+
+  // Send the tiles of one row of frame that differ from what the panel shows.  The SPI bus must
+  // be locked.  Returns the bytes sent.
+  uint16_t sendRow(u8x8_t* u8x8, const uint8_t* frame, uint8_t row) {
+    const uint8_t width = u8x8->display_info->tile_width;
+    const uint8_t* tiles = frame + row * width * 8;
+    uint8_t* sent = sentTiles + row * width * 8;
+
+    int16_t first = -1;
+    int16_t last = -1;
+    if (!(knownRows & (1ul << row))) {
+      first = 0;
+      last = width - 1;
+    } else {
+      for (uint8_t i = 0; i < width; i++) {
+        if (memcmp(tiles + i * 8, sent + i * 8, 8) == 0) continue;
+        if (first < 0) first = i;
+        last = i;
+      }
+      if (first < 0) return 0;
+    }
+
+    u8x8_tile_t changed;
+    changed.x_pos = first;
+    changed.y_pos = row;
+    changed.cnt = last - first + 1;
+    changed.tile_ptr = const_cast<uint8_t*>(tiles + first * 8);
+    panelCallback(u8x8, U8X8_MSG_DISPLAY_DRAW_TILE, 1, &changed);
+    memcpy(sent + first * 8, tiles + first * 8, changed.cnt * 8);
+    knownRows |= 1ul << row;
+    return changed.cnt * 8;
+  }
+
+  // Send a whole frame from this task
+  void sendNow(u8x8_t* u8x8, const uint8_t* frame) {
+    frameSequence++;
+    const uint8_t rows = u8x8->display_info->tile_height;
+    if (SpiLockGuard::heldByThisTask()) {
+      for (uint8_t row = 0; row < rows; row++) sendRow(u8x8, frame, row);
+      return;
+    }
+    SpiLockGuard spiLock(25, false);
+    if (!spiLock) return;
+    for (uint8_t row = 0; row < rows; row++) sendRow(u8x8, frame, row);
+  }
+
+  // Swap the queued frame in as sendFrame, unless something newer has gone out directly since
+  bool takeQueuedFrame() {
+    portENTER_CRITICAL(&queueLock);
+    const bool taken = frameQueued && queuedSequence == frameSequence;
+    if (taken) {
+      std::swap(sendFrame, queuedFrame);
+      sendSequence = queuedSequence;
+      sendStats.varioLayer = sendStats.varioLayer && queuedVarioLayer;
+    }
+    frameQueued = false;
+    portEXIT_CRITICAL(&queueLock);
+    return taken;
+  }
+
+  bool isFrameQueued() {
+    portENTER_CRITICAL(&queueLock);
+    const bool queued = frameQueued;
+    portEXIT_CRITICAL(&queueLock);
+    return queued;
+  }
+
+  void sendTaskMain(void*) {
+    u8x8_t* u8x8 = u8g2.getU8x8();
+    while (true) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      do {
+        while (takeQueuedFrame()) {
+          for (uint8_t row = 0; row < u8x8->display_info->tile_height; row++) {
+            SpiLockGuard spiLock;
+            if (frameSequence != sendSequence) break;  // Something newer is queued or went out
+            const uint32_t lockStartUs = micros();
+            sendStats.bytesSent += sendRow(u8x8, sendFrame, row);
+            sendStats.spiLockUs += micros() - lockStartUs;
+          }
+        }
+        xSemaphoreGive(sendIdle);
+        // A frame queued just as this one finished, before finishFrame could see the task idle
+      } while (isFrameQueued() && xSemaphoreTake(sendIdle, 0) == pdTRUE);
+    }
+  }
+
+  // Hand a finished frame to the send task, or send it now if that's not possible
+  void finishFrame(u8x8_t* u8x8) {
+    const uint8_t* frame = u8g2.getBufferPtr();
+    if (!deferFrames || !sendTask || xTaskGetCurrentTaskHandle() == sendTask ||
+        SpiLockGuard::heldByThisTask()) {
+      sendNow(u8x8, frame);
+      return;
+    }
+
+    portENTER_CRITICAL(&queueLock);
+    memcpy(queuedFrame, frame, frameBytes(u8x8));
+    queuedSequence = ++frameSequence;
+    queuedVarioLayer = deferredVarioLayer;
+    frameQueued = true;
+    portEXIT_CRITICAL(&queueLock);
+
+    // Still sending the last frame: it picks this one up when it is done
+    if (xSemaphoreTake(sendIdle, 0) != pdTRUE) return;
+
+    if (sendStats.pending) {
+      if (sendStats.varioLayer)
+        cpu_utilization::recordVarioLayerFlush(sendStats.bytesSent, sendStats.spiLockUs);
+      else
+        cpu_utilization::recordDisplayFlush(sendStats.bytesSent, sendStats.fullFrameBytes,
+                                            sendStats.spiLockUs);
+    }
+    sendStats = {true, true, 0, frameBytes(u8x8), 0};
+    xTaskNotifyGive(sendTask);
+  }
+
+  uint8_t partialFlushCallback(u8x8_t* u8x8, uint8_t msg, uint8_t arg_int, void* arg_ptr) {
+    if (msg == U8X8_MSG_DISPLAY_INIT) knownRows = 0;
+    if (msg == U8X8_MSG_DISPLAY_REFRESH) finishFrame(u8x8);
+    if (msg != U8X8_MSG_DISPLAY_DRAW_TILE) return panelCallback(u8x8, msg, arg_int, arg_ptr);
+
+    // Whole rows of u8g2's buffer are sent from the buffer when the frame is finished
+    const u8x8_tile_t* tile = static_cast<const u8x8_tile_t*>(arg_ptr);
+    if (arg_int == 1 && tile->x_pos == 0 && tile->cnt == u8x8->display_info->tile_width) return 1;
+
+    // Anything else (a row of repeated tiles from clearDisplay) goes out as it is, and leaves the
+    // row to be sent whole next time
+    knownRows &= ~(1ul << tile->y_pos);
+    return panelCallback(u8x8, msg, arg_int, arg_ptr);
+  }
+
+  void installPartialFlush() {
+    if (panelCallback) return;
+    u8x8_t* u8x8 = u8g2.getU8x8();
+    const u8x8_display_info_t* info = u8x8->display_info;
+    if (info->tile_height > 32) return;
+    sentTiles = new (std::nothrow) uint8_t[frameBytes(u8x8)];
+    if (!sentTiles) return;  // Keep sending whole frames
+    knownRows = 0;
+    panelCallback = u8x8->display_cb;
+    u8x8->display_cb = partialFlushCallback;
+
+    // Without the send task, frames are sent by whoever draws them
+    sendFrame = new (std::nothrow) uint8_t[frameBytes(u8x8)];
+    queuedFrame = new (std::nothrow) uint8_t[frameBytes(u8x8)];
+    sendIdle = xSemaphoreCreateBinary();
+    if (!sendFrame || !queuedFrame || !sendIdle) return;
+    xSemaphoreGive(sendIdle);
+    if (xTaskCreatePinnedToCore(sendTaskMain, "DisplaySend", SEND_TASK_STACK_BYTES, NULL,
+                                SEND_TASK_PRIORITY, &sendTask, SEND_TASK_CORE) != pdPASS) {
+      sendTask = NULL;
+      return;
+    }
+    heap_monitor::registerTask("display_send", sendTask);
+  }
+
+  // Frames finished while one of these is in scope go to the send task
+  class DeferFrames {
+   public:
+    explicit DeferFrames(bool varioLayer) {
+      deferFrames = true;
+      deferredVarioLayer = varioLayer;
+    }
+    ~DeferFrames() { deferFrames = false; }
+  };
+}  // namespace
+
 void Display::init(void) {
   {
     // Scope lock as setting a contrast will take its own lock
@@ -64,6 +293,7 @@ void Display::init(void) {
     Serial.print("u8g2 set clock. ");
     u8g2.begin();
     Serial.print("u8g2 began. ");
+    installPartialFlush();
 
     pinMode(LCD_BACKLIGHT, OUTPUT);
     Serial.println("u8g2 done. ");
@@ -215,9 +445,28 @@ void Display::update() {
     return;
   }
 
-  SpiLockGuard spiLock(25, false);  // Take out an SPI lock for the rending of the page
-  if (!spiLock) return;
+  DeferFrames deferFrames(false);
+  drawCurrentPage();
+  shownContext_ = lastRenderContext_;
+}
+
+// Between full renders the frame buffer still holds the last page drawn, so the pages with a vario
+// bar can erase and redraw just that part of it.  The partial flush then sends only the tiles the
+// bar and climb digits changed.
+void Display::updateVarioLayer() {
+  if (shownContext_ != DisplayRenderContext::Basic && shownContext_ != DisplayRenderContext::User)
+    return;
+
+  DeferFrames deferFrames(true);
+  lastRenderContext_ = shownContext_;
+  if (shownContext_ == DisplayRenderContext::Basic)
+    simplePage_drawVarioLayer();
+  else
+    thermalPage_drawVarioLayer();
+}
 
+// Called by update(); the frame is sent by the display send task
+void Display::drawCurrentPage() {
   if (displayPage_ == MainPage::Charging) {
     lastRenderContext_ = DisplayRenderContext::Charging;
     chargingPage_draw();
@@ -292,6 +541,7 @@ void Display::clear() {
   SpiLockGuard spiLock(25, false);
   if (!spiLock) return;
   u8g2.clear();
+  shownContext_ = DisplayRenderContext::None;
 }
 
 void Display::clearPage() {
@@ -55,6 +55,8 @@ class Display {
  public:
   void init();
   void update();
+  // Redraw just the vario bar and climb rate, if the page last drawn by update() has them
+  void updateVarioLayer();
   void clear();      // clear all pixels on the display
   void clearPage();  // reset all display target pages and pop-ups (there will be no target content
                      // after this call)
@@ -75,6 +77,7 @@ class Display {
   DisplayRenderContext lastRenderContext() const { return lastRenderContext_; }
 
  private:
+  void drawCurrentPage();
   MainPage sanitizedMainPage(MainPage targetPage);
   MainPage firstVisiblePrimaryPage(MainPage preferredPage) const;
   bool isScrollableMainPageVisible(MainPage targetPage) const;
@@ -90,6 +93,8 @@ class Display {
 
   bool showWarning_ = true;
   DisplayRenderContext lastRenderContext_ = DisplayRenderContext::None;
+  // What the last full render left on the screen, for updateVarioLayer to draw over
+  DisplayRenderContext shownContext_ = DisplayRenderContext::None;
 };
 
 extern Display display;
@@ -12,6 +12,7 @@
 #include "navigation/gpx.h"
 #include "power.h"
 #include "storage/sd_card.h"
+#include "storage/sd_latency.h"
 #include "system/version_info.h"
 #include "time.h"
 #include "ui/display/display.h"
@@ -19,6 +20,92 @@
 #include "ui/settings/settings.h"
 #include "wind_estimate/wind_estimate.h"
 
+namespace {
+  // The text a field last formatted at one place on screen, and the value it was formatted from.
+  // Pages draw into a cleared buffer every frame, so a field's glyphs are always drawn again, but
+  // while its value stays the same the saved text is drawn as it is instead of being formatted
+  // again.  The pixels then come out identical, so the partial flush in display.cpp sends nothing
+  // for the field either.
+  struct FieldText {
+    uint8_t x;
+    uint8_t y;
+    bool valid;
+    int32_t value;   // What the text shows, in display units (e.g. tenths for one decimal place)
+    uint8_t format;  // Settings the text depends on besides value
+    int8_t offsetX;  // Where the text starts relative to x
+    char text[12];
+
+    // True, and remembers value and format, if text no longer shows them and must be formatted
+    bool stale(int32_t newValue, uint8_t newFormat) {
+      if (valid && value == newValue && format == newFormat) return false;
+      valid = true;
+      value = newValue;
+      format = newFormat;
+      offsetX = 0;
+      text[0] = '\0';
+      return true;
+    }
+
+    // Draws text at the field's position, leaving the cursor after it like u8g2.print would
+    void print() const {
+      u8g2.setCursor(x + offsetX, y);
+      u8g2.print(text);
+    }
+  };
+
+  // Formats into a FieldText with the same Print calls (and so the same output) as printing to
+  // u8g2 directly
+  class FieldTextWriter : public Print {
+   public:
+    explicit FieldTextWriter(FieldText& field) : field_(field), length_(strlen(field.text)) {}
+
+    size_t write(uint8_t c) override {
+      if (length_ + 1 >= sizeof(field_.text)) return 0;
+      field_.text[length_++] = c;
+      field_.text[length_] = '\0';
+      return 1;
+    }
+
+   private:
+    FieldText& field_;
+    size_t length_;
+  };
+
+  // A field function's cached text for each place it's drawn.  A few slots cover every page a
+  // field appears on; a place no slot has seen takes over the oldest one.
+  template <uint8_t SLOTS>
+  class FieldTextCache {
+   public:
+    FieldText& at(uint8_t x, uint8_t y) {
+      for (FieldText& field : fields_) {
+        if (field.valid && field.x == x && field.y == y) return field;
+      }
+      FieldText& field = fields_[next_];
+      next_ = (next_ + 1) % SLOTS;
+      field = FieldText();
+      field.x = x;
+      field.y = y;
+      return field;
+    }
+
+   private:
+    FieldText fields_[SLOTS] = {};
+    uint8_t next_ = 0;
+  };
+
+  // Field values with no number to show
+  constexpr int32_t FIELD_UNAVAILABLE = INT32_MIN;
+
+  FieldTextCache<2> clockTimeFields;
+  FieldTextCache<4> speedFields;
+  FieldTextCache<8> altFields;
+  FieldTextCache<2> climbRateFields;
+  FieldTextCache<2> accelFields;
+  FieldTextCache<4> glideFields;
+  FieldTextCache<2> tempFields;
+  FieldTextCache<2> humidityFields;
+}  // namespace
+
 /********************************************************************************************/
 // Display Components
 // Individual fields that can be called from many different pages, and/or placed in different
@@ -37,33 +124,35 @@ void display_selectionBox(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t tr
 }
 
 void display_clockTime(uint8_t x, uint8_t y, bool show_ampm) {
-  u8g2.setCursor(x, y);
   u8g2.setDrawColor(1);
+  FieldText& field = clockTimeFields.at(x, y);
 
   // Get the local date, print NOGPS on error
   tm cal;
-  if (!gps.getLocalDateTime(cal)) {
-    u8g2.print("NO GPS");
-  } else {
-    // Crafts a 24 or 12 hour time to show depending on prefs
-    char buf[10];
-    if (settings.units_hours) {
+  const bool hasTime = gps.getLocalDateTime(cal);
+  const int32_t minuteOfDay = hasTime ? cal.tm_hour * 60 + cal.tm_min : FIELD_UNAVAILABLE;
+  if (field.stale(minuteOfDay, settings.units_hours | (show_ampm << 1))) {
+    char* buf = field.text;
+    if (!hasTime) {
+      strcpy(buf, "NO GPS");
+    } else if (settings.units_hours) {
+      // Crafts a 24 or 12 hour time to show depending on prefs
       if (show_ampm) {
         // This is a 12 hour time and needs to print eg " 9:45am"
-        strftime(buf, 10, "%I:%M%p", &cal);
+        strftime(buf, sizeof(field.text), "%I:%M%p", &cal);
       } else {
         // This is a 12 hour time and needs to print eg " 9:45"
-        strftime(buf, 10, "%I:%M", &cal);
+        strftime(buf, sizeof(field.text), "%I:%M", &cal);
       }
       if (buf[0] == '0') {
         buf[0] = ' ';
       }
     } else {
       // 24 hour.  Print in the format of "09:45"
-      strftime(buf, 10, "%R", &cal);
+      strftime(buf, sizeof(field.text), "%R", &cal);
     }
-    u8g2.print(buf);
   }
+  field.print();
 }
 
 void display_waypointTimeRemaining(uint8_t x, uint8_t y, const uint8_t* font) {
@@ -136,10 +225,14 @@ bool display_speed(uint8_t cursor_x, uint8_t cursor_y) {
   if (displaySpeed >= 1000) displaySpeed = 999;  // cap display value at 3 digits
   if (displaySpeed >= 100) speedIsThreeDigits = true;
 
-  u8g2.setCursor(cursor_x, cursor_y);
-  if (displaySpeed < 100) u8g2.print(" ");  // leave a space if needed
-  if (displaySpeed < 10) u8g2.print(" ");   // leave a space if needed
-  u8g2.print(displaySpeed);
+  FieldText& field = speedFields.at(cursor_x, cursor_y);
+  if (field.stale(displaySpeed, 0)) {
+    FieldTextWriter text(field);
+    if (displaySpeed < 100) text.print(" ");  // leave a space if needed
+    if (displaySpeed < 10) text.print(" ");   // leave a space if needed
+    text.print(displaySpeed);
+  }
+  field.print();
 
   return speedIsThreeDigits;
 }
@@ -260,6 +353,59 @@ void display_headingTurn(uint8_t cursor_x, uint8_t cursor_y) {
   if (displayTurn > '=') u8g2.print(displayTurn);
 }
 
+namespace {
+  // Altitude in m or ft, right-aligned in 6 characters with a thousands separator
+  void formatAlt(Print& text, int32_t displayAlt) {
+    bool negativeVal = false;
+
+    if (displayAlt < 0) {
+      negativeVal = true;
+      displayAlt *= -1;
+      if (displayAlt > 9999) displayAlt = 9999;  // max size if negative
+    } else if (displayAlt > 99999)
+      displayAlt = 99999;  // max size if positive
+
+    uint8_t digits = 0;
+    bool keepZeros = 0;
+
+    // Thousands piece
+    if (displayAlt > 999) {
+      digits = displayAlt / 1000;
+      displayAlt -= (1000 * digits);  // save the last 3 digits for later
+      keepZeros = 1;  // and keep leading zeros for rest of digits since we printed something in
+                      // thousands place
+      if (digits < 10) {
+        if (negativeVal)
+          text.print('-');  // negative sign for negative values (negative values are capped at
+                            // 9999 so 'digits < 10' will always be true)
+        else
+          text.print(' ');  // otherwise leading space as needed for positive values
+      }
+      text.print(digits);
+      text.print(',');
+    } else {
+      text.print(' ');  // ten-thousands place
+      if (negativeVal) {
+        text.print('-');
+      } else {
+        text.print(' ');  // thousands place
+      }
+    }
+    // rest of the number
+    if (keepZeros) {
+      for (int i = 100; i > 0; i /= 10) {
+        digits = displayAlt / i;
+        displayAlt -= (digits * i);
+        text.print(digits);
+      }
+    } else {  // don't show leading zeros for altitudes less than 1000
+      if (displayAlt < 100) text.print(' ');
+      if (displayAlt < 10) text.print(' ');
+      text.print(displayAlt);
+    }
+  }
+}  // namespace
+
 void display_alt_type(uint8_t cursor_x, uint8_t cursor_y, const uint8_t* font, uint8_t altType) {
   int32_t displayAlt = 0;
 
@@ -292,61 +438,18 @@ void display_alt(uint8_t cursor_x, uint8_t cursor_y, const uint8_t* font, int32_
   else
     displayAlt /= 100;  // convert from cm to m
 
-  u8g2.setCursor(cursor_x, cursor_y);
   u8g2.setFont(font);
-  if (displayAlt < -9999) {
-    // Altitude is unavailable
-    u8g2.print(" ---");
-    return;
-  }
-
-  bool negativeVal = false;
-
-  if (displayAlt < 0) {
-    negativeVal = true;
-    displayAlt *= -1;
-    if (displayAlt > 9999) displayAlt = 9999;  // max size if negative
-  } else if (displayAlt > 99999)
-    displayAlt = 99999;  // max size if positive
-
-  uint8_t digits = 0;
-  bool keepZeros = 0;
-
-  // Thousands piece
-  if (displayAlt > 999) {
-    digits = displayAlt / 1000;
-    displayAlt -= (1000 * digits);  // save the last 3 digits for later
-    keepZeros = 1;  // and keep leading zeros for rest of digits since we printed something in
-                    // thousands place
-    if (digits < 10) {
-      if (negativeVal)
-        u8g2.print('-');  // negative sign for negative values (negative values are capped at 9999
-                          // so 'digits < 10' will always be true)
-      else
-        u8g2.print(' ');  // otherwise leading space as needed for positive values
-    }
-    u8g2.print(digits);
-    u8g2.print(',');
-  } else {
-    u8g2.print(' ');  // ten-thousands place
-    if (negativeVal) {
-      u8g2.print('-');
+  FieldText& field = altFields.at(cursor_x, cursor_y);
+  if (field.stale(displayAlt, 0)) {
+    FieldTextWriter text(field);
+    if (displayAlt < -9999) {
+      // Altitude is unavailable
+      text.print(" ---");
     } else {
-      u8g2.print(' ');  // thousands place
+      formatAlt(text, displayAlt);
     }
   }
-  // rest of the number
-  if (keepZeros) {
-    for (int i = 100; i > 0; i /= 10) {
-      digits = displayAlt / i;
-      displayAlt -= (digits * i);
-      u8g2.print(digits);
-    }
-  } else {  // don't show leading zeros for altitudes less than 1000
-    if (displayAlt < 100) u8g2.print(' ');
-    if (displayAlt < 10) u8g2.print(' ');
-    u8g2.print(displayAlt);
-  }
+  field.print();
 }
 
 void print_alt_label(uint8_t altType) {
@@ -468,50 +571,39 @@ void display_climbRatePointerBox(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uin
 }
 
 void display_climbRate(uint8_t x, uint8_t y, const uint8_t* font, int16_t displayClimbRate) {
-  u8g2.setCursor(x, y);
   u8g2.setFont(font);
   u8g2.setDrawColor(0);
 
-  float climbInMS = 0;
-
-  if (displayClimbRate >= 0)
-    u8g2.print('+');
-  else {
-    u8g2.print('-');
-    displayClimbRate *= -1;  // keep positive part
-  }
+  const bool negative = displayClimbRate < 0;
+  if (negative) displayClimbRate *= -1;  // keep positive part
 
   if (settings.units_climb) {
     // convert from cm/s to fpm (lose one significant digit)
     displayClimbRate = displayClimbRate * 197 / 1000 * 10;
-    if (displayClimbRate < 1000) u8g2.print(" ");
-    if (displayClimbRate < 100) u8g2.print(" ");
-    if (displayClimbRate < 10) u8g2.print(" ");
-    u8g2.print(displayClimbRate);
-    /*
-    if (font == leaf_21h) {
-      u8g2.print("f");
-    } else {
-      u8g2.setFont(leaf_labels);
-      u8g2.print(" fpm");
-    }
-    */
   } else {
     // lose one decimal place and round off in the process
     displayClimbRate = (displayClimbRate + 5) / 10;
-    // convert to float for ease of printing with the decimal in place
-    climbInMS = (float)displayClimbRate / 10;
-    if (climbInMS < 10) u8g2.print(" ");
-    u8g2.print(climbInMS, 1);
-    /*
-    if (font == leaf_21h) {
-      u8g2.print("m");
+  }
+
+  // The sign is part of the key on its own: -0 and +0 are shown differently
+  FieldText& field = climbRateFields.at(x, y);
+  if (field.stale(displayClimbRate, settings.units_climb | (negative << 1))) {
+    FieldTextWriter text(field);
+    text.print(negative ? '-' : '+');
+    if (settings.units_climb) {
+      if (displayClimbRate < 1000) text.print(" ");
+      if (displayClimbRate < 100) text.print(" ");
+      if (displayClimbRate < 10) text.print(" ");
+      text.print(displayClimbRate);
     } else {
-      u8g2.setFont(leaf_labels);
-      u8g2.print(" m/s");
+      // convert to float for ease of printing with the decimal in place
+      float climbInMS = (float)displayClimbRate / 10;
+      if (climbInMS < 10) text.print(" ");
+      text.print(climbInMS, 1);
     }
-    */
   }
+  field.print();
+
   // always set back to 1 if we've been using 0, just in case
   u8g2.setDrawColor(1);
 }
@@ -573,62 +665,89 @@ void display_altAboveLaunch(uint8_t x, uint8_t y) {
 }
 
 void display_accel(uint8_t x, uint8_t y, float accel) {
-  u8g2.setCursor(x, y);
   u8g2.setDrawColor(1);
   u8g2.setFont(leaf_6x12);
-  u8g2.print(accel, 1);
-  u8g2.print(" g");
+
+  // Tenths of a g, as shown
+  const int32_t accelTenths = lroundf(accel * 10);
+  FieldText& field = accelFields.at(x, y);
+  if (field.stale(accelTenths, 0)) {
+    FieldTextWriter text(field);
+    text.print(accelTenths / 10.0f, 1);
+    text.print(" g");
+  }
+  field.print();
 }
 
 void display_glide(uint8_t x, uint8_t y, float glide) {
   u8g2.setDrawColor(1);
   u8g2.setFont(leaf_6x12);
 
+  // Tenths of the glide ratio, as shown
+  int32_t glideTenths = FIELD_UNAVAILABLE;
+  bool indented = false;
   // the 'usual' positive glide angle (going down)
   if (glide > 0) {
-    if (glide < 10) x += 7;
+    if (glide < 10) indented = true;
     if (glide >= 100) glide = 99.9;  // clip at max display glide
-    u8g2.setCursor(x, y);
-    u8g2.print(glide, 1);
-  } else {  // 0 or negative glide ratio (this means the angle is 'upward', since traditionally a
-            // positive glide angle is still 'going down')
-    u8g2.setCursor(x, y);
-    u8g2.print("--.-");
+    glideTenths = lroundf(glide * 10);
+  }  // else 0 or negative glide ratio (this means the angle is 'upward', since traditionally a
+     // positive glide angle is still 'going down')
+
+  FieldText& field = glideFields.at(x, y);
+  if (field.stale(glideTenths, indented)) {
+    FieldTextWriter text(field);
+    if (glideTenths == FIELD_UNAVAILABLE) {
+      text.print("--.-");
+    } else {
+      if (indented) field.offsetX = 7;
+      text.print(glideTenths / 10.0f, 1);
+    }
   }
+  field.print();
 }
 
 void display_temp(uint8_t x, uint8_t y, const Ambient& ambient) {
-  u8g2.setCursor(x, y);
   u8g2.setDrawColor(1);
   u8g2.setFont(leaf_6x12);
 
+  int32_t temperature = FIELD_UNAVAILABLE;
   if (ambient.state() == Ambient::State::Ready) {
-    int16_t temperature = ambient.temp();
-    if (settings.units_temp) {
-      temperature = temperature * 9 / 5 + 32;
-      u8g2.print(temperature);
-      u8g2.print((char)134);
+    temperature = (int16_t)ambient.temp();
+    if (settings.units_temp) temperature = temperature * 9 / 5 + 32;
+  }
+
+  FieldText& field = tempFields.at(x, y);
+  if (field.stale(temperature, settings.units_temp)) {
+    FieldTextWriter text(field);
+    if (temperature == FIELD_UNAVAILABLE) {
+      text.print("--");
     } else {
-      u8g2.print(temperature);
-      u8g2.print((char)133);
+      text.print(temperature);
+      text.print(settings.units_temp ? (char)134 : (char)133);
     }
-  } else {
-    u8g2.print("--");
   }
+  field.print();
 }
 
 void display_humidity(uint8_t x, uint8_t y, const Ambient& ambient) {
-  u8g2.setCursor(x, y);
   u8g2.setDrawColor(1);
   u8g2.setFont(leaf_6x12);
 
-  if (ambient.state() == Ambient::State::Ready) {
-    uint8_t humidity = (uint8_t)ambient.humidity();
-    u8g2.print(humidity);
-    u8g2.print('%');
-  } else {
-    u8g2.print("--%");
+  int32_t humidity = FIELD_UNAVAILABLE;
+  if (ambient.state() == Ambient::State::Ready) humidity = (uint8_t)ambient.humidity();
+
+  FieldText& field = humidityFields.at(x, y);
+  if (field.stale(humidity, 0)) {
+    FieldTextWriter text(field);
+    if (humidity == FIELD_UNAVAILABLE) {
+      text.print("--");
+    } else {
+      text.print(humidity);
+    }
+    text.print('%');
   }
+  field.print();
 }
 
 void display_battIcon(uint8_t x, uint8_t y, bool vertical) {
@@ -812,6 +931,31 @@ void display_fanet_icon(const uint8_t& x, const uint8_t& y) {
   }
 }
 
+bool display_trafficWarning(uint8_t y) {
+  const fanet_traffic::Report threat = fanetRadio.getTrafficThreat();
+  if (threat.alarm == fanet_traffic::Alarm::None) return false;
+
+  // Solid for low and important alarms; the urgent one flashes
+  const bool solid = threat.alarm != fanet_traffic::Alarm::Urgent || (millis() / 250) % 2 == 0;
+  u8g2.setDrawColor(1);
+  if (solid) {
+    u8g2.drawBox(0, y - 13, 96, 14);
+  } else {
+    u8g2.drawFrame(0, y - 13, 96, 14);
+  }
+
+  // e.g. "TRAFFIC 2h 40m": which way to look, and how far
+  u8g2.setDrawColor(solid ? 0 : 1);
+  u8g2.setFont(leaf_6x12);
+  u8g2.setCursor(0, y);
+  u8g2.print("TRAFFIC ");
+  u8g2.print(threat.clock);
+  u8g2.print("h ");
+  display_distance(u8g2.getCursorX(), y, threat.distance < 1 ? 1 : threat.distance);
+  u8g2.setDrawColor(1);
+  return true;
+}
+
 // Wind Sock Center Pointer
 void display_windSockArrow(int16_t x, int16_t y, int16_t radius) {
   const WindEstimate& windEstimate = windEstimator.getWindEstimate();
@@ -1071,6 +1215,9 @@ void display_header(bool showTurnArrows) {
 }
 
 void display_footer(bool timerSelected) {
+  // A predicted collision takes the footer over until it clears
+  if (display_trafficWarning(192)) return;
+
   // battery
   display_battIcon(0, 192, true);
 
@@ -1138,6 +1285,13 @@ void display_on_splash() {
   do {
     display_splashLogo();
 
+    // The card was benchmarked as it was mounted: logging to one this slow stalls
+    if (sd_latency::mountBenchmark().slow) {
+      u8g2.setFont(leaf_5x8);
+      u8g2.setCursor(18, 137);
+      u8g2.print("SLOW SD CARD");
+    }
+
     u8g2.setFont(leaf_6x12);
     u8g2.setCursor(28, 149);
     u8g2.print("HELLO");
@@ -57,6 +57,9 @@ void display_batt_charging_fullscreen(uint8_t x, uint8_t y);
 void display_batt_charging_fullscreen(uint8_t x, uint8_t y, bool warning);
 void display_GPS_icon(uint8_t x, uint8_t y);
 void display_fanet_icon(const uint8_t& x, const uint8_t& y);
+// Draws the most urgent predicted collision across the width of the screen, baseline y.  Returns
+// false, drawing nothing, when there is none.
+bool display_trafficWarning(uint8_t y);
 
 void display_windSockArrow(int16_t x, int16_t y, int16_t radius);
 void display_windSockRing(int16_t x, int16_t y, int16_t radius, int16_t size, bool showPointer);
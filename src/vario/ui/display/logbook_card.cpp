@@ -64,10 +64,22 @@ namespace {
     return formatAccel(summary.minAccelG, false) + "/" + formatAccel(summary.maxAccelG, true);
   }
 
+  String formatXcScore(const LogbookEntrySummary& summary) {
+    if (!summary.xcValid) return "--";
+    const char* type = summary.xcType == XcScore::Type::FaiTriangle    ? "FAI"
+                       : summary.xcType == XcScore::Type::FlatTriangle ? "Tri"
+                                                                       : "Free";
+    return String(type) + " " + String(summary.xcScore, 1) + "p";
+  }
+
   constexpr uint8_t METRIC_LABEL_X = 2;
   constexpr uint8_t METRIC_VALUE_RIGHT_X = 94;
   constexpr uint8_t METRIC_FRAME_Y = 35;
   constexpr uint8_t METRIC_FRAME_H = 106;
+  constexpr uint8_t METRIC_FIRST_ROW_Y = 47;
+  constexpr uint8_t METRIC_ROW_PITCH = 13;
+
+  constexpr uint8_t metricRowY(uint8_t row) { return METRIC_FIRST_ROW_Y + row * METRIC_ROW_PITCH; }
 
   void drawMetricRow(const String& label, const String& value, uint8_t y) {
     u8g2.setCursor(METRIC_LABEL_X, y);
@@ -123,17 +135,20 @@ namespace logbook_card {
 
     u8g2.drawRFrame(0, METRIC_FRAME_Y, 96, METRIC_FRAME_H, 3);
 
-    drawMetricRow("MaxAlt:", formatLogbookAltitude(summary.maxAltitudeM), 49);
-    drawMetricRow("", formatLogbookClimbRange(summary), 64);
+    drawMetricRow("MaxAlt:", formatLogbookAltitude(summary.maxAltitudeM), metricRowY(0));
+    drawMetricRow("", formatLogbookClimbRange(summary), metricRowY(1));
     drawMetricRow(String((char)148) + "Dist:",
-                  formatDistance(summary.straightLineDistanceM, settings.units_distance, true), 79);
+                  formatDistance(summary.straightLineDistanceM, settings.units_distance, true),
+                  metricRowY(2));
     drawMetricRow(String((char)147) + "Path:",
-                  formatDistance(summary.pathDistanceM, settings.units_distance, true), 94);
+                  formatDistance(summary.pathDistanceM, settings.units_distance, true),
+                  metricRowY(3));
+    drawMetricRow("XC:", formatXcScore(summary), metricRowY(4));
     drawMetricRow("MaxSpeed:", formatSpeed(summary.maxGroundSpeedMps, settings.units_speed, true),
-                  109);
-    drawMetricRow("Accel:", formatLogbookAccelRange(summary), 124);
+                  metricRowY(5));
+    drawMetricRow("Accel:", formatLogbookAccelRange(summary), metricRowY(6));
     if (summary.maxWindValid) {
-      drawMetricRow((char)143, formatMaxWind(summary), 139);
+      drawMetricRow((char)143, formatMaxWind(summary), metricRowY(7));
     }
   }
 }  // namespace logbook_card
@@ -24,6 +24,11 @@ PageFlightSummary::PageFlightSummary() {
 }
 
 void PageFlightSummary::draw() {
+  if (xcScoresSeen != xc_score_task::completedCount()) {
+    xcScoresSeen = xc_score_task::completedCount();
+    LogbookStore::readSummary(logbookPath, summary);
+  }
+
   u8g2.firstPage();
   do {
     display_menuTitle("SUMMARY");
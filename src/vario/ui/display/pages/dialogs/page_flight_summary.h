@@ -2,6 +2,7 @@
 
 #include "logbook/flight_stats.h"
 #include "logbook/logbook_store.h"
+#include "logbook/xc_score_task.h"
 #include "ui/display/menu_page.h"
 
 class PageFlightSummary : public SettingsMenuPage {
@@ -18,6 +19,7 @@ class PageFlightSummary : public SettingsMenuPage {
     this->deletePending = 0;
     this->summary = LogbookEntrySummary();
     LogbookStore::readSummary(logbookPath, this->summary);
+    this->xcScoresSeen = xc_score_task::completedCount();
     cursor_position = CURSOR_BACK;
     showing_ = true;
     push_page(this);
@@ -29,5 +31,6 @@ class PageFlightSummary : public SettingsMenuPage {
   String trackPath;
   LogbookEntrySummary summary;
   uint8_t deletePending = 0;
+  uint32_t xcScoresSeen = 0;  // Re-read the entry when its post-flight XC score lands
   static bool showing_;
 };
@@ -7,6 +7,7 @@
 #include "navigation/gpx.h"
 #include "navigation/route_store.h"
 #include "navigation/user_waypoints.h"
+#include "storage/dir_cache.h"
 #include "storage/sd_card.h"
 #include "ui/audio/sound_effects.h"
 #include "ui/audio/speaker.h"
@@ -67,12 +68,6 @@ namespace {
     return *a == '\0' ? -1 : 1;
   }
 
-  String fileNameOnly(const String& path) {
-    const int slash = path.lastIndexOf('/');
-    if (slash < 0) return path;
-    return path.substring(slash + 1);
-  }
-
   bool isUserWaypointsLabel(const char* name) {
     return name != nullptr && strcmp(name, USER_WAYPOINTS_LABEL) == 0;
   }
@@ -172,30 +167,19 @@ void PageGpxFileSelect::refreshIndex() {
     return;
   }
 
-  File dir = SD_MMC.open(directoryPath());
-  if (!dir || !dir.isDirectory()) {
-    snprintf(status_, sizeof(status_), "Folder error");
-    cursor_position = CURSOR_BACK;
-    cursor_max = CURSOR_BACK;
-    return;
-  }
-
   if (mode_ == Mode::NavFiles && user_waypoints::hasSavedPoints()) {
     addFileName(USER_WAYPOINTS_LABEL);
   }
 
-  File entry = dir.openNextFile();
-  while (entry) {
-    if (!entry.isDirectory()) {
-      const String name = fileNameOnly(entry.name());
-      if (supportedFileName(name.c_str())) {
-        addFileName(name);
-      }
-    }
-    entry.close();
-    entry = dir.openNextFile();
+  const bool listed = dir_cache::forEach(directoryPath(), [this](const dir_cache::Entry& entry) {
+    if (!entry.directory && supportedFileName(entry.name)) addFileName(entry.name);
+  });
+  if (!listed) {
+    snprintf(status_, sizeof(status_), "Folder error");
+    cursor_position = CURSOR_BACK;
+    cursor_max = CURSOR_BACK;
+    return;
   }
-  dir.close();
 
   if (fileCount_ == 0) {
     snprintf(status_, sizeof(status_),
@@ -87,7 +87,7 @@ void AltimeterMenuPage::draw() {
     u8g2.setCursor(label_indent, start_y += 15);
     u8g2.print("Set:");
     u8g2.setCursor(32, start_y);
-    u8g2.print(baro.altimeterSetting, 3);
+    u8g2.print(baro.altimeterSetting(), 3);
     u8g2.print("inHg");
 
     uint8_t setting_choice_x = 78;
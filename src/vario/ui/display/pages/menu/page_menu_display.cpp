@@ -19,6 +19,7 @@ enum display_menu_items {
   cursor_display_show_thermal_track,
   cursor_display_show_navigate,
   cursor_display_contrast,
+  cursor_display_vario_bar_rate,
 };
 
 namespace {
@@ -102,6 +103,12 @@ void DisplayMenuPage::draw() {
           if (settings.disp_contrast < 10) u8g2.print(" ");
           u8g2.print(settings.disp_contrast);
           break;
+        case cursor_display_vario_bar_rate:
+          u8g2.setCursor(contrast_value_x - 6, y);
+          if (settings.disp_varioBarHz < 10) u8g2.print(" ");
+          u8g2.print(settings.disp_varioBarHz);
+          u8g2.print("Hz");
+          break;
         case cursor_display_back:
           menu_ui::drawBackIcon(setting_choice_x, y);
           break;
@@ -179,6 +186,9 @@ void DisplayMenuPage::setting_change(Button dir, ButtonEvent state, uint8_t coun
       if (state == ButtonEvent::CLICKED || state == ButtonEvent::INCREMENTED)
         settings.adjustContrast(dir);
       break;
+    case cursor_display_vario_bar_rate:
+      if (state == ButtonEvent::CLICKED) settings.adjustVarioBarRate(dir);
+      break;
     case cursor_display_back:
       if (state == ButtonEvent::CLICKED) {
         speaker.playSound(fx::cancel);
@@ -193,7 +203,8 @@ void DisplayMenuPage::setting_change(Button dir, ButtonEvent state, uint8_t coun
 }
 
 bool DisplayMenuPage::cursorUsesLeftButton() const {
-  return cursor_position == cursor_display_contrast;
+  return cursor_position == cursor_display_contrast ||
+         cursor_position == cursor_display_vario_bar_rate;
 }
 
 bool DisplayMenuPage::row_hidden(uint8_t row) const {
@@ -208,7 +219,7 @@ uint8_t DisplayMenuPage::row_y(uint8_t row) const {
   for (uint8_t i = 1; i < row; ++i) {
     if (!row_hidden(i)) y += 15;
   }
-  if (row == cursor_display_contrast) y += 15;
+  if (row >= cursor_display_contrast) y += 15;
   return y;
 }
 
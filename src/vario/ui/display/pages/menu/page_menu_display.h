@@ -10,7 +10,7 @@ class DisplayMenuPage : public SettingsMenuPage {
  public:
   DisplayMenuPage() {
     cursor_position = 0;
-    cursor_max = 6;
+    cursor_max = 7;
   }
   void draw();
   bool button_event(Button button, ButtonEvent state, uint8_t count) override;
@@ -20,8 +20,9 @@ class DisplayMenuPage : public SettingsMenuPage {
   bool cursorUsesLeftButton() const override;
 
  private:
-  static constexpr char* labels[7] = {
-      "Back", "Basic", "User", "Thermal\037Core", "Thermal\037Track", "Navigate", "Contrast"};
+  static constexpr char* labels[8] = {"Back",     "Basic",           "User",
+                                      "Thermal\037Core", "Thermal\037Track", "Navigate",
+                                      "Contrast", "Vario\037Bar"};
   bool row_hidden(uint8_t row) const;
   uint8_t row_y(uint8_t row) const;
   void skip_hidden_forward();
@@ -16,6 +16,9 @@ enum leaf_labs_menu_items {
   cursor_leaf_labs_thermal_core,
   cursor_leaf_labs_thermal_track,
   cursor_leaf_labs_leaf_log,
+  cursor_leaf_labs_gps_rate,
+  cursor_leaf_labs_ble_vario_rate,
+  cursor_leaf_labs_ble_gps_rate,
 };
 
 namespace {
@@ -47,6 +50,14 @@ namespace {
     }
     speaker.playSound(enabled ? fx::enter : fx::cancel);
   }
+
+  // Right-aligned under the on/off icons, e.g. " 5Hz"
+  void printRate(uint8_t x, uint8_t y, int8_t hz) {
+    u8g2.setCursor(x - 12, y);
+    if (hz < 10) u8g2.print(" ");
+    u8g2.print(hz);
+    u8g2.print("Hz");
+  }
 }  // namespace
 
 void LeafLabsMenuPage::draw() {
@@ -67,7 +78,7 @@ void LeafLabsMenuPage::draw() {
 
     uint8_t setting_name_x = 2;
     uint8_t setting_choice_x = 81;
-    uint8_t menu_items_y[] = {190, 86, 101, 116};
+    uint8_t menu_items_y[] = {190, 86, 101, 116, 131, 146, 161};
 
     for (int i = 0; i <= cursor_max; i++) {
       const bool selected = i == cursor_position;
@@ -84,6 +95,15 @@ void LeafLabsMenuPage::draw() {
         case cursor_leaf_labs_leaf_log:
           menu_ui::printGlyph(settings.labs_leafLog ? menu_ui::ICON_ON : menu_ui::ICON_OFF);
           break;
+        case cursor_leaf_labs_gps_rate:
+          printRate(setting_choice_x, menu_items_y[i], settings.labs_gpsRateHz);
+          break;
+        case cursor_leaf_labs_ble_vario_rate:
+          printRate(setting_choice_x, menu_items_y[i], settings.labs_bleVarioHz);
+          break;
+        case cursor_leaf_labs_ble_gps_rate:
+          printRate(setting_choice_x, menu_items_y[i], settings.labs_bleGpsHz);
+          break;
         case cursor_leaf_labs_back:
           menu_ui::drawBackIcon(setting_choice_x, menu_items_y[i]);
           break;
@@ -114,6 +134,14 @@ void LeafLabsMenuPage::draw() {
           "Leaf web app",
       };
       menu_ui::drawNoteBox(menu_items_y[cursor_leaf_labs_leaf_log], noteLines, 3);
+    } else if (cursor_position == cursor_leaf_labs_gps_rate) {
+      const char* const noteLines[] = {
+          "GPS fixes each",
+          "second for the",
+          "tracklog and wind",
+          "(uses more power)",
+      };
+      menu_ui::drawNoteBox(menu_items_y[cursor_leaf_labs_gps_rate], noteLines, 4);
     }
   } while (u8g2.nextPage());
 }
@@ -135,6 +163,15 @@ void LeafLabsMenuPage::setting_change(Button dir, ButtonEvent state, uint8_t cou
         setLeafLogEnabled(!settings.labs_leafLog);
       }
       break;
+    case cursor_leaf_labs_gps_rate:
+      if (state == ButtonEvent::CLICKED) settings.adjustGpsRate(dir);
+      break;
+    case cursor_leaf_labs_ble_vario_rate:
+      if (state == ButtonEvent::CLICKED) settings.adjustBleVarioRate(dir);
+      break;
+    case cursor_leaf_labs_ble_gps_rate:
+      if (state == ButtonEvent::CLICKED) settings.adjustBleGpsRate(dir);
+      break;
     case cursor_leaf_labs_back:
       if (state == ButtonEvent::CLICKED) {
         speaker.playSound(fx::cancel);
@@ -74,7 +74,7 @@ void debugPage_draw() {
     u8g2.print("AltSet:");
     u8g2.setCursor(65, 53);
     u8g2.setFont(leaf_6x12);
-    u8g2.print(baro.altimeterSetting);
+    u8g2.print(baro.altimeterSetting());
 
     /*
     // fix quality debugging
@@ -5,6 +5,8 @@
 #include "hardware/icm_20948.h"
 #include "instruments/imu.h"
 #include "power.h"
+#include "storage/sd_latency.h"
+#include "task_schedule.h"
 #include "ui/audio/sound_effects.h"
 #include "ui/audio/speaker.h"
 #include "ui/display/display.h"
@@ -31,9 +33,129 @@ namespace {
     }
     y += 8;
   }
+
+  // UP/DOWN cycle between the IMU counters, the main loop's task timings and SD card latencies
+  enum class View : uint8_t { Imu, Tasks, SdCard };
+  constexpr uint8_t VIEW_COUNT = 3;
+  View view = View::Imu;
+
+  void drawTaskTimes() {
+    u8g2.firstPage();
+    do {
+      uint8_t y = 8;
+      u8g2.setFont(leaf_5h);
+      u8g2.setCursor(0, y);
+      u8g2.print("TASKS AVG/MAX US");
+      y += 8;
+
+      uint32_t overBudget = 0;
+      uint32_t deadlineMisses = 0;
+      for (uint8_t i = 0; i < task_schedule::taskCount(); i++) {
+        const task_schedule::Task& task = task_schedule::task(i);
+        const task_schedule::Stats& stats = task_schedule::stats(i);
+        overBudget += stats.overBudget;
+        deadlineMisses += stats.deadlineMisses;
+
+        // Flag tasks that have run over budget or past the end of their block
+        char name[9];
+        name[0] = stats.overBudget || stats.deadlineMisses ? '*' : ' ';
+        strncpy(name + 1, task.name, sizeof(name) - 2);
+        name[sizeof(name) - 1] = '\0';
+        u8g2.setFont(leaf_5h);
+        u8g2.setCursor(0, y);
+        u8g2.print(name);
+        u8g2.setFont(leaf_5x8);
+        u8g2.setCursor(40, y);
+        u8g2.print(min(task_schedule::averageUs(stats), (uint32_t)9999));
+        u8g2.setCursor(66, y);
+        u8g2.print(min(stats.maxUs, (uint32_t)99999));
+        y += 8;
+      }
+
+      y += 4;
+      u8g2.setFont(leaf_5x8);
+      printCounterLine(0, y, "over", overBudget, 0, false);
+      printCounterLine(0, y, "miss", deadlineMisses, 0, false);
+    } while (u8g2.nextPage());
+  }
+
+  void printLatencyLine(uint8_t& y, const char* label, const sd_latency::Histogram& histogram) {
+    u8g2.setFont(leaf_5h);
+    u8g2.setCursor(0, y);
+    u8g2.print(label);
+    u8g2.setFont(leaf_5x8);
+    u8g2.setCursor(40, y);
+    u8g2.print(min(sd_latency::percentileUs(histogram, 99), (uint32_t)99999));
+    u8g2.setCursor(66, y);
+    u8g2.print(min(histogram.maxUs, (uint32_t)999999));
+    y += 8;
+  }
+
+  void drawSdLatency() {
+    u8g2.firstPage();
+    do {
+      uint8_t y = 8;
+      u8g2.setFont(leaf_5h);
+      u8g2.setCursor(0, y);
+      u8g2.print("SD P99/MAX US");
+      y += 8;
+
+      uint32_t total = 0;
+      for (uint8_t i = 0; i < sd_latency::OP_COUNT; i++) {
+        const sd_latency::Op op = (sd_latency::Op)i;
+        const sd_latency::Histogram histogram = sd_latency::histogram(op);
+        total += histogram.count;
+        printLatencyLine(y, sd_latency::name(op), histogram);
+      }
+      u8g2.setFont(leaf_5x8);
+      printCounterLine(0, y, "ops", total, 0, false);
+
+      // Writes by size of delay: a slow card shows up in the long tail
+      y += 4;
+      u8g2.setFont(leaf_5h);
+      u8g2.setCursor(0, y);
+      u8g2.print("WRITES UNDER MS");
+      y += 8;
+      u8g2.setFont(leaf_5x8);
+      const sd_latency::Histogram writes = sd_latency::histogram(sd_latency::Op::Write);
+      uint32_t under1 = 0;
+      uint32_t under16 = 0;
+      uint32_t under128 = 0;
+      for (uint8_t i = 0; i < sd_latency::BUCKET_COUNT - 1; i++) {
+        const uint32_t boundUs = sd_latency::FIRST_BUCKET_US << i;
+        if (boundUs <= 1024) under1 += writes.buckets[i];
+        if (boundUs <= 16384) under16 += writes.buckets[i];
+        if (boundUs <= 131072) under128 += writes.buckets[i];
+      }
+      printCounterLine(0, y, "1", under1, percent(under1, writes.count));
+      printCounterLine(0, y, "16", under16, percent(under16, writes.count));
+      printCounterLine(0, y, "128", under128, percent(under128, writes.count));
+      printCounterLine(0, y, "more", writes.count - under128,
+                       percent(writes.count - under128, writes.count));
+
+      y += 4;
+      const sd_latency::Benchmark benchmark = sd_latency::mountBenchmark();
+      u8g2.setFont(leaf_5h);
+      u8g2.setCursor(0, y);
+      u8g2.print(benchmark.slow ? "BENCH: SLOW CARD" : "BENCH");
+      y += 8;
+      u8g2.setFont(leaf_5x8);
+      printCounterLine(0, y, "KB/s", benchmark.bytesPerSecond / 1024, 0, false);
+      printLatencyLine(y, "write", benchmark.writes);
+    } while (u8g2.nextPage());
+  }
 }  // namespace
 
 void debug2Page_draw() {
+  if (view == View::Tasks) {
+    drawTaskTimes();
+    return;
+  }
+  if (view == View::SdCard) {
+    drawSdLatency();
+    return;
+  }
+
   u8g2.firstPage();
   do {
     const ICM20948& icm = ICM20948::getInstance();
@@ -134,6 +256,14 @@ void debug2Page_button(Button button, ButtonEvent state, uint8_t count) {
         speaker.playSound(fx::decrease);
       }
       break;
+    case Button::UP:
+      if (state == ButtonEvent::CLICKED) view = (View)(((uint8_t)view + 1) % VIEW_COUNT);
+      break;
+    case Button::DOWN:
+      if (state == ButtonEvent::CLICKED) {
+        view = (View)(((uint8_t)view + VIEW_COUNT - 1) % VIEW_COUNT);
+      }
+      break;
   }
   display.update();
 }
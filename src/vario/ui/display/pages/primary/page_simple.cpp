@@ -31,6 +31,40 @@ uint8_t simple_page_cursor_timeCount =
 uint8_t simple_page_cursor_timeOut =
     10;  // after 8 page draws (4 seconds) reset the cursor if a button hasn't been pushed.
 
+namespace {
+  // Vario Bar
+  constexpr uint8_t topOfFrame = 18;
+  constexpr uint8_t varioBarWidth = 12;
+  constexpr uint8_t varioBarClimbHeight = 85;
+  constexpr uint8_t varioBarSinkHeight = 70;
+
+  // Climb
+  constexpr uint8_t climbBoxHeight = 34;
+  constexpr uint8_t climbBoxY = topOfFrame + varioBarClimbHeight - climbBoxHeight / 2;
+
+  // The vario bar and the climb rate box pointing at it; nothing else on the page overlaps them,
+  // so simplePage_drawVarioLayer can redraw them on their own
+  void drawVarioLayer() {
+    // TODO: display lack of climb rate differently than 0
+    int32_t climbRate = baro.climbRateFilteredValid() ? baro.climbRateFiltered() : 0;
+    display_varioBar(topOfFrame, varioBarClimbHeight, varioBarSinkHeight, varioBarWidth, climbRate);
+
+    display_climbRatePointerBox(varioBarWidth + 9, climbBoxY, 75, climbBoxHeight,
+                                16);  // x, y, w, h, triangle size
+    display_climbRate(11, climbBoxY + 31, leaf_28h, climbRate);
+    u8g2.setDrawColor(0);
+    u8g2.drawPixel(varioBarWidth + 9,
+                   climbBoxY);  // one pixel corner needs trimmed due to interaction with triangle
+                                // and even-dimension box height
+    u8g2.setFont(leaf_28h);
+    if (settings.units_climb)
+      u8g2.print('f');
+    else
+      u8g2.print('m');
+    u8g2.setDrawColor(1);
+  }
+}  // namespace
+
 void simplePage_draw() {
   // if cursor is selecting something, count toward the timeOut value before we reset cursor
   if (simple_page_cursor_position != cursor_simplePage_none &&
@@ -85,32 +119,8 @@ void simplePage_draw() {
     bool showPointer = true;
     display_windSockRing(center_x, wind_y, wind_radius, pointer_size, showPointer);
 
-    // Vario Bar
-    uint8_t topOfFrame = 18;
-    uint8_t varioBarWidth = 12;
-    uint8_t varioBarClimbHeight = 85;
-    uint8_t varioBarSinkHeight = 70;
-
-    // TODO: display lack of climb rate differently than 0
-    int32_t climbRate = baro.climbRateFilteredValid() ? baro.climbRateFiltered() : 0;
-    display_varioBar(topOfFrame, varioBarClimbHeight, varioBarSinkHeight, varioBarWidth, climbRate);
-
-    // Climb
-    uint8_t climbBoxHeight = 34;
-    uint8_t climbBoxY = topOfFrame + varioBarClimbHeight - climbBoxHeight / 2;
-    display_climbRatePointerBox(varioBarWidth + 9, climbBoxY, 75, climbBoxHeight,
-                                16);  // x, y, w, h, triangle size
-    display_climbRate(11, climbBoxY + 31, leaf_28h, climbRate);
-    u8g2.setDrawColor(0);
-    u8g2.drawPixel(varioBarWidth + 9,
-                   climbBoxY);  // one pixel corner needs trimmed due to interaction with triangle
-                                // and even-dimension box height
-    u8g2.setFont(leaf_28h);
-    if (settings.units_climb)
-      u8g2.print('f');
-    else
-      u8g2.print('m');
-    u8g2.setDrawColor(1);
+    // Vario Bar and Climb
+    drawVarioLayer();
 
     // Altitude
     uint8_t alt_y = 139;
@@ -136,6 +146,17 @@ void simplePage_draw() {
   } while (u8g2.nextPage());
 }
 
+void simplePage_drawVarioLayer() {
+  // Erase the vario bar, and the full width of the rows the climb box covers
+  u8g2.setDrawColor(0);
+  u8g2.drawBox(0, topOfFrame, varioBarWidth, varioBarClimbHeight + varioBarSinkHeight + 1);
+  u8g2.drawBox(0, climbBoxY, u8g2.getDisplayWidth(), climbBoxHeight);
+  u8g2.setDrawColor(1);
+
+  drawVarioLayer();
+  u8g2.sendBuffer();
+}
+
 void simple_page_cursor_move(Button button) {
   if (button == Button::UP) {
     simple_page_cursor_position--;
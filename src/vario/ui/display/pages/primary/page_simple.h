@@ -8,6 +8,10 @@
 // draw the pixels to the display
 void simplePage_draw(void);
 
+// redraw just the vario bar and climb rate over the last frame drawn by simplePage_draw, and send
+// it to the display
+void simplePage_drawVarioLayer(void);
+
 // handle button presses relative to what's shown on the display
 void simplePage_button(Button button, ButtonEvent state, uint8_t count);
 
@@ -37,6 +37,39 @@ uint8_t thermal_page_cursor_timeCount =
 uint8_t thermal_page_cursor_timeOut =
     8;  // after 8 page draws (4 seconds) reset the cursor if a button hasn't been pushed.
 
+namespace {
+  // Vario Bar
+  constexpr uint8_t topOfFrame = 21;
+  constexpr uint8_t varioBarWidth = 25;
+  constexpr uint8_t varioBarClimbHeight = 75;
+  constexpr uint8_t varioBarSinkHeight = varioBarClimbHeight;
+
+  // Climb
+  constexpr uint8_t climbBoxHeight = 27;
+  constexpr uint8_t climbBoxY = topOfFrame + varioBarClimbHeight - climbBoxHeight / 2;
+
+  // The vario bar and the climb rate box pointing at it; nothing else on the page overlaps them,
+  // so thermalPage_drawVarioLayer can redraw them on their own
+  void drawVarioLayer() {
+    // TODO: display lack of climb rate differently than 0
+    int32_t climbRate = baro.climbRateFilteredValid() ? baro.climbRateFiltered() : 0;
+    display_varioBar(topOfFrame, varioBarClimbHeight, varioBarSinkHeight, varioBarWidth, climbRate);
+
+    display_climbRatePointerBox(varioBarWidth, climbBoxY, 76, climbBoxHeight,
+                                13);  // x, y, w, h, triangle size
+    display_climbRate(20, climbBoxY + 24, leaf_21h, climbRate);
+    u8g2.setDrawColor(0);
+    u8g2.setFont(leaf_5h);
+    u8g2.print(" ");  // put a space, but using a small font so the space isn't too wide
+    u8g2.setFont(leaf_21h);
+    if (settings.units_climb)
+      u8g2.print('f');
+    else
+      u8g2.print('m');
+    u8g2.setDrawColor(1);
+  }
+}  // namespace
+
 void thermalPage_draw() {
   // if cursor is selecting something, count toward the timeOut value before we reset cursor
   if (thermal_page_cursor_position != cursor_thermalPage_none &&
@@ -62,15 +95,8 @@ void thermalPage_draw() {
 
     // Main Info ****************************************************
 
-    // Vario Bar
-    uint8_t topOfFrame = 21;
-    uint8_t varioBarWidth = 25;
-    uint8_t varioBarClimbHeight = 75;
-    uint8_t varioBarSinkHeight = varioBarClimbHeight;
-
-    // TODO: display lack of climb rate differently than 0
-    int32_t climbRate = baro.climbRateFilteredValid() ? baro.climbRateFiltered() : 0;
-    display_varioBar(topOfFrame, varioBarClimbHeight, varioBarSinkHeight, varioBarWidth, climbRate);
+    // Vario Bar and Climb
+    drawVarioLayer();
 
     // Altitude
     uint8_t alt_y = 58;
@@ -92,22 +118,6 @@ void thermalPage_draw() {
       display_selectionBox(varioBarWidth + 1, alt_y - 2, 96 - (varioBarWidth + 1), 25, 7);
     }
 
-    // Climb
-    uint8_t climbBoxHeight = 27;
-    uint8_t climbBoxY = topOfFrame + varioBarClimbHeight - climbBoxHeight / 2;
-    display_climbRatePointerBox(varioBarWidth, climbBoxY, 76, climbBoxHeight,
-                                13);  // x, y, w, h, triangle size
-    display_climbRate(20, climbBoxY + 24, leaf_21h, climbRate);
-    u8g2.setDrawColor(0);
-    u8g2.setFont(leaf_5h);
-    u8g2.print(" ");  // put a space, but using a small font so the space isn't too wide
-    u8g2.setFont(leaf_21h);
-    if (settings.units_climb)
-      u8g2.print('f');
-    else
-      u8g2.print('m');
-    u8g2.setDrawColor(1);
-
     // User Fields
     uint8_t userfield_y = climbBoxY + 53;
     uint8_t userfield_x = varioBarWidth + 4;
@@ -126,6 +136,17 @@ void thermalPage_draw() {
   } while (u8g2.nextPage());
 }
 
+void thermalPage_drawVarioLayer() {
+  // Erase the vario bar, and the full width of the rows the climb box covers
+  u8g2.setDrawColor(0);
+  u8g2.drawBox(0, topOfFrame, varioBarWidth, varioBarClimbHeight + varioBarSinkHeight + 1);
+  u8g2.drawBox(0, climbBoxY, u8g2.getDisplayWidth(), climbBoxHeight);
+  u8g2.setDrawColor(1);
+
+  drawVarioLayer();
+  u8g2.sendBuffer();
+}
+
 void drawUserField(uint8_t x, uint8_t y, uint8_t field, bool selected) {
   switch (field) {
     case static_cast<int>(ThermalPageUserFields::ABOVE_LAUNCH):
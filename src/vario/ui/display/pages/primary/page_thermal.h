@@ -8,6 +8,10 @@
 // draw the pixels to the display
 void thermalPage_draw(void);
 
+// redraw just the vario bar and climb rate over the last frame drawn by thermalPage_draw, and send
+// it to the display
+void thermalPage_drawVarioLayer(void);
+
 // handle button presses relative to what's shown on the display
 void thermalPage_button(Button button, ButtonEvent state, uint8_t count);
 
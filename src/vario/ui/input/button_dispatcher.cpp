@@ -24,6 +24,26 @@
 ButtonDispatcher buttonDispatcher;
 
 void ButtonDispatcher::on_receive(const ButtonEventMessage& msg) {
+  if (!events_.push({msg.button, msg.event, msg.holdCount})) {
+    Serial.printf("Button event %u dropped; dispatch queue full\n", (uint8_t)msg.event);
+  }
+}
+
+void ButtonDispatcher::dispatchPending() {
+  Event event;
+  while (events_.pop(event)) {
+    if (event.event == ButtonEvent::PRESSED || event.event == ButtonEvent::RELEASED) {
+      skipUntilRelease_ = false;
+    } else if (skipUntilRelease_) {
+      continue;
+    }
+    const uint32_t consumed = buttons.consumeCount();
+    dispatch(event);
+    if (buttons.consumeCount() != consumed) skipUntilRelease_ = true;
+  }
+}
+
+void ButtonDispatcher::dispatch(const Event& msg) {
   power.resetAutoOffCounter();  // pressing any button should reset the auto-off counter
                                 // TODO: we should probably have a counter for Auto-Timer-Off as
                                 // well, and button presses should reset that.
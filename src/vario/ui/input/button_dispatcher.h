@@ -5,14 +5,34 @@
 #include "dispatch/message_sink.h"
 #include "dispatch/message_types.h"
 #include "hardware/configuration.h"
+#include "utils/spsc_queue.h"
 
 /// @brief Listens for button events on the message bus and then dispatches them to the appropriate
 /// UI element.
+/// @details Buttons are read by the realtime loop, but the UI belongs to the service task, so
+/// events are queued as they arrive and dispatched when the UI's owner calls dispatchPending().
 class ButtonDispatcher : public MessageSink<ButtonDispatcher, ButtonEventMessage> {
  public:
   // MessageSink<ButtonDispatcher, ButtonEventMessage>
   void on_receive(const ButtonEventMessage& msg);
   void on_receive_unknown(const etl::imessage& msg) {}
+
+  // Hand the queued events to the UI, in order.  Call with MainLoopLockGuard held.
+  void dispatchPending();
+
+ private:
+  struct Event {
+    Button button;
+    ButtonEvent event;
+    uint16_t holdCount;
+  };
+
+  void dispatch(const Event& event);
+
+  SpscQueue<Event, 16> events_;
+
+  // A handler consumed the press (Buttons::consumeButton) after later events for it were queued
+  bool skipUntilRelease_ = false;
 };
 
 extern ButtonDispatcher buttonDispatcher;
@@ -125,8 +125,9 @@ class CharSetting : public NumericSetting<int8_t, MinValue, DefaultValue, MaxVal
   using Base::Base;       // inherit constructor(s)
   using Base::operator=;  // make Base::operator=(int8_t) visible
 
+  // Keeps the current value if the key is absent
   void readFrom(Preferences& prefs) override {
-    auto v = prefs.getChar(this->key(), Base::defaultValue());
+    auto v = prefs.getChar(this->key(), this->value_);
     Base::operator=(v);  // clamps/validates
   }
 
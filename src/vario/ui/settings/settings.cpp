@@ -3,8 +3,12 @@
 #include "esp_mac.h"
 
 #include <Preferences.h>
+#include <esp_rom_crc.h>
 #include <esp_wifi.h>
 #include <nvs_flash.h>
+#include <stddef.h>
+
+#include <algorithm>
 
 #include "comms/leaf_log_credentials.h"
 #include "comms/wifi_coordinator.h"
@@ -22,8 +26,175 @@ namespace {
       {0, -1.2, -1.4, -1.6, -1.8, -2.0, -2.5, -3.0, -4.0, -5.0, -6.0},   // m/s
       {0, -240, -280, -320, -360, -400, -500, -600, -800, -1000, -1200}  // fpm
   };
+
+  // Steps `value` to the next of `rates` in the direction of `dir` and plays the matching sound.
+  // A value between two rates steps as if it were the higher one.
+  int8_t stepRate(int8_t value, Button dir, const int8_t* rates, uint8_t count) {
+    uint8_t index = 0;
+    while (index < count - 1 && rates[index] < value) index++;
+
+    sound_t sound = fx::neutral;
+    if (dir == Button::RIGHT && index < count - 1) {
+      sound = fx::increase;
+      value = rates[index + 1];
+    } else if (dir == Button::LEFT && index > 0) {
+      sound = fx::decrease;
+      value = rates[index - 1];
+    } else {
+      sound = fx::doubleClick;
+    }
+    speaker.playSound(sound);
+    return value;
+  }
+
+  // The rates Bluetooth output is offered at: divisors of the 10 Hz BLE timer
+  constexpr int8_t BLE_RATES[] = {1, 2, 5, 10};
+  constexpr uint8_t BLE_RATE_COUNT = sizeof(BLE_RATES) / sizeof(BLE_RATES[0]);
 }
 
+// Settings as stored in NVS: one record under SETTINGS_KEY instead of a key per setting, so boot
+// reads one value and a save writes one, and only when something in it changed.
+//
+// Fields are only ever appended.  A record from older firmware is shorter and the fields it lacks
+// keep their defaults; one from newer firmware is longer and the fields this one does not know
+// are ignored.  Bump VERSION, and give retrieve() a conversion, if an existing field has to
+// change instead.
+struct __attribute__((packed)) StoredSettings {
+  static constexpr uint16_t VERSION = 1;
+
+  uint16_t version;
+  uint16_t size;  // Of the record as written, header included
+  uint32_t crc;   // Of everything after it
+
+  // Vario Settings
+  float vario_sinkAlarm;
+  uint8_t vario_sinkAlarm_units;
+  int8_t vario_sensitivity;
+  int8_t vario_climbAvg;
+  int8_t vario_climbStart;
+  int8_t vario_volume;
+  uint8_t volumeShortcut;
+  uint8_t vario_quietMode;
+  uint8_t vario_tones;
+  int8_t vario_liftyAir;
+  float vario_altSetting;
+  uint8_t vario_altSyncToGPS;
+
+  // GPS & Track Log Settings
+  uint8_t distanceFlownType;
+  int8_t gpsMode;
+  uint8_t log_saveTrack;
+  uint8_t log_autoStart;
+  uint8_t log_autoStop;
+
+  // System Settings
+  int16_t system_timeZone;
+  int8_t system_volume;
+  uint8_t system_ecoMode;
+  uint8_t system_autoOff;
+  uint8_t system_wifiOn;
+  uint8_t system_bluetoothOn;
+  uint8_t system_showWarning;
+  uint8_t productionTest;
+  uint8_t commissioningPending;
+  uint8_t commissioningComplete;
+  char macAddress[18];
+
+  // Developer Options
+  uint8_t dev_mode;
+  uint8_t dev_startLogAtBoot;
+  uint8_t dev_startDisconnected;
+  uint8_t dev_fanetFwd;
+  uint8_t diag_systemEvents;
+  uint8_t diag_networkEvents;
+  uint8_t diag_webRequests;
+  uint8_t diag_vario;
+  uint8_t diag_cpuUtilization;
+
+  // Leaf Labs
+  uint8_t labs_thermalCore;
+  uint8_t labs_thermalTrack;
+  uint8_t labs_leafLog;
+  int8_t labs_gpsRateHz;
+  int8_t labs_bleVarioHz;
+  int8_t labs_bleGpsHz;
+
+  // Boot Flags
+  uint8_t boot_enterBootloader;
+  uint8_t boot_toOnState;
+  uint8_t boot_firstTime;
+
+  // Display Settings
+  uint8_t disp_contrast;
+  int8_t disp_varioBarHz;
+  uint8_t disp_navPageAltType;
+  uint8_t disp_thmPageAltType;
+  uint8_t disp_thmPageAlt2Type;
+  uint8_t disp_thmPageUser1;
+  uint8_t disp_thmPageUser2;
+  uint8_t disp_showDebugPage;
+  uint8_t disp_showBasicPage;
+  uint8_t disp_showUserPage;
+  uint8_t disp_showThermalCorePage;
+  uint8_t disp_showThermalTrackPage;
+  uint8_t disp_showNavPage;
+  uint8_t startPage;
+
+  // Fanet settings
+  uint8_t fanet_region;
+  char fanet_address[8];
+
+  // Unit Values
+  uint8_t units_climb;
+  uint8_t units_alt;
+  uint8_t units_temp;
+  uint8_t units_speed;
+  uint8_t units_heading;
+  uint8_t units_distance;
+  uint8_t units_hours;
+};
+
+namespace {
+  constexpr auto SETTINGS_KEY = "settings";
+
+  // The CRC covers the record from the first setting on
+  constexpr size_t CRC_START = offsetof(StoredSettings, crc) + sizeof(uint32_t);
+  // Longest record retrieve() accepts, from firmware newer than this
+  constexpr size_t MAX_STORED_SIZE = 512;
+
+  // The keys settings were stored under before StoredSettings, read once to migrate them.  Never
+  // add to this: new settings only go in the record.
+  constexpr const char* LEGACY_KEYS[] = {
+      "SINK_ALARM_VAL",  "SINK_ALARM_UNIT", "vSensitivity",    "CLIMB_AVERAGE",   "CLIMB_START",
+      "VOLUME_VARIO",    "VOL_SHORTCUT",    "QUIET_MODE",      "VARIO_TONES",     "LIFTY_AIR",
+      "ALT_SETTING",     "ALT_SYNC_GPS",    "DISTANCE_FLOWN",  "GPS_SETTING",     "TRACK_SAVE",
+      "AUTO_START",      "AUTO_STOP",       "TIME_ZONE",       "VOLUME_SYSTEM",   "ECO_MODE",
+      "AUTO_OFF",        "WIFI_ON",         "BLUETOOTH_ON",    "SHOW_WARNING",    "MAC_ADDRESS",
+      "PRODUCTION_TEST", "COMM_COMPLETE",   "COMM_PENDING",    "DEV_MODE",        "DEVELOPER_MENU",
+      "DEV_STARTLOG",    "DEV_STARTDISCON", "DEV_FANET_FWD",   "DIAG_SYSTEM",     "DIAG_NETWORK",
+      "DIAG_WEB_REQ",    "DIAG_VARIO",      "DIAG_CPU_UTIL",   "LAB_THERM_CORE",  "LAB_THERM_TRACK",
+      "LAB_LEAF_LOG",    "lGpsRateHz",      "lBleVarioHz",     "lBleGpsHz",       "ENTER_BOOTLOAD",
+      "BOOT_TO_ON",      "FIRST_BOOT",      "CONTRAST",        "dVarioBarHz",     "NAVPG_ALT_TYP",
+      "THMPG_ALT_TYP",   "THMPG_ALT2_TYP",  "THMPG_USR1",      "THMPG_USR2",      "SHOW_DEBUG",
+      "SHOW_BASIC",      "SHOW_SIMPLE",     "SHOW_USER",       "SHOW_THRM",       "SHOW_THERM_CORE",
+      "SHOW_THERM_TRK",  "SHOW_THERM_NAV",  "SHOW_NAV",        "START_PAGE",      "FANET_REGION",
+      "FANET_ADDRESS",   "UNITS_climb",     "UNITS_alt",       "UNITS_temp",      "UNITS_speed",
+      "UNITS_heading",   "UNITS_distance",  "UNITS_hours"};
+
+  // What was last written to (or read from) NVS, so save() can tell whether anything changed
+  StoredSettings lastStored;
+  bool lastStoredValid = false;
+
+  uint32_t storedCrc(const uint8_t* record, size_t size) {
+    return esp_rom_crc32_le(0, record + CRC_START, size - CRC_START);
+  }
+
+  void copyString(char* field, size_t capacity, const String& value) {
+    strncpy(field, value.c_str(), capacity - 1);
+    field[capacity - 1] = '\0';
+  }
+}  // namespace
+
 Settings settings;
 
 Preferences leafPrefs;
@@ -49,6 +220,7 @@ bool Settings::init() {
     }
     baro.setFilterSamples(nSamples);
   });
+  labs_gpsRateHz.onChange([](const int8_t& newValue) { gps.setFixRate(newValue); });
 
   loadDefaults();  // load defaults regardless, but we'll overwrite
                    // these with saved user settings (if available)
@@ -207,6 +379,9 @@ void Settings::loadDefaults() {
   labs_thermalCore = DEF_LABS_THERMAL_CORE;
   labs_thermalTrack = DEF_LABS_THERMAL_TRACK;
   labs_leafLog = DEF_LABS_LEAF_LOG;
+  labs_gpsRateHz.loadDefault();
+  labs_bleVarioHz.loadDefault();
+  labs_bleGpsHz.loadDefault();
 
   // Boot Flags
   boot_enterBootloader = DEF_ENTER_BOOTLOAD;
@@ -214,6 +389,7 @@ void Settings::loadDefaults() {
 
   // Display Settings
   disp_contrast = DEF_CONTRAST;
+  disp_varioBarHz.loadDefault();
   disp_navPageAltType = DEF_NAVPG_ALT_TYP;
   disp_thmPageAltType = DEF_THMPG_ALT_TYP;
   disp_thmPageAlt2Type = DEF_THMPG_ALT2_TYP;
@@ -239,185 +415,341 @@ void Settings::loadDefaults() {
 
 void Settings::retrieve() {
   leafPrefs.begin("varioPrefs", RO_MODE);
+  const size_t size = leafPrefs.isKey(SETTINGS_KEY) ? leafPrefs.getBytesLength(SETTINGS_KEY) : 0;
+  uint8_t record[MAX_STORED_SIZE];
+  const bool read = size >= CRC_START && size <= sizeof(record) &&
+                    leafPrefs.getBytes(SETTINGS_KEY, record, sizeof(record)) == size;
+  leafPrefs.end();
+
+  // Fields a shorter record lacks keep their current values, which at boot are the defaults
+  StoredSettings stored;
+  pack(stored);
+  if (read) memcpy(&stored, record, std::min(size, sizeof(stored)));
+  if (!read || stored.version != StoredSettings::VERSION || stored.size != size ||
+      stored.crc != storedCrc(record, size)) {
+    // Nothing stored yet, or not readable: take whatever is under the old per-setting keys
+    importKeys();
+    return;
+  }
+
+  unpack(stored);
+  constrain();
+  pack(lastStored);
+  lastStoredValid = true;
+}
+
+void Settings::save() {
+  // Save settings before shutdown (or other times as needed).  Menus call this on every change,
+  // so it writes only when the record differs from what is already stored.
+  StoredSettings stored;
+  pack(stored);
+  if (lastStoredValid && memcmp(&stored, &lastStored, sizeof(stored)) == 0) return;
+
+  leafPrefs.begin("varioPrefs", RW_MODE);
+  const bool written = leafPrefs.putBytes(SETTINGS_KEY, &stored, sizeof(stored)) == sizeof(stored);
+  leafPrefs.end();
+  lastStored = stored;
+  lastStoredValid = written;
+}
+
+void Settings::pack(StoredSettings& stored) const {
+  memset(&stored, 0, sizeof(stored));
+  stored.version = StoredSettings::VERSION;
+  stored.size = sizeof(stored);
+
+  // Vario Settings
+  stored.vario_sinkAlarm = vario_sinkAlarm;
+  stored.vario_sinkAlarm_units = vario_sinkAlarm_units;
+  stored.vario_sensitivity = vario_sensitivity;
+  stored.vario_climbAvg = vario_climbAvg;
+  stored.vario_climbStart = vario_climbStart;
+  stored.vario_volume = vario_volume;
+  stored.volumeShortcut = volumeShortcut;
+  stored.vario_quietMode = vario_quietMode;
+  stored.vario_tones = vario_tones;
+  stored.vario_liftyAir = vario_liftyAir;
+  stored.vario_altSetting = vario_altSetting;
+  stored.vario_altSyncToGPS = vario_altSyncToGPS;
+  // GPS & Track Log Settings
+  stored.distanceFlownType = distanceFlownType;
+  stored.gpsMode = gpsMode;
+  stored.log_saveTrack = log_saveTrack;
+  stored.log_autoStart = log_autoStart;
+  stored.log_autoStop = log_autoStop;
+  // System Settings
+  stored.system_timeZone = system_timeZone;
+  stored.system_volume = system_volume;
+  stored.system_ecoMode = system_ecoMode;
+  stored.system_autoOff = system_autoOff;
+  stored.system_wifiOn = system_wifiOn;
+  stored.system_bluetoothOn = system_bluetoothOn;
+  stored.system_showWarning = system_showWarning;
+  stored.productionTest = productionTest;
+  stored.commissioningPending = commissioningPending;
+  stored.commissioningComplete = commissioningComplete;
+  copyString(stored.macAddress, sizeof(stored.macAddress), macAddress);
+  // Developer Options
+  stored.dev_mode = dev_mode;
+  stored.dev_startLogAtBoot = dev_startLogAtBoot;
+  stored.dev_startDisconnected = dev_startDisconnected;
+  stored.dev_fanetFwd = dev_fanetFwd;
+  stored.diag_systemEvents = diag_systemEvents;
+  stored.diag_networkEvents = diag_networkEvents;
+  stored.diag_webRequests = diag_webRequests;
+  stored.diag_vario = diag_vario;
+  stored.diag_cpuUtilization = diag_cpuUtilization;
+  // Leaf Labs
+  stored.labs_thermalCore = labs_thermalCore;
+  stored.labs_thermalTrack = labs_thermalTrack;
+  stored.labs_leafLog = labs_leafLog;
+  stored.labs_gpsRateHz = labs_gpsRateHz;
+  stored.labs_bleVarioHz = labs_bleVarioHz;
+  stored.labs_bleGpsHz = labs_bleGpsHz;
+  // Boot Flags
+  stored.boot_enterBootloader = boot_enterBootloader;
+  stored.boot_toOnState = boot_toOnState;
+  stored.boot_firstTime = boot_firstTime;
+  // Display Settings
+  stored.disp_contrast = disp_contrast;
+  stored.disp_varioBarHz = disp_varioBarHz;
+  stored.disp_navPageAltType = disp_navPageAltType;
+  stored.disp_thmPageAltType = disp_thmPageAltType;
+  stored.disp_thmPageAlt2Type = disp_thmPageAlt2Type;
+  stored.disp_thmPageUser1 = disp_thmPageUser1;
+  stored.disp_thmPageUser2 = disp_thmPageUser2;
+  stored.disp_showDebugPage = disp_showDebugPage;
+  stored.disp_showBasicPage = disp_showBasicPage;
+  stored.disp_showUserPage = disp_showUserPage;
+  stored.disp_showThermalCorePage = disp_showThermalCorePage;
+  stored.disp_showThermalTrackPage = disp_showThermalTrackPage;
+  stored.disp_showNavPage = disp_showNavPage;
+  stored.startPage = startPage;
+  // Fanet Settings
+  stored.fanet_region = (uint8_t)fanet_region;
+  copyString(stored.fanet_address, sizeof(stored.fanet_address), fanet_address);
+  // Unit Values
+  stored.units_climb = units_climb;
+  stored.units_alt = units_alt;
+  stored.units_temp = units_temp;
+  stored.units_speed = units_speed;
+  stored.units_heading = units_heading;
+  stored.units_distance = units_distance;
+  stored.units_hours = units_hours;
+
+  stored.crc = storedCrc((const uint8_t*)&stored, sizeof(stored));
+}
+
+void Settings::unpack(const StoredSettings& stored) {
+  // Vario Settings
+  vario_sinkAlarm = stored.vario_sinkAlarm;
+  vario_sinkAlarm_units = stored.vario_sinkAlarm_units;
+  vario_sensitivity = stored.vario_sensitivity;
+  vario_climbAvg = stored.vario_climbAvg;
+  vario_climbStart = stored.vario_climbStart;
+  vario_volume = stored.vario_volume;
+  volumeShortcut = stored.volumeShortcut;
+  resetShortcutVolume();
+  vario_quietMode = stored.vario_quietMode;
+  vario_tones = stored.vario_tones;
+  vario_liftyAir = stored.vario_liftyAir;
+  vario_altSetting = stored.vario_altSetting;
+  vario_altSyncToGPS = stored.vario_altSyncToGPS;
+  // GPS & Track Log Settings
+  distanceFlownType = stored.distanceFlownType;
+  gpsMode = stored.gpsMode;
+  log_saveTrack = stored.log_saveTrack;
+  log_autoStart = stored.log_autoStart;
+  log_autoStop = stored.log_autoStop;
+  // System Settings
+  system_timeZone = stored.system_timeZone;
+  system_volume = stored.system_volume;
+  speaker.setVolume(Speaker::SoundChannel::FX, (SpeakerVolume)system_volume);
+  system_ecoMode = stored.system_ecoMode;
+  system_autoOff = stored.system_autoOff;
+  system_wifiOn = stored.system_wifiOn;
+  system_bluetoothOn = stored.system_bluetoothOn;
+  system_showWarning = stored.system_showWarning;
+  productionTest = stored.productionTest;
+  commissioningPending = stored.commissioningPending;
+  commissioningComplete = stored.commissioningComplete;
+  macAddress = stored.macAddress;
+  // Developer Options
+  dev_mode = stored.dev_mode;
+  dev_startLogAtBoot = stored.dev_startLogAtBoot;
+  dev_startDisconnected = stored.dev_startDisconnected;
+  dev_fanetFwd = stored.dev_fanetFwd;
+  diag_systemEvents = stored.diag_systemEvents;
+  diag_networkEvents = stored.diag_networkEvents;
+  diag_webRequests = stored.diag_webRequests;
+  diag_vario = stored.diag_vario;
+  diag_cpuUtilization = stored.diag_cpuUtilization;
+  // Leaf Labs
+  labs_thermalCore = stored.labs_thermalCore;
+  labs_thermalTrack = stored.labs_thermalTrack;
+  labs_leafLog = stored.labs_leafLog;
+  labs_gpsRateHz = stored.labs_gpsRateHz;
+  labs_bleVarioHz = stored.labs_bleVarioHz;
+  labs_bleGpsHz = stored.labs_bleGpsHz;
+  // Boot Flags
+  boot_enterBootloader = stored.boot_enterBootloader;
+  boot_toOnState = stored.boot_toOnState;
+  boot_firstTime = stored.boot_firstTime;
+  // Display Settings
+  disp_contrast = stored.disp_contrast;
+  disp_varioBarHz = stored.disp_varioBarHz;
+  disp_navPageAltType = stored.disp_navPageAltType;
+  disp_thmPageAltType = stored.disp_thmPageAltType;
+  disp_thmPageAlt2Type = stored.disp_thmPageAlt2Type;
+  disp_thmPageUser1 = stored.disp_thmPageUser1;
+  disp_thmPageUser2 = stored.disp_thmPageUser2;
+  disp_showDebugPage = stored.disp_showDebugPage;
+  disp_showBasicPage = stored.disp_showBasicPage;
+  disp_showUserPage = stored.disp_showUserPage;
+  disp_showThermalCorePage = stored.disp_showThermalCorePage;
+  disp_showThermalTrackPage = stored.disp_showThermalTrackPage;
+  disp_showNavPage = stored.disp_showNavPage;
+  startPage = stored.startPage;
+  // Fanet Settings
+  fanet_region = (FanetRadioRegion)stored.fanet_region;
+  fanet_address = stored.fanet_address;
+  // Unit Values
+  units_climb = stored.units_climb;
+  units_alt = stored.units_alt;
+  units_temp = stored.units_temp;
+  units_speed = stored.units_speed;
+  units_heading = stored.units_heading;
+  units_distance = stored.units_distance;
+  units_hours = stored.units_hours;
+}
+
+// Values that are out of range, or depend on a lab that is off, whichever way they were stored
+void Settings::constrain() {
+  if (disp_contrast < CONTRAST_MIN || disp_contrast > CONTRAST_MAX) disp_contrast = DEF_CONTRAST;
+  if (!labs_thermalCore) disp_showThermalCorePage = false;
+  if (!labs_thermalTrack) disp_showThermalTrackPage = false;
+  if (startPage > (uint8_t)MainPage::Navigate) startPage = DEF_STARTPAGE;
+}
+
+// The layout before StoredSettings: one NVS key per setting.  Keys that are present override the
+// current values; absent ones leave them be.
+void Settings::importKeys() {
+  leafPrefs.begin("varioPrefs", RO_MODE);
 
   // Vario Settings
-  vario_sinkAlarm = leafPrefs.getFloat("SINK_ALARM_VAL", DEF_SINK_ALARM);
-  vario_sinkAlarm_units = leafPrefs.getBool("SINK_ALARM_UNIT", DEF_SINK_ALARM_UNITS);
+  vario_sinkAlarm = leafPrefs.getFloat("SINK_ALARM_VAL", vario_sinkAlarm);
+  vario_sinkAlarm_units = leafPrefs.getBool("SINK_ALARM_UNIT", vario_sinkAlarm_units);
   vario_sensitivity.readFrom(leafPrefs);
-  vario_climbAvg = leafPrefs.getChar("CLIMB_AVERAGE");
-  vario_climbStart = leafPrefs.getChar("CLIMB_START");
-  vario_volume = leafPrefs.getChar("VOLUME_VARIO");
-  volumeShortcut = leafPrefs.getBool("VOL_SHORTCUT", DEF_VOLUME_SHORTCUT);
+  vario_climbAvg = leafPrefs.getChar("CLIMB_AVERAGE", vario_climbAvg);
+  vario_climbStart = leafPrefs.getChar("CLIMB_START", vario_climbStart);
+  vario_volume = leafPrefs.getChar("VOLUME_VARIO", vario_volume);
+  volumeShortcut = leafPrefs.getBool("VOL_SHORTCUT", volumeShortcut);
   resetShortcutVolume();
-  vario_quietMode = leafPrefs.getBool("QUIET_MODE");
-  vario_tones = leafPrefs.getBool("VARIO_TONES");
-  vario_liftyAir = leafPrefs.getChar("LIFTY_AIR");
-  vario_altSetting = leafPrefs.getFloat("ALT_SETTING");
-  vario_altSyncToGPS = leafPrefs.getBool("ALT_SYNC_GPS");
+  vario_quietMode = leafPrefs.getBool("QUIET_MODE", vario_quietMode);
+  vario_tones = leafPrefs.getBool("VARIO_TONES", vario_tones);
+  vario_liftyAir = leafPrefs.getChar("LIFTY_AIR", vario_liftyAir);
+  vario_altSetting = leafPrefs.getFloat("ALT_SETTING", vario_altSetting);
+  vario_altSyncToGPS = leafPrefs.getBool("ALT_SYNC_GPS", vario_altSyncToGPS);
 
   // GPS & Track Log Settings
-  distanceFlownType = leafPrefs.getBool("DISTANCE_FLOWN");
-  gpsMode = leafPrefs.getChar("GPS_SETTING");
-  log_saveTrack = leafPrefs.getBool("TRACK_SAVE");
-  log_autoStart = leafPrefs.getBool("AUTO_START");
-  log_autoStop = leafPrefs.getBool("AUTO_STOP");
+  distanceFlownType = leafPrefs.getBool("DISTANCE_FLOWN", distanceFlownType);
+  gpsMode = leafPrefs.getChar("GPS_SETTING", gpsMode);
+  log_saveTrack = leafPrefs.getBool("TRACK_SAVE", log_saveTrack);
+  log_autoStart = leafPrefs.getBool("AUTO_START", log_autoStart);
+  log_autoStop = leafPrefs.getBool("AUTO_STOP", log_autoStop);
 
   // System Settings
-  system_timeZone = leafPrefs.getShort("TIME_ZONE");
-  system_volume = leafPrefs.getChar("VOLUME_SYSTEM");
+  system_timeZone = leafPrefs.getShort("TIME_ZONE", system_timeZone);
+  system_volume = leafPrefs.getChar("VOLUME_SYSTEM", system_volume);
   speaker.setVolume(Speaker::SoundChannel::FX, (SpeakerVolume)system_volume);
-  system_ecoMode = leafPrefs.getBool("ECO_MODE");
-  system_autoOff = leafPrefs.getChar("AUTO_OFF");
-  system_wifiOn = leafPrefs.getBool("WIFI_ON");
-  system_bluetoothOn = leafPrefs.getBool("BLUETOOTH_ON");
-  system_showWarning = leafPrefs.getBool("SHOW_WARNING");
-  macAddress = leafPrefs.getString("MAC_ADDRESS", getMacAddress());
-  productionTest = leafPrefs.getBool("PRODUCTION_TEST", DEF_PRODUCTIONTEST);
-  commissioningComplete = leafPrefs.getBool("COMM_COMPLETE", productionTest);
-  commissioningPending =
-      leafPrefs.getBool("COMM_PENDING", !commissioningComplete && !productionTest);
+  system_ecoMode = leafPrefs.getBool("ECO_MODE", system_ecoMode);
+  system_autoOff = leafPrefs.getChar("AUTO_OFF", system_autoOff);
+  system_wifiOn = leafPrefs.getBool("WIFI_ON", system_wifiOn);
+  system_bluetoothOn = leafPrefs.getBool("BLUETOOTH_ON", system_bluetoothOn);
+  system_showWarning = leafPrefs.getBool("SHOW_WARNING", system_showWarning);
+  macAddress =
+      leafPrefs.getString("MAC_ADDRESS", macAddress.isEmpty() ? getMacAddress() : macAddress);
+  productionTest = leafPrefs.getBool("PRODUCTION_TEST", productionTest);
+  if (leafPrefs.isKey("PRODUCTION_TEST") && !leafPrefs.isKey("COMM_COMPLETE")) {
+    // Saved before commissioning existed: a unit that passed its production test is commissioned
+    commissioningComplete = productionTest;
+    commissioningPending = !productionTest;
+  }
+  commissioningComplete = leafPrefs.getBool("COMM_COMPLETE", commissioningComplete);
+  commissioningPending = leafPrefs.getBool("COMM_PENDING", commissioningPending);
 
   // Developer Options
-  dev_mode = leafPrefs.getBool("DEV_MODE", leafPrefs.getBool("DEVELOPER_MENU", DEF_DEV_MODE));
-  dev_startLogAtBoot = leafPrefs.getBool("DEV_STARTLOG");
-  dev_startDisconnected = leafPrefs.getBool("DEV_STARTDISCON");
-  dev_fanetFwd = leafPrefs.getBool("DEV_FANET_FWD", DEF_DEV_FANET_FWD);
-  diag_systemEvents = leafPrefs.getBool("DIAG_SYSTEM", DEF_DIAG_SYSTEM_EVENTS);
-  diag_networkEvents = leafPrefs.getBool("DIAG_NETWORK", DEF_DIAG_NETWORK_EVENTS);
-  diag_webRequests = leafPrefs.getBool("DIAG_WEB_REQ", DEF_DIAG_WEB_REQUESTS);
-  diag_vario = leafPrefs.getBool("DIAG_VARIO", DEF_DIAG_VARIO);
-  diag_cpuUtilization = leafPrefs.getBool("DIAG_CPU_UTIL", DEF_DIAG_CPU_UTILIZATION);
+  dev_mode = leafPrefs.getBool("DEV_MODE", leafPrefs.getBool("DEVELOPER_MENU", dev_mode));
+  dev_startLogAtBoot = leafPrefs.getBool("DEV_STARTLOG", dev_startLogAtBoot);
+  dev_startDisconnected = leafPrefs.getBool("DEV_STARTDISCON", dev_startDisconnected);
+  dev_fanetFwd = leafPrefs.getBool("DEV_FANET_FWD", dev_fanetFwd);
+  diag_systemEvents = leafPrefs.getBool("DIAG_SYSTEM", diag_systemEvents);
+  diag_networkEvents = leafPrefs.getBool("DIAG_NETWORK", diag_networkEvents);
+  diag_webRequests = leafPrefs.getBool("DIAG_WEB_REQ", diag_webRequests);
+  diag_vario = leafPrefs.getBool("DIAG_VARIO", diag_vario);
+  diag_cpuUtilization = leafPrefs.getBool("DIAG_CPU_UTIL", diag_cpuUtilization);
 
   // Leaf Labs
-  labs_thermalCore = leafPrefs.getBool("LAB_THERM_CORE", DEF_LABS_THERMAL_CORE);
-  labs_thermalTrack = leafPrefs.getBool("LAB_THERM_TRACK", DEF_LABS_THERMAL_TRACK);
-  labs_leafLog = leafPrefs.getBool("LAB_LEAF_LOG", DEF_LABS_LEAF_LOG);
+  labs_thermalCore = leafPrefs.getBool("LAB_THERM_CORE", labs_thermalCore);
+  labs_thermalTrack = leafPrefs.getBool("LAB_THERM_TRACK", labs_thermalTrack);
+  labs_leafLog = leafPrefs.getBool("LAB_LEAF_LOG", labs_leafLog);
+  labs_gpsRateHz.readFrom(leafPrefs);
+  labs_bleVarioHz.readFrom(leafPrefs);
+  labs_bleGpsHz.readFrom(leafPrefs);
 
   // Boot Flags
-  boot_enterBootloader = leafPrefs.getBool("ENTER_BOOTLOAD");
-  boot_toOnState = leafPrefs.getBool("BOOT_TO_ON");
-  boot_firstTime = leafPrefs.getBool("FIRST_BOOT", false);
+  boot_enterBootloader = leafPrefs.getBool("ENTER_BOOTLOAD", boot_enterBootloader);
+  boot_toOnState = leafPrefs.getBool("BOOT_TO_ON", boot_toOnState);
+  boot_firstTime = leafPrefs.getBool("FIRST_BOOT", boot_firstTime);
 
   // Display Settings
-  disp_contrast = leafPrefs.getUChar("CONTRAST");
-  if (disp_contrast < CONTRAST_MIN || disp_contrast > CONTRAST_MAX) disp_contrast = DEF_CONTRAST;
-  disp_navPageAltType = leafPrefs.getUChar("NAVPG_ALT_TYP");
-  disp_thmPageAltType = leafPrefs.getUChar("THMPG_ALT_TYP");
-  disp_thmPageAlt2Type = leafPrefs.getUChar("THMPG_ALT2_TYP");
-  disp_thmPageUser1 = leafPrefs.getUChar("THMPG_USR1");
-  disp_thmPageUser2 = leafPrefs.getUChar("THMPG_USR2");
-  disp_showDebugPage = leafPrefs.getBool("SHOW_DEBUG");
+  disp_contrast = leafPrefs.getUChar("CONTRAST", disp_contrast);
+  disp_varioBarHz.readFrom(leafPrefs);
+  disp_navPageAltType = leafPrefs.getUChar("NAVPG_ALT_TYP", disp_navPageAltType);
+  disp_thmPageAltType = leafPrefs.getUChar("THMPG_ALT_TYP", disp_thmPageAltType);
+  disp_thmPageAlt2Type = leafPrefs.getUChar("THMPG_ALT2_TYP", disp_thmPageAlt2Type);
+  disp_thmPageUser1 = leafPrefs.getUChar("THMPG_USR1", disp_thmPageUser1);
+  disp_thmPageUser2 = leafPrefs.getUChar("THMPG_USR2", disp_thmPageUser2);
+  disp_showDebugPage = leafPrefs.getBool("SHOW_DEBUG", disp_showDebugPage);
   disp_showBasicPage =
-      leafPrefs.getBool("SHOW_BASIC", leafPrefs.getBool("SHOW_SIMPLE", DEF_SHOW_BASIC));
-  disp_showUserPage = leafPrefs.getBool("SHOW_USER", leafPrefs.getBool("SHOW_THRM", DEF_SHOW_USER));
-  disp_showThermalCorePage = leafPrefs.getBool("SHOW_THERM_CORE", DEF_SHOW_THERMAL_CORE);
-  if (!labs_thermalCore) disp_showThermalCorePage = false;
+      leafPrefs.getBool("SHOW_BASIC", leafPrefs.getBool("SHOW_SIMPLE", disp_showBasicPage));
+  disp_showUserPage =
+      leafPrefs.getBool("SHOW_USER", leafPrefs.getBool("SHOW_THRM", disp_showUserPage));
+  disp_showThermalCorePage = leafPrefs.getBool("SHOW_THERM_CORE", disp_showThermalCorePage);
   disp_showThermalTrackPage = leafPrefs.getBool(
-      "SHOW_THERM_TRK", leafPrefs.getBool("SHOW_THERM_NAV", DEF_SHOW_THERMAL_TRACK));
-  if (!labs_thermalTrack) disp_showThermalTrackPage = false;
-  disp_showNavPage = leafPrefs.getBool("SHOW_NAV");
-  startPage = leafPrefs.getUChar("START_PAGE", DEF_STARTPAGE);
-  if (startPage > (uint8_t)MainPage::Navigate) startPage = DEF_STARTPAGE;
+      "SHOW_THERM_TRK", leafPrefs.getBool("SHOW_THERM_NAV", disp_showThermalTrackPage));
+  disp_showNavPage = leafPrefs.getBool("SHOW_NAV", disp_showNavPage);
+  startPage = leafPrefs.getUChar("START_PAGE", startPage);
 
   // Fanet settings
-  fanet_region = (FanetRadioRegion)leafPrefs.getUInt("FANET_REGION");
-  fanet_address = leafPrefs.getString("FANET_ADDRESS");
+  fanet_region = (FanetRadioRegion)leafPrefs.getUInt("FANET_REGION", (uint32_t)fanet_region);
+  fanet_address = leafPrefs.getString("FANET_ADDRESS", fanet_address);
 
   // Unit Values
-  units_climb = leafPrefs.getBool("UNITS_climb");
-  units_alt = leafPrefs.getBool("UNITS_alt");
-  units_temp = leafPrefs.getBool("UNITS_temp");
-  units_speed = leafPrefs.getBool("UNITS_speed");
-  units_heading = leafPrefs.getBool("UNITS_heading");
-  units_distance = leafPrefs.getBool("UNITS_distance");
-  units_hours = leafPrefs.getBool("UNITS_hours");
+  units_climb = leafPrefs.getBool("UNITS_climb", units_climb);
+  units_alt = leafPrefs.getBool("UNITS_alt", units_alt);
+  units_temp = leafPrefs.getBool("UNITS_temp", units_temp);
+  units_speed = leafPrefs.getBool("UNITS_speed", units_speed);
+  units_heading = leafPrefs.getBool("UNITS_heading", units_heading);
+  units_distance = leafPrefs.getBool("UNITS_distance", units_distance);
+  units_hours = leafPrefs.getBool("UNITS_hours", units_hours);
 
   leafPrefs.end();
-}
 
-void Settings::save() {
-  // Save settings before shutdown (or other times as needed)
+  constrain();
 
+  // Store them in the record, and only once that has worked drop the keys, so that losing power
+  // part way through leaves them to be read again
+  save();
+  if (!lastStoredValid) return;
   leafPrefs.begin("varioPrefs", RW_MODE);
-
-  // Vario Settings
-  leafPrefs.putFloat("SINK_ALARM_VAL", vario_sinkAlarm);
-  leafPrefs.putBool("SINK_ALARM_UNIT", vario_sinkAlarm_units);
-  vario_sensitivity.putInto(leafPrefs);
-  leafPrefs.putChar("CLIMB_AVERAGE", vario_climbAvg);
-  leafPrefs.putChar("CLIMB_START", vario_climbStart);
-  leafPrefs.putChar("VOLUME_VARIO", vario_volume);
-  leafPrefs.putBool("VOL_SHORTCUT", volumeShortcut);
-  leafPrefs.putBool("QUIET_MODE", vario_quietMode);
-  leafPrefs.putBool("VARIO_TONES", vario_tones);
-  leafPrefs.putChar("LIFTY_AIR", vario_liftyAir);
-  leafPrefs.putFloat("ALT_SETTING", vario_altSetting);
-  leafPrefs.putBool("ALT_SYNC_GPS", vario_altSyncToGPS);
-  // GPS & Track Log Settings
-  leafPrefs.putBool("DISTANCE_FLOWN", distanceFlownType);
-  leafPrefs.putChar("GPS_SETTING", gpsMode);
-  leafPrefs.putBool("TRACK_SAVE", log_saveTrack);
-  leafPrefs.putBool("AUTO_START", log_autoStart);
-  leafPrefs.putBool("AUTO_STOP", log_autoStop);
-  // System Settings
-  leafPrefs.putShort("TIME_ZONE", system_timeZone);
-  leafPrefs.putChar("VOLUME_SYSTEM", system_volume);
-  leafPrefs.putBool("ECO_MODE", system_ecoMode);
-  leafPrefs.putChar("AUTO_OFF", system_autoOff);
-  leafPrefs.putBool("WIFI_ON", system_wifiOn);
-  leafPrefs.putBool("BLUETOOTH_ON", system_bluetoothOn);
-  leafPrefs.putBool("SHOW_WARNING", system_showWarning);
-  leafPrefs.putBool("PRODUCTION_TEST", productionTest);
-  leafPrefs.putBool("COMM_PENDING", commissioningPending);
-  leafPrefs.putBool("COMM_COMPLETE", commissioningComplete);
-  leafPrefs.putString("MAC_ADDRESS", macAddress);
-  // Developer Options
-  leafPrefs.putBool("DEV_MODE", dev_mode);
-  leafPrefs.putBool("DEV_STARTLOG", dev_startLogAtBoot);
-  leafPrefs.putBool("DEV_STARTDISCON", dev_startDisconnected);
-  leafPrefs.putBool("DEV_FANET_FWD", dev_fanetFwd);
-  leafPrefs.putBool("DIAG_SYSTEM", diag_systemEvents);
-  leafPrefs.putBool("DIAG_NETWORK", diag_networkEvents);
-  leafPrefs.putBool("DIAG_WEB_REQ", diag_webRequests);
-  leafPrefs.putBool("DIAG_VARIO", diag_vario);
-  leafPrefs.putBool("DIAG_CPU_UTIL", diag_cpuUtilization);
-  // Leaf Labs
-  leafPrefs.putBool("LAB_THERM_CORE", labs_thermalCore);
-  leafPrefs.putBool("LAB_THERM_TRACK", labs_thermalTrack);
-  leafPrefs.putBool("LAB_LEAF_LOG", labs_leafLog);
-  // Boot Flags
-  leafPrefs.putBool("ENTER_BOOTLOAD", boot_enterBootloader);
-  leafPrefs.putBool("BOOT_TO_ON", boot_toOnState);
-  leafPrefs.putBool("FIRST_BOOT", boot_firstTime);
-  // Display Settings
-  leafPrefs.putUChar("CONTRAST", disp_contrast);
-  leafPrefs.putUChar("NAVPG_ALT_TYP", disp_navPageAltType);
-  leafPrefs.putUChar("THMPG_ALT_TYP", disp_thmPageAltType);
-  leafPrefs.putUChar("THMPG_ALT2_TYP", disp_thmPageAlt2Type);
-  leafPrefs.putUChar("THMPG_USR1", disp_thmPageUser1);
-  leafPrefs.putUChar("THMPG_USR2", disp_thmPageUser2);
-  leafPrefs.putBool("SHOW_DEBUG", disp_showDebugPage);
-  leafPrefs.putBool("SHOW_BASIC", disp_showBasicPage);
-  leafPrefs.putBool("SHOW_USER", disp_showUserPage);
-  leafPrefs.putBool("SHOW_THERM_CORE", disp_showThermalCorePage);
-  leafPrefs.putBool("SHOW_THERM_TRK", disp_showThermalTrackPage);
-  leafPrefs.putBool("SHOW_NAV", disp_showNavPage);
-  leafPrefs.putUChar("START_PAGE", startPage);
-  // Fanet Settings
-  leafPrefs.putUInt("FANET_REGION", (uint32_t)fanet_region);
-  leafPrefs.putString("FANET_ADDRESS", fanet_address);
-  // Unit Values
-  leafPrefs.putBool("UNITS_climb", units_climb);
-  leafPrefs.putBool("UNITS_alt", units_alt);
-  leafPrefs.putBool("UNITS_temp", units_temp);
-  leafPrefs.putBool("UNITS_speed", units_speed);
-  leafPrefs.putBool("UNITS_heading", units_heading);
-  leafPrefs.putBool("UNITS_distance", units_distance);
-  leafPrefs.putBool("UNITS_hours", units_hours);
-
+  for (const char* key : LEGACY_KEYS) {
+    if (leafPrefs.isKey(key)) leafPrefs.remove(key);
+  }
   leafPrefs.end();
 }
 
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Adjust individual settings
@@ -449,6 +781,58 @@ void Settings::adjustContrast(Button dir) {
   speaker.playSound(sound);
 }
 
+void Settings::adjustVarioBarRate(Button dir) {
+  if (dir == Button::CENTER) {  // reset to default
+    speaker.playSound(fx::confirm);
+    disp_varioBarHz.loadDefault();
+    return;
+  }
+
+  // Steps of 2 Hz: one more redraw between each of the twice-a-second page updates
+  const int8_t before = disp_varioBarHz;
+  sound_t sound = fx::neutral;
+  if (dir == Button::RIGHT) {
+    sound = fx::increase;
+    disp_varioBarHz = before + 2;
+  } else {
+    sound = fx::decrease;
+    disp_varioBarHz = before - 2;
+  }
+  if (disp_varioBarHz == before) sound = fx::doubleClick;
+  speaker.playSound(sound);
+}
+
+void Settings::adjustGpsRate(Button dir) {
+  if (dir == Button::CENTER) {  // reset to default
+    speaker.playSound(fx::confirm);
+    labs_gpsRateHz.loadDefault();
+    return;
+  }
+
+  // The rates the receiver's output is planned around (see LC86G::sendConfiguration)
+  constexpr int8_t RATES[] = {1, 5, 10};
+  constexpr uint8_t RATE_COUNT = sizeof(RATES) / sizeof(RATES[0]);
+  labs_gpsRateHz = stepRate(labs_gpsRateHz, dir, RATES, RATE_COUNT);
+}
+
+void Settings::adjustBleVarioRate(Button dir) {
+  if (dir == Button::CENTER) {  // reset to default
+    speaker.playSound(fx::confirm);
+    labs_bleVarioHz.loadDefault();
+    return;
+  }
+  labs_bleVarioHz = stepRate(labs_bleVarioHz, dir, BLE_RATES, BLE_RATE_COUNT);
+}
+
+void Settings::adjustBleGpsRate(Button dir) {
+  if (dir == Button::CENTER) {  // reset to default
+    speaker.playSound(fx::confirm);
+    labs_bleGpsHz.loadDefault();
+    return;
+  }
+  labs_bleGpsHz = stepRate(labs_bleGpsHz, dir, BLE_RATES, BLE_RATE_COUNT);
+}
+
 void Settings::adjustSinkAlarm(Button dir) {
   uint8_t opt = vario_sinkAlarm_units ? 1 : 0;  // determine m/s or fpm options
   sound_t sound = fx::neutral;
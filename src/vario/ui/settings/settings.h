@@ -120,6 +120,8 @@
 #define DEF_UNITS_distance 1  // 0 (km, or m for <1km),	1 (miles, or ft for < 1000 feet)
 #define DEF_UNITS_hours 1     // 0 (24-hour time),  1 (12 hour time),
 
+struct StoredSettings;
+
 class Settings {
  public:
   // Vario Settings
@@ -183,6 +185,12 @@ setting | samples | time avg
   bool labs_thermalCore;
   bool labs_thermalTrack;
   bool labs_leafLog;
+  // GPS position fixes per second: 1, 5 or 10
+  CharSetting<1, 1, 10> labs_gpsRateHz{"lGpsRateHz"};
+  // Bluetooth sentences per second: LK8EX1, and GGA and RMC (no faster than the GPS delivers
+  // them).  Each 1, 2, 5 or 10
+  CharSetting<1, 10, 10> labs_bleVarioHz{"lBleVarioHz"};
+  CharSetting<1, 2, 10> labs_bleGpsHz{"lBleGpsHz"};
 
   // Boot Flags
   bool boot_enterBootloader;
@@ -191,6 +199,9 @@ setting | samples | time avg
 
   // Display Settings
   uint8_t disp_contrast;
+  // Vario bar and climb rate redraws per second; the rest of the page redraws twice a second, so
+  // 2 means no extra redraws
+  CharSetting<2, 2, 10> disp_varioBarHz{"dVarioBarHz"};
   uint8_t disp_navPageAltType;
   uint8_t disp_thmPageAltType;
   uint8_t disp_thmPageAlt2Type;
@@ -220,8 +231,11 @@ setting | samples | time avg
   // manage-settings functions
   bool init(void);  // returns true if first-ever boot
   void loadDefaults(void);
-  void save(void);
+  void save(void);  // Writes only if something changed
   void retrieve(void);
+  // Reads settings stored under their own NVS keys (the layout before one record held them all)
+  // over the current values, saves them and removes the keys
+  void importKeys(void);
   void reset(void);
   void factoryResetVario(void);
   void totallyEraseNVS(void);
@@ -234,6 +248,10 @@ setting | samples | time avg
 
   // adjust-settings functions
   void adjustContrast(Button dir);
+  void adjustVarioBarRate(Button dir);
+  void adjustGpsRate(Button dir);
+  void adjustBleVarioRate(Button dir);
+  void adjustBleGpsRate(Button dir);
   void adjustSinkAlarm(Button dir);
   void adjustSinkAlarmUnits(bool units);
   void adjustVarioAverage(Button dir);
@@ -252,6 +270,11 @@ setting | samples | time avg
 
   void toggleBoolNeutral(bool* boolSetting);
   void toggleBoolOnOff(bool* switchSetting);
+
+ private:
+  void pack(StoredSettings& stored) const;
+  void unpack(const StoredSettings& stored);
+  void constrain(void);
 };
 extern Settings settings;
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+/// @brief Latest value of a small struct, handed from one writer to any number of readers without
+/// a lock.
+/// @details write() must only ever be called by one task at a time; read() may be called from any
+/// task and retries until it copies a value no write() overlapped, so it never sees one half
+/// updated.  A reader spins while a write is in progress, so a task must not read a Seqlock whose
+/// writer it can preempt on the same core.
+/// @tparam T Trivially copyable value type
+template <typename T>
+class Seqlock {
+ public:
+  void write(const T& value) {
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);  // Odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    value_ = value;
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  T read() const {
+    T value;
+    uint32_t before;
+    uint32_t after;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      value = value_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return value;
+  }
+
+ private:
+  T value_ = T();
+  std::atomic<uint32_t> sequence_{0};
+};
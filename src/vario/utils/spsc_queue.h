@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Fixed-size queue for handing items from exactly one producer to exactly one consumer
+/// without a lock.
+/// @details push() must only ever be called from one task (or ISR) and pop() from one other; each
+/// side owns one index and only reads the other's, so neither can block or be blocked by the
+/// other.  Holds CAPACITY - 1 items.
+/// @tparam T Trivially copyable item type
+/// @tparam CAPACITY Slot count; a power of two so the indices wrap with a mask
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+ public:
+  // Returns false, leaving the queue unchanged, if it is full
+  bool push(const T& item) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t next = (head + 1) & (CAPACITY - 1);
+    if (next == tail_.load(std::memory_order_acquire)) return false;
+    items_[head] = item;
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if the queue is empty
+  bool pop(T& item) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    item = items_[tail];
+    tail_.store((tail + 1) & (CAPACITY - 1), std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+ private:
+  T items_[CAPACITY];
+  std::atomic<size_t> head_{0};  // Next slot push() writes; only the producer stores it
+  std::atomic<size_t> tail_{0};  // Next slot pop() reads; only the consumer stores it
+};
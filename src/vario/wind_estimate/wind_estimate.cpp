@@ -33,10 +33,31 @@ constexpr WindEstimateAdjustment adjustments[ADJUSTMENT_COUNT] = {
 
 void WindEstimator::on_receive(const GpsReading& msg) {
   if (msg.gps.course.isUpdated() || msg.gps.speed.isUpdated()) {
-    GroundVelocity v = {.trackAngle = (float)(DEG_TO_RAD * gps.course.deg()),
-                        .speed = (float)gps.speed.mps()};
+    const float trackAngle = DEG_TO_RAD * gps.course.deg();
+    const float speed = gps.speed.mps();
+    const uint8_t second = gps.time.second();
+
+    // Fixes are averaged into one sample per second of GPS time, however many actually arrive in
+    // it, so at high GPS rates the bins still span as many circles as they do at 1Hz, and each
+    // sample is steadier.  A second's sample is taken when the first fix of the next arrives.
+    if (pending_.count > 0 && second != pending_.second) {
+      float averageAngle = pending_.track;
+      if (pending_.count > 1) {
+        averageAngle = atan2(pending_.east, pending_.north);
+        if (averageAngle < 0) averageAngle += TWO_PI;
+      }
+      GroundVelocity v = {.trackAngle = averageAngle, .speed = pending_.speed / pending_.count};
+      pending_ = {};
+
+      if (flightTimer_isRunning()) submitVelocityForWindEstimate(v);
+    }
 
-    if (flightTimer_isRunning()) submitVelocityForWindEstimate(v);
+    pending_.east += sin(trackAngle) * speed;
+    pending_.north += cos(trackAngle) * speed;
+    pending_.speed += speed;
+    pending_.track = trackAngle;
+    pending_.second = second;
+    pending_.count++;
   }
 }
 
@@ -260,6 +281,7 @@ void WindEstimator::clearWindEstimate() {
 
   // clear the sample points
   // (we don't need to actually erase them; just set indices and count to 0)
+  pending_ = {};
   for (int b = 0; b < BIN_COUNT; b++) {
     totalSamples_.bin[b].index = 0;
     totalSamples_.bin[b].sampleCount = 0;
@@ -106,6 +106,17 @@ class WindEstimator : public MessageSink<WindEstimator, GpsReading> {
   //   airspeed: Constant airspeed of aircraft, m/s
   float errorOf(float wx, float wy, float airspeed) const;
 
+  // Velocity components summed over the fixes not yet averaged into a sample
+  struct PendingVelocity {
+    float east = 0;   // m/s
+    float north = 0;  // m/s
+    float speed = 0;  // m/s
+    float track = 0;  // rad, of the last fix
+    uint8_t count = 0;
+    uint8_t second = 0;  // Of GPS time, that the fixes were in
+  };
+  PendingVelocity pending_;
+
   uint8_t windEstimateStep_ = 0;
 
   WindEstimate windEstimate_;
@@ -1,4 +1,20 @@
+// Worst-case write latency of a track log, written the way the firmware used to (a file that grows
+// as it is written) and the way it does now (storage/preallocated_file: a contiguous extent
+// reserved ahead of time, written through a 4 KB buffer, and truncated on close).
+//
+// Each run times opening the file, then writes RECORDS IGC-sized records one at a time, timing
+// every write, prints a summary and saves the latencies (microseconds, little-endian uint32) to
+// /stress_<run>.lat for profiling.ipynb.  The preallocated run also times reserving the extent,
+// which the firmware does in the background before a flight, so opening is only a rename.
+// FAT allocation stalls grow with how full and fragmented the card is: run it on a card that has
+// seen real use as well as a freshly formatted one.
+
 #include <Arduino.h>
+#include <esp_vfs_fat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
 #include "FS.h"
 #include "SD_MMC.h"
 
@@ -7,19 +23,107 @@ int cmd = 35;
 int d0 = 37;
 int d1 = 38;
 int d2 = 33;
-int d3 = 34; 
+int d3 = 34;
+
+constexpr const char* MOUNT_POINT = "/sdcard";
+// A B record with every extension the firmware logs, and its CRLF
+constexpr size_t RECORD_BYTES = 56;
+// About five and a half hours of flight at 1 Hz
+constexpr size_t RECORDS = 20000;
+constexpr size_t RESERVE_BYTES = RECORD_BYTES * RECORDS;
+constexpr size_t WRITE_BUFFER_BYTES = 4096;
+constexpr const char* SPARE_PATH = "/stress_spare.bin";
+constexpr uint32_t SLOW_WRITE_US = 10000;
+
+uint32_t* latencies;
+uint32_t* sorted;
+
+String fullPath(const char* path) { return String(MOUNT_POINT) + path; }
+
+fs::File openGrowing(const char* path) { return SD_MMC.open(path, FILE_WRITE); }
+
+// Reserve the extent the way the firmware does before a flight
+bool reserve(const char* sparePath) {
+  if (SD_MMC.exists(sparePath)) SD_MMC.remove(sparePath);
+  const uint32_t startedUs = micros();
+  const esp_err_t result = esp_vfs_fat_create_contiguous_file(
+      MOUNT_POINT, fullPath(sparePath).c_str(), RESERVE_BYTES, true);
+  const uint32_t reserveUs = micros() - startedUs;
+  if (result != ESP_OK) {
+    Serial.println("No free contiguous run for the reservation");
+    return false;
+  }
+  Serial.printf("Reserved %u KB in %lu us\n", (unsigned)(RESERVE_BYTES / 1024), reserveUs);
+  return true;
+}
+
+// And take it when the flight starts
+fs::File openPreallocated(const char* path) {
+  fs::File file = SD_MMC.rename(SPARE_PATH, path) ? SD_MMC.open(path, "r+") : fs::File();
+  if (file) file.setBufferSize(WRITE_BUFFER_BYTES);
+  return file;
+}
+
+void saveLatencies(const char* run) {
+  fs::File out = SD_MMC.open(String("/stress_") + run + ".lat", FILE_WRITE);
+  out.write((const uint8_t*)latencies, RECORDS * sizeof(uint32_t));
+  out.close();
+}
+
+void run(const char* name, bool preallocate) {
+  const char* path = preallocate ? "/stress_preallocated.igc" : "/stress_growing.igc";
+  if (SD_MMC.exists(path)) SD_MMC.remove(path);
+  if (preallocate && !reserve(SPARE_PATH)) return;
+
+  const uint32_t openStartedUs = micros();
+  fs::File file = preallocate ? openPreallocated(path) : openGrowing(path);
+  const uint32_t openUs = micros() - openStartedUs;
+  if (!file) {
+    Serial.printf("%s: could not open %s\n", name, path);
+    return;
+  }
+
+  uint8_t record[RECORD_BYTES];
+  memset(record, 'B', sizeof(record));
+  record[RECORD_BYTES - 2] = '\r';
+  record[RECORD_BYTES - 1] = '\n';
+
+  const uint32_t startedUs = micros();
+  for (size_t i = 0; i < RECORDS; i++) {
+    const uint32_t writeStartedUs = micros();
+    file.write(record, sizeof(record));
+    latencies[i] = micros() - writeStartedUs;
+  }
+  const uint32_t closeStartedUs = micros();
+  const size_t written = file.position();
+  file.close();
+  if (preallocate) truncate(fullPath(path).c_str(), written);
+  const uint32_t closeUs = micros() - closeStartedUs;
+  const uint32_t totalUs = micros() - startedUs;
+
+  memcpy(sorted, latencies, RECORDS * sizeof(uint32_t));
+  std::sort(sorted, sorted + RECORDS);
+  const size_t slow =
+      sorted + RECORDS - std::lower_bound(sorted, sorted + RECORDS, SLOW_WRITE_US);
+  Serial.printf("%s: %u records in %lu ms\n", name, (unsigned)RECORDS, totalUs / 1000);
+  Serial.printf("  p50 %lu us, p99 %lu us, p99.9 %lu us, max %lu us\n", sorted[RECORDS / 2],
+                sorted[RECORDS * 99 / 100], sorted[RECORDS * 999 / 1000], sorted[RECORDS - 1]);
+  Serial.printf("  %u writes over %lu ms, open %lu us, close %lu us\n", (unsigned)slow,
+                SLOW_WRITE_US / 1000, openUs, closeUs);
+  saveLatencies(name);
+}
 
 void setup() {
   Serial.begin(115200);
   delay(3000);
 
   // Setup the SD card
-  if(!SD_MMC.setPins(clk, cmd, d0, d1, d2, d3)){
-      Serial.println("Pin change failed!");
-      return;
+  if (!SD_MMC.setPins(clk, cmd, d0, d1, d2, d3)) {
+    Serial.println("Pin change failed!");
+    return;
   }
 
-  if (!SD_MMC.begin()) {
+  if (!SD_MMC.begin(MOUNT_POINT)) {
     Serial.println("Card Mount Failed");
     return;
   }
@@ -40,20 +144,19 @@ void setup() {
   } else {
     Serial.println("UNKNOWN");
   }
+  Serial.printf("Used %llu of %llu MB\n", SD_MMC.usedBytes() >> 20, SD_MMC.totalBytes() >> 20);
 
-  fs::File file = SD_MMC.open("/logfile.txt", FILE_WRITE);
-
-  Serial.println((String)"The size of micros is: " + sizeof(unsigned long));
-  while(true) {
-    for(int i = 0; i < 1000; i++) {
-      auto running_time = micros();
-      file.write((const uint8_t*)&running_time, sizeof(unsigned long));
-    }
-    // Don't flush terribly often
-    file.flush();
+  latencies = (uint32_t*)ps_malloc(RECORDS * sizeof(uint32_t));
+  sorted = (uint32_t*)ps_malloc(RECORDS * sizeof(uint32_t));
+  if (!latencies || !sorted) {
+    Serial.println("Out of memory for the latency record");
+    return;
   }
+
+  run("growing", false);
+  run("preallocated", true);
 }
 
 void loop() {
   // Nothing to do
-}
\ No newline at end of file
+}